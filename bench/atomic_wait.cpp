@@ -0,0 +1,96 @@
+/* atomic_wait.cpp - waiting on a word against a semaphore per flag */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Compares vxworks::atomic_wait() and atomic_notify_one() on a
+ * std::atomic<unsigned> with a vxworks::binary_semaphore used as the same
+ * flag:
+ *
+ *   idle		setting the flag with no one waiting, and taking it back
+ *   wakeup		the time from setting the flag to the waiter running
+ *   pingpong		two threads handing a turn back and forth
+ */
+
+#include "bench.hpp"
+#include "vxworks/atomic_wait.hpp"
+#include "vxworks/semaphore.hpp"
+
+using vxbench::report;
+
+namespace
+{
+/* round trips per second of two threads taking turns through <pass> */
+template <typename Pass>
+void pingpong(report& r, const vxbench::options& opts, const std::string& name,
+	      Pass pass)
+    {
+    const unsigned rounds = opts.iterations / 10;
+
+    if (!r.wanted(name))
+	return;
+    unsigned long long start = vxbench::now();
+    std::thread other([&] { for (unsigned i = 0; i < rounds; i++) pass(1); });
+    for (unsigned i = 0; i < rounds; i++)
+	pass(0);
+    other.join();
+    double seconds = (vxbench::now() - start) / 1e9;
+    r.add(name, "pingpong", 2, rounds / seconds, "rounds/s");
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("atomic_wait", opts);
+    std::atomic<unsigned> flag {0};
+    vxworks::binary_semaphore sem;
+
+    r.latency("atomic_notify_one.idle", [&]
+	{
+	flag.fetch_add(1);
+	vxworks::atomic_notify_one(&flag);
+	unsigned seen = flag.load();
+	vxworks::atomic_wait(&flag, seen - 1);
+	});
+    r.latency("binary_semaphore.idle", [&]
+	{
+	sem.give();
+	sem.take(WAIT_FOREVER);
+	});
+
+    unsigned seen = flag.load();
+    r.wakeup("atomic_wait",
+	     [&] { flag.fetch_add(1); vxworks::atomic_notify_one(&flag); },
+	     [&]
+		{
+		while (flag.load() == seen)
+		    vxworks::atomic_wait(&flag, seen);
+		seen = flag.load();
+		});
+    r.wakeup("binary_semaphore", [&] { sem.give(); },
+	     [&] { sem.take(WAIT_FOREVER); });
+
+    /* the turn is flag % 2; each side waits for its own */
+    std::atomic<unsigned> turn {0};
+    pingpong(r, opts, "atomic_wait", [&](unsigned me)
+	{
+	unsigned t;
+	while ((t = turn.load()) % 2 != me)
+	    vxworks::atomic_wait(&turn, t);
+	turn.store(t + 1);
+	vxworks::atomic_notify_one(&turn);
+	});
+    vxworks::binary_semaphore side[2];
+    side[0].give();
+    pingpong(r, opts, "binary_semaphore", [&](unsigned me)
+	{
+	side[me].take(WAIT_FOREVER);
+	side[1 - me].give();
+	});
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
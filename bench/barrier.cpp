@@ -0,0 +1,107 @@
+/* barrier.cpp - the cost of a phase for 2 to 32 workers */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures the time per phase of 2, 4, 8, 16 and 32 workers meeting
+ * repeatedly at:
+ *
+ *   barrier		a vxworks::barrier
+ *   barrier+completion	the same with a completion function
+ *   mutex+condvar	a count and a generation under a vxworks::mutex, with
+ *			a vxworks::condition_variable broadcast by the last
+ *			worker to arrive
+ *
+ * The workers do no work between phases, so this is the synchronization
+ * cost alone.
+ */
+
+#include "bench.hpp"
+#include "vxworks/barrier.hpp"
+#include "vxworks/condition_variable.hpp"
+#include "vxworks/mutex.hpp"
+
+using vxbench::report;
+
+namespace
+{
+/* nanoseconds per phase of <workers> threads each calling <phase> <rounds> times */
+template <typename Phase>
+void phases(report& r, const vxbench::options& opts, const std::string& name,
+	    unsigned workers, Phase phase)
+    {
+    const unsigned rounds = std::max(100ul, opts.iterations / 50);
+    std::vector<std::thread> threads;
+
+    if (!r.wanted(name))
+	return;
+    unsigned long long start = vxbench::now();
+    for (unsigned t = 0; t < workers; t++)
+	threads.emplace_back([&, t]
+	    {
+	    for (unsigned i = 0; i < rounds; i++)
+		phase(t, i);
+	    });
+    for (auto& th : threads)
+	th.join();
+    r.add(name, "phase", workers, double(vxbench::now() - start) / rounds, "ns");
+    }
+
+/* what mutex+condvar callers write today */
+struct condvar_barrier
+    {
+    vxworks::timed_mutex m;
+    vxworks::condition_variable cv {CONDVAR_Q_PRIORITY};
+    unsigned expected;
+    unsigned count;
+    unsigned long long generation = 0;
+
+    explicit condvar_barrier(unsigned n) : expected(n), count(n)
+	{
+	}
+
+    void arrive_and_wait()
+	{
+	m.lock();
+	unsigned long long g = generation;
+	if (--count == 0)
+	    {
+	    count = expected;
+	    generation++;
+	    cv.notify_all();
+	    }
+	else
+	    while (g == generation)
+		cv.wait(m);
+	m.unlock();
+	}
+    };
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("barrier", opts);
+    for (unsigned n = 2; n <= 32; n *= 2)
+	{
+	vxworks::barrier<> b(n);
+	phases(r, opts, "barrier", n, [&](unsigned, unsigned)
+	    { b.arrive_and_wait(); });
+
+	unsigned long long completed = 0;
+	auto done = [&]() noexcept { completed++; };
+	vxworks::barrier<decltype(done)> bc(n, done);
+	phases(r, opts, "barrier+completion", n, [&](unsigned, unsigned)
+	    { bc.arrive_and_wait(); });
+	vxbench::keep(completed);
+
+	condvar_barrier cb(n);
+	phases(r, opts, "mutex+condvar", n, [&](unsigned, unsigned)
+	    { cb.arrive_and_wait(); });
+	}
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
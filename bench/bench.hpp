@@ -0,0 +1,401 @@
+/* bench.hpp - benchmark harness for the vxworks namespace */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * The programs in bench/ measure the classes of the vxworks namespace on
+ * a host, against the simulation in host/. Each result is a name, a
+ * metric, a thread count and a value; a run is written to stdout as one
+ * JSON document so that results can be tracked over time, while progress
+ * is written to stderr.
+ *
+ * Every program accepts the same options:
+ *
+ *   -q		quick run, for smoke testing
+ *   -t <n>	largest thread count for contended runs (default 8)
+ *   -f <text>	run only the benchmarks whose name contains <text>
+ *   -l <ns>	fail, with exit status 1, if any latency p99 exceeds <ns>
+ */
+
+#ifndef __INCbenchhpp
+#define __INCbenchhpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vxbench
+{
+//! monotonic time in nanoseconds
+inline unsigned long long now() noexcept
+    {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+//! keep the compiler from optimising away the computation of *value*
+template <typename T> inline void keep(const T& value) noexcept
+    {
+    asm volatile("" : : "g"(&value) : "memory");
+    }
+
+//! the value below which a fraction *p* of the sorted *samples* lie
+inline unsigned long long percentile(const std::vector<unsigned long long>& samples,
+				     double p)
+    {
+    if (samples.empty())
+	return 0;
+    size_t i = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[std::min(i, samples.size() - 1)];
+    }
+
+/*!
+
+\brief  A Latency Histogram
+
+ Counts nanosecond samples in the manner of an HDR histogram: each power
+ of two is divided into 32 linear sub-buckets, so any recorded value is
+ known to within about 3% over the whole range from 1 ns to about 18
+ minutes, in fixed storage and at a constant cost per sample.
+*/
+class histogram
+    {
+private:
+    static const unsigned subBits = 5;
+    static const unsigned sub = 1u << subBits;
+    static const unsigned maxExp = 40;
+    static const unsigned size = (maxExp - subBits + 2) * sub;
+
+    unsigned long long counts[size] = {};
+    unsigned long long total = 0;
+    unsigned long long largest = 0;
+
+    static unsigned index(unsigned long long ns)
+	{
+	if (ns < 2 * sub)
+	    return static_cast<unsigned>(ns);
+	unsigned e = 63 - __builtin_clzll(ns);
+	if (e > maxExp)
+	    return size - 1;
+	return (e - subBits) * sub + static_cast<unsigned>(ns >> (e - subBits));
+	}
+
+    /* the largest value counted in bucket <i> */
+    static unsigned long long upper(unsigned i)
+	{
+	if (i < 2 * sub)
+	    return i;
+	unsigned e = i / sub + subBits - 1;
+	unsigned long long top = i % sub + sub;
+	return ((top + 1) << (e - subBits)) - 1;
+	}
+
+public:
+    //! count one sample of *ns* nanoseconds
+    void record(unsigned long long ns) noexcept
+	{
+	counts[index(ns)]++;
+	total++;
+	if (ns > largest)
+	    largest = ns;
+	}
+
+    //! the number of samples recorded
+    unsigned long long count() const noexcept
+	{
+	return total;
+	}
+
+    //! the largest sample recorded
+    unsigned long long max() const noexcept
+	{
+	return largest;
+	}
+
+    //! the value at or below which a fraction *p* of the samples lie
+    unsigned long long percentile(double p) const noexcept
+	{
+	unsigned long long seen = 0;
+
+	if (total == 0)
+	    return 0;
+	for (unsigned i = 0; i < size; i++)
+	    {
+	    seen += counts[i];
+	    if (seen >= p * total && seen > 0)
+		return std::min(upper(i), largest);
+	    }
+	return largest;
+	}
+    };
+
+/*! Options shared by all the benchmark programs. */
+struct options
+    {
+    const char * filter = nullptr;	//!< run only names containing this
+    unsigned maxThreads = 8;		//!< largest thread count when contended
+    unsigned long iterations = 200000;	//!< operations per uncontended run
+    unsigned samples = 10000;		//!< samples per latency distribution
+    double seconds = 0.25;		//!< length of each contended run
+    unsigned long long limit = 0;	//!< largest acceptable p99, 0 for none
+
+    options(int argc, char ** argv)
+	{
+	for (int i = 1; i < argc; i++)
+	    {
+	    if (strcmp(argv[i], "-q") == 0)
+		{
+		iterations = 20000;
+		samples = 1000;
+		seconds = 0.05;
+		}
+	    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+		maxThreads = std::max(1, atoi(argv[++i]));
+	    else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		filter = argv[++i];
+	    else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+		limit = strtoull(argv[++i], nullptr, 0);
+	    else
+		{
+		fprintf(stderr, "usage: %s [-q] [-t threads] [-f filter] "
+			"[-l p99-limit-ns]\n", argv[0]);
+		exit(2);
+		}
+	    }
+	}
+    };
+
+/*!
+
+\brief  A Benchmark Report
+
+ Runs benchmarks and collects their results. Three kinds of measurement
+ are offered:
+
+ * latency() - the mean cost of an operation in a single thread, in
+   nanoseconds; the best of several runs is kept to filter out noise.
+
+ * throughput() - operations per second completed by 1, 2, 4 ... threads
+   all calling the same operation for a fixed time.
+
+ * wakeup() - the distribution of the time from one thread signalling to
+   another thread, pended on the same object, resuming.
+ .
+*/
+class report
+    {
+private:
+    struct result
+	{
+	std::string name;
+	std::string metric;
+	unsigned threads;
+	double value;
+	const char * unit;
+	};
+
+    const char * suite;
+    const options& opts;
+    std::vector<result> results;
+    bool over = false;
+
+    /* note a p99 that is over the limit given on the command line */
+    void check(const std::string& name, unsigned long long p99)
+	{
+	if (opts.limit != 0 && p99 > opts.limit)
+	    {
+	    fprintf(stderr, "%s: p99 of %llu ns is over the limit of %llu ns\n",
+		    name.c_str(), p99, opts.limit);
+	    over = true;
+	    }
+	}
+
+public:
+    report(const char * suite, const options& opts) : suite(suite), opts(opts)
+	{
+	}
+
+    //! Returns true if the benchmark *name* was selected on the command line
+    bool wanted(const std::string& name) const
+	{
+	return opts.filter == nullptr ||
+	       name.find(opts.filter) != std::string::npos;
+	}
+
+    //! record one result
+    void add(const std::string& name, const char * metric, unsigned threads,
+	     double value, const char * unit)
+	{
+	results.push_back(result{name, metric, threads, value, unit});
+	fprintf(stderr, "%-40s %-12s %2u %14.1f %s\n", name.c_str(), metric,
+		threads, value, unit);
+	}
+
+    //! record the percentiles of a set of samples in nanoseconds
+    void distribution(const std::string& name, const char * metric,
+		      std::vector<unsigned long long>& samples)
+	{
+	std::string base(metric);
+
+	std::sort(samples.begin(), samples.end());
+	check(name, percentile(samples, 0.99));
+	add(name, (base + ".p50").c_str(), 1, percentile(samples, 0.50), "ns");
+	add(name, (base + ".p99").c_str(), 1, percentile(samples, 0.99), "ns");
+	add(name, (base + ".p999").c_str(), 1, percentile(samples, 0.999), "ns");
+	add(name, (base + ".max").c_str(), 1,
+	    samples.empty() ? 0 : samples.back(), "ns");
+	}
+
+    //! record the percentiles of a histogram
+    void distribution(const std::string& name, const char * metric,
+		      const histogram& h)
+	{
+	std::string base(metric);
+
+	check(name, h.percentile(0.99));
+	add(name, (base + ".p50").c_str(), 1, h.percentile(0.50), "ns");
+	add(name, (base + ".p99").c_str(), 1, h.percentile(0.99), "ns");
+	add(name, (base + ".p999").c_str(), 1, h.percentile(0.999), "ns");
+	add(name, (base + ".max").c_str(), 1, h.max(), "ns");
+	}
+
+    //! Returns true if any p99 was over the limit given with -l
+    bool failed() const
+	{
+	return over;
+	}
+
+    //! the mean cost in nanoseconds of *op*, run repeatedly in one thread
+    template <typename Op> void latency(const std::string& name, Op op)
+	{
+	double best = 0;
+
+	if (!wanted(name))
+	    return;
+	for (int run = 0; run < 5; run++)
+	    {
+	    unsigned long long start = now();
+	    for (unsigned long i = 0; i < opts.iterations; i++)
+		op();
+	    double ns = double(now() - start) / opts.iterations;
+	    if (run == 0 || ns < best)
+		best = ns;
+	    }
+	add(name, "uncontended", 1, best, "ns/op");
+	}
+
+    /*! The operations per second completed by 1, 2, 4 ... maxThreads
+        threads calling *op(index, threads)* until time is up. *op* returns
+	true for an operation that is to be counted. It must not pend
+	indefinitely, so that every thread sees the end of the run.
+    */
+    template <typename Op> void throughput(const std::string& name, Op op)
+	{
+	if (!wanted(name))
+	    return;
+	for (unsigned n = 1; n <= opts.maxThreads; n *= 2)
+	    {
+	    std::atomic<bool> go(false);
+	    std::atomic<bool> stop(false);
+	    std::atomic<unsigned long long> total(0);
+	    std::vector<std::thread> threads;
+
+	    for (unsigned t = 0; t < n; t++)
+		threads.emplace_back([&, t]
+		    {
+		    unsigned long long count = 0;
+		    while (!go.load(std::memory_order_acquire))
+			std::this_thread::yield();
+		    while (!stop.load(std::memory_order_relaxed))
+			if (op(t, n))
+			    count++;
+		    total.fetch_add(count);
+		    });
+
+	    unsigned long long start = now();
+	    go.store(true, std::memory_order_release);
+	    std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+	    stop.store(true);
+	    double elapsed = double(now() - start) / 1e9;
+	    for (auto& th : threads)
+		th.join();
+	    add(name, "contended", n, total.load() / elapsed, "ops/s");
+	    }
+	}
+
+    /*! The distribution of the time between one thread calling *signal()*
+        and a second thread returning from *wait()*. *prepare()* is called
+	in the waiting thread before the first sample, to set up anything
+	that must be done in that thread's context.
+    */
+    template <typename Signal, typename Wait, typename Prepare>
+    void wakeup(const std::string& name, Signal signal, Wait wait,
+		Prepare prepare)
+	{
+	std::vector<unsigned long long> samples(opts.samples);
+	std::atomic<unsigned long long> stamp(0);
+	std::atomic<unsigned> done(0);
+	std::atomic<bool> ready(false);
+
+	if (!wanted(name))
+	    return;
+	std::thread waiter([&]
+	    {
+	    prepare();
+	    ready.store(true);
+	    for (unsigned i = 0; i < opts.samples; i++)
+		{
+		wait();
+		samples[i] = now() - stamp.load(std::memory_order_acquire);
+		done.store(i + 1, std::memory_order_release);
+		}
+	    });
+
+	while (!ready.load())
+	    std::this_thread::yield();
+	for (unsigned i = 0; i < opts.samples; i++)
+	    {
+	    /* give the waiter time to pend before it is signalled */
+	    std::this_thread::sleep_for(std::chrono::microseconds(20));
+	    stamp.store(now(), std::memory_order_release);
+	    signal();
+	    while (done.load(std::memory_order_acquire) <= i)
+		std::this_thread::yield();
+	    }
+	waiter.join();
+	distribution(name, "wakeup", samples);
+	}
+
+    //! wakeup() with nothing to prepare
+    template <typename Signal, typename Wait>
+    void wakeup(const std::string& name, Signal signal, Wait wait)
+	{
+	wakeup(name, signal, wait, [] {});
+	}
+
+    //! write all the results to *out* as a JSON document
+    void write(FILE * out) const
+	{
+	fprintf(out, "{\n  \"suite\": \"%s\",\n  \"cpus\": %u,\n  \"results\": [",
+		suite, std::thread::hardware_concurrency());
+	for (size_t i = 0; i < results.size(); i++)
+	    {
+	    const result& r = results[i];
+	    fprintf(out, "%s\n    {\"name\": \"%s\", \"metric\": \"%s\", "
+		    "\"threads\": %u, \"value\": %.1f, \"unit\": \"%s\"}",
+		    (i == 0) ? "" : ",", r.name.c_str(), r.metric.c_str(),
+		    r.threads, r.value, r.unit);
+	    }
+	fprintf(out, "\n  ]\n}\n");
+	}
+    };  // report
+}      // vxbench
+#endif // __INCbenchhpp
@@ -0,0 +1,113 @@
+/* expected.cpp - the throwing API against the std::nothrow one */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Compares the methods that throw on failure with their std::nothrow
+ * overloads, which return a vxworks::expected, for a mutex lock/unlock
+ * pair, a binary semaphore release/acquire pair and a queue push/pop pair:
+ *
+ *   latency	the cost of the pair on the success path
+ *   code	the bytes of machine code of a function making the pair,
+ *		each placed in its own section, whose bounds the linker
+ *		provides; exception tables are not counted
+ *
+ * and reports how each API tells a timeout from a deleted object.
+ */
+
+#include "bench.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+
+using vxbench::report;
+
+#define THROWING	__attribute__((noinline, section("vx_throwing")))
+#define NOTHROW		__attribute__((noinline, section("vx_nothrow")))
+
+extern "C" const char __start_vx_throwing[], __stop_vx_throwing[];
+extern "C" const char __start_vx_nothrow[], __stop_vx_nothrow[];
+
+namespace
+{
+struct msg
+    {
+    unsigned long long seq;
+    };
+
+THROWING void mutex_throwing(vxworks::mutex& m)
+    {
+    m.lock();
+    m.unlock();
+    }
+
+THROWING void semaphore_throwing(vxworks::binary_semaphore& s)
+    {
+    s.release();
+    s.aquire();
+    }
+
+THROWING msg queue_throwing(vxworks::queue<msg>& q, const msg& in)
+    {
+    msg out;
+
+    q.push(in);
+    q >> out;
+    return out;
+    }
+
+NOTHROW bool mutex_nothrow(vxworks::mutex& m) noexcept
+    {
+    return m.lock(std::nothrow) && m.unlock(std::nothrow);
+    }
+
+NOTHROW bool semaphore_nothrow(vxworks::binary_semaphore& s) noexcept
+    {
+    return s.release(std::nothrow) && s.acquire(std::nothrow);
+    }
+
+NOTHROW vxworks::expected<msg> queue_nothrow(vxworks::queue<msg>& q,
+					     const msg& in) noexcept
+    {
+    vxworks::expected<void> sent = q.push(in, std::nothrow);
+
+    if (!sent)
+	return sent.error();
+    return q.pop(std::nothrow);
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("expected", opts);
+    vxworks::mutex m;
+    vxworks::binary_semaphore s;
+    vxworks::queue<msg> q(16);
+    msg in = {1};
+
+    r.latency("mutex.lock/unlock", [&] { mutex_throwing(m); });
+    r.latency("mutex.lock/unlock(nothrow)", [&] { vxbench::keep(mutex_nothrow(m)); });
+    r.latency("binary_semaphore.release/aquire", [&] { semaphore_throwing(s); });
+    r.latency("binary_semaphore.release/acquire(nothrow)", [&]
+	{ vxbench::keep(semaphore_nothrow(s)); });
+    r.latency("queue.push/>>", [&] { vxbench::keep(queue_throwing(q, in)); });
+    r.latency("queue.push/pop(nothrow)", [&] { vxbench::keep(queue_nothrow(q, in)); });
+
+    r.add("throwing", "code", 1, double(__stop_vx_throwing - __start_vx_throwing), "bytes");
+    r.add("nothrow", "code", 1, double(__stop_vx_nothrow - __start_vx_nothrow), "bytes");
+
+    /* the errors the nothrow API tells apart, and the throwing one cannot */
+    vxworks::expected<msg> none = q.pop(NO_WAIT, std::nothrow);
+    r.add("queue.pop(NO_WAIT) on empty", "unavailable", 1,
+	  !none && none.error().unavailable() ? 1 : 0, "bool");
+    vxworks::expected<void> late = s.try_acquire_for(std::chrono::milliseconds(1),
+						     std::nothrow);
+    r.add("binary_semaphore.try_acquire_for on empty", "timed_out", 1,
+	  !late && late.error().timed_out() ? 1 : 0, "bool");
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,115 @@
+/* hazard.cpp - a lock-free stack against a mutex-protected vector */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Compares a vxworks::lockfree_stack, whose popped nodes are reclaimed
+ * through the hazard_domain, with a std::vector used as a stack under a
+ * vxworks::mutex, plain and scalable:
+ *
+ *   push/pop		a push and a pop, uncontended and by 1, 2, 4 ...
+ *			threads at once
+ *
+ * and a vxworks::lockfree_list with one insert and one erase in every
+ * eight operations on 64 keys. Each thread reclaims what it can as it exits,
+ * and the nodes the main thread has left retired are reported.
+ */
+
+#include <vector>
+#include "bench.hpp"
+#include "vxworks/lockfree_list.hpp"
+#include "vxworks/lockfree_stack.hpp"
+#include "vxworks/mutex.hpp"
+
+using vxbench::report;
+
+namespace
+{
+void locked(report& r, vxworks::mutex& m, const std::string& name)
+    {
+    std::vector<unsigned long> v;
+
+    v.reserve(1024);
+    r.latency(name + ".push/pop", [&]
+	{
+	m.lock();
+	v.push_back(1);
+	m.unlock();
+	m.lock();
+	vxbench::keep(v.back());
+	v.pop_back();
+	m.unlock();
+	});
+    r.throughput(name + ".push/pop", [&](unsigned t, unsigned)
+	{
+	unsigned long x = 0;
+	bool popped = false;
+
+	m.lock();
+	v.push_back(t);
+	m.unlock();
+	m.lock();
+	if (!v.empty())
+	    {
+	    x = v.back();
+	    v.pop_back();
+	    popped = true;
+	    }
+	m.unlock();
+	vxbench::keep(x);
+	return popped;
+	});
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("hazard", opts);
+    vxworks::lockfree_stack<unsigned long> stack;
+    vxworks::lockfree_list<unsigned> list;
+    vxworks::mutex m;
+    vxworks::mutex qm(vxworks::scalable);
+
+    r.latency("lockfree_stack.push/pop", [&]
+	{
+	unsigned long v;
+	stack.push(1);
+	stack.pop(v);
+	vxbench::keep(v);
+	});
+    r.throughput("lockfree_stack.push/pop", [&](unsigned t, unsigned)
+	{
+	unsigned long v;
+	stack.push(t);
+	return stack.pop(v);
+	});
+    r.throughput("lockfree_list.mixed", [&](unsigned t, unsigned)
+	{
+	static thread_local unsigned x = 1;
+	x = x * 1103515245 + 12345 + t;
+	unsigned key = (x >> 8) & 63;
+	switch ((x >> 16) & 7)
+	    {
+	    case 0:
+		list.insert(key);
+		break;
+	    case 1:
+		list.erase(key);
+		break;
+	    default:
+		vxbench::keep(list.contains(key));
+	    }
+	return true;
+	});
+    r.add("hazard_domain.reclaim", "retired", 1,
+	  vxworks::hazard_domain::reclaim(), "nodes");
+
+    locked(r, m, "mutex+vector");
+    locked(r, qm, "mutex(scalable)+vector");
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,100 @@
+/* lockdep.cpp - the cost of lock order validation */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Built with VX_LOCKDEP, so every mutex acquisition is validated. Measures
+ * nested lock/unlock of two and four mutexes, whose lock orders are already
+ * known after the first pass, against the same nesting through the C API,
+ * which is not validated, and the cost of validating a new lock order,
+ * which includes creating and deleting the inner mutex.
+ */
+
+#define VX_LOCKDEP
+
+#include "bench.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/shared_mutex.hpp"
+
+using vxbench::report;
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("lockdep", opts);
+    vxworks::mutex m[4];
+    vxworks::shared_mutex s;
+    SEM_ID sem[4];
+
+    for (SEM_ID& id : sem)
+	id = ::semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+
+    r.latency("semMTake/semMGive.nested2", [&]
+	{
+	::semMTake(sem[0], WAIT_FOREVER);
+	::semMTake(sem[1], WAIT_FOREVER);
+	::semMGive(sem[1]);
+	::semMGive(sem[0]);
+	});
+    r.latency("mutex.nested2", [&]
+	{
+	m[0].lock();
+	m[1].lock();
+	m[1].unlock();
+	m[0].unlock();
+	});
+    r.latency("semMTake/semMGive.nested4", [&]
+	{
+	for (SEM_ID id : sem)
+	    ::semMTake(id, WAIT_FOREVER);
+	for (int i = 3; i >= 0; i--)
+	    ::semMGive(sem[i]);
+	});
+    r.latency("mutex.nested4", [&]
+	{
+	for (vxworks::mutex& x : m)
+	    x.lock();
+	for (int i = 3; i >= 0; i--)
+	    m[i].unlock();
+	});
+    r.latency("shared_mutex.nested2", [&]
+	{
+	m[0].lock();
+	s.lock_shared();
+	s.unlock_shared();
+	m[0].unlock();
+	});
+    r.latency("semMCreate/semDelete.nested", [&]
+	{
+	SEM_ID id = ::semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+	::semMTake(sem[0], WAIT_FOREVER);
+	::semMTake(id, WAIT_FOREVER);
+	::semMGive(id);
+	::semMGive(sem[0]);
+	::semDelete(id);
+	});
+    r.latency("mutex.new_order", [&]
+	{
+	vxworks::mutex inner;
+	m[0].lock();
+	inner.lock();
+	inner.unlock();
+	m[0].unlock();
+	});
+    r.throughput("mutex.nested2", [&](unsigned, unsigned)
+	{
+	m[0].lock();
+	m[1].lock();
+	m[1].unlock();
+	m[0].unlock();
+	return true;
+	});
+
+    r.add("lockdep", "reports", 1, vxworks::lockdep::reports(), "reports");
+    for (SEM_ID id : sem)
+	::semDelete(id);
+    r.write(stdout);
+    return (r.failed() || vxworks::lockdep::reports() != 0) ? 1 : 0;
+    }
@@ -0,0 +1,112 @@
+/* move.cpp - the cost of moving the object classes */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * The object classes are move-only, so a std::vector holds them directly;
+ * test/move.cpp checks their layout and what a move does. Measures:
+ *
+ *   move		one move construction and one move assignment
+ *   relocate		moving 64 elements into a new vector, one growth step
+ *   grow		push_back 16 newly created mutexes into an empty vector
+ *
+ * each for a vector of mutexes against a vector of unique_ptrs to mutexes,
+ * which is what had to be used while the classes could not be moved.
+ */
+
+#include "bench.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/shared_mutex.hpp"
+#include <memory>
+#include <vector>
+
+using vxbench::report;
+
+namespace
+{
+const size_t relocated = 64;
+const size_t grown = 16;
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("move", opts);
+
+    vxworks::mutex a, b;
+    r.latency("mutex.move", [&]
+	{
+	vxworks::mutex c(std::move(a));
+	a = std::move(c);
+	vxbench::keep(a.handle());
+	});
+    vxworks::shared_mutex sa(vxworks::scalable), sb;
+    r.latency("shared_mutex.move", [&]
+	{
+	vxworks::shared_mutex c(std::move(sa));
+	sa = std::move(c);
+	vxbench::keep(sa.handle());
+	});
+
+    std::vector<vxworks::mutex> v(relocated);
+    r.latency("vector<mutex>.relocate", [&]
+	{
+	std::vector<vxworks::mutex> w;
+	w.reserve(v.size());
+	for (vxworks::mutex& m : v)
+	    w.push_back(std::move(m));
+	v.swap(w);
+	});
+    std::vector<std::unique_ptr<vxworks::mutex>> p;
+    for (size_t i = 0; i < relocated; i++)
+	p.emplace_back(new vxworks::mutex);
+    r.latency("vector<unique_ptr<mutex>>.relocate", [&]
+	{
+	std::vector<std::unique_ptr<vxworks::mutex>> w;
+	w.reserve(p.size());
+	for (std::unique_ptr<vxworks::mutex>& m : p)
+	    w.push_back(std::move(m));
+	p.swap(w);
+	});
+
+    r.latency("vector<mutex>.grow", [&]
+	{
+	std::vector<vxworks::mutex> w;
+	for (size_t i = 0; i < grown; i++)
+	    w.emplace_back();
+	vxbench::keep(w.data());
+	});
+    r.latency("vector<unique_ptr<mutex>>.grow", [&]
+	{
+	std::vector<std::unique_ptr<vxworks::mutex>> w;
+	for (size_t i = 0; i < grown; i++)
+	    w.emplace_back(new vxworks::mutex);
+	vxbench::keep(w.data());
+	});
+
+    /* locking through the vector: contiguous mutexes against pointers */
+    r.latency("vector<mutex>.lock_all", [&]
+	{
+	for (vxworks::mutex& m : v)
+	    {
+	    m.lock();
+	    m.unlock();
+	    }
+	});
+    r.latency("vector<unique_ptr<mutex>>.lock_all", [&]
+	{
+	for (std::unique_ptr<vxworks::mutex>& m : p)
+	    {
+	    m->lock();
+	    m->unlock();
+	    }
+	});
+
+    r.add("sizeof(mutex)", "size", 1, double(sizeof(vxworks::mutex)), "bytes");
+    r.add("sizeof(queue<int>)", "size", 1, double(sizeof(vxworks::queue<int>)), "bytes");
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
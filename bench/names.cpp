@@ -0,0 +1,69 @@
+/* names.cpp - the cost of putting object names in log messages */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Formats a log line carrying the name of a named queue, the way a
+ * logging call would, with each way of getting the name:
+ *
+ *   objNameGet	the C API into a malloc()ed buffer, which is what
+ *		object::name(capacity) did on every call before the name
+ *		was cached
+ *   name(capacity)	a std::string copy of the cached name
+ *   name(buffer)	a copy into the caller's buffer
+ *   name()		a name_view of the cached name
+ */
+
+#include "bench.hpp"
+#include "vxworks/queue.hpp"
+#include <cstdlib>
+
+using vxbench::report;
+
+namespace
+{
+struct msg
+    {
+    unsigned long long seq;
+    };
+
+char line[256];
+unsigned long long seq;
+
+void log(const char * name)
+    {
+    snprintf(line, sizeof(line), "%s: message %llu dropped", name, ++seq);
+    vxbench::keep(line);
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("names", opts);
+    /* longer than the std::string small-string buffer, as real names are */
+    vxworks::queue<msg> q("/telemetry.downlink.tx", 16);
+
+    r.latency("log.objNameGet", [&]
+	{
+	const size_t capacity = 64;
+	char * buf = static_cast<char *>(malloc(capacity));
+	::objNameGet(__OBJ(q.handle()), buf, capacity);
+	std::string name(buf);
+	free(buf);
+	log(name.c_str());
+	});
+    r.latency("log.name(capacity)", [&] { log(q.name(64).c_str()); });
+    r.latency("log.name(buffer)", [&]
+	{
+	char buf[64];
+	q.name(buf);
+	log(buf);
+	});
+    r.latency("log.name()", [&] { log(q.name().c_str()); });
+    r.latency("log.unnamed", [&] { log("-"); });
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
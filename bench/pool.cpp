@@ -0,0 +1,90 @@
+/* pool.cpp - fixed-block pools against malloc under churn */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Each thread keeps a window of live objects and, on every operation,
+ * frees the oldest and allocates a replacement, so the allocator sees a
+ * steady mix of frees and allocations from every thread at once. The
+ * same churn is run through malloc()/free(), vxworks::fixed_pool,
+ * vxworks::object_pool and vxworks::shared_object_pool.
+ */
+
+#include "bench.hpp"
+#include "vxworks/intrusive_queue.hpp"
+#include "vxworks/object_pool.hpp"
+#include <cstdlib>
+
+using vxbench::report;
+
+namespace
+{
+const size_t window = 64;
+
+struct obj
+    {
+    unsigned long long payload[8];
+    };
+
+/* one thread's live objects, kept apart from its neighbours' */
+struct alignas(64) live
+    {
+    void * slot[window] = {};
+    size_t next = 0;
+    };
+
+/*
+ * Churn through <alloc> and <release>: each call replaces the oldest
+ * object in thread <t>'s window.
+ */
+template <typename Alloc, typename Release>
+void churn(report& r, const vxbench::options& opts, const std::string& name,
+	   Alloc alloc, Release release)
+    {
+    std::vector<live> windows(opts.maxThreads);
+
+    r.latency(name + ".alloc/free", [&]
+	{
+	void * p = alloc();
+	vxbench::keep(p);
+	release(p);
+	});
+    r.throughput(name + ".churn", [&](unsigned t, unsigned)
+	{
+	live& w = windows[t];
+	void *& s = w.slot[w.next++ % window];
+
+	if (s != nullptr)
+	    release(s);
+	s = alloc();
+	return s != nullptr;
+	});
+    for (live& w : windows)
+	for (void * s : w.slot)
+	    if (s != nullptr)
+		release(s);
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("pool", opts);
+    const size_t blocks = 4096;	/* the windows of 64 threads */
+    static vxworks::fixed_pool<obj, blocks> fixed;
+    static vxworks::object_pool<obj, blocks> pool;
+    vxworks::shared_object_pool<obj, blocks> shared("/benchPool");
+
+    churn(r, opts, "malloc", [] { return std::malloc(sizeof(obj)); },
+	  [](void * p) { std::free(p); });
+    churn(r, opts, "fixed_pool", [] { return static_cast<void *>(fixed.make()); },
+	  [](void * p) { fixed.destroy(static_cast<obj *>(p)); });
+    churn(r, opts, "object_pool", [] { return pool.allocate(); },
+	  [](void * p) { pool.deallocate(p); });
+    churn(r, opts, "shared_object_pool", [&] { return shared.pool().allocate(); },
+	  [&](void * p) { shared.pool().deallocate(p); });
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,587 @@
+/* primitives.cpp - microbenchmarks of the vxworks namespace */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures every class in the namespace three ways where it makes sense:
+ * the uncontended cost of an operation, contended throughput across
+ * thread counts, and the latency of waking a pended task. The raw C API
+ * and the standard library are measured alongside as baselines.
+ *
+ * Contended queue runs split the threads into producer/consumer pairs;
+ * with one thread the same task sends and then receives. Pending
+ * operations in contended runs use a short timeout, so that every thread
+ * notices the end of the run.
+ */
+
+#include "bench.hpp"
+#include "vxworks/condition_variable.hpp"
+#include "vxworks/event.hpp"
+#include "vxworks/intrusive_queue.hpp"
+#include "vxworks/mpmc_queue.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/priority_queue.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/shared_mutex.hpp"
+#include "vxworks/wd.hpp"
+#include <taskLib.h>
+#include <sysLib.h>
+#include <memory>
+#include <mutex>
+
+using vxbench::report;
+
+namespace
+{
+struct msg
+    {
+    unsigned long long seq;
+    unsigned long long stamp;
+    };
+
+/* ticks a contended operation may pend before rechecking for the end */
+const _Vx_ticks_t slice = 10000;
+
+/* send on even threads, receive on odd ones, both on a single thread */
+template <typename Send, typename Receive>
+bool pair(unsigned t, unsigned n, Send send, Receive receive)
+    {
+    if (n == 1)
+	return send() && receive();
+    if (t & 1)
+	return receive();
+    send();
+    return false;
+    }
+
+void mutexes(report& r)
+    {
+    vxworks::mutex m;
+    vxworks::mutex qm(vxworks::scalable);
+    vxworks::recursive_mutex rm;
+    vxworks::recursive_mutex qrm(vxworks::scalable);
+    vxworks::timed_mutex tm;
+    vxworks::timed_mutex qtm(vxworks::scalable);
+    std::mutex sm;
+    SEM_ID raw = ::semMCreate(SEM_Q_PRIORITY|SEM_INVERSION_SAFE);
+    unsigned long long counter = 0;
+
+    r.latency("semMTake/semMGive", [&] { ::semMTake(raw, WAIT_FOREVER);
+					 counter++; ::semMGive(raw); });
+    r.latency("mutex.lock", [&] { m.lock(); counter++; m.unlock(); });
+    r.latency("mutex.take_quickly", [&] { m.take_quickly(); counter++;
+					  m.give_quickly(); });
+    r.latency("mutex(scalable).lock", [&] { qm.lock(); counter++; qm.unlock(); });
+    r.latency("recursive_mutex.lock", [&] { rm.lock(); counter++; rm.unlock(); });
+    r.latency("recursive_mutex(scalable).lock", [&] { qrm.lock(); counter++;
+						       qrm.unlock(); });
+    r.latency("timed_mutex.lock", [&] { tm.lock(); counter++; tm.unlock(); });
+    r.latency("timed_mutex(scalable).lock", [&] { qtm.lock(); counter++;
+						   qtm.unlock(); });
+    r.latency("std::mutex.lock", [&] { sm.lock(); counter++; sm.unlock(); });
+
+    r.throughput("mutex.lock", [&](unsigned, unsigned)
+	{ m.lock(); counter++; m.unlock(); return true; });
+    r.throughput("mutex.take_quickly", [&](unsigned, unsigned)
+	{ m.take_quickly(); counter++; m.give_quickly(); return true; });
+    r.throughput("mutex(scalable).lock", [&](unsigned, unsigned)
+	{ std::lock_guard<vxworks::mutex> g(qm); counter++; return true; });
+    r.throughput("recursive_mutex.lock", [&](unsigned, unsigned)
+	{ rm.lock(); counter++; rm.unlock(); return true; });
+    r.throughput("recursive_mutex(scalable).lock", [&](unsigned, unsigned)
+	{ qrm.lock(); counter++; qrm.unlock(); return true; });
+    r.throughput("std::mutex.lock", [&](unsigned, unsigned)
+	{ sm.lock(); counter++; sm.unlock(); return true; });
+
+    vxbench::keep(counter);
+    ::semDelete(raw);
+    }
+
+void shared_mutexes(report& r, vxworks::shared_mutex& sm, const char * kind)
+    {
+    std::string name(kind);
+    unsigned long long counter = 0;
+
+    r.latency(name + ".lock", [&] { sm.lock(); counter++; sm.unlock(); });
+    r.latency(name + ".lock_shared", [&] { sm.lock_shared();
+					       vxbench::keep(counter);
+					       sm.unlock_shared(); });
+    r.throughput(name + ".lock", [&](unsigned, unsigned)
+	{ sm.lock(); counter++; sm.unlock(); return true; });
+    r.throughput(name + ".lock_shared", [&](unsigned, unsigned)
+	{ sm.lock_shared(); vxbench::keep(counter); sm.unlock_shared();
+	  return true; });
+    /* one writer in every four threads */
+    r.throughput(name + ".mixed", [&](unsigned t, unsigned)
+	{
+	if ((t & 3) == 0)
+	    {
+	    sm.lock(); counter++; sm.unlock();
+	    }
+	else
+	    {
+	    sm.lock_shared(); vxbench::keep(counter); sm.unlock_shared();
+	    }
+	return true;
+	});
+    }
+
+void semaphores(report& r)
+    {
+    vxworks::counting_semaphore cs(SEM_Q_PRIORITY, 1);
+    vxworks::binary_semaphore bs(SEM_Q_PRIORITY, SEM_FULL);
+
+    r.latency("counting_semaphore.take/give", [&] { cs.take(WAIT_FOREVER);
+						    cs.give(); });
+    r.latency("binary_semaphore.take/give", [&] { bs.take(WAIT_FOREVER);
+						  bs.give(); });
+    r.throughput("counting_semaphore.take/give", [&](unsigned, unsigned)
+	{ cs.take(WAIT_FOREVER); cs.give(); return true; });
+    r.throughput("binary_semaphore.take/give", [&](unsigned, unsigned)
+	{ bs.take(WAIT_FOREVER); bs.give(); return true; });
+
+    vxworks::binary_semaphore bw;
+    vxworks::counting_semaphore cw(SEM_Q_PRIORITY, 0);
+    r.wakeup("binary_semaphore", [&] { bw.give(); },
+	     [&] { bw.take(WAIT_FOREVER); });
+    r.wakeup("counting_semaphore", [&] { cw.give(); },
+	     [&] { cw.take(WAIT_FOREVER); });
+    }
+
+void events(report& r)
+    {
+    vxworks::event ev;
+    std::atomic<TASK_ID> waiter(TASK_ID_NULL);
+    _Vx_event_t got;
+
+    r.latency("event.send/receive", [&]
+	{
+	ev.send(::taskIdSelf(), VXEV01);
+	ev.receive(VXEV01, EVENTS_WAIT_ANY, NO_WAIT, got);
+	});
+    r.wakeup("event", [&] { ev.send(waiter.load(), VXEV01); },
+	     [&] { ev.receive(VXEV01, EVENTS_WAIT_ANY, WAIT_FOREVER, got); },
+	     [&] { waiter.store(::taskIdSelf()); });
+    }
+
+void condition_variables(report& r)
+    {
+    vxworks::condition_variable cv(CONDVAR_Q_PRIORITY);
+    vxworks::mutex m;
+    bool flag = false;
+
+    r.latency("condition_variable.notify_one", [&] { cv.notify_one(); });
+    r.wakeup("condition_variable",
+	     [&] { m.lock(); flag = true; cv.notify_one(); m.unlock(); },
+	     [&]
+	     {
+	     m.lock();
+	     while (!flag)
+		 cv.wait(m);
+	     flag = false;
+	     m.unlock();
+	     });
+    }
+
+void watchdogs(report& r)
+    {
+    vxworks::wd w;
+    std::atomic<unsigned long long> fired(0);
+    std::vector<unsigned long long> samples;
+    unsigned long long tick = 1000000000ull / ::sysClkRateGet();
+
+    r.latency("wd.start/cancel", [&] { w.start(1000, [] {}); w.cancel(); });
+
+    if (!r.wanted("wd"))
+	return;
+    /* how late the callback runs after the tick it was due */
+    for (unsigned i = 0; i < 1000; i++)
+	{
+	fired.store(0);
+	unsigned long long start = vxbench::now();
+	w.start(100, [&] { fired.store(vxbench::now()); });
+	while (fired.load() == 0)
+	    std::this_thread::yield();
+	unsigned long long due = start + 100 * tick;
+	samples.push_back(fired.load() > due ? fired.load() - due : 0);
+	}
+    r.distribution("wd", "lateness", samples);
+    }
+
+void queues(report& r)
+    {
+    const size_t depth = 64;
+    vxworks::queue<msg> q(depth);
+    vxworks::queue<msg, vxworks::queue_telemetry> tq(depth);
+    vxworks::msgQ raw(depth, sizeof(msg), MSG_Q_FIFO);
+    msg m = {0, 0};
+
+    r.latency("msgQ.send/recieve", [&]
+	{
+	raw.send(reinterpret_cast<char&>(m), sizeof(m));
+	raw.recieve(reinterpret_cast<char&>(m), sizeof(m), WAIT_FOREVER);
+	});
+    r.latency("queue.send/recieve", [&] { q.send(m); q.recieve(m); });
+    r.latency("queue<telemetry>.send/recieve", [&] { tq.send(m); tq.recieve(m); });
+
+    r.throughput("queue", [&](unsigned t, unsigned n)
+	{
+	msg local = {0, 0};
+	return pair(t, n,
+		    [&] { return OK == q.send(local, slice, MSG_PRI_NORMAL); },
+		    [&] { return ERROR != q.recieve(local, slice); });
+	});
+
+    /* the cost of a send to a full queue under each policy; see overload()
+       for the latency a consumer sees */
+    vxworks::queue<msg> full(4);
+    while (full.send(m, NO_WAIT, MSG_PRI_NORMAL) == OK)
+	;
+    r.latency("queue.full.send(NO_WAIT)", [&] { full.send(m, NO_WAIT, MSG_PRI_NORMAL); });
+    full.overflow(vxworks::overflow_policy::drop_newest);
+    r.latency("queue.full.drop_newest", [&] { full.push(m); });
+    full.overflow(vxworks::overflow_policy::drop_oldest);
+    r.latency("queue.full.drop_oldest", [&] { full.push(m); });
+    /* keys are indexed from coalesce_by() on, so fill the queue after it */
+    vxworks::queue<msg> keyed(4);
+    keyed.coalesce_by([](const msg& x) { return x.seq; });
+    for (unsigned i = 0; i < 4; i++)
+	{
+	msg x = {m.seq + i, 0};
+	keyed.send(x, NO_WAIT, MSG_PRI_NORMAL);
+	}
+    r.latency("queue.full.coalesce", [&] { keyed.push(m); });
+
+    vxworks::queue<msg> wq(depth);
+    r.wakeup("queue", [&] { wq.send(m); },
+	     [&] { msg x; wq.recieve(x); });
+    }
+
+/*
+ * A producer sending as fast as it can to a consumer that spends 2 us on
+ * each message, through a queue of 64 under each overflow policy: the
+ * distribution of the time the producer spends in push(), and of the time
+ * from a message being sent to the consumer receiving it, with the number
+ * of messages dropped or coalesced. Coalescing uses 16 keys.
+ */
+void overload(report& r, const vxbench::options& opts)
+    {
+    static const struct
+	{
+	const char * name;
+	vxworks::overflow_policy policy;
+	} policies[] =
+	{
+	{"block", vxworks::overflow_policy::block},
+	{"drop_newest", vxworks::overflow_policy::drop_newest},
+	{"drop_oldest", vxworks::overflow_policy::drop_oldest},
+	{"coalesce", vxworks::overflow_policy::coalesce},
+	};
+    const unsigned messages = static_cast<unsigned>(opts.iterations / 10);
+
+    for (auto& p : policies)
+	{
+	std::string name = std::string("queue.overload.") + p.name;
+	if (!r.wanted(name))
+	    continue;
+
+	vxworks::queue<msg> q(64);
+	if (p.policy == vxworks::overflow_policy::coalesce)
+	    q.coalesce_by([](const msg& x) { return x.seq % 16; });
+	else
+	    q.overflow(p.policy);
+
+	static vxbench::histogram sends;
+	static vxbench::histogram deliveries;
+	sends = vxbench::histogram();
+	deliveries = vxbench::histogram();
+	std::atomic<bool> done(false);
+
+	std::thread consumer([&]
+	    {
+	    msg x;
+	    for (;;)
+		{
+		if (ERROR == q.recieve(x, slice))
+		    {
+		    if (done.load())
+			break;
+		    continue;
+		    }
+		unsigned long long t = vxbench::now();
+		deliveries.record(t - x.stamp);
+		while (vxbench::now() - t < 2000)
+		    ;
+		}
+	    });
+
+	for (unsigned i = 0; i < messages; i++)
+	    {
+	    msg x = {i, vxbench::now()};
+	    q.push(x);
+	    sends.record(vxbench::now() - x.stamp);
+	    }
+	done.store(true);
+	consumer.join();
+
+	r.distribution(name, "send", sends);
+	r.distribution(name, "delivery", deliveries);
+	r.add(name, "dropped", 1, double(q.dropped()), "msgs");
+	}
+    }
+
+void mpmc_queues(report& r)
+    {
+    vxworks::mpmc_queue<msg> q(64);
+    msg m = {0, 0};
+
+    r.latency("mpmc_queue.send/recieve", [&] { q.send(m); q.recieve(m); });
+    r.throughput("mpmc_queue", [&](unsigned t, unsigned n)
+	{
+	msg local = {0, 0};
+	return pair(t, n,
+		    [&] { return OK == q.send(local, slice); },
+		    [&] { return ERROR != q.recieve(local, slice); });
+	});
+
+    vxworks::mpmc_queue<msg> wq(64);
+    r.wakeup("mpmc_queue", [&] { wq.send(m); },
+	     [&] { msg x; wq.recieve(x); });
+    }
+
+void priority_queues(report& r)
+    {
+    vxworks::priority_queue<msg> q(64);
+    msg m = {0, 0};
+    unsigned band = 0;
+
+    r.latency("priority_queue.send/recieve", [&]
+	{
+	q.send(m, band++ & 31);
+	q.recieve(m);
+	});
+    r.throughput("priority_queue", [&](unsigned t, unsigned n)
+	{
+	msg local = {0, 0};
+	return pair(t, n,
+		    [&] { return OK == q.send(local, t & 31, slice); },
+		    [&] { return ERROR != q.recieve(local, slice); });
+	});
+
+    vxworks::priority_queue<msg> wq(64);
+    r.wakeup("priority_queue", [&] { wq.send(m, 0); },
+	     [&] { msg x; wq.recieve(x); });
+    }
+
+/*
+ * Messages in eight priority classes, each producer cycling through them:
+ * through one priority_queue, and through the workaround of one msgQ per
+ * class, with a counting semaphore counting the messages in all of them
+ * and each receive scanning the queues from the most urgent class.
+ */
+void mixed_priorities(report& r)
+    {
+    const unsigned classes = 8;
+    const size_t depth = 64;
+
+    vxworks::priority_queue<msg> pq(depth);
+    r.throughput("priority_queue.mixed", [&](unsigned t, unsigned n)
+	{
+	static thread_local unsigned long long seq;
+	msg local = {0, 0};
+	return pair(t, n,
+		    [&] { return OK == pq.send(local, seq++ % classes, slice); },
+		    [&] { return ERROR != pq.recieve(local, slice); });
+	});
+
+    std::vector<std::unique_ptr<vxworks::queue<msg>>> perClass;
+    for (unsigned c = 0; c < classes; c++)
+	perClass.emplace_back(new vxworks::queue<msg>(depth / classes));
+    vxworks::counting_semaphore pending(SEM_Q_PRIORITY, 0);
+    r.throughput("msgQ-per-class.mixed", [&](unsigned t, unsigned n)
+	{
+	static thread_local unsigned long long seq;
+	msg local = {0, 0};
+	return pair(t, n,
+		    [&]
+		    {
+		    if (OK != perClass[seq++ % classes]->send(local, slice,
+							      MSG_PRI_NORMAL))
+			return false;
+		    pending.give();
+		    return true;
+		    },
+		    [&]
+		    {
+		    if (OK != pending.take(slice))
+			return false;
+		    for (auto& q : perClass)
+			if (ERROR != q->recieve(local, NO_WAIT))
+			    return true;
+		    return false;
+		    });
+	});
+    }
+
+struct node
+    {
+    vxworks::intrusive_hook<node> hook;
+    msg body;
+    };
+
+void intrusive_queues(report& r)
+    {
+    vxworks::intrusive_queue<node, &node::hook> q;
+    static vxworks::fixed_pool<node, 256> pool;
+    node * p = pool.make();
+
+    r.latency("fixed_pool.make/destroy", [&] { pool.destroy(pool.make()); });
+    r.latency("intrusive_queue.push/poll", [&] { q.push(p); p = q.poll(); });
+    r.throughput("intrusive_queue", [&](unsigned t, unsigned n)
+	{
+	node * local;
+	return pair(t, n,
+		    [&]
+		    {
+		    local = pool.make();
+		    if (local == nullptr)
+			{
+			/* out of buffers: let the consumers catch up */
+			std::this_thread::yield();
+			return false;
+			}
+		    q.push(local);
+		    return true;
+		    },
+		    [&]
+		    {
+		    if (OK != q.recieve(local, slice))
+			return false;
+		    pool.destroy(local);
+		    return true;
+		    });
+	});
+    while ((p = q.poll()) != nullptr)
+	pool.destroy(p);
+
+    vxworks::intrusive_queue<node, &node::hook> wq;
+    node * w = pool.make();
+    r.wakeup("intrusive_queue", [&] { wq.push(w); },
+	     [&] { node * x; wq.recieve(x); });
+    pool.destroy(w);
+    }
+
+template <size_t Size> struct buffer
+    {
+    vxworks::intrusive_hook<buffer> hook;
+    unsigned long long payload[Size / sizeof(unsigned long long)];
+    };
+
+/*
+ * Handing a buffer of <Size> bytes from a producer, which stamps it, to a
+ * consumer, which reads the stamp: copied through a queue<M>, and passed
+ * by pointer through an intrusive_queue from a fixed_pool.
+ */
+template <size_t Size> void handoff(report& r, const std::string& size)
+    {
+    typedef buffer<Size> buf;
+    const size_t depth = 16;
+    const size_t last = Size / sizeof(unsigned long long) - 1;
+
+    vxworks::queue<buf> q(depth);
+    static buf local;
+    r.latency("handoff.queue." + size, [&]
+	{
+	local.payload[0] = local.payload[last] = 1;
+	q.send(local);
+	q.recieve(local);
+	vxbench::keep(local.payload[last]);
+	});
+    r.throughput("handoff.queue." + size, [&](unsigned t, unsigned n)
+	{
+	static thread_local buf b;
+	return pair(t, n,
+		    [&]
+		    {
+		    b.payload[0] = b.payload[last] = t;
+		    return OK == q.send(b, slice, MSG_PRI_NORMAL);
+		    },
+		    [&]
+		    {
+		    if (ERROR == q.recieve(b, slice))
+			return false;
+		    vxbench::keep(b.payload[last]);
+		    return true;
+		    });
+	});
+
+    vxworks::intrusive_queue<buf, &buf::hook> iq;
+    static vxworks::fixed_pool<buf, depth> pool;
+    r.latency("handoff.intrusive_queue." + size, [&]
+	{
+	buf * b = pool.make();
+	b->payload[0] = b->payload[last] = 1;
+	iq.push(b);
+	iq.recieve(b);
+	vxbench::keep(b->payload[last]);
+	pool.destroy(b);
+	});
+    r.throughput("handoff.intrusive_queue." + size, [&](unsigned t, unsigned n)
+	{
+	buf * b;
+	return pair(t, n,
+		    [&]
+		    {
+		    b = pool.make();
+		    if (b == nullptr)
+			{
+			std::this_thread::yield();
+			return false;
+			}
+		    b->payload[0] = b->payload[last] = t;
+		    iq.push(b);
+		    return true;
+		    },
+		    [&]
+		    {
+		    if (OK != iq.recieve(b, slice))
+			return false;
+		    vxbench::keep(b->payload[last]);
+		    pool.destroy(b);
+		    return true;
+		    });
+	});
+    for (buf * b; (b = iq.poll()) != nullptr; )
+	pool.destroy(b);
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("primitives", opts);
+
+    vxworks::shared_mutex sm;
+    vxworks::shared_mutex qsm(vxworks::scalable);
+
+    mutexes(r);
+    shared_mutexes(r, sm, "shared_mutex");
+    shared_mutexes(r, qsm, "shared_mutex(scalable)");
+    semaphores(r);
+    events(r);
+    condition_variables(r);
+    watchdogs(r);
+    queues(r);
+    overload(r, opts);
+    mpmc_queues(r);
+    priority_queues(r);
+    mixed_priorities(r);
+    intrusive_queues(r);
+    handoff<1024>(r, "1KiB");
+    handoff<16384>(r, "16KiB");
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,149 @@
+/* rate.cpp - the accuracy and cost of rate limiting at 1k to 1M permits/s */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures, for 1, 2 and 4 tasks taking one permit at a time as fast as
+ * they are given them, at 1k, 10k, 100k and 1M permits per second:
+ *
+ *   rate_limiter	a vxworks::rate_limiter with a burst of a
+ *			millisecond's permits
+ *   semaphore+wd	a vxworks::counting_semaphore that a watchdog
+ *			refills with a millisecond's permits every
+ *			millisecond, as on a 1 kHz system clock
+ *
+ * the error of the rate achieved, in percent of the rate asked for, and the
+ * CPU time of the whole process per permit. The uncontended cost of
+ * rate_limiter::try_acquire() is measured too.
+ */
+
+#include <time.h>
+#include <cmath>
+#include "bench.hpp"
+#include "vxworks/rate_limiter.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/wd.hpp"
+
+using vxbench::report;
+
+namespace
+{
+unsigned long long cputime()
+    {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+/* what is done today: a counting semaphore refilled from a watchdog */
+struct refilled_semaphore
+    {
+    vxworks::counting_semaphore permits;
+    vxworks::wd timer;
+    std::ptrdiff_t per;
+    _Vx_ticks_t period;
+    std::atomic<bool> stopping {false};
+
+    explicit refilled_semaphore(double rate)
+	: per(std::max(1l, std::lround(rate / 1000))),
+	  period(std::max(1, sysClkRateGet() / 1000))
+	{
+	timer.start(period, reinterpret_cast<FUNCPTR>(refill),
+		    reinterpret_cast<_Vx_usr_arg_t>(this));
+	}
+
+    ~refilled_semaphore()
+	{
+	stopping = true;
+	timer.cancel();
+	taskDelay(2 * period);
+	}
+
+    static void refill(refilled_semaphore * s)
+	{
+	if (s->stopping.load())
+	    return;
+	s->permits.release(s->per);
+	s->timer.start(s->period, reinterpret_cast<FUNCPTR>(refill),
+		       reinterpret_cast<_Vx_usr_arg_t>(s));
+	}
+    };
+
+/* record the rate error and CPU per permit of <tasks> calling <take> */
+template <typename Take>
+void limited(report& r, const vxbench::options& opts, const std::string& name,
+	     double rate, unsigned tasks, Take take)
+    {
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long long> total(0);
+    std::vector<std::thread> threads;
+
+    unsigned long long start = vxbench::now();
+    unsigned long long cpu = cputime();
+    for (unsigned t = 0; t < tasks; t++)
+	threads.emplace_back([&]
+	    {
+	    unsigned long long count = 0;
+	    while (!stop.load(std::memory_order_relaxed))
+		if (take())
+		    count++;
+	    total += count;
+	    });
+    std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+    stop = true;
+    for (auto& th : threads)
+	th.join();
+    double elapsed = double(vxbench::now() - start) / 1e9;
+    cpu = cputime() - cpu;
+
+    double achieved = total.load() / elapsed;
+    r.add(name, "error", tasks, 100.0 * std::fabs(achieved - rate) / rate, "%");
+    r.add(name, "cpu", tasks, double(cpu) / std::max(1ull, total.load()), "ns/permit");
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("rate", opts);
+    const char * names[] = {"1k", "10k", "100k", "1M"};
+    double rate = 1000;
+
+    {
+    vxworks::rate_limiter unlimited(1e12, 1000000);
+    r.latency("rate_limiter.try_acquire", [&] { vxbench::keep(unlimited.try_acquire()); });
+    }
+
+    for (const char * n : names)
+	{
+	for (unsigned tasks = 1; tasks <= 4; tasks *= 2)
+	    {
+	    std::string name = std::string("rate_limiter@") + n;
+	    if (r.wanted(name))
+		{
+		vxworks::rate_limiter limit(rate, std::max(1l, std::lround(rate / 1000)));
+		limited(r, opts, name, rate, tasks, [&]
+		    {
+		    return limit.take(1, std::chrono::milliseconds(10)) == OK;
+		    });
+		}
+
+	    name = std::string("semaphore+wd@") + n;
+	    if (r.wanted(name))
+		{
+		refilled_semaphore sem(rate);
+		limited(r, opts, name, rate, tasks, [&]
+		    {
+		    return sem.permits.take(std::chrono::milliseconds(10)) == OK;
+		    });
+		}
+	    }
+	rate *= 10;
+	}
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,119 @@
+/* rcu.cpp - reading an rcu_ptr against a shared_mutex */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Compares the readers of a table held by a vxworks::rcu_ptr with readers
+ * of the same table under a vxworks::shared_mutex, plain and scalable:
+ *
+ *   read		one reader, uncontended
+ *   read		1, 2, 4 ... readers at once
+ *   read+update	as read, with the first thread also replacing the
+ *			table every 4096 reads
+ *
+ * The detector runs on a one tick watchdog for the rcu_ptr runs, and the
+ * number of retired tables left at the end is reported, which should be 0.
+ */
+
+#include "bench.hpp"
+#include "vxworks/rcu_ptr.hpp"
+#include "vxworks/shared_mutex.hpp"
+
+using vxbench::report;
+
+namespace
+{
+struct table
+    {
+    unsigned entries[64];
+    unsigned long long generation;
+    };
+
+unsigned lookup(const table& t, unsigned key)
+    {
+    return t.entries[key & 63];
+    }
+
+void locked(report& r, vxworks::shared_mutex& sm, const std::string& name)
+    {
+    table current = {};
+    std::atomic<unsigned> ops(0);
+
+    r.latency(name + ".read", [&]
+	{
+	sm.lock_shared();
+	vxbench::keep(lookup(current, 7));
+	sm.unlock_shared();
+	});
+    r.throughput(name + ".read", [&](unsigned t, unsigned)
+	{
+	sm.lock_shared();
+	vxbench::keep(lookup(current, t));
+	sm.unlock_shared();
+	return true;
+	});
+    r.throughput(name + ".read+update", [&](unsigned t, unsigned)
+	{
+	if (t == 0 && (ops.fetch_add(1, std::memory_order_relaxed) & 4095) == 0)
+	    {
+	    sm.lock();
+	    current.generation++;
+	    sm.unlock();
+	    }
+	sm.lock_shared();
+	vxbench::keep(lookup(current, t));
+	sm.unlock_shared();
+	return true;
+	});
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("rcu", opts);
+    vxworks::shared_mutex sm;
+    vxworks::shared_mutex qsm(vxworks::scalable);
+    vxworks::rcu_ptr<table> rcu(new table());
+    std::atomic<unsigned> ops(0);
+
+    vxworks::rcu_domain::start_detector(1);
+    r.latency("rcu_ptr.read", [&]
+	{
+	auto g = rcu.read();
+	vxbench::keep(lookup(*g, 7));
+	});
+    r.latency("rcu_ptr.update", [&]
+	{
+	rcu.update(new table(*rcu.read()));
+	});
+    r.throughput("rcu_ptr.read", [&](unsigned t, unsigned)
+	{
+	auto g = rcu.read();
+	vxbench::keep(lookup(*g, t));
+	return true;
+	});
+    r.throughput("rcu_ptr.read+update", [&](unsigned t, unsigned)
+	{
+	if (t == 0 && (ops.fetch_add(1, std::memory_order_relaxed) & 4095) == 0)
+	    {
+	    table * next = new table(*rcu.read());
+	    next->generation++;
+	    rcu.update(next);
+	    }
+	auto g = rcu.read();
+	vxbench::keep(lookup(*g, t));
+	return true;
+	});
+    vxworks::rcu_domain::start_detector(0);
+    rcu.synchronize();
+    r.add("rcu_ptr", "retired", 1, rcu.retired_count(), "versions");
+
+    locked(r, sm, "shared_mutex");
+    locked(r, qsm, "shared_mutex(scalable)");
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,65 @@
+/* registry.cpp - the cost of the object registry */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Built with VX_OBJECT_REGISTRY, so every object registers itself.
+ * Measures what registration adds to creating and deleting an object,
+ * compared with the C API, and how long a snapshot of 10, 100 and 1000
+ * objects takes, with the budget of a 10 Hz poll for comparison.
+ */
+
+#define VX_OBJECT_REGISTRY
+
+#include "bench.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include <memory>
+
+using vxbench::report;
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("registry", opts);
+
+    r.latency("semMCreate/semDelete", [] { ::semDelete(::semMCreate(SEM_Q_PRIORITY)); });
+    r.latency("mutex create/delete", [] { vxworks::mutex m; });
+    r.throughput("mutex create/delete", [](unsigned, unsigned)
+	{
+	vxworks::mutex m;
+	return true;
+	});
+
+    for (size_t n = 10; n <= 1000; n *= 10)
+	{
+	std::vector<std::unique_ptr<vxworks::counting_semaphore> > sems;
+	std::vector<std::unique_ptr<vxworks::queue<int> > > queues;
+	std::vector<vxworks::object_info> info(n);
+	std::string name = "snapshot." + std::to_string(n);
+
+	for (size_t i = 0; i < n / 2; i++)
+	    {
+	    sems.emplace_back(new vxworks::counting_semaphore(SEM_Q_FIFO, 0));
+	    queues.emplace_back(new vxworks::queue<int>(4));
+	    }
+	if (!r.wanted(name))
+	    continue;
+	unsigned long long best = 0;
+	for (int run = 0; run < 5; run++)
+	    {
+	    unsigned long long start = vxbench::now();
+	    vxworks::registry::snapshot(info.data(), info.size());
+	    unsigned long long ns = vxbench::now() - start;
+	    if (run == 0 || ns < best)
+		best = ns;
+	    }
+	r.add(name, "uncontended", 1, double(best), "ns");
+	r.add(name, "10Hz.cpu", 1, best / 100.0, "ppm");
+	}
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,134 @@
+/* ring.cpp - CPU per telemetry sample delivered to 1 to 8 readers */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures the CPU time of the whole process, writer and readers together,
+ * per sample for one writer streaming samples to 1, 2, 4 and 8 reader
+ * threads:
+ *
+ *   ring		a named vxworks::broadcast_ring; the readers take
+ *			batches of up to 64 samples in place and pend with
+ *			wait() when they have caught up. The samples they
+ *			lost to overruns are reported.
+ *   queue		one named vxworks::queue per reader, to each of which
+ *			the writer sends every sample
+ *
+ * Every ring and queue holds 1024 samples of 64 bytes. The writer does not
+ * pace itself, so this is the cost of delivery alone.
+ */
+
+#include <time.h>
+#include <memory>
+#include "bench.hpp"
+#include "vxworks/broadcast_ring.hpp"
+#include "vxworks/queue.hpp"
+
+using vxbench::report;
+
+namespace
+{
+struct sample
+    {
+    unsigned long long seq;
+    double values[7];
+    };
+
+unsigned long long cputime()
+    {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+/* CPU nanoseconds per sample from the first write to the last read */
+template <typename Write, typename Read>
+double deliver(unsigned readers, unsigned samples, Write write, Read read)
+    {
+    std::atomic<unsigned> ready(0);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < readers; t++)
+	threads.emplace_back([&, t] { read(t, ready); });
+    while (ready.load() < readers)
+	std::this_thread::yield();
+
+    unsigned long long start = cputime();
+    for (unsigned i = 1; i <= samples; i++)
+	{
+	sample s = {i, {}};
+	write(s);
+	}
+    for (auto& th : threads)
+	th.join();
+    return double(cputime() - start) / samples;
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("ring", opts);
+    const unsigned samples = opts.iterations;
+
+    for (unsigned n = 1; n <= 8; n *= 2)
+	{
+	if (r.wanted("ring"))
+	    {
+	    vxworks::broadcast_ring<sample> ring(std::string("/bench_ring"), 1024);
+	    std::atomic<unsigned long long> lost(0);
+	    r.add("ring", "cpu", n, deliver(n, samples,
+		[&](const sample& s) { ring.write(s); },
+		[&](unsigned, std::atomic<unsigned>& ready)
+		    {
+		    vxworks::broadcast_ring<sample>::reader rd(ring);
+		    const uint64_t end = ring.published() + samples;
+		    uint64_t next = 0;
+		    double sum = 0;
+		    ready++;
+		    while (next != end)
+			{
+			auto b = rd.read(64);
+			if (b.count == 0)
+			    {
+			    rd.wait();
+			    continue;
+			    }
+			for (size_t i = 0; i < b.count; i++)
+			    sum += b.data[i].values[0];
+			next = b.first + b.count;
+			if (!rd.release(b))
+			    sum = 0;	/* a real reader would discard the batch */
+			}
+		    vxbench::keep(sum);
+		    lost += rd.lost();
+		    }), "ns/sample");
+	    r.add("ring", "lost", n, double(lost.load()), "samples");
+	    }
+
+	if (r.wanted("queue"))
+	    {
+	    std::vector<std::unique_ptr<vxworks::queue<sample>>> queues;
+	    for (unsigned t = 0; t < n; t++)
+		queues.emplace_back(new vxworks::queue<sample>(
+		    std::string("/bench_telem") + std::to_string(t), 1024));
+	    r.add("queue", "cpu", n, deliver(n, samples,
+		[&](sample& s) { for (auto& q : queues) q->send(s); },
+		[&](unsigned t, std::atomic<unsigned>& ready)
+		    {
+		    sample s = {};
+		    double sum = 0;
+		    ready++;
+		    while (s.seq != samples && queues[t]->recieve(s) != ERROR)
+			sum += s.values[0];
+		    vxbench::keep(sum);
+		    }), "ns/sample");
+	    }
+	}
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,200 @@
+/* stop.cpp - shutting down 1000 blocked tasks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Blocks 1000 tasks, then stops them all, and measures the time from the
+ * stop to the last task's exit, and the CPU time the process spent per
+ * second while they were blocked:
+ *
+ *   queue		each task in vxworks::queue::recieve() on a queue of
+ *			its own, given a vxworks::stop_token
+ *   semaphore		each task in counting_semaphore::take() on a semaphore
+ *			of its own, given the token
+ *   event		each task in event::receive(), given the token
+ *   condvar		every task in condition_variable::wait() on one
+ *			variable, given the token
+ *   queue(poll)	each task in recieve() on a queue of its own with a
+ *			10 ms timeout, checking a flag between receives, as
+ *			is done without tokens
+ *
+ * and then with every task waiting on one object, with which only one task
+ * at a time can register for events, or which sends none:
+ *
+ *   queue(shared)	every task in recieve() on one empty queue
+ *   queue.send(shared)	every task in send() to one full queue
+ *   semaphore(shared)	every task in take() on one semaphore
+ *   mutex(shared)	every task in lock() of one mutex held by main()
+ *   mutex.scalable(shared)
+ *			the same for a mutex taken on the scalable path
+ */
+
+#include <time.h>
+#include <memory>
+#include "bench.hpp"
+#include "vxworks/condition_variable.hpp"
+#include "vxworks/event.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/stop_token.hpp"
+
+using vxbench::report;
+
+namespace
+{
+const unsigned tasks = 1000;
+const unsigned long long idle_ns = 100000000ull;
+
+unsigned long long cputime()
+    {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+/* block <tasks> tasks in <block(index, token)>, then stop them with <stop> */
+template <typename Block, typename Stop>
+void shutdown(report& r, const std::string& name, Block block, Stop stop)
+    {
+    vxworks::stop_source source;
+    std::atomic<unsigned> started(0);
+    std::vector<std::thread> threads;
+
+    if (!r.wanted(name))
+	return;
+    for (unsigned t = 0; t < tasks; t++)
+	threads.emplace_back([&, t]
+	    {
+	    started++;
+	    block(t, source.get_token());
+	    });
+    while (started.load() < tasks)
+	std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    unsigned long long cpu = cputime();
+    std::this_thread::sleep_for(std::chrono::nanoseconds(idle_ns));
+    cpu = cputime() - cpu;
+
+    unsigned long long start = vxbench::now();
+    stop(source);
+    for (auto& th : threads)
+	th.join();
+    r.add(name, "shutdown", tasks, double(vxbench::now() - start) / 1000, "us");
+    r.add(name, "idle_cpu", tasks, double(cpu) * 1000 / idle_ns, "ms/s");
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("stop", opts);
+    auto request = [](vxworks::stop_source& s) { s.request_stop(); };
+
+    {
+    std::vector<std::unique_ptr<vxworks::queue<int>>> queues;
+    for (unsigned t = 0; t < tasks; t++)
+	queues.emplace_back(new vxworks::queue<int>(4));
+    shutdown(r, "queue", [&](unsigned t, vxworks::stop_token st)
+	{
+	int m;
+	while (queues[t]->recieve(m, st) != ERROR)
+	    ;
+	}, request);
+
+    std::atomic<bool> closing(false);
+    shutdown(r, "queue(poll)", [&](unsigned t, vxworks::stop_token)
+	{
+	int m;
+	while (!closing.load())
+	    queues[t]->recieve(m, std::chrono::milliseconds(10));
+	}, [&](vxworks::stop_source&) { closing = true; });
+    }
+
+    {
+    std::vector<std::unique_ptr<vxworks::counting_semaphore>> sems;
+    for (unsigned t = 0; t < tasks; t++)
+	sems.emplace_back(new vxworks::counting_semaphore(0));
+    shutdown(r, "semaphore", [&](unsigned t, vxworks::stop_token st)
+	{
+	while (sems[t]->take(st) == OK)
+	    ;
+	}, request);
+    }
+
+    shutdown(r, "event", [&](unsigned, vxworks::stop_token st)
+	{
+	vxworks::event ev;
+	while (ev.receive(VXEV01, EVENTS_WAIT_ANY, st) == OK)
+	    ;
+	}, request);
+
+    {
+    vxworks::timed_mutex m;
+    vxworks::condition_variable cv(CONDVAR_Q_PRIORITY);
+    shutdown(r, "condvar", [&](unsigned, vxworks::stop_token st)
+	{
+	m.lock();
+	cv.wait(m, st, [] { return false; });
+	m.unlock();
+	}, request);
+    }
+
+    {
+    vxworks::queue<int> q(4);
+    shutdown(r, "queue(shared)", [&](unsigned, vxworks::stop_token st)
+	{
+	int m;
+	while (q.recieve(m, st) != ERROR)
+	    ;
+	}, request);
+
+    int m = 0;
+    while (q.send(m, NO_WAIT, MSG_PRI_NORMAL) == OK)
+	;
+    shutdown(r, "queue.send(shared)", [&](unsigned, vxworks::stop_token st)
+	{
+	int n = 0;
+	q.send(n, st);
+	}, request);
+    }
+
+    {
+    vxworks::counting_semaphore sem(0);
+    shutdown(r, "semaphore(shared)", [&](unsigned, vxworks::stop_token st)
+	{
+	while (sem.take(st) == OK)
+	    ;
+	}, request);
+    }
+
+    {
+    vxworks::mutex m;
+    vxworks::mutex fast(vxworks::scalable);
+    auto block = [](vxworks::mutex& x, vxworks::stop_token st)
+	{
+	if (x.lock(st) == OK)
+	    x.unlock();
+	};
+
+    m.lock();
+    shutdown(r, "mutex(shared)", [&](unsigned, vxworks::stop_token st)
+	{
+	block(m, st);
+	}, request);
+    m.unlock();
+
+    fast.lock();
+    shutdown(r, "mutex.scalable(shared)", [&](unsigned, vxworks::stop_token st)
+	{
+	block(fast, st);
+	}, request);
+    fast.unlock();
+    }
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
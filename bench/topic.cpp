@@ -0,0 +1,122 @@
+/* topic.cpp - fanning a message out to 1 to 32 subscribers */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures the time per message for one publisher to deliver a stream of
+ * messages to 1, 2, 4 ... 32 subscriber threads, until every subscriber has
+ * received the last one:
+ *
+ *   topic		a vxworks::topic with block subscribers, so that no
+ *			message is lost
+ *   topic(drop)	the same with drop subscribers; the messages they
+ *			missed are reported
+ *   queue		one vxworks::queue per subscriber, to each of which
+ *			the publisher sends every message
+ *
+ * Every ring and queue holds 64 messages of 64 bytes.
+ */
+
+#include <memory>
+#include "bench.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/topic.hpp"
+
+using vxbench::report;
+
+namespace
+{
+struct sample
+    {
+    unsigned long long seq;
+    double values[7];
+    };
+
+/* nanoseconds per message from the first publish to the last receive */
+template <typename Publish, typename Subscribe>
+double fanout(unsigned subscribers, unsigned messages, Publish publish,
+	      Subscribe subscribe)
+    {
+    std::atomic<unsigned> ready(0);
+    std::vector<std::thread> threads;
+
+    for (unsigned s = 0; s < subscribers; s++)
+	threads.emplace_back([&, s] { subscribe(s, ready); });
+    while (ready.load() < subscribers)
+	std::this_thread::yield();
+
+    unsigned long long start = vxbench::now();
+    for (unsigned i = 1; i <= messages; i++)
+	{
+	sample m = {i, {}};
+	publish(m);
+	}
+    for (auto& th : threads)
+	th.join();
+    return double(vxbench::now() - start) / messages;
+    }
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("topic", opts);
+    const unsigned messages = opts.iterations / 10;
+
+    for (unsigned n = 1; n <= 32; n *= 2)
+	{
+	if (r.wanted("topic"))
+	    {
+	    vxworks::topic<sample> t(64);
+	    r.add("topic", "fanout", n, fanout(n, messages,
+		[&](const sample& m) { t.publish(m); },
+		[&](unsigned, std::atomic<unsigned>& ready)
+		    {
+		    vxworks::topic<sample>::subscriber s(t, vxworks::subscriber_policy::block);
+		    sample m = {};
+		    ready++;
+		    while (m.seq != messages && s.receive(m) == OK)
+			;
+		    }), "ns/msg");
+	    }
+
+	if (r.wanted("topic(drop)"))
+	    {
+	    vxworks::topic<sample> t(64);
+	    std::atomic<unsigned long long> dropped(0);
+	    r.add("topic(drop)", "fanout", n, fanout(n, messages,
+		[&](const sample& m) { t.publish(m); },
+		[&](unsigned, std::atomic<unsigned>& ready)
+		    {
+		    vxworks::topic<sample>::subscriber s(t, vxworks::subscriber_policy::drop);
+		    sample m = {};
+		    ready++;
+		    while (m.seq != messages && s.receive(m) == OK)
+			;
+		    dropped += s.dropped();
+		    }), "ns/msg");
+	    r.add("topic(drop)", "dropped", n, double(dropped.load()), "msgs");
+	    }
+
+	if (r.wanted("queue"))
+	    {
+	    std::vector<std::unique_ptr<vxworks::queue<sample>>> queues;
+	    for (unsigned s = 0; s < n; s++)
+		queues.emplace_back(new vxworks::queue<sample>(64));
+	    r.add("queue", "fanout", n, fanout(n, messages,
+		[&](sample& m) { for (auto& q : queues) q->send(m); },
+		[&](unsigned s, std::atomic<unsigned>& ready)
+		    {
+		    sample m = {};
+		    ready++;
+		    while (m.seq != messages && queues[s]->recieve(m) != ERROR)
+			;
+		    }), "ns/msg");
+	    }
+	}
+
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,91 @@
+/* trace.cpp - the cost of the synchronization event trace */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Built with VX_OBJECT_TRACE, so every operation is recorded. Measures the
+ * cost of one trace record on its own, with and without reading the clock,
+ * and what recording adds to a mutex lock/unlock pair, a semaphore
+ * give/take pair and a queue send/receive pair compared with the same
+ * calls made through the C API, which are not traced.
+ */
+
+#define VX_OBJECT_TRACE
+
+#include "bench.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+
+using vxbench::report;
+using vxworks::trace;
+using vxworks::trace_op;
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("trace", opts);
+    vxworks::mutex m;
+    vxworks::binary_semaphore b;
+    vxworks::queue<int> q(16);
+    SEM_ID sem = ::semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+    SEM_ID bsem = ::semBCreate(SEM_Q_FIFO, SEM_EMPTY);
+    int msg = 0;
+
+    r.latency("trace::now", [] { vxbench::keep(trace::now()); });
+    r.latency("trace::record", [&]
+	{
+	trace::record(trace_op::lock, (uintptr_t) sem, OK);
+	});
+    r.latency("trace::record(stamped)", [&]
+	{
+	trace::record(trace_op::lock, (uintptr_t) sem, OK, 0);
+	});
+    r.throughput("trace::record", [&](unsigned, unsigned)
+	{
+	trace::record(trace_op::lock, (uintptr_t) sem, OK);
+	return true;
+	});
+
+    r.latency("semMTake/semMGive", [&]
+	{
+	::semMTake(sem, WAIT_FOREVER);
+	::semMGive(sem);
+	});
+    r.latency("mutex lock/unlock", [&]
+	{
+	m.lock();
+	m.unlock();
+	});
+    r.latency("semBGive/semBTake", [&]
+	{
+	::semBGive(bsem);
+	::semBTake(bsem, WAIT_FOREVER);
+	});
+    r.latency("binary_semaphore give/take", [&]
+	{
+	b.give();
+	b.take(WAIT_FOREVER);
+	});
+    r.latency("msgQSend/msgQReceive", [&]
+	{
+	::msgQSend(q.handle(), reinterpret_cast<char *>(&msg), sizeof(msg),
+		   WAIT_FOREVER, MSG_PRI_NORMAL);
+	::msgQReceive(q.handle(), reinterpret_cast<char *>(&msg), sizeof(msg),
+		      WAIT_FOREVER);
+	});
+    r.latency("queue send/receive", [&]
+	{
+	q.send(msg);
+	q.recieve(msg);
+	});
+
+    std::vector<vxworks::trace_record> all = trace::collect();
+    r.add("trace::collect", "records", 1, double(all.size()), "records");
+    ::semDelete(bsem);
+    ::semDelete(sem);
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
@@ -0,0 +1,120 @@
+/* wakeup.cpp - interrupt-to-task wake-up latency */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Measures how long a task pended on each of the signalling classes
+ * takes to run after a watchdog routine, standing in for an interrupt
+ * service routine, signals it. Each sample arms a vxworks::wd, pends, and
+ * records the time from the moment the watchdog routine signals until the
+ * task resumes into an HDR-style histogram; p50, p99, p99.9 and the
+ * maximum are reported for each class.
+ *
+ * On a host the watchdog routine runs on a simulation thread rather than
+ * at interrupt level, so the figures compare the classes with each other
+ * rather than predict target latencies. Run with -l to turn the program
+ * into an acceptance test: it exits with status 1 if any p99 is over the
+ * limit.
+ */
+
+#include "bench.hpp"
+#include "vxworks/event.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/wd.hpp"
+#include <taskLib.h>
+
+using vxbench::report;
+
+namespace
+{
+/* what the watchdog routine does, and when it did it */
+struct source
+    {
+    std::atomic<unsigned long long> stamp;
+    void (*signal)(source *);
+    void * target;
+    TASK_ID task;
+    };
+
+/* the watchdog routine: stamp the time, then signal the task */
+void fire(_Vx_usr_arg_t arg)
+    {
+    source * s = reinterpret_cast<source *>(arg);
+
+    s->stamp.store(vxbench::now(), std::memory_order_release);
+    s->signal(s);
+    }
+
+/* run <samples> interrupt-to-task wake-ups through <wait> */
+template <typename Wait>
+void measure(report& r, const vxbench::options& opts, const char * name,
+	     void (*signal)(source *), void * target, Wait wait)
+    {
+    vxworks::wd w;
+    vxbench::histogram h;
+    source s;
+    /* long enough for the task to pend before the routine runs */
+    _Vx_ticks_t delay = std::max<_Vx_ticks_t>(1,
+			    vxworks::chrono2tic(std::chrono::milliseconds(1)));
+
+    if (!r.wanted(name))
+	return;
+    s.signal = signal;
+    s.target = target;
+    std::thread task([&]
+	{
+	s.task = ::taskIdSelf();
+	for (unsigned i = 0; i < opts.samples; i++)
+	    {
+	    w.start(delay, reinterpret_cast<FUNCPTR>(fire),
+		    reinterpret_cast<_Vx_usr_arg_t>(&s));
+	    wait();
+	    h.record(vxbench::now() - s.stamp.load(std::memory_order_acquire));
+	    }
+	});
+    task.join();
+    r.distribution(name, "wakeup", h);
+    }
+
+struct msg
+    {
+    unsigned long long seq;
+    };
+}
+
+int main(int argc, char ** argv)
+    {
+    vxbench::options opts(argc, argv);
+    report r("wakeup", opts);
+    vxworks::binary_semaphore bs;
+    vxworks::counting_semaphore cs(SEM_Q_PRIORITY, 0);
+    vxworks::queue<msg> q(16);
+    vxworks::event ev;
+    _Vx_event_t got;
+    msg m = {0};
+
+    measure(r, opts, "event",
+	    [](source * s) { ::eventSend(s->task, VXEV01); }, nullptr,
+	    [&] { ev.receive(VXEV01, EVENTS_WAIT_ANY, WAIT_FOREVER, got); });
+    measure(r, opts, "binary_semaphore",
+	    [](source * s)
+		{ static_cast<vxworks::binary_semaphore *>(s->target)->give(); },
+	    &bs, [&] { bs.take(WAIT_FOREVER); });
+    measure(r, opts, "counting_semaphore",
+	    [](source * s)
+		{ static_cast<vxworks::counting_semaphore *>(s->target)->give(); },
+	    &cs, [&] { cs.take(WAIT_FOREVER); });
+    measure(r, opts, "queue",
+	    [](source * s)
+		{
+		msg sent = {0};
+		static_cast<vxworks::queue<msg> *>(s->target)->send(sent, NO_WAIT,
+								    MSG_PRI_NORMAL);
+		},
+	    &q, [&] { q.recieve(m); });
+    r.write(stdout);
+    return r.failed() ? 1 : 0;
+    }
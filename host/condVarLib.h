@@ -0,0 +1,152 @@
+/* condVarLib.h - host simulation of the condition variable library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCcondVarLibh
+#define __INCcondVarLibh
+
+#include <vxWorks.h>
+#include <semLib.h>
+#include <private/hostLibP.h>
+#include <algorithm>
+#include <deque>
+
+typedef struct vxhost_condVar * CONDVAR_ID;
+#define CONDVAR_ID_NULL	((CONDVAR_ID) 0)
+
+#define CONDVAR_Q_FIFO			0x0
+#define CONDVAR_Q_PRIORITY		0x1
+#define CONDVAR_INTERRUPTIBLE		0x2
+#define CONDVAR_KERNEL_INTERRUPTIBLE	0x4
+#define CONDVAR_TASK_DELETION_WAKEUP	0x8
+
+struct vxhost_condVar : vxhost_obj
+    {
+    int				options;
+    std::deque<bool *>		waiters;	/* the woken flags of pended tasks */
+    std::mutex			lock;
+    std::condition_variable	cv;
+
+    explicit vxhost_condVar (int opt) :
+	vxhost_obj (vxhost::CLASS_CONDVAR), options (opt) {}
+    ~vxhost_condVar () { vxhost::retire (*this, lock, cv); }
+    };
+
+inline CONDVAR_ID condVarCreate (int options)
+    {
+    return new vxhost_condVar (options);
+    }
+
+inline STATUS condVarDelete (CONDVAR_ID condVarId)
+    {
+    if (condVarId == CONDVAR_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    delete condVarId;
+    return OK;
+    }
+
+inline CONDVAR_ID condVarOpen (const char * name, int options, int mode,
+			       void * context)
+    {
+    (void) context;
+    if (name == nullptr || *name == '\0')
+	return condVarCreate (options);
+    return vxhost::open<vxhost_condVar> (name, vxhost::CLASS_CONDVAR, mode,
+	[&] { return condVarCreate (options); });
+    }
+
+inline STATUS condVarClose (CONDVAR_ID condVarId)
+    {
+    return vxhost::close (condVarId);
+    }
+
+inline STATUS condVarUnlink (const char * name)
+    {
+    return vxhost::unlink (name, vxhost::CLASS_CONDVAR);
+    }
+
+/*
+ * Atomically give <mutexId> and pend on the condition variable. Each waiter
+ * queues its own flag, so a signal or broadcast wakes only the tasks already
+ * waiting, as on a target, and not a task that waits after it. The mutex is
+ * retaken even if the condition variable is deleted meanwhile.
+ */
+
+inline STATUS condVarWait (CONDVAR_ID condVarId, SEM_ID mutexId,
+			   _Vx_ticks_t timeout)
+    {
+    bool ok;
+    bool deleted;
+    bool woken = false;
+
+    if (condVarId == CONDVAR_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::unique_lock<std::mutex> lk (condVarId->lock);
+    if (semMGive (mutexId) != OK)
+	return ERROR;
+    vxhost::pending p (*condVarId);
+    condVarId->waiters.push_back (&woken);
+    ok = vxhost::waitFor (lk, condVarId->cv, timeout,
+			  [&] { return woken || condVarId->deleted; });
+    if (!woken)
+	{
+	auto & w = condVarId->waiters;
+	w.erase (std::find (w.begin (), w.end (), &woken));
+	}
+    deleted = condVarId->deleted;
+    }
+    if (semMTake (mutexId, WAIT_FOREVER) != OK)
+	return ERROR;
+    if (deleted)
+	{
+	errno = S_objLib_OBJ_DELETED;
+	return ERROR;
+	}
+    return ok ? OK : ERROR;
+    }
+
+inline STATUS condVarSignal (CONDVAR_ID condVarId)
+    {
+    if (condVarId == CONDVAR_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (condVarId->lock);
+    if (condVarId->waiters.empty ())
+	return OK;
+    *condVarId->waiters.front () = true;
+    condVarId->waiters.pop_front ();
+    }
+    condVarId->cv.notify_all ();
+    return OK;
+    }
+
+inline STATUS condVarBroadcast (CONDVAR_ID condVarId)
+    {
+    if (condVarId == CONDVAR_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (condVarId->lock);
+    for (bool * w : condVarId->waiters)
+	*w = true;
+    condVarId->waiters.clear ();
+    }
+    condVarId->cv.notify_all ();
+    return OK;
+    }
+
+#endif /* __INCcondVarLibh */
@@ -0,0 +1,121 @@
+/* eventLib.h - host simulation of the event library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCeventLibh
+#define __INCeventLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+#define VXEV01	0x00000001
+#define VXEV02	0x00000002
+#define VXEV03	0x00000004
+#define VXEV04	0x00000008
+#define VXEV05	0x00000010
+#define VXEV06	0x00000020
+#define VXEV07	0x00000040
+#define VXEV08	0x00000080
+#define VXEV09	0x00000100
+#define VXEV10	0x00000200
+#define VXEV11	0x00000400
+#define VXEV12	0x00000800
+#define VXEV13	0x00001000
+#define VXEV14	0x00002000
+#define VXEV15	0x00004000
+#define VXEV16	0x00008000
+#define VXEV17	0x00010000
+#define VXEV18	0x00020000
+#define VXEV19	0x00040000
+#define VXEV20	0x00080000
+#define VXEV21	0x00100000
+#define VXEV22	0x00200000
+#define VXEV23	0x00400000
+#define VXEV24	0x00800000
+
+/* eventReceive() options */
+
+#define EVENTS_WAIT_ALL			0x0
+#define EVENTS_WAIT_ANY			0x1
+#define EVENTS_RETURN_ALL		0x2
+#define EVENTS_KEEP_UNWANTED		0x4
+#define EVENTS_FETCH			0x80
+#define EVENTS_Q_INTERRUPTIBLE		0x10000
+#define EVENTS_TASK_DELETION_WAKEUP	0x20000
+
+/* resource registration options */
+
+#define EVENTS_OPTIONS_NONE		0x0
+#define EVENTS_SEND_ONCE		0x1
+#define EVENTS_ALLOW_OVERWRITE		0x2
+#define EVENTS_SEND_IF_FREE		0x4
+
+inline STATUS eventSend (TASK_ID taskId, _Vx_event_t events)
+    {
+    return vxhost::eventSend (taskId, events);
+    }
+
+inline STATUS eventReceiveEx (_Vx_event_t events, _Vx_UINT32 options,
+			      _Vx_ticks_t timeout,
+			      _Vx_event_t * pEventsReceived)
+    {
+    TASK_ID self = vxhost::self ();
+    std::unique_lock<std::mutex> lk (self->lock);
+    bool any = (options & EVENTS_WAIT_ANY) != 0;
+
+    if (options & EVENTS_FETCH)
+	{
+	if (pEventsReceived != nullptr)
+	    *pEventsReceived = self->events;
+	return OK;
+	}
+
+    if (events == 0)
+	{
+	if (pEventsReceived != nullptr)
+	    *pEventsReceived = 0;
+	return OK;
+	}
+
+    bool ok = vxhost::waitFor (lk, self->cv, timeout,
+	[&] { return any ? (self->events & events) != 0 :
+			   (self->events & events) == events; },
+	S_eventLib_TIMEOUT);
+
+    if (!ok && timeout == NO_WAIT)
+	errno = S_eventLib_NOT_ALL_EVENTS;
+
+    if (pEventsReceived != nullptr)
+	*pEventsReceived = (options & EVENTS_RETURN_ALL) ?
+	    self->events : (self->events & events);
+
+    if (!ok)
+	return ERROR;
+
+    if (options & EVENTS_RETURN_ALL)
+	self->events = 0;
+    else if (options & EVENTS_KEEP_UNWANTED)
+	self->events &= ~events;
+    else
+	self->events = 0;
+    return OK;
+    }
+
+inline STATUS eventReceive (_Vx_event_t events, UINT8 options,
+			    _Vx_ticks_t timeout, _Vx_event_t * pEventsReceived)
+    {
+    return eventReceiveEx (events, options, timeout, pEventsReceived);
+    }
+
+inline STATUS eventClear (void)
+    {
+    TASK_ID self = vxhost::self ();
+    std::lock_guard<std::mutex> g (self->lock);
+
+    self->events = 0;
+    return OK;
+    }
+
+#endif /* __INCeventLibh */
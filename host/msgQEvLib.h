@@ -0,0 +1,60 @@
+/* msgQEvLib.h - host simulation of message queue event registration */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCmsgQEvLibh
+#define __INCmsgQEvLibh
+
+#include <msgQLib.h>
+#include <eventLib.h>
+
+/* register the calling task to receive <events> when a message arrives */
+
+inline STATUS msgQEvStart (MSG_Q_ID msgQId, _Vx_event_t events, UINT8 options)
+    {
+    TASK_ID self = vxhost::self ();
+    bool now;
+
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (msgQId->lock);
+    if (msgQId->ev.task != TASK_ID_NULL && msgQId->ev.task != self &&
+	!(options & EVENTS_ALLOW_OVERWRITE))
+	{
+	errno = S_eventLib_ALREADY_REGISTERED;
+	return ERROR;
+	}
+    msgQId->ev.task = self;
+    msgQId->ev.events = events;
+    msgQId->ev.options = options;
+    now = (options & EVENTS_SEND_IF_FREE) && !msgQId->msgs.empty ();
+    if (now)
+	msgQId->ev.notify ();
+    }
+    return OK;
+    }
+
+inline STATUS msgQEvStop (MSG_Q_ID msgQId)
+    {
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    std::lock_guard<std::mutex> g (msgQId->lock);
+    if (msgQId->ev.task != vxhost::self ())
+	{
+	errno = S_eventLib_ALREADY_REGISTERED;
+	return ERROR;
+	}
+    msgQId->ev.task = TASK_ID_NULL;
+    return OK;
+    }
+
+#endif /* __INCmsgQEvLibh */
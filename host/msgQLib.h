@@ -0,0 +1,192 @@
+/* msgQLib.h - host simulation of the message queue library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCmsgQLibh
+#define __INCmsgQLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+#include <deque>
+#include <vector>
+
+typedef struct vxhost_msgQ * MSG_Q_ID;
+#define MSG_Q_ID_NULL	((MSG_Q_ID) 0)
+
+#define MSG_Q_FIFO		0x00
+#define MSG_Q_PRIORITY		0x01
+#define MSG_Q_EVENTSEND_ERR_NOTIFY 0x02
+#define MSG_Q_INTERRUPTIBLE	0x04
+
+#define MSG_PRI_NORMAL		0
+#define MSG_PRI_URGENT		1
+
+struct vxhost_msgQ : vxhost_obj
+    {
+    size_t				maxMsgs;
+    size_t				maxMsgLength;
+    int					options;
+    std::deque<std::vector<char> >	msgs;
+    std::mutex				lock;
+    std::condition_variable		notEmpty;
+    std::condition_variable		notFull;
+    vxhost::evReg			ev;
+
+    vxhost_msgQ (size_t n, size_t len, int opt) :
+	vxhost_obj (vxhost::CLASS_MSGQ), maxMsgs (n), maxMsgLength (len),
+	options (opt) {}
+    ~vxhost_msgQ () { vxhost::retire (*this, lock, notEmpty, notFull); }
+    };
+
+inline MSG_Q_ID msgQCreate (size_t maxMsgs, size_t maxMsgLength, int options)
+    {
+    if (maxMsgs == 0)
+	{
+	errno = S_msgQLib_INVALID_MSG_LENGTH;
+	return MSG_Q_ID_NULL;
+	}
+    return new vxhost_msgQ (maxMsgs, maxMsgLength, options);
+    }
+
+inline STATUS msgQDelete (MSG_Q_ID msgQId)
+    {
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    delete msgQId;
+    return OK;
+    }
+
+inline MSG_Q_ID msgQOpen (const char * name, size_t maxMsgs,
+			  size_t maxMsgLength, int options, int mode,
+			  void * context)
+    {
+    (void) context;
+    if (name == nullptr || *name == '\0')
+	return msgQCreate (maxMsgs, maxMsgLength, options);
+    return vxhost::open<vxhost_msgQ> (name, vxhost::CLASS_MSGQ, mode,
+	[&] { return msgQCreate (maxMsgs, maxMsgLength, options); });
+    }
+
+inline STATUS msgQClose (MSG_Q_ID msgQId)
+    {
+    return vxhost::close (msgQId);
+    }
+
+inline STATUS msgQUnlink (const char * name)
+    {
+    return vxhost::unlink (name, vxhost::CLASS_MSGQ);
+    }
+
+inline STATUS msgQSend (MSG_Q_ID msgQId, char * buffer, size_t nBytes,
+			_Vx_ticks_t timeout, int priority)
+    {
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    if (nBytes > msgQId->maxMsgLength)
+	{
+	errno = S_msgQLib_INVALID_MSG_LENGTH;
+	return ERROR;
+	}
+    {
+    std::unique_lock<std::mutex> lk (msgQId->lock);
+    vxhost::pending p (*msgQId);
+    if (!vxhost::waitFor (lk, msgQId->notFull, timeout,
+		[&] { return msgQId->msgs.size () < msgQId->maxMsgs ||
+			     msgQId->deleted; }) ||
+	msgQId->gone ())
+	return ERROR;
+    if (priority == MSG_PRI_URGENT)
+	msgQId->msgs.emplace_front (buffer, buffer + nBytes);
+    else
+	msgQId->msgs.emplace_back (buffer, buffer + nBytes);
+    msgQId->ev.notify ();
+    }
+    msgQId->notEmpty.notify_one ();
+    return OK;
+    }
+
+inline ssize_t msgQReceive (MSG_Q_ID msgQId, char * buffer, size_t maxNBytes,
+			    _Vx_ticks_t timeout)
+    {
+    size_t n;
+
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::unique_lock<std::mutex> lk (msgQId->lock);
+    vxhost::pending p (*msgQId);
+    if (!vxhost::waitFor (lk, msgQId->notEmpty, timeout,
+			  [&] { return !msgQId->msgs.empty () ||
+				       msgQId->deleted; }) ||
+	msgQId->gone ())
+	return ERROR;
+    std::vector<char> & msg = msgQId->msgs.front ();
+    n = msg.size () < maxNBytes ? msg.size () : maxNBytes;
+    if (n > 0)
+	memcpy (buffer, msg.data (), n);
+    msgQId->msgs.pop_front ();
+    }
+    msgQId->notFull.notify_one ();
+    return static_cast<ssize_t> (n);
+    }
+
+inline ssize_t msgQNumMsgs (MSG_Q_ID msgQId)
+    {
+    if (msgQId == MSG_Q_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    std::lock_guard<std::mutex> g (msgQId->lock);
+    return static_cast<ssize_t> (msgQId->msgs.size ());
+    }
+
+/* message queue information; the task and message lists are not filled in */
+
+typedef struct
+    {
+    int		numMsgs;
+    int		numTasks;
+    int		sendTimeouts;
+    int		recvTimeouts;
+    int		options;
+    int		maxMsgs;
+    int		maxMsgLength;
+    int		taskIdListMax;
+    TASK_ID *	taskIdList;
+    int		msgListMax;
+    char **	msgPtrList;
+    int *	msgLenList;
+    } MSG_Q_INFO;
+
+inline STATUS msgQInfoGet (MSG_Q_ID msgQId, MSG_Q_INFO * pInfo)
+    {
+    if (msgQId == MSG_Q_ID_NULL || msgQId->cls != vxhost::CLASS_MSGQ ||
+	pInfo == nullptr)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    std::lock_guard<std::mutex> g (msgQId->lock);
+    pInfo->numMsgs = static_cast<int> (msgQId->msgs.size ());
+    pInfo->numTasks = msgQId->pended;
+    pInfo->sendTimeouts = 0;
+    pInfo->recvTimeouts = 0;
+    pInfo->options = msgQId->options;
+    pInfo->maxMsgs = static_cast<int> (msgQId->maxMsgs);
+    pInfo->maxMsgLength = static_cast<int> (msgQId->maxMsgLength);
+    return OK;
+    }
+
+#endif /* __INCmsgQLibh */
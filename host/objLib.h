@@ -0,0 +1,64 @@
+/* objLib.h - host simulation of the generic object library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCobjLibh
+#define __INCobjLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+#include <cstdio>
+
+/* print the class and name of an object */
+
+inline STATUS objShow (OBJ_ID objId, int showType)
+    {
+    static const char * const cls [] =
+	{ "semaphore", "message queue", "watchdog", "condition variable",
+	  "shared data" };
+
+    (void) showType;
+    if (objId == nullptr)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    printf ("%-20s %p \"%s\"\n", cls [objId->cls], (void *) objId,
+	    objId->name.c_str ());
+    return OK;
+    }
+
+inline STATUS objShowAll (OBJ_ID objId, int showType)
+    {
+    return objShow (objId, showType);
+    }
+
+/* return the length of an object's name, or ERROR if it is not named */
+
+inline ssize_t objNameLenGet (OBJ_ID objId)
+    {
+    if (objId == nullptr || objId->name.empty ())
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    return static_cast<ssize_t> (objId->name.size ());
+    }
+
+/* copy an object's name, including the terminating NUL */
+
+inline STATUS objNameGet (OBJ_ID objId, char * buffer, size_t length)
+    {
+    if (objId == nullptr || buffer == nullptr ||
+	length < objId->name.size () + 1)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    memcpy (buffer, objId->name.c_str (), objId->name.size () + 1);
+    return OK;
+    }
+
+#endif /* __INCobjLibh */
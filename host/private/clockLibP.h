@@ -0,0 +1,44 @@
+/* clockLibP.h - host simulation of the private clock interfaces */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCclockLibPh
+#define __INCclockLibPh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+#include <time.h>
+
+/*
+ * Convert the absolute time <pTimeout> on clock <clockId> into a relative
+ * number of system ticks. A time in the past yields 0.
+ */
+
+inline int clock_absTimeoutCalc (clockid_t clockId,
+				 const struct timespec * pTimeout,
+				 _Vx_ticks_t * pTicks)
+    {
+    struct timespec now;
+    long long ns;
+
+    if (pTimeout == nullptr || pTicks == nullptr ||
+	clock_gettime (clockId, &now) != 0)
+	{
+	errno = EINVAL;
+	return ERROR;
+	}
+
+    ns = (pTimeout->tv_sec - now.tv_sec) * 1000000000ll +
+	 (pTimeout->tv_nsec - now.tv_nsec);
+    if (ns <= 0)
+	*pTicks = 0;
+    else
+	*pTicks = static_cast<_Vx_ticks_t>
+	    ((static_cast<unsigned __int128> (ns) * vxhost::clkRate () +
+	      999999999u) / 1000000000u);
+    return OK;
+    }
+
+#endif /* __INCclockLibPh */
@@ -0,0 +1,321 @@
+/* hostLibP.h - private core of the host simulation */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Every simulated kernel object derives from vxhost::obj. Blocking is done
+ * with a std::mutex/std::condition_variable pair per object, and system
+ * ticks are simulated from CLOCK_MONOTONIC at a rate of CLOCKS_PER_SEC so
+ * that chrono2tic() conversions agree with the simulated clock.
+ */
+
+#ifndef __INChostLibPh
+#define __INChostLibPh
+
+#include <vxWorks.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* a simulated task: one per host thread, holding the event register */
+
+struct windTcb
+    {
+    std::mutex			lock;
+    std::condition_variable	cv;
+    _Vx_event_t			events = 0;
+    };
+
+typedef struct vxhost_obj * OBJ_ID;
+
+namespace vxhost
+{
+enum objClass { CLASS_SEM, CLASS_MSGQ, CLASS_WD, CLASS_CONDVAR, CLASS_SD };
+
+typedef std::chrono::steady_clock	clock;
+
+/* the number of simulated objects in existence, for checks of ownership */
+
+inline std::atomic<long> & objCount ()
+    {
+    static std::atomic<long> n (0);
+    return n;
+    }
+
+/* the base of every simulated object */
+
+struct obj
+    {
+    objClass		cls;
+    std::string		name;
+    int			refs = 1;
+    int			mode = 0;
+    bool		unlinked = false;
+    int			pended = 0;	/* tasks waiting, under the object's lock */
+    bool		deleted = false; /* set under the object's lock */
+    std::condition_variable drained;	/* signalled as the last waiter leaves */
+
+    explicit obj (objClass c) : cls (c) { objCount ()++; }
+    virtual ~obj () { objCount ()--; }
+
+    /* after a wait, with the lock held: report an object deleted meanwhile */
+
+    bool gone () const
+	{
+	if (deleted)
+	    errno = S_objLib_OBJ_DELETED;
+	return deleted;
+	}
+    };
+
+/* the calling thread's simulated task */
+
+inline TASK_ID self ()
+    {
+    static thread_local windTcb tcb;
+    return &tcb;
+    }
+
+/* simulated system clock rate */
+
+inline int clkRate ()
+    {
+    return static_cast<int> (CLOCKS_PER_SEC);
+    }
+
+inline clock::duration ticks2dur (_Vx_ticks_t ticks)
+    {
+    return std::chrono::duration_cast<clock::duration>
+	(std::chrono::nanoseconds ((1000000000ull * ticks) / clkRate ()));
+    }
+
+inline _Vx_ticks64_t tick64 ()
+    {
+    static const clock::time_point boot = clock::now ();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+	(clock::now () - boot).count ();
+    return static_cast<_Vx_ticks64_t> ((ns * (unsigned long long) clkRate ())
+				       / 1000000000ull);
+    }
+
+/*
+ * Count a task as pended on an object for the duration of a wait. Declare
+ * it after the lock, so that the count drops while the lock is still held.
+ */
+
+struct pending
+    {
+    obj & o;
+
+    explicit pending (obj & object) : o (object) { o.pended++; }
+    ~pending ()
+	{
+	if (--o.pended == 0 && o.deleted)
+	    o.drained.notify_all ();
+	}
+    };
+
+/*
+ * Mark an object deleted, wake every task pended on it through <cv>, and
+ * wait until all of them have left, so that none relocks a destroyed mutex.
+ * Called from the destructor of a simulated object, with <m> unlocked.
+ */
+
+template <typename... Cv>
+void retire (obj & o, std::mutex & m, Cv &... cv)
+    {
+    std::unique_lock<std::mutex> lk (m);
+
+    o.deleted = true;
+    (cv.notify_all (), ...);
+    o.drained.wait (lk, [&] { return o.pended == 0; });
+    }
+
+/*
+ * Wait on <cv> until <pred> holds, honouring the NO_WAIT and WAIT_FOREVER
+ * conventions. On timeout errno is set to <timeoutErrno> and false returned.
+ */
+
+template <typename Pred>
+bool waitFor (std::unique_lock<std::mutex> & lk, std::condition_variable & cv,
+	      _Vx_ticks_t timeout, Pred pred,
+	      int timeoutErrno = S_objLib_OBJ_TIMEOUT)
+    {
+    bool ok;
+
+    if (timeout == NO_WAIT)
+	{
+	ok = pred ();
+	if (!ok)
+	    errno = S_objLib_OBJ_UNAVAILABLE;
+	return ok;
+	}
+
+    if (timeout == WAIT_FOREVER)
+	{
+	cv.wait (lk, pred);
+	return true;
+	}
+
+    ok = cv.wait_until (lk, clock::now () + ticks2dur (timeout), pred);
+    if (!ok)
+	errno = timeoutErrno;
+    return ok;
+    }
+
+/* the name space of named (public) objects */
+
+inline std::mutex & namesLock ()
+    {
+    static std::mutex m;
+    return m;
+    }
+
+inline std::map<std::string, obj *> & names ()
+    {
+    static std::map<std::string, obj *> table;
+    return table;
+    }
+
+/*
+ * Open or create the named object <name> of class <cls>. <create> builds a
+ * new object when OM_CREATE is given and the name is unknown.
+ */
+
+template <typename T, typename Create>
+T * open (const char * name, objClass cls, int mode, Create create)
+    {
+    std::lock_guard<std::mutex> g (namesLock ());
+    auto it = names ().find (name);
+
+    if (it != names ().end ())
+	{
+	if ((mode & OM_CREATE) && (mode & OM_EXCL))
+	    {
+	    errno = S_objLib_OBJ_NAME_CLASH;
+	    return nullptr;
+	    }
+	if (it->second->cls != cls)
+	    {
+	    errno = S_objLib_OBJ_ID_ERROR;
+	    return nullptr;
+	    }
+	it->second->refs++;
+	return static_cast<T *> (it->second);
+	}
+
+    if (!(mode & OM_CREATE))
+	{
+	errno = S_objLib_OBJ_NOT_FOUND;
+	return nullptr;
+	}
+
+    T * p = create ();
+    if (p == nullptr)
+	return nullptr;
+    p->name = name;
+    p->mode = mode;
+    names ()[name] = p;
+    return p;
+    }
+
+/* drop a reference to a named object, destroying it when appropriate */
+
+inline STATUS close (obj * p)
+    {
+    bool destroy = false;
+
+    if (p == nullptr)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (namesLock ());
+    if (--p->refs == 0 && (p->unlinked || (p->mode & OM_DESTROY_ON_LAST_CALL)))
+	{
+	if (!p->unlinked)
+	    names ().erase (p->name);
+	destroy = true;
+	}
+    }
+    if (destroy)
+	delete p;
+    return OK;
+    }
+
+/* remove a name from the name space; destroyed on last close */
+
+inline STATUS unlink (const char * name, objClass cls)
+    {
+    obj * p = nullptr;
+    {
+    std::lock_guard<std::mutex> g (namesLock ());
+    auto it = names ().find (name);
+
+    if (it == names ().end () || it->second->cls != cls)
+	{
+	errno = S_objLib_OBJ_NOT_FOUND;
+	return ERROR;
+	}
+    it->second->unlinked = true;
+    if (it->second->refs == 0)
+	p = it->second;
+    names ().erase (it);
+    }
+    delete p;
+    return OK;
+    }
+
+/* send events to a task registered on a resource */
+
+inline STATUS eventSend (TASK_ID tid, _Vx_event_t events)
+    {
+    if (tid == TASK_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (tid->lock);
+    tid->events |= events;
+    }
+    tid->cv.notify_all ();
+    return OK;
+    }
+
+/* resource event registration (semEvStart() / msgQEvStart()) */
+
+struct evReg
+    {
+    TASK_ID	task = TASK_ID_NULL;
+    _Vx_event_t	events = 0;
+    UINT8	options = 0;
+
+    /* called with the owning object locked when the resource is free */
+
+    void notify ()
+	{
+	if (task == TASK_ID_NULL)
+	    return;
+	vxhost::eventSend (task, events);
+	if (options & 0x1)	/* EVENTS_SEND_ONCE */
+	    task = TASK_ID_NULL;
+	}
+    };
+}   // vxhost
+
+struct vxhost_obj : vxhost::obj
+    {
+    using vxhost::obj::obj;
+    };
+
+#endif /* __INChostLibPh */
@@ -0,0 +1,36 @@
+/* semLibP.h - host simulation of the private semaphore interfaces */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * The scalable mutex routines skip validation and instrumentation on a
+ * target. The simulation has nothing to skip, so they map onto the
+ * ordinary mutex routines, except that SEM_NO_RECURSE is honoured per call.
+ */
+
+#ifndef __INCsemLibPh
+#define __INCsemLibPh
+
+#include <semLib.h>
+
+#define SEM_NO_ID_VALIDATE	0x100
+#define SEM_NO_ERROR_CHECK	0x200
+#define SEM_NO_SYSTEM_VIEWER	0x400
+#define SEM_NO_EVENT_SEND	0x800
+
+inline STATUS semMTakeScalable (SEM_ID semId, _Vx_ticks_t timeout, int options)
+    {
+    return vxhost::semMutexTake (semId, timeout,
+	(options & SEM_NO_RECURSE) ||
+	(semId != SEM_ID_NULL && (semId->options & SEM_NO_RECURSE)));
+    }
+
+inline STATUS semMGiveScalable (SEM_ID semId, int options)
+    {
+    (void) options;
+    return semMGive (semId);
+    }
+
+#endif /* __INCsemLibPh */
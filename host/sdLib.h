@@ -0,0 +1,104 @@
+/* sdLib.h - host simulation of shared data regions */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * A shared data region is simulated by a block of zeroed, page aligned
+ * memory in the one host process, so every "RTP" that opens it sees the
+ * same virtual address. Physical addresses and MMU attributes are ignored.
+ */
+
+#ifndef __INCsdLibh
+#define __INCsdLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+#include <cstdlib>
+
+typedef UINT32			MMU_ATTR;
+typedef long long		off_t64;
+
+#define SD_LINGER		0x1
+#define SD_PRIVATE		0x2
+
+#define SD_ATTR_RW		0x0006
+#define SD_ATTR_RWX		0x0007
+#define SD_CACHE_COPYBACK	0x0100
+#define SD_CACHE_OFF		0x0400
+
+struct vxhost_sd : vxhost_obj
+    {
+    void *	base;
+    size_t	size;
+
+    vxhost_sd (size_t n)
+	: vxhost_obj (vxhost::CLASS_SD),
+	  size ((n + 4095) & ~size_t (4095))
+	{
+	base = std::aligned_alloc (4096, size);
+	if (base != nullptr)
+	    std::memset (base, 0, size);
+	}
+
+    ~vxhost_sd ()
+	{
+	std::free (base);
+	}
+    };
+
+typedef struct vxhost_sd * SD_ID;
+#define SD_ID_NULL	((SD_ID) 0)
+
+inline SD_ID sdOpen (const char * name, int options, int mode, size_t size,
+		     off_t64 physAddress, MMU_ATTR attr, void ** pVirtAddress)
+    {
+    (void) physAddress;
+    (void) attr;
+    if (!(options & SD_LINGER))
+	mode |= OM_DELETE_ON_LAST_CLOSE;
+
+    vxhost_sd * sd = vxhost::open<vxhost_sd> (name, vxhost::CLASS_SD, mode,
+	[&] () -> vxhost_sd *
+	    {
+	    if (size == 0)
+		{
+		errno = S_objLib_OBJ_ID_ERROR;
+		return nullptr;
+		}
+	    vxhost_sd * p = new vxhost_sd (size);
+	    if (p->base == nullptr)
+		{
+		delete p;
+		return nullptr;
+		}
+	    return p;
+	    });
+
+    if (sd != nullptr && pVirtAddress != nullptr)
+	*pVirtAddress = sd->base;
+    return sd;
+    }
+
+inline STATUS sdClose (SD_ID sdId, int options)
+    {
+    (void) options;
+    return vxhost::close (sdId);
+    }
+
+/* delete a region: its name is removed now, its memory on last close */
+
+inline STATUS sdDelete (SD_ID sdId, int options)
+    {
+    if (sdId == SD_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    if (!sdId->unlinked)
+	vxhost::unlink (sdId->name.c_str (), vxhost::CLASS_SD);
+    return sdClose (sdId, options);
+    }
+
+#endif /* __INCsdLibh */
@@ -0,0 +1,52 @@
+/* semEvLib.h - host simulation of semaphore event registration */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCsemEvLibh
+#define __INCsemEvLibh
+
+#include <semLib.h>
+#include <eventLib.h>
+
+/* register the calling task to receive <events> when the semaphore is free */
+
+inline STATUS semEvStart (SEM_ID semId, _Vx_event_t events, UINT8 options)
+    {
+    TASK_ID self = vxhost::self ();
+
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+
+    std::lock_guard<std::mutex> g (semId->lock);
+    if (semId->ev.task != TASK_ID_NULL && semId->ev.task != self &&
+	!(options & EVENTS_ALLOW_OVERWRITE))
+	{
+	errno = S_eventLib_ALREADY_REGISTERED;
+	return ERROR;
+	}
+    semId->ev.task = self;
+    semId->ev.events = events;
+    semId->ev.options = options;
+    if ((options & EVENTS_SEND_IF_FREE) && semId->free ())
+	semId->ev.notify ();
+    return OK;
+    }
+
+inline STATUS semEvStop (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+
+    std::lock_guard<std::mutex> g (semId->lock);
+    if (semId->ev.task != vxhost::self ())
+	{
+	errno = S_eventLib_ALREADY_REGISTERED;
+	return ERROR;
+	}
+    semId->ev.task = TASK_ID_NULL;
+    return OK;
+    }
+
+#endif /* __INCsemEvLibh */
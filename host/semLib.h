@@ -0,0 +1,478 @@
+/* semLib.h - host simulation of the semaphore library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Binary, counting, mutex and read/write semaphores share one simulated
+ * object. Mutual exclusion semaphores track their owner and recursion
+ * count; priority inheritance and deletion safety are accepted but have no
+ * effect on a host.
+ */
+
+#ifndef __INCsemLibh
+#define __INCsemLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+typedef struct vxhost_sem * SEM_ID;
+#define SEM_ID_NULL	((SEM_ID) 0)
+
+typedef enum
+    {
+    SEM_EMPTY = 0,
+    SEM_FULL = 1
+    } SEM_B_STATE;
+
+#define SEM_TYPE_BINARY		0
+#define SEM_TYPE_MUTEX		1
+#define SEM_TYPE_COUNTING	2
+#define SEM_TYPE_RW		4
+
+#define SEM_Q_FIFO			0x0
+#define SEM_Q_PRIORITY			0x1
+#define SEM_DELETE_SAFE			0x4
+#define SEM_INVERSION_SAFE		0x8
+#define SEM_EVENTSEND_ERR_NOTIFY	0x10
+#define SEM_INTERRUPTIBLE		0x20
+#define SEM_NO_RECURSE			0x40
+#define SEM_USER			0x80
+#define SEM_TASK_DELETION_WAKEUP	0x2000
+#define SEM_ROBUST			0x20000
+
+#ifndef SEM_RW_MAX_CONCURRENT_READERS
+#define SEM_RW_MAX_CONCURRENT_READERS	64
+#endif
+
+struct vxhost_sem : vxhost_obj
+    {
+    int				type;
+    int				options;
+    int				count = 0;	/* binary and counting */
+    TASK_ID			owner = TASK_ID_NULL; /* mutex and writer */
+    int				recurse = 0;
+    int				readers = 0;
+    int				maxReaders = 0;
+    unsigned			flushes = 0;
+    std::mutex			lock;
+    std::condition_variable	cv;
+    vxhost::evReg		ev;
+
+    vxhost_sem (int t, int opt) : vxhost_obj (vxhost::CLASS_SEM),
+	type (t), options (opt) {}
+    ~vxhost_sem () { vxhost::retire (*this, lock, cv); }
+
+    bool free () const
+	{
+	switch (type)
+	    {
+	    case SEM_TYPE_MUTEX:
+		return owner == TASK_ID_NULL;
+	    case SEM_TYPE_RW:
+		return owner == TASK_ID_NULL && readers == 0;
+	    default:
+		return count > 0;
+	    }
+	}
+    };
+
+namespace vxhost
+{
+inline SEM_ID semNew (int type, int options, int initial)
+    {
+    SEM_ID s = new vxhost_sem (type, options);
+
+    if (type == SEM_TYPE_RW)
+	s->maxReaders = (initial > 0 && initial < SEM_RW_MAX_CONCURRENT_READERS) ?
+	    initial : SEM_RW_MAX_CONCURRENT_READERS;
+    else if (type == SEM_TYPE_BINARY)
+	s->count = initial ? 1 : 0;
+    else if (type == SEM_TYPE_COUNTING)
+	s->count = initial;
+    return s;
+    }
+
+inline bool semValid (SEM_ID s, int type)
+    {
+    if (s == SEM_ID_NULL || s->deleted || (type >= 0 && s->type != type))
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return false;
+	}
+    return true;
+    }
+
+/* take a binary or counting semaphore */
+
+inline STATUS semCountTake (SEM_ID s, _Vx_ticks_t timeout)
+    {
+    std::unique_lock<std::mutex> lk (s->lock);
+    unsigned flushes = s->flushes;
+    vxhost::pending p (*s);
+
+    if (!waitFor (lk, s->cv, timeout,
+		  [&] { return s->count > 0 || s->flushes != flushes ||
+			       s->deleted; }) ||
+	s->gone ())
+	return ERROR;
+    if (s->flushes == flushes)
+	s->count--;
+    return OK;
+    }
+
+/* give a binary or counting semaphore */
+
+inline STATUS semCountGive (SEM_ID s)
+    {
+    {
+    std::lock_guard<std::mutex> g (s->lock);
+    if (s->type == SEM_TYPE_BINARY)
+	s->count = 1;
+    else if (s->count == INT_MAX)
+	{
+	errno = S_semLib_INVALID_OPERATION;
+	return ERROR;
+	}
+    else
+	s->count++;
+    s->ev.notify ();
+    }
+    s->cv.notify_one ();
+    return OK;
+    }
+}   // vxhost
+
+/* creation and deletion */
+
+inline SEM_ID semBCreate (int options, SEM_B_STATE initialState)
+    {
+    return vxhost::semNew (SEM_TYPE_BINARY, options, initialState);
+    }
+
+inline SEM_ID semCCreate (int options, int initialCount)
+    {
+    return vxhost::semNew (SEM_TYPE_COUNTING, options, initialCount);
+    }
+
+inline SEM_ID semMCreate (int options)
+    {
+    if ((options & SEM_INVERSION_SAFE) && !(options & SEM_Q_PRIORITY))
+	{
+	errno = S_semLib_INVALID_OPTION;
+	return SEM_ID_NULL;
+	}
+    return vxhost::semNew (SEM_TYPE_MUTEX, options, 0);
+    }
+
+inline SEM_ID semRWCreate (int options, int maxReaders)
+    {
+    return vxhost::semNew (SEM_TYPE_RW, options, maxReaders);
+    }
+
+inline STATUS semDelete (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+    delete semId;
+    return OK;
+    }
+
+/* named semaphores */
+
+inline SEM_ID semOpen (const char * name, int type, int initState,
+		       int options, int mode, void * context)
+    {
+    (void) context;
+    if (name == nullptr || *name == '\0')
+	return vxhost::semNew (type, options, initState);
+    return vxhost::open<vxhost_sem> (name, vxhost::CLASS_SEM, mode,
+	[&] { return vxhost::semNew (type, options, initState); });
+    }
+
+inline STATUS semClose (SEM_ID semId)
+    {
+    return vxhost::close (semId);
+    }
+
+inline STATUS semUnlink (const char * name)
+    {
+    return vxhost::unlink (name, vxhost::CLASS_SEM);
+    }
+
+/* binary semaphores */
+
+inline STATUS semBTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_BINARY))
+	return ERROR;
+    return vxhost::semCountTake (semId, timeout);
+    }
+
+inline STATUS semBGive (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_BINARY))
+	return ERROR;
+    return vxhost::semCountGive (semId);
+    }
+
+/* counting semaphores */
+
+inline STATUS semCTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_COUNTING))
+	return ERROR;
+    return vxhost::semCountTake (semId, timeout);
+    }
+
+inline STATUS semCGive (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_COUNTING))
+	return ERROR;
+    return vxhost::semCountGive (semId);
+    }
+
+/* mutual exclusion semaphores */
+
+namespace vxhost
+{
+inline STATUS semMutexTake (SEM_ID semId, _Vx_ticks_t timeout, bool noRecurse)
+    {
+    TASK_ID self = vxhost::self ();
+
+    if (!vxhost::semValid (semId, SEM_TYPE_MUTEX))
+	return ERROR;
+
+    std::unique_lock<std::mutex> lk (semId->lock);
+    if (semId->owner == self)
+	{
+	if (noRecurse)
+	    {
+	    errno = S_semLib_INVALID_OPERATION;
+	    return ERROR;
+	    }
+	semId->recurse++;
+	return OK;
+	}
+    vxhost::pending p (*semId);
+    if (!vxhost::waitFor (lk, semId->cv, timeout,
+			  [&] { return semId->owner == TASK_ID_NULL ||
+				       semId->deleted; }) ||
+	semId->gone ())
+	return ERROR;
+    semId->owner = self;
+    semId->recurse = 0;
+    return OK;
+    }
+}   // vxhost
+
+inline STATUS semMTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    return vxhost::semMutexTake (semId, timeout,
+	semId != SEM_ID_NULL && (semId->options & SEM_NO_RECURSE));
+    }
+
+inline STATUS semMGive (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_MUTEX))
+	return ERROR;
+    {
+    std::lock_guard<std::mutex> g (semId->lock);
+    if (semId->owner != vxhost::self ())
+	{
+	errno = S_semLib_INVALID_OPERATION;
+	return ERROR;
+	}
+    if (semId->recurse > 0)
+	{
+	semId->recurse--;
+	return OK;
+	}
+    semId->owner = TASK_ID_NULL;
+    semId->ev.notify ();
+    }
+    semId->cv.notify_one ();
+    return OK;
+    }
+
+inline STATUS semMConsistent (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_MUTEX))
+	return ERROR;
+    return OK;
+    }
+
+/* read/write semaphores */
+
+inline STATUS semRTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    TASK_ID self = vxhost::self ();
+
+    if (!vxhost::semValid (semId, SEM_TYPE_RW))
+	return ERROR;
+
+    std::unique_lock<std::mutex> lk (semId->lock);
+    if (semId->owner == self)
+	{
+	semId->recurse++;
+	return OK;
+	}
+    vxhost::pending p (*semId);
+    if (!vxhost::waitFor (lk, semId->cv, timeout,
+			  [&] { return (semId->owner == TASK_ID_NULL &&
+					semId->readers < semId->maxReaders) ||
+				       semId->deleted; }) ||
+	semId->gone ())
+	return ERROR;
+    semId->readers++;
+    return OK;
+    }
+
+inline STATUS semWTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    TASK_ID self = vxhost::self ();
+
+    if (!vxhost::semValid (semId, SEM_TYPE_RW))
+	return ERROR;
+
+    std::unique_lock<std::mutex> lk (semId->lock);
+    if (semId->owner == self)
+	{
+	semId->recurse++;
+	return OK;
+	}
+    vxhost::pending p (*semId);
+    if (!vxhost::waitFor (lk, semId->cv, timeout,
+			  [&] { return (semId->owner == TASK_ID_NULL &&
+					semId->readers == 0) ||
+				       semId->deleted; }) ||
+	semId->gone ())
+	return ERROR;
+    semId->owner = self;
+    semId->recurse = 0;
+    return OK;
+    }
+
+inline STATUS semRWGive (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, SEM_TYPE_RW))
+	return ERROR;
+    {
+    std::lock_guard<std::mutex> g (semId->lock);
+    if (semId->owner == vxhost::self ())
+	{
+	if (semId->recurse > 0)
+	    {
+	    semId->recurse--;
+	    return OK;
+	    }
+	semId->owner = TASK_ID_NULL;
+	}
+    else if (semId->readers > 0)
+	semId->readers--;
+    else
+	{
+	errno = S_semLib_INVALID_OPERATION;
+	return ERROR;
+	}
+    if (semId->free ())
+	semId->ev.notify ();
+    }
+    semId->cv.notify_all ();
+    return OK;
+    }
+
+/* generic operations */
+
+inline STATUS semTake (SEM_ID semId, _Vx_ticks_t timeout)
+    {
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+    switch (semId->type)
+	{
+	case SEM_TYPE_MUTEX:
+	    return semMTake (semId, timeout);
+	case SEM_TYPE_RW:
+	    return semWTake (semId, timeout);
+	default:
+	    return vxhost::semCountTake (semId, timeout);
+	}
+    }
+
+inline STATUS semGive (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+    switch (semId->type)
+	{
+	case SEM_TYPE_MUTEX:
+	    return semMGive (semId);
+	case SEM_TYPE_RW:
+	    return semRWGive (semId);
+	default:
+	    return vxhost::semCountGive (semId);
+	}
+    }
+
+/* semaphore information; the pended task list is not filled in */
+
+typedef struct
+    {
+    UINT	numTasks;
+    int		semType;
+    int		options;
+    union
+	{
+	UINT	count;
+	BOOL	full;
+	TASK_ID	owner;
+	} state;
+    int		taskIdListMax;
+    TASK_ID *	taskIdList;
+    } SEM_INFO;
+
+inline STATUS semInfoGet (SEM_ID semId, SEM_INFO * pInfo)
+    {
+    if (!vxhost::semValid (semId, -1) || pInfo == nullptr)
+	return ERROR;
+    std::lock_guard<std::mutex> g (semId->lock);
+    pInfo->numTasks = static_cast<UINT> (semId->pended);
+    pInfo->semType = semId->type;
+    pInfo->options = semId->options;
+    switch (semId->type)
+	{
+	case SEM_TYPE_MUTEX:
+	case SEM_TYPE_RW:
+	    pInfo->state.owner = semId->owner;
+	    break;
+	case SEM_TYPE_BINARY:
+	    pInfo->state.full = semId->count > 0;
+	    break;
+	default:
+	    pInfo->state.count = static_cast<UINT> (semId->count);
+	    break;
+	}
+    return OK;
+    }
+
+/* unblock every task pended on a binary or counting semaphore */
+
+inline STATUS semFlush (SEM_ID semId)
+    {
+    if (!vxhost::semValid (semId, -1))
+	return ERROR;
+    if (semId->type == SEM_TYPE_MUTEX || semId->type == SEM_TYPE_RW)
+	{
+	errno = S_semLib_INVALID_OPERATION;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (semId->lock);
+    semId->flushes++;
+    }
+    semId->cv.notify_all ();
+    return OK;
+    }
+
+#endif /* __INCsemLibh */
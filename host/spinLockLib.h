@@ -0,0 +1,42 @@
+/* spinLockLib.h - host simulation of task-level spinlocks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * On a target spinLockTaskTake() also disables task preemption. Host
+ * threads cannot be kept from being preempted, so the simulation spins and
+ * yields.
+ */
+
+#ifndef __INCspinLockLibh
+#define __INCspinLockLibh
+
+#include <vxWorks.h>
+#include <atomic>
+#include <thread>
+
+typedef struct
+    {
+    std::atomic_flag	flag;
+    } spinlockTask_t;
+
+inline void spinLockTaskInit (spinlockTask_t * pLock, int flags)
+    {
+    (void) flags;
+    pLock->flag.clear ();
+    }
+
+inline void spinLockTaskTake (spinlockTask_t * pLock)
+    {
+    while (pLock->flag.test_and_set (std::memory_order_acquire))
+	std::this_thread::yield ();
+    }
+
+inline void spinLockTaskGive (spinlockTask_t * pLock)
+    {
+    pLock->flag.clear (std::memory_order_release);
+    }
+
+#endif /* __INCspinLockLibh */
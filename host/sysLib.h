@@ -0,0 +1,18 @@
+/* sysLib.h - host simulation of the system clock rate */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCsysLibh
+#define __INCsysLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+inline int sysClkRateGet (void)
+    {
+    return vxhost::clkRate ();
+    }
+
+#endif /* __INCsysLibh */
@@ -0,0 +1,29 @@
+/* taskLib.h - host simulation of the task library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCtaskLibh
+#define __INCtaskLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+inline TASK_ID taskIdSelf (void)
+    {
+    return vxhost::self ();
+    }
+
+/* delay the calling task; a delay of 0 yields the CPU */
+
+inline STATUS taskDelay (_Vx_ticks_t ticks)
+    {
+    if (ticks == 0)
+	std::this_thread::yield ();
+    else
+	std::this_thread::sleep_for (vxhost::ticks2dur (ticks));
+    return OK;
+    }
+
+#endif /* __INCtaskLibh */
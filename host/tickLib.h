@@ -0,0 +1,23 @@
+/* tickLib.h - host simulation of the system tick count */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCtickLibh
+#define __INCtickLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+inline _Vx_ticks_t tickGet (void)
+    {
+    return static_cast<_Vx_ticks_t> (vxhost::tick64 ());
+    }
+
+inline _Vx_ticks64_t tick64Get (void)
+    {
+    return vxhost::tick64 ();
+    }
+
+#endif /* __INCtickLibh */
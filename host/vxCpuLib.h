@@ -0,0 +1,31 @@
+/* vxCpuLib.h - host simulation of the CPU identification library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Host threads may migrate at any moment, so the index returned is only a
+ * hint, as it is on a target when preemption is not locked.
+ */
+
+#ifndef __INCvxCpuLibh
+#define __INCvxCpuLibh
+
+#include <vxWorks.h>
+#include <sched.h>
+#include <thread>
+
+inline unsigned int vxCpuIndexGet (void)
+    {
+    int cpu = sched_getcpu ();
+    return (cpu < 0) ? 0 : static_cast<unsigned int> (cpu);
+    }
+
+inline unsigned int vxCpuConfiguredGet (void)
+    {
+    unsigned int n = std::thread::hardware_concurrency ();
+    return (n == 0) ? 1 : n;
+    }
+
+#endif /* __INCvxCpuLibh */
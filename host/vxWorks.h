@@ -0,0 +1,89 @@
+/* vxWorks.h - host simulation of the VxWorks basic types */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * The host/ directory is a stand-in for the VxWorks headers used by the
+ * vxworks:: namespace. It implements just enough of the kernel C API on
+ * top of pthreads to compile and exercise the classes on a Linux host.
+ * It is C++ only (the functions are defined inline in the headers) and is
+ * not a substitute for running on a target.
+ */
+
+#ifndef __INCvxWorksh
+#define __INCvxWorksh
+
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cerrno>
+#include <sys/types.h>
+
+typedef int		STATUS;
+typedef int		_Vx_STATUS;
+typedef int		BOOL;
+typedef unsigned char	UINT8;
+typedef unsigned short	UINT16;
+typedef unsigned int	UINT;
+typedef unsigned int	UINT32;
+typedef unsigned int	_Vx_UINT32;
+typedef unsigned long long UINT64;
+typedef unsigned int	_Vx_ticks_t;
+typedef unsigned long long _Vx_ticks64_t;
+typedef unsigned int	_Vx_event_t;
+typedef long		_Vx_usr_arg_t;
+typedef int		(*FUNCPTR) (...);
+typedef void		(*VOIDFUNCPTR) (...);
+
+#ifndef OK
+#define OK		0
+#endif
+#ifndef ERROR
+#define ERROR		(-1)
+#endif
+#ifndef TRUE
+#define TRUE		1
+#endif
+#ifndef FALSE
+#define FALSE		0
+#endif
+
+#define NO_WAIT		((_Vx_ticks_t) 0)
+#define WAIT_FOREVER	((_Vx_ticks_t) -1)
+
+/* object open modes (objLib) */
+
+#define OM_CREATE		0x10000000
+#define OM_EXCL			0x20000000
+#define OM_DELETE_ON_LAST_CLOSE	0x40000000
+#define OM_DESTROY_ON_LAST_CALL	OM_DELETE_ON_LAST_CLOSE
+
+/* module numbers and the errno values set by the simulation */
+
+#define M_semLib	(22 << 16)
+#define M_objLib	(61 << 16)
+#define M_msgQLib	(65 << 16)
+#define M_eventLib	(82 << 16)
+
+#define S_objLib_OBJ_ID_ERROR		(M_objLib | 1)
+#define S_objLib_OBJ_UNAVAILABLE	(M_objLib | 2)
+#define S_objLib_OBJ_DELETED		(M_objLib | 3)
+#define S_objLib_OBJ_TIMEOUT		(M_objLib | 4)
+#define S_objLib_OBJ_NOT_FOUND		(M_objLib | 16)
+#define S_objLib_OBJ_NAME_CLASH		(M_objLib | 18)
+#define S_semLib_INVALID_OPTION		(M_semLib | 103)
+#define S_semLib_INVALID_OPERATION	(M_semLib | 104)
+#define S_semLib_EOWNERDEAD		(M_semLib | 109)
+#define S_msgQLib_INVALID_MSG_LENGTH	(M_msgQLib | 1)
+#define S_eventLib_TIMEOUT		(M_eventLib | 2)
+#define S_eventLib_NOT_ALL_EVENTS	(M_eventLib | 3)
+#define S_eventLib_ALREADY_REGISTERED	(M_eventLib | 4)
+#define S_eventLib_EVENTSEND_FAILED	(M_eventLib | 5)
+
+struct windTcb;
+typedef struct windTcb * TASK_ID;
+#define TASK_ID_NULL	((TASK_ID) 0)
+
+#endif /* __INCvxWorksh */
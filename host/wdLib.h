@@ -0,0 +1,132 @@
+/* wdLib.h - host simulation of the watchdog timer library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Each watchdog is serviced by its own host thread standing in for the
+ * system clock interrupt. The routine runs on that thread, outside any
+ * lock, so it may restart or delete its own watchdog as it would on a
+ * target. A watchdog deleted by its own routine is freed by its thread
+ * once the routine returns.
+ */
+
+#ifndef __INCwdLibh
+#define __INCwdLibh
+
+#include <vxWorks.h>
+#include <private/hostLibP.h>
+
+typedef struct vxhost_wd * WDOG_ID;
+#define WDOG_ID_NULL	((WDOG_ID) 0)
+
+struct vxhost_wd : vxhost_obj
+    {
+    std::mutex				lock;
+    std::condition_variable		cv;
+    std::thread				thread;
+    vxhost::clock::time_point		expiry;
+    FUNCPTR				routine = nullptr;
+    _Vx_usr_arg_t			parameter = 0;
+    bool				armed = false;
+    bool				quit = false;
+    bool				detached = false;
+
+    vxhost_wd () : vxhost_obj (vxhost::CLASS_WD) {}
+
+    /* service the watchdog; true if the thread must free it on return */
+
+    bool run ()
+	{
+	std::unique_lock<std::mutex> lk (lock);
+
+	while (!quit)
+	    {
+	    if (!armed)
+		{
+		cv.wait (lk);
+		continue;
+		}
+	    if (cv.wait_until (lk, expiry) != std::cv_status::timeout ||
+		!armed || vxhost::clock::now () < expiry)
+		continue;
+	    armed = false;
+	    FUNCPTR fn = routine;
+	    _Vx_usr_arg_t arg = parameter;
+	    lk.unlock ();
+	    fn (arg);
+	    lk.lock ();
+	    }
+	return detached;
+	}
+    };
+
+inline WDOG_ID wdCreate (void)
+    {
+    WDOG_ID wd = new vxhost_wd;
+
+    wd->thread = std::thread ([wd] { if (wd->run ()) delete wd; });
+    return wd;
+    }
+
+inline STATUS wdDelete (WDOG_ID wdId)
+    {
+    if (wdId == WDOG_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    if (wdId->thread.get_id () == std::this_thread::get_id ())
+	{
+	std::lock_guard<std::mutex> g (wdId->lock);
+	wdId->quit = true;
+	wdId->detached = true;
+	wdId->thread.detach ();
+	return OK;
+	}
+    {
+    std::lock_guard<std::mutex> g (wdId->lock);
+    wdId->quit = true;
+    }
+    wdId->cv.notify_all ();
+    wdId->thread.join ();
+    delete wdId;
+    return OK;
+    }
+
+inline STATUS wdStart (WDOG_ID wdId, _Vx_ticks_t delay, FUNCPTR pRoutine,
+		       _Vx_usr_arg_t parameter)
+    {
+    if (wdId == WDOG_ID_NULL || pRoutine == nullptr)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (wdId->lock);
+    wdId->expiry = vxhost::clock::now () + vxhost::ticks2dur (delay);
+    wdId->routine = pRoutine;
+    wdId->parameter = parameter;
+    wdId->armed = true;
+    }
+    wdId->cv.notify_all ();
+    return OK;
+    }
+
+inline STATUS wdCancel (WDOG_ID wdId)
+    {
+    if (wdId == WDOG_ID_NULL)
+	{
+	errno = S_objLib_OBJ_ID_ERROR;
+	return ERROR;
+	}
+    {
+    std::lock_guard<std::mutex> g (wdId->lock);
+    wdId->armed = false;
+    }
+    wdId->cv.notify_all ();
+    return OK;
+    }
+
+#endif /* __INCwdLibh */
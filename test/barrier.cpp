@@ -0,0 +1,124 @@
+/* barrier.cpp - checks of the latch and the barrier */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks that a latch stays closed, to try_wait() and to waiting tasks,
+ * until it has been counted down to zero, by one or by several at once.
+ * Then has four tasks meet at a barrier for many phases and checks that
+ * the completion function runs once per phase, before any task leaves it,
+ * that arrive() and wait() split the meeting, and that once a task has
+ * arrived and dropped the others complete the phases that follow without
+ * it.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/barrier.hpp"
+#include "vxworks/latch.hpp"
+
+namespace
+{
+const int tasks = 4;
+const int phases = 200;
+
+void latches()
+    {
+    vxworks::latch l(tasks + 2);
+    std::atomic<int> through(0);
+    std::vector<std::thread> threads;
+
+    CHECK(!l.try_wait());
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&]
+	    {
+	    l.arrive_and_wait();
+	    through++;
+	    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(through.load() == 0 && !l.try_wait());
+
+    /* the last two counts at once open it */
+    l.count_down(2);
+    for (auto& th : threads)
+	th.join();
+    CHECK(through.load() == tasks && l.try_wait());
+    l.wait();
+    }
+
+/* a completion function counting the phases */
+struct counter
+    {
+    std::atomic<int> * n;
+
+    void operator()() noexcept
+	{
+	(*n)++;
+	}
+    };
+
+void phased()
+    {
+    std::atomic<int> completed(0);
+    vxworks::barrier<counter> b(tasks, counter {&completed});
+    std::atomic<int> early(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&, t]
+	    {
+	    for (int p = 0; p < phases; p++)
+		{
+		if (t == 0 && p % 2 == 1)
+		    {
+		    /* arrive, then wait apart */
+		    auto token = b.arrive();
+		    b.wait(std::move(token));
+		    }
+		else
+		    b.arrive_and_wait();
+		/* the phase completed before any task left it, and the next
+		   cannot complete without this task */
+		if (completed.load() != p + 1)
+		    early++;
+		}
+	    });
+    for (auto& th : threads)
+	th.join();
+    CHECK(completed.load() == phases);
+    CHECK(early.load() == 0);
+    }
+
+void dropped()
+    {
+    std::atomic<int> completed(0);
+    vxworks::barrier<counter> b(tasks, counter {&completed});
+    std::vector<std::thread> threads;
+
+    /* task t meets for 10 * t phases and then drops out, so phase 10 * t
+       waits for one task fewer */
+    for (int t = 1; t <= tasks; t++)
+	threads.emplace_back([&, t]
+	    {
+	    for (int p = 0; p < 10 * t; p++)
+		b.arrive_and_wait();
+	    b.arrive_and_drop();
+	    });
+    for (auto& th : threads)
+	th.join();
+    CHECK(completed.load() == 10 * tasks + 1);
+    }
+}
+
+int main()
+    {
+    latches();
+    phased();
+    dropped();
+    return vxcheck::status("barrier");
+    }
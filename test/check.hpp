@@ -0,0 +1,51 @@
+/* check.hpp - minimal harness for the host checks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * The programs in test/ check the behaviour of classes of the vxworks
+ * namespace against the simulation in host/. Each is a plain program that
+ * reports every failed check on stderr and exits with status 1 if any
+ * failed; `make test` builds and runs them all.
+ */
+
+#ifndef __INCcheckhpp
+#define __INCcheckhpp
+
+#include <cstdio>
+
+namespace vxcheck
+{
+//! the number of checks that have failed
+inline unsigned& failures() noexcept
+    {
+    static unsigned n = 0;
+    return n;
+    }
+
+//! note the failure of check *what* at *file*:*line*
+inline bool fail(const char * file, int line, const char * what) noexcept
+    {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    failures()++;
+    return false;
+    }
+
+//! the exit status of the program: 0 if every check passed
+inline int status(const char * name) noexcept
+    {
+    if (failures() != 0)
+	fprintf(stderr, "%s: %u checks failed\n", name, failures());
+    else
+	fprintf(stderr, "%s: passed\n", name);
+    return failures() != 0 ? 1 : 0;
+    }
+}      // vxcheck
+
+//! check that *cond* holds, going on with the program if it does not
+#define CHECK(cond) \
+    ((cond) ? true : vxcheck::fail(__FILE__, __LINE__, #cond))
+
+#endif // __INCcheckhpp
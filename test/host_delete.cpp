@@ -0,0 +1,136 @@
+/* host_delete.cpp - checks of object deletion in the host simulation */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Pends tasks on each kind of semaphore, on both ends of a message queue
+ * and on a condition variable, deletes the object, and checks that every
+ * wait ends with S_objLib_OBJ_DELETED. Then checks that a watchdog may
+ * delete itself from its routine and that a delay of 0 is accepted.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include <condVarLib.h>
+#include <msgQLib.h>
+#include <semLib.h>
+#include <wdLib.h>
+
+namespace
+{
+const unsigned waiters = 4;
+
+/* run <wait> in <waiters> tasks, wait until <pended> of them are pended on
+   <obj>, delete it with <destroy>, and check that every wait failed */
+void deleted(const std::function<STATUS()>& wait, OBJ_ID obj,
+	     const std::function<void()>& destroy)
+    {
+    std::atomic<unsigned> failed(0);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < waiters; t++)
+	threads.emplace_back([&]
+	    {
+	    if (wait() == ERROR && errno == S_objLib_OBJ_DELETED)
+		failed++;
+	    });
+    for (int ms = 0; ms < 2000 && obj->pended < (int) waiters; ms++)
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(obj->pended == (int) waiters);
+
+    destroy();
+    for (auto& th : threads)
+	th.join();
+    CHECK(failed.load() == waiters);
+    }
+
+void semaphores()
+    {
+    SEM_ID b = semBCreate(SEM_Q_FIFO, SEM_EMPTY);
+    deleted([&] { return semBTake(b, WAIT_FOREVER); }, b,
+	    [&] { CHECK(semDelete(b) == OK); });
+
+    SEM_ID m = semMCreate(SEM_Q_FIFO);
+    CHECK(semMTake(m, WAIT_FOREVER) == OK);
+    deleted([&] { return semMTake(m, WAIT_FOREVER); }, m,
+	    [&] { CHECK(semDelete(m) == OK); });
+
+    SEM_ID r = semRWCreate(SEM_Q_FIFO, 0);
+    CHECK(semWTake(r, WAIT_FOREVER) == OK);
+    deleted([&] { return semRTake(r, WAIT_FOREVER); }, r,
+	    [&] { CHECK(semDelete(r) == OK); });
+
+    SEM_ID w = semRWCreate(SEM_Q_FIFO, 0);
+    CHECK(semRTake(w, WAIT_FOREVER) == OK);
+    deleted([&] { return semWTake(w, WAIT_FOREVER); }, w,
+	    [&] { CHECK(semDelete(w) == OK); });
+    }
+
+void queues()
+    {
+    char c = 0;
+
+    MSG_Q_ID empty = msgQCreate(1, 1, MSG_Q_FIFO);
+    deleted([&] { return (STATUS) msgQReceive(empty, &c, 1, WAIT_FOREVER); },
+	    empty, [&] { CHECK(msgQDelete(empty) == OK); });
+
+    MSG_Q_ID full = msgQCreate(1, 1, MSG_Q_FIFO);
+    CHECK(msgQSend(full, &c, 1, NO_WAIT, MSG_PRI_NORMAL) == OK);
+    deleted([&] { return msgQSend(full, &c, 1, WAIT_FOREVER, MSG_PRI_NORMAL); },
+	    full, [&] { CHECK(msgQDelete(full) == OK); });
+    }
+
+/* the waits must retake the mutex, so they end one after another */
+void condVars()
+    {
+    SEM_ID m = semMCreate(SEM_Q_FIFO);
+    CONDVAR_ID cv = condVarCreate(CONDVAR_Q_FIFO);
+
+    deleted([&]
+	{
+	semMTake(m, WAIT_FOREVER);
+	STATUS s = condVarWait(cv, m, WAIT_FOREVER);
+	int e = errno;
+	semMGive(m);
+	errno = e;
+	return s;
+	}, cv, [&] { CHECK(condVarDelete(cv) == OK); });
+    CHECK(semDelete(m) == OK);
+    }
+
+std::atomic<unsigned> fired(0);
+
+void selfDelete(_Vx_usr_arg_t arg)
+    {
+    fired++;
+    CHECK(wdDelete(reinterpret_cast<WDOG_ID>(arg)) == OK);
+    }
+
+void watchdogs()
+    {
+    long before = vxhost::objCount().load();
+    WDOG_ID wd = wdCreate();
+
+    CHECK(wdStart(wd, 0, reinterpret_cast<FUNCPTR>(selfDelete),
+		  reinterpret_cast<_Vx_usr_arg_t>(wd)) == OK);
+    for (int ms = 0; ms < 2000 && vxhost::objCount().load() != before; ms++)
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(fired.load() == 1);
+    CHECK(vxhost::objCount().load() == before);
+    }
+}      // namespace
+
+int main()
+    {
+    semaphores();
+    queues();
+    condVars();
+    watchdogs();
+    return vxcheck::status("host_delete");
+    }
@@ -0,0 +1,135 @@
+/* lockdep.cpp - checks of the lock order validator */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Built with VX_LOCKDEP. Takes a mutex and a shared_mutex in one order and
+ * then in the other, from a single task so that nothing deadlocks, and
+ * checks through a replaced handler that the inversion is reported exactly
+ * once, naming both lock classes, and that orders consistent with those
+ * already seen are not reported, also when the lock that closes the cycle
+ * is a stoppable one. Then holds more mutexes than the task's
+ * held stack keeps, and checks that taking them in order reports nothing.
+ */
+
+#define VX_LOCKDEP
+
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/shared_mutex.hpp"
+#include "vxworks/stop_token.hpp"
+
+namespace
+{
+unsigned handled = 0;
+char acquiring[40];
+char held[40];
+
+/* count the report and keep the names of the two classes in it */
+void record(const vxworks::lockdep_report& r)
+    {
+    handled++;
+    vxworks::lockdep::name(r.acquiring, acquiring, sizeof(acquiring));
+    vxworks::lockdep::name(r.held, held, sizeof(held));
+    }
+
+const vxworks::lock_class aClass("A");
+const vxworks::lock_class bClass("B");
+
+void inversion()
+    {
+    vxworks::mutex a;
+    vxworks::shared_mutex b;
+
+    a.set_lock_class(aClass);
+    b.set_lock_class(bClass);
+
+    /* A then B, read side: the order is learnt, nothing is reported */
+    a.lock();
+    b.lock_shared();
+    b.unlock_shared();
+    a.unlock();
+    CHECK(handled == 0);
+
+    /* the same order again, through the write side */
+    a.lock();
+    b.lock();
+    b.unlock();
+    a.unlock();
+    CHECK(handled == 0);
+
+    /* B then A closes the cycle */
+    b.lock();
+    a.lock();
+    a.unlock();
+    b.unlock();
+    CHECK(handled == 1);
+    CHECK(strcmp(acquiring, "A") == 0);
+    CHECK(strcmp(held, "B") == 0);
+
+    /* the inversion is remembered, so repeating it is not reported again */
+    b.lock_shared();
+    a.lock();
+    a.unlock();
+    b.unlock_shared();
+    CHECK(handled == 1);
+    CHECK(vxworks::lockdep::reports() == 1);
+    }
+
+/* a stoppable lock takes the mutex with trylocks, but is checked as a
+   blocking one */
+void stoppable()
+    {
+    vxworks::mutex c;
+    vxworks::mutex d;
+    vxworks::stop_source source;
+    unsigned before = handled;
+
+    c.lock();
+    d.lock();
+    d.unlock();
+    c.unlock();
+
+    d.lock();
+    CHECK(c.lock(source.get_token()) == OK);
+    c.unlock();
+    d.unlock();
+    CHECK(handled == before + 1);
+    }
+
+/* nest more mutexes than are kept on the held stack, twice in the same
+   order, so the second pass checks against the edges of the first */
+void deep()
+    {
+    std::vector<std::unique_ptr<vxworks::mutex>> m;
+    unsigned before = handled;
+
+    for (int i = 0; i < 40; i++)
+	m.emplace_back(new vxworks::mutex);
+    for (int pass = 0; pass < 2; pass++)
+	{
+	for (auto& p : m)
+	    p->lock();
+	for (auto p = m.rbegin(); p != m.rend(); ++p)
+	    (*p)->unlock();
+	}
+    CHECK(handled == before);
+    }
+}
+
+int main()
+    {
+    vxworks::lockdep::handler_t old = vxworks::lockdep::set_handler(&record);
+
+    CHECK(old == &vxworks::lockdep::print);
+    inversion();
+    stoppable();
+    deep();
+    vxworks::lockdep::set_handler(old);
+    return vxcheck::status("lockdep");
+    }
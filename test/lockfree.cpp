@@ -0,0 +1,193 @@
+/* lockfree.cpp - checks of the hazard pointers and the lock-free containers */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks that a retired node another task has protected is kept until that
+ * task clears its slot, and one no task holds is deleted by reclaim(). Then
+ * checks the order of a lockfree_stack and that, with four tasks pushing and
+ * four popping, every element is popped exactly once; and the set semantics
+ * of a lockfree_list, that an erased key's node is deleted once reclaimed,
+ * and that tasks inserting and erasing keys of their own while others look
+ * them up leave exactly the keys expected.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/hazard_pointer.hpp"
+#include "vxworks/lockfree_list.hpp"
+#include "vxworks/lockfree_stack.hpp"
+
+namespace
+{
+std::atomic<int> alive(0);
+
+/* a value that counts its instances */
+struct counted
+    {
+    int value;
+
+    explicit counted(int v = 0) : value(v) { alive++; }
+    counted(const counted& other) : value(other.value) { alive++; }
+    counted& operator=(const counted&) = default;
+    ~counted() { alive--; }
+
+    bool operator<(const counted& other) const { return value < other.value; }
+    };
+
+typedef vxworks::hazard_domain domain;
+
+void hazards()
+    {
+    std::atomic<counted *> shared(new counted(1));
+    std::atomic<bool> holding(false);
+    std::atomic<bool> release(false);
+    counted * held = shared.load();
+
+    std::thread reader([&]
+	{
+	CHECK(domain::protect(0, shared) == held);
+	holding = true;
+	while (!release.load())
+	    std::this_thread::yield();
+	CHECK(held->value == 1);
+	domain::clear(0);
+	holding = false;
+	});
+    while (!holding.load())
+	std::this_thread::yield();
+
+    /* unlink and retire it, with another that no task holds */
+    shared.store(nullptr);
+    domain::retire(held);
+    domain::retire(new counted(2));
+    CHECK(alive.load() == 2);
+    CHECK(domain::reclaim() == 1);
+    CHECK(alive.load() == 1);
+
+    release = true;
+    while (holding.load())
+	std::this_thread::yield();
+    CHECK(domain::reclaim() == 0);
+    CHECK(alive.load() == 0);
+    reader.join();
+    }
+
+void stack()
+    {
+    const int tasks = 4;
+    const int each = 20000;
+
+    {
+    vxworks::lockfree_stack<counted> s;
+    counted c;
+
+    CHECK(s.empty() && !s.pop(c));
+    for (int i = 1; i <= 3; i++)
+	s.push(counted(i));
+    for (int i = 3; i >= 1; i--)
+	CHECK(s.pop(c) && c.value == i);
+    CHECK(s.empty() && !s.pop(c));
+    s.push(counted(4));
+    }
+    CHECK(domain::reclaim() == 0);
+    CHECK(alive.load() == 0);
+
+    vxworks::lockfree_stack<int> s;
+    std::vector<std::atomic<int>> seen(tasks * each);
+    std::atomic<int> popped(0);
+    std::vector<std::thread> threads;
+
+    for (auto& n : seen)
+	n = 0;
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&, t]
+	    {
+	    for (int i = 0; i < each; i++)
+		s.push(t * each + i);
+	    });
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&]
+	    {
+	    int v;
+
+	    while (popped.load() < tasks * each)
+		if (s.pop(v))
+		    {
+		    seen[v]++;
+		    popped++;
+		    }
+	    });
+    for (auto& th : threads)
+	th.join();
+
+    int once = 0;
+    for (auto& n : seen)
+	once += (n.load() == 1);
+    CHECK(once == tasks * each);
+    CHECK(s.empty());
+    }
+
+void list()
+    {
+    const int tasks = 4;
+    const int keys = 500;
+
+    {
+    vxworks::lockfree_list<counted> l;
+
+    CHECK(l.empty() && !l.contains(counted(1)));
+    CHECK(l.insert(counted(2)) && l.insert(counted(1)) && l.insert(counted(3)));
+    CHECK(!l.insert(counted(2)));
+    CHECK(l.contains(counted(1)) && l.contains(counted(2)) && l.contains(counted(3)));
+    CHECK(l.erase(counted(2)) && !l.erase(counted(2)));
+    CHECK(!l.contains(counted(2)) && l.contains(counted(3)));
+
+    /* the erased key's node goes once no task holds it */
+    CHECK(domain::reclaim() == 0);
+    CHECK(alive.load() == 2);
+    }
+    CHECK(alive.load() == 0);
+
+    /* each task owns the keys equal to its number modulo <tasks>: it
+       inserts them all, erases the odd ones, and looks up its neighbour's */
+    vxworks::lockfree_list<int> l;
+    std::vector<std::thread> threads;
+    std::atomic<int> wrong(0);
+
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&, t]
+	    {
+	    for (int k = t; k < tasks * keys; k += tasks)
+		if (!l.insert(k))
+		    wrong++;
+	    for (int k = t; k < tasks * keys; k += tasks)
+		{
+		if ((k / tasks) % 2 == 1 && !l.erase(k))
+		    wrong++;
+		l.contains(k + 1);
+		}
+	    for (int k = t; k < tasks * keys; k += tasks)
+		if (l.contains(k) != ((k / tasks) % 2 == 0))
+		    wrong++;
+	    });
+    for (auto& th : threads)
+	th.join();
+
+    CHECK(wrong.load() == 0);
+    for (int k = 0; k < tasks * keys; k++)
+	CHECK(l.contains(k) == ((k / tasks) % 2 == 0));
+    }
+}
+
+int main()
+    {
+    hazards();
+    stack();
+    list();
+    return vxcheck::status("lockfree");
+    }
@@ -0,0 +1,119 @@
+/* move.cpp - checks of the layout and the moves of the object classes */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks at compile time that every object class is a handle and one word,
+ * plus one pointer for a queue, shared_mutex or wd, and that all of them
+ * are nothrow move constructible and assignable but not copyable. Then
+ * moves a mutex, a queue, a shared_mutex and a wd, by construction and by
+ * assignment, and checks that the moved-from object is left !valid(), that
+ * the move assigned to deletes its own kernel object, and, through the
+ * host simulation's count of objects, that destroying a moved-from object
+ * deletes nothing.
+ */
+
+#include <private/hostLibP.h>
+#include <type_traits>
+#include <utility>
+#include "check.hpp"
+#include "vxworks/condition_variable.hpp"
+#include "vxworks/mutex.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/shared_mutex.hpp"
+#include "vxworks/wd.hpp"
+
+namespace
+{
+/* the layouts without the optional members that VX_OBJECT_REGISTRY and
+   VX_LOCKDEP add to every class */
+#if !defined(VX_OBJECT_REGISTRY) && !defined(VX_LOCKDEP)
+const size_t word = sizeof(void *);
+
+static_assert(sizeof(vxworks::mutex) == 2 * word, "mutex is a handle and a word");
+static_assert(sizeof(vxworks::recursive_timed_mutex) == 2 * word,
+	      "recursive_timed_mutex is a handle and a word");
+static_assert(sizeof(vxworks::counting_semaphore) == 2 * word,
+	      "counting_semaphore is a handle and a word");
+static_assert(sizeof(vxworks::binary_semaphore) == 2 * word,
+	      "binary_semaphore is a handle and a word");
+static_assert(sizeof(vxworks::condition_variable) == 2 * word,
+	      "condition_variable is a handle and a word");
+static_assert(sizeof(vxworks::msgQ) == 2 * word, "msgQ is a handle and a word");
+static_assert(sizeof(vxworks::queue<int>) == 3 * word,
+	      "queue adds one pointer for back pressure");
+static_assert(sizeof(vxworks::shared_mutex) == 3 * word,
+	      "shared_mutex adds one pointer for the scalable path");
+static_assert(sizeof(vxworks::wd) == 3 * word, "wd adds one pointer for its routine");
+#endif
+
+template <typename T> constexpr bool movable()
+    {
+    return std::is_nothrow_move_constructible<T>::value &&
+	   std::is_nothrow_move_assignable<T>::value &&
+	   !std::is_copy_constructible<T>::value;
+    }
+
+static_assert(movable<vxworks::mutex>(), "mutex");
+static_assert(movable<vxworks::recursive_mutex>(), "recursive_mutex");
+static_assert(movable<vxworks::timed_mutex>(), "timed_mutex");
+static_assert(movable<vxworks::recursive_timed_mutex>(), "recursive_timed_mutex");
+static_assert(movable<vxworks::shared_mutex>(), "shared_mutex");
+static_assert(movable<vxworks::counting_semaphore>(), "counting_semaphore");
+static_assert(movable<vxworks::binary_semaphore>(), "binary_semaphore");
+static_assert(movable<vxworks::condition_variable>(), "condition_variable");
+static_assert(movable<vxworks::msgQ>(), "msgQ");
+static_assert(movable<vxworks::queue<int>>(), "queue");
+static_assert(movable<vxworks::queue<int, vxworks::queue_telemetry>>(), "queue with telemetry");
+static_assert(movable<vxworks::wd>(), "wd");
+
+/* move a T made by <make> into another and over a third, checking the
+   count of kernel objects after each step */
+template <typename Make>
+void moved(Make make)
+    {
+    long before = vxhost::objCount();
+
+    {
+    auto kept = make();
+    CHECK(vxhost::objCount() == before + 1);
+    {
+    auto a = make();
+    auto b(std::move(a));
+    CHECK(!a.valid() && b.valid());
+    CHECK(vxhost::objCount() == before + 2);
+
+    /* the target of an assignment gives up its own object */
+    kept = std::move(b);
+    CHECK(!b.valid() && kept.valid());
+    CHECK(vxhost::objCount() == before + 1);
+    }
+    /* and destroying what was moved from deletes nothing */
+    CHECK(vxhost::objCount() == before + 1);
+    CHECK(kept.valid());
+    }
+    CHECK(vxhost::objCount() == before);
+    }
+}
+
+int main()
+    {
+    moved([] { return vxworks::mutex(); });
+    moved([] { return vxworks::queue<int>(4); });
+    moved([] { return vxworks::shared_mutex(vxworks::scalable); });
+    moved([] { return vxworks::wd(); });
+
+    /* a moved queue still works, with its back pressure state */
+    vxworks::queue<int> q(4);
+    int m = 7;
+    size_t highs = 0;
+    q.watermarks(1, 0, [&](size_t) { highs++; }, nullptr);
+    vxworks::queue<int> r(std::move(q));
+    CHECK(r.send(m, NO_WAIT, MSG_PRI_NORMAL) == OK);
+    CHECK(r.recieve(m, NO_WAIT) == static_cast<ssize_t>(sizeof(int)) && m == 7);
+    CHECK(highs == 1);
+    return vxcheck::status("move");
+    }
@@ -0,0 +1,94 @@
+/* mpmc_queue.cpp - checks of the lock-free bounded MPMC queue */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks the rounding of the capacity, FIFO order, the errors of a full
+ * and an empty queue, and then has four producers and four consumers pass
+ * messages through a queue of eight, so that both sides pend, and checks
+ * that every message arrives exactly once and that each consumer sees each
+ * producer's messages in the order they were sent.
+ */
+
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/mpmc_queue.hpp"
+
+namespace
+{
+const unsigned producers = 4;
+const unsigned consumers = 4;
+const unsigned each = 20000;
+
+void basics()
+    {
+    vxworks::mpmc_queue<int> q(5);
+    int m = 0;
+
+    CHECK(q.capacity() == 8);
+    CHECK(q.empty());
+    CHECK(q.poll(m) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(q.recieve(m, 2000) == ERROR && errno == S_objLib_OBJ_TIMEOUT);
+
+    for (int i = 0; i < 8; i++)
+	CHECK(q.send(i, NO_WAIT) == OK);
+    CHECK(q.numMsgs() == 8);
+    CHECK(q.send(8, NO_WAIT) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(q.send(8, 2000) == ERROR && errno == S_objLib_OBJ_TIMEOUT);
+
+    for (int i = 0; i < 8; i++)
+	CHECK(q.recieve(m, NO_WAIT) == static_cast<ssize_t>(sizeof(int)) && m == i);
+    CHECK(q.empty());
+    }
+
+void contended()
+    {
+    vxworks::mpmc_queue<unsigned> q(8);
+    std::vector<std::thread> threads;
+    std::vector<unsigned> seen(producers * each, 0);
+    std::atomic<unsigned> disorder(0);
+
+    for (unsigned c = 0; c < consumers; c++)
+	threads.emplace_back([&]
+	    {
+	    unsigned last[producers] = {};
+	    unsigned m;
+
+	    for (unsigned n = 0; n < producers * each / consumers; n++)
+		{
+		if (q.recieve(m) == ERROR)
+		    return;
+		seen[m]++;
+		unsigned p = m / each;
+		if (m % each + 1 <= last[p])
+		    disorder++;
+		last[p] = m % each + 1;
+		}
+	    });
+    for (unsigned p = 0; p < producers; p++)
+	threads.emplace_back([&, p]
+	    {
+	    for (unsigned i = 0; i < each; i++)
+		q.push(p * each + i);
+	    });
+    for (auto& th : threads)
+	th.join();
+
+    unsigned once = 0;
+    for (unsigned n : seen)
+	once += (n == 1);
+    CHECK(once == producers * each);
+    CHECK(disorder.load() == 0);
+    CHECK(q.empty());
+    }
+}
+
+int main()
+    {
+    basics();
+    contended();
+    return vxcheck::status("mpmc_queue");
+    }
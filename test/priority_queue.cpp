@@ -0,0 +1,151 @@
+/* priority_queue.cpp - checks of the bounded priority queue */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks that messages are received from the most urgent band first, in
+ * the order they were sent within a band or in the order of a Compare, that
+ * the band counts and highest_band() follow, that a band out of range is
+ * refused, that a full queue pends a sender until a receive, and that a
+ * message whose copy throws leaves the queue unlocked and whole.
+ */
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "check.hpp"
+#include "vxworks/priority_queue.hpp"
+
+namespace
+{
+typedef vxworks::priority_queue<int> int_queue;
+
+void bands()
+    {
+    int_queue q(16);
+    int m = 0;
+    unsigned band = 0;
+
+    CHECK(q.highest_band() == -1);
+    CHECK(q.send(1, int_queue::lowest_band) == OK);
+    CHECK(q.send(2, 7) == OK);
+    CHECK(q.send(3, 0) == OK);
+    CHECK(q.send(4, 7) == OK);
+    CHECK(q.send(5, int_queue::lowest_band) == OK);
+    CHECK(q.send(6, 0) == OK);
+    CHECK(q.send(9, int_queue::bands) == ERROR && errno == EINVAL);
+
+    CHECK(q.size() == 6);
+    CHECK(q.size(0) == 2 && q.size(7) == 2 && q.size(int_queue::lowest_band) == 2);
+    CHECK(q.highest_band() == 0);
+
+    /* most urgent band first, and in sending order within a band */
+    const int order[] = {3, 6, 2, 4, 1, 5};
+    const unsigned from[] = {0, 0, 7, 7, 31, 31};
+    for (unsigned i = 0; i < 6; i++)
+	{
+	CHECK(q.recieve(m, band, NO_WAIT) == static_cast<ssize_t>(sizeof(int)));
+	CHECK(m == order[i] && band == from[i]);
+	if (i == 1)
+	    CHECK(q.highest_band() == 7);
+	}
+    CHECK(q.empty() && q.highest_band() == -1);
+    CHECK(q.poll(m) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    }
+
+void compared()
+    {
+    vxworks::priority_queue<int, std::less<int> > q(8);
+    int m = 0;
+
+    /* the greatest first within a band, but never ahead of a more urgent one */
+    q.push(1, 3);
+    q.push(8, 3);
+    q.push(4, 3);
+    q.push(2, 1);
+    const int order[] = {2, 8, 4, 1};
+    for (int expect : order)
+	CHECK(q.poll(m) != ERROR && m == expect);
+    }
+
+void pending()
+    {
+    int_queue q(2);
+    int m = 0;
+
+    q.push(1, 5);
+    q.push(2, 5);
+    CHECK(q.send(3, 0, NO_WAIT) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(q.send(3, 0, 2000) == ERROR && errno == S_objLib_OBJ_TIMEOUT);
+
+    /* a full queue pends the sender until a message is received */
+    std::thread sender([&] { CHECK(q.send(3, 0) == OK); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(q.recieve(m) != ERROR && m == 1);
+    sender.join();
+    CHECK(q.recieve(m) != ERROR && m == 3);
+    CHECK(q.recieve(m) != ERROR && m == 2);
+
+    /* and an empty one the receiver until a send */
+    std::thread receiver([&] { CHECK(q.recieve(m) != ERROR && m == 4); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    q.push(4, 9);
+    receiver.join();
+    }
+
+/* a message whose copies throw while <fail> is set */
+struct fragile
+    {
+    static bool fail;
+    int value;
+
+    fragile(int v = 0) : value(v) {}
+    fragile(const fragile& o) : value(o.value) { if (fail) throw 1; }
+    fragile& operator=(const fragile& o)
+	{
+	if (fail)
+	    throw 1;
+	value = o.value;
+	return *this;
+	}
+    };
+
+bool fragile::fail = false;
+
+/* the lock is a mutex semaphore, which its owner could take again, so
+   another task checks that a throw did not leave it taken */
+void thrown()
+    {
+    vxworks::priority_queue<fragile> q(4);
+    fragile m;
+    int threw = 0;
+
+    CHECK(q.send(fragile(1), 3) == OK);
+    fragile::fail = true;
+    try { q.send(fragile(2), 0); } catch (int) { threw++; }
+    try { q.recieve(m, NO_WAIT); } catch (int) { threw++; }
+    fragile::fail = false;
+    CHECK(threw == 2);
+    CHECK(q.size() == 1 && q.size(3) == 1);
+
+    std::thread other([&]
+	{
+	CHECK(q.send(fragile(3), 0, NO_WAIT) == OK);
+	CHECK(q.recieve(m, NO_WAIT) != ERROR && m.value == 3);
+	CHECK(q.recieve(m, NO_WAIT) != ERROR && m.value == 1);
+	});
+    other.join();
+    CHECK(q.size() == 0);
+    }
+}
+
+int main()
+    {
+    bands();
+    compared();
+    pending();
+    thrown();
+    return vxcheck::status("priority_queue");
+    }
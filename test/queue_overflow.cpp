@@ -0,0 +1,217 @@
+/* queue_overflow.cpp - checks of the queue overflow policies and watermarks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Fills a queue of four under each overflow policy and checks what is left
+ * on it and what dropped() counts, and that each watermark callback fires
+ * once per crossing, including a low watermark installed without a high
+ * one, and that the policy can be changed while another task sends.
+ * Checks that coalescing while another task receives keeps every key's
+ * values in order and loses none uncounted, and that a named queue does
+ * not coalesce, and that coalescing is refused on a queue holding messages.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/queue.hpp"
+
+namespace
+{
+struct update
+    {
+    unsigned key;
+    unsigned value;
+    };
+
+/* send <key, value> without pending */
+_Vx_STATUS put(vxworks::queue<update>& q, unsigned key, unsigned value)
+    {
+    update u = {key, value};
+    return q.send(u, NO_WAIT, MSG_PRI_NORMAL);
+    }
+
+/* receive everything on <q>, returning the values in order */
+std::vector<unsigned> drain(vxworks::queue<update>& q)
+    {
+    std::vector<unsigned> values;
+    update u;
+
+    while (q.recieve(u, NO_WAIT) != ERROR)
+	values.push_back(u.value);
+    return values;
+    }
+
+void policies()
+    {
+    vxworks::queue<update> q(4);
+
+    /* a discarded message is reported to its sender */
+    q.overflow(vxworks::overflow_policy::drop_newest);
+    for (unsigned i = 0; i < 4; i++)
+	CHECK(put(q, i, i) == OK);
+    for (unsigned i = 4; i < 6; i++)
+	CHECK(put(q, i, i) == ERROR && errno == ENOBUFS);
+    CHECK(q.dropped() == 2);
+    CHECK((drain(q) == std::vector<unsigned>{0, 1, 2, 3}));
+
+    q.overflow(vxworks::overflow_policy::drop_oldest);
+    for (unsigned i = 0; i < 6; i++)
+	CHECK(put(q, i, i) == OK);
+    CHECK(q.dropped() == 4);
+    CHECK((drain(q) == std::vector<unsigned>{2, 3, 4, 5}));
+
+    /* the index is not made over messages it has not counted */
+    CHECK(put(q, 0, 0) == OK);
+    CHECK(q.coalesce_by([](const update& u) { return u.key; }) == ERROR && errno == EBUSY);
+    CHECK(q.overflow() == vxworks::overflow_policy::drop_oldest);
+    CHECK((drain(q) == std::vector<unsigned>{0}));
+
+    /* the newest message of the same key is replaced in place */
+    CHECK(q.coalesce_by([](const update& u) { return u.key; }) == OK);
+    for (unsigned i = 0; i < 4; i++)
+	CHECK(put(q, i % 2, i) == OK);
+    CHECK(put(q, 0, 10) == OK);
+    CHECK(put(q, 1, 11) == OK);
+    CHECK(q.dropped() == 6);
+    CHECK((drain(q) == std::vector<unsigned>{0, 1, 10, 11}));
+
+    /* with no message of the key, the send fails as a blocking one does */
+    for (unsigned i = 0; i < 4; i++)
+	CHECK(put(q, i, i) == OK);
+    CHECK(put(q, 9, 9) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(q.dropped() == 6);
+    CHECK(drain(q).size() == 4);
+    }
+
+/* change the policy while another task sends; the counts survive */
+void reconfigured()
+    {
+    vxworks::queue<update> q(4);
+    std::atomic<bool> done(false);
+
+    q.overflow(vxworks::overflow_policy::drop_newest);
+    for (unsigned i = 0; i < 6; i++)
+	put(q, i, i);
+    q.overflow(vxworks::overflow_policy::drop_oldest);
+    CHECK(q.dropped() == 2);
+    drain(q);
+
+    std::thread sender([&]
+	{
+	for (unsigned i = 0; i < 20000; i++)
+	    CHECK(put(q, i, i) == OK || errno == ENOBUFS);
+	done = true;
+	});
+    for (unsigned n = 0; !done.load(); n++)
+	{
+	q.overflow((n % 2) ? vxworks::overflow_policy::drop_oldest
+			   : vxworks::overflow_policy::drop_newest);
+	drain(q);
+	}
+    sender.join();
+    CHECK(q.dropped() >= 2);
+    }
+
+void watermarks()
+    {
+    vxworks::queue<update> q(8);
+    unsigned highs = 0;
+    unsigned lows = 0;
+    update u;
+
+    q.watermarks(6, 2, [&](size_t) { highs++; }, [&](size_t) { lows++; });
+    for (unsigned round = 0; round < 2; round++)
+	{
+	for (unsigned i = 0; i < 8; i++)
+	    put(q, i, i);
+	drain(q);
+	}
+    CHECK(highs == 2);
+    CHECK(lows == 2);
+
+    /* a low watermark on its own fires after each rise past the high */
+    lows = 0;
+    q.watermarks(6, 2, nullptr, [&](size_t) { lows++; });
+    for (unsigned i = 0; i < 5; i++)
+	put(q, i, i);
+    drain(q);
+    CHECK(lows == 0);
+    for (unsigned i = 0; i < 6; i++)
+	put(q, i, i);
+    while (q.recieve(u, NO_WAIT) != ERROR)
+	;
+    CHECK(lows == 1);
+    }
+}
+
+/* coalesce while another task receives: each key's values arrive in order,
+   the last value of every key arrives, and none is lost uncounted */
+void coalesced()
+    {
+    const unsigned keys = 8;
+    const unsigned rounds = 5000;
+    vxworks::queue<update> q(4);
+    std::vector<unsigned> last(keys, 0);
+    std::atomic<bool> done(false);
+    unsigned received = 0;
+    unsigned misordered = 0;
+
+    CHECK(q.coalesce_by([](const update& u) { return u.key; }) == OK);
+    std::thread receiver([&]
+	{
+	update u;
+	for (;;)
+	    {
+	    if (q.recieve(u, 1) == ERROR)
+		{
+		if (done.load())
+		    break;
+		continue;
+		}
+	    if (u.value != 0 && u.value <= last[u.key])
+		misordered++;
+	    last[u.key] = u.value;
+	    received++;
+	    }
+	});
+    for (unsigned v = 1; v <= rounds; v++)
+	for (unsigned k = 0; k < keys; k++)
+	    {
+	    update u = {k, v};
+	    CHECK(q.send(u, WAIT_FOREVER, MSG_PRI_NORMAL) == OK);
+	    }
+    done.store(true);
+    receiver.join();
+    CHECK(misordered == 0);
+    for (unsigned k = 0; k < keys; k++)
+	CHECK(last[k] == rounds);
+    CHECK(received + q.dropped() == keys * rounds);
+    }
+
+/* on a named queue coalescing falls back to pending */
+void named()
+    {
+    vxworks::queue<update> q("/queue_overflow", 2);
+
+    q.coalesce_by([](const update& u) { return u.key; });
+    CHECK(put(q, 0, 0) == OK);
+    CHECK(put(q, 0, 1) == OK);
+    CHECK(put(q, 0, 2) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(q.dropped() == 0);
+    CHECK((drain(q) == std::vector<unsigned>{0, 1}));
+    }
+
+int main()
+    {
+    policies();
+    reconfigured();
+    coalesced();
+    named();
+    watermarks();
+    return vxcheck::status("queue_overflow");
+    }
@@ -0,0 +1,152 @@
+/* queue_telemetry.cpp - checks of the statistics kept by queue_telemetry */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Sends and receives on a queue with telemetry with known delays and
+ * timeouts, and checks every field of the snapshot: the counts of messages
+ * and of timeouts, the high-water mark, and the bucket of the latency
+ * histogram that each message's time in the queue falls in. The bucketing
+ * and percentiles are also checked directly with fixed timestamps.
+ */
+
+#include <chrono>
+#include <thread>
+#include "check.hpp"
+#include "vxworks/queue.hpp"
+
+namespace
+{
+typedef vxworks::queue<int, vxworks::queue_telemetry> telemetry_queue;
+
+/* send <value>, which queue::send() takes by reference */
+_Vx_STATUS put(telemetry_queue& q, int value, _Vx_ticks_t timeout = WAIT_FOREVER)
+    {
+    return q.send(value, timeout, MSG_PRI_NORMAL);
+    }
+
+/* the number of messages counted in the histogram */
+unsigned long long counted(const vxworks::queue_stats& s)
+    {
+    unsigned long long n = 0;
+
+    for (unsigned i = 0; i < vxworks::queue_stats::buckets; i++)
+	n += s.latency[i];
+    return n;
+    }
+
+/* the lowest bucket holding a message, or buckets if none does */
+unsigned lowest(const vxworks::queue_stats& s)
+    {
+    unsigned i = 0;
+
+    while (i < vxworks::queue_stats::buckets && s.latency[i] == 0)
+	i++;
+    return i;
+    }
+
+void counters()
+    {
+    telemetry_queue q(4);
+    int m = 0;
+
+    vxworks::queue_stats s = q.snapshot();
+    CHECK(s.sends == 0 && s.receives == 0 && s.high_water == 0);
+    CHECK(counted(s) == 0 && s.percentile(0.99) == 0);
+
+    /* three messages deep, then drained */
+    for (int i = 1; i <= 3; i++)
+	CHECK(put(q, i) == OK);
+    for (int i = 1; i <= 3; i++)
+	CHECK(q.recieve(m) != ERROR && m == i);
+    s = q.snapshot();
+    CHECK(s.sends == 3);
+    CHECK(s.receives == 3);
+    CHECK(s.high_water == 3);
+    CHECK(counted(s) == 3);
+
+    /* filled: a send that times out is counted, one that cannot wait is not */
+    for (int i = 0; i < 4; i++)
+	CHECK(put(q, i, NO_WAIT) == OK);
+    CHECK(put(q, 9, NO_WAIT) == ERROR);
+    CHECK(put(q, 9, 1000) == ERROR);
+    s = q.snapshot();
+    CHECK(s.sends == 7);
+    CHECK(s.send_timeouts == 1);
+    CHECK(s.high_water == 4);
+
+    /* emptied: likewise for receives */
+    while (q.recieve(m, NO_WAIT) != ERROR)
+	;
+    CHECK(q.recieve(m, 1000) == ERROR);
+    CHECK(q.recieve(m, 1000) == ERROR);
+    s = q.snapshot();
+    CHECK(s.receives == 7);
+    CHECK(s.receive_timeouts == 2);
+    CHECK(s.send_timeouts == 1);
+
+    q.reset_telemetry();
+    s = q.snapshot();
+    CHECK(s.sends == 0 && s.receives == 0 && s.high_water == 0);
+    CHECK(s.send_timeouts == 0 && s.receive_timeouts == 0);
+    CHECK(counted(s) == 0);
+    }
+
+void latency()
+    {
+    telemetry_queue q(4);
+    int m = 0;
+
+    /* a message left in the queue for 2 ms lands in the bucket of 2^20 ns
+       to 2^21 ns, or a little above if the host was slow to wake */
+    CHECK(put(q, 1) == OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    CHECK(q.recieve(m) != ERROR);
+    vxworks::queue_stats s = q.snapshot();
+    CHECK(counted(s) == 1);
+    CHECK(lowest(s) >= 20 && lowest(s) <= 23);
+    CHECK(s.percentile(1.0) >= 2000000);
+
+    /* one received at once lands well below */
+    q.reset_telemetry();
+    CHECK(put(q, 2) == OK);
+    CHECK(q.recieve(m) != ERROR);
+    s = q.snapshot();
+    CHECK(counted(s) == 1);
+    CHECK(lowest(s) < 20);
+    }
+
+void buckets()
+    {
+    vxworks::queue_telemetry t;
+    unsigned long long now = vxworks::queue_telemetry::now();
+
+    /* a stamp in the future counts as no time at all */
+    t.received(now + 1000000000ull);
+    /* 2^30 ns and a little more */
+    t.received(vxworks::queue_telemetry::now() - (1ull << 30));
+    vxworks::queue_stats s = t.snapshot();
+    CHECK(s.latency[0] == 1);
+    CHECK(s.latency[30] == 1);
+    CHECK(counted(s) == 2);
+    CHECK(s.percentile(0.5) == 2);
+    CHECK(s.percentile(1.0) == 2ull << 30);
+
+    /* the high-water mark only rises */
+    t.sent(5);
+    t.sent(2);
+    t.sent(-1);
+    CHECK(t.snapshot().high_water == 5);
+    CHECK(t.snapshot().sends == 3);
+    }
+}
+
+int main()
+    {
+    counters();
+    latency();
+    buckets();
+    return vxcheck::status("queue_telemetry");
+    }
@@ -0,0 +1,149 @@
+/* rate_limiter.cpp - checks of the token-bucket rate limiter */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Checks that a new limiter holds a full burst and no more, that a take()
+ * that cannot be met in time fails at once and reserves nothing, that
+ * acquire() and take() wait as long as the rate says, that a rate that is
+ * not positive is refused, that permits accrue
+ * while idle up to the burst, and that tasks racing in try_acquire() are
+ * granted no more than the burst plus what accrued meanwhile. All times
+ * are checked against std::chrono::steady_clock, with slack only on the
+ * side that a busy host can stretch.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/rate_limiter.hpp"
+
+namespace
+{
+typedef std::chrono::steady_clock clock_type;
+
+double ms_since(clock_type::time_point start)
+    {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    }
+
+_Vx_ticks_t ticks(int ms)
+    {
+    return static_cast<_Vx_ticks_t>(ms * (sysClkRateGet() / 1000));
+    }
+
+void burst()
+    {
+    vxworks::rate_limiter limit(10.0, 5);
+
+    CHECK(std::fabs(limit.rate() - 10.0) < 1e-6 && limit.burst() == 5);
+    CHECK(limit.available() == 5);
+    for (int i = 0; i < 5; i++)
+	CHECK(limit.try_acquire());
+    CHECK(!limit.try_acquire());
+    CHECK(limit.available() == 0);
+    CHECK(limit.take(1, NO_WAIT) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+
+    /* a permit is 100 ms away, so a take of 1 ms fails at once */
+    clock_type::time_point start = clock_type::now();
+    CHECK(limit.take(1, ticks(1)) == ERROR && errno == S_objLib_OBJ_TIMEOUT);
+    CHECK(ms_since(start) < 50);
+
+    /* and reserved nothing: the next permit still comes after 100 ms */
+    CHECK(limit.take(1, ticks(1000)) == OK);
+    double waited = ms_since(start);
+    CHECK(waited >= 95 && waited < 190);
+    }
+
+void paced()
+    {
+    vxworks::rate_limiter limit(200.0);
+
+    /* the first permit is there, each of the next ten 5 ms later */
+    clock_type::time_point start = clock_type::now();
+    for (int i = 0; i <= 10; i++)
+	limit.acquire();
+    CHECK(ms_since(start) >= 49);
+
+    /* several at once wait for all of them */
+    start = clock_type::now();
+    CHECK(limit.take(4, ticks(1000)) == OK);
+    CHECK(ms_since(start) >= 19);
+
+    /* a higher rate applies to the permits acquired after it */
+    CHECK(limit.set_rate(1000.0) == OK);
+    CHECK(std::fabs(limit.rate() - 1000.0) < 1e-6);
+
+    /* a rate that is not positive is refused and changes nothing */
+    CHECK(limit.set_rate(0.0) == ERROR && errno == EINVAL);
+    CHECK(limit.set_rate(-5.0) == ERROR && errno == EINVAL);
+    CHECK(limit.set_rate(std::nan("")) == ERROR && errno == EINVAL);
+    CHECK(std::fabs(limit.rate() - 1000.0) < 1e-6);
+    start = clock_type::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (int i = 0; i < 10; i++)
+	limit.acquire();
+    CHECK(ms_since(start) >= 18);
+    }
+
+void idle()
+    {
+    vxworks::rate_limiter limit(1000.0, 4);
+
+    while (limit.try_acquire())
+	;
+    CHECK(limit.available() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    CHECK(limit.available() >= 1);
+
+    /* no more than the burst accrues */
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(limit.available() == 4);
+    limit.set_burst(8);
+    CHECK(limit.burst() == 8);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(limit.available() == 8);
+    CHECK(limit.take(8, NO_WAIT) == OK && limit.available() == 0);
+    }
+
+void raced()
+    {
+    const int tasks = 4;
+    const double rate = 2000.0;
+    const int burst = 10;
+    vxworks::rate_limiter limit(rate, burst);
+    std::atomic<long> granted(0);
+    std::vector<std::thread> threads;
+
+    clock_type::time_point start = clock_type::now();
+    for (int t = 0; t < tasks; t++)
+	threads.emplace_back([&]
+	    {
+	    while (ms_since(start) < 100)
+		if (limit.try_acquire())
+		    granted++;
+		else
+		    std::this_thread::yield();
+	    });
+    for (auto& th : threads)
+	th.join();
+    double elapsed = ms_since(start);
+
+    CHECK(granted.load() <= burst + static_cast<long>(elapsed * rate / 1000) + 1);
+    CHECK(granted.load() >= static_cast<long>(100 * rate / 1000) / 2);
+    }
+}
+
+int main()
+    {
+    burst();
+    paced();
+    idle();
+    raced();
+    return vxcheck::status("rate_limiter");
+    }
@@ -0,0 +1,145 @@
+/* rcu_ptr.cpp - checks of the reclamation of rcu_ptr versions */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Counts the versions alive and checks that an update with no reader
+ * deletes the version it replaces at once, that one a task is reading,
+ * through a nested guard too, stays readable and is kept until the guard
+ * goes, that a reader which started after the update does not hold it
+ * back, that synchronize() waits for a reader, that the detector watchdog
+ * publishes the oldest epoch, and that the destructor deletes the rest.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "check.hpp"
+#include "vxworks/rcu_ptr.hpp"
+
+namespace
+{
+std::atomic<int> alive(0);
+
+struct version
+    {
+    int value;
+
+    explicit version(int v) : value(v) { alive++; }
+    ~version() { alive--; }
+    };
+
+typedef vxworks::rcu_ptr<version> version_ptr;
+
+/* run <body> in a task that holds a guard on <p> until <release> is set */
+struct holder
+    {
+    std::atomic<bool> holding {false};
+    std::atomic<bool> release {false};
+    std::atomic<int> seen {0};
+    std::thread task;
+
+    explicit holder(version_ptr& p) : task([this, &p]
+	{
+	auto outer = p.read();
+	{
+	auto inner = p.read();
+	seen = inner->value;
+	}
+	holding = true;
+	while (!release.load())
+	    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	seen = outer->value;
+	})
+	{
+	while (!holding.load())
+	    std::this_thread::yield();
+	}
+
+    void finish()
+	{
+	release = true;
+	task.join();
+	}
+    };
+
+void unread()
+    {
+    {
+    version_ptr p(new version(1));
+
+    CHECK(p.read()->value == 1);
+    p.update(new version(2));
+    CHECK(p.retired_count() == 0 && alive.load() == 1);
+    CHECK(p.read()->value == 2);
+    CHECK(p.reclaim() == 0);
+    }
+    CHECK(alive.load() == 0);
+    }
+
+void read()
+    {
+    {
+    version_ptr p(new version(1));
+    holder h(p);
+
+    /* the version the holder reads outlives the update */
+    p.update(new version(2));
+    CHECK(p.retired_count() == 1 && alive.load() == 2);
+    CHECK(p.reclaim() == 1);
+    CHECK(p.read()->value == 2);
+
+    /* a reader that started after the update does not hold it back */
+    holder late(p);
+    h.finish();
+    CHECK(h.seen.load() == 1);
+    CHECK(p.reclaim() == 0 && alive.load() == 1);
+
+    /* but keeps the version it reads, until synchronize() sees it leave */
+    p.update(new version(3));
+    CHECK(p.retired_count() == 1);
+    std::thread leaving([&]
+	{
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	late.finish();
+	});
+    p.synchronize();
+    leaving.join();
+    CHECK(late.seen.load() == 2);
+    CHECK(p.retired_count() == 0 && alive.load() == 1);
+
+    /* the destructor deletes what is still retired */
+    holder last(p);
+    p.update(new version(4));
+    last.finish();
+    CHECK(alive.load() == 2);
+    }
+    CHECK(alive.load() == 0);
+    }
+
+void detector()
+    {
+    version_ptr p(new version(1));
+    holder h(p);
+
+    CHECK(vxworks::rcu_domain::start_detector(100) == OK);
+    p.update(new version(2));
+    CHECK(p.retired_count() == 1);
+    h.finish();
+    /* reclaim() only compares with what the watchdog last published */
+    p.synchronize();
+    CHECK(p.retired_count() == 0 && alive.load() == 1);
+    CHECK(vxworks::rcu_domain::start_detector(0) == OK);
+    }
+}
+
+int main()
+    {
+    unread();
+    read();
+    detector();
+    CHECK(alive.load() == 0);
+    return vxcheck::status("rcu_ptr");
+    }
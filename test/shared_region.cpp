@@ -0,0 +1,99 @@
+/* shared_region.cpp - checks of opening named shared regions */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Opens each class that lives in a named shared data region a second
+ * time, as another context would, both asking to create it and not, and
+ * checks that the second open attaches to the state the first left rather
+ * than initialising it again.
+ */
+
+#include "check.hpp"
+#include "vxworks/broadcast_ring.hpp"
+#include "vxworks/object_pool.hpp"
+#include "vxworks/topic.hpp"
+
+namespace
+{
+struct block
+    {
+    unsigned long long value;
+    };
+
+void pools()
+    {
+    vxworks::shared_object_pool<block, 8> creator("/test.pool");
+    block * b = creator.make();
+    CHECK(b != nullptr);
+    b->value = 42;
+    size_t i = creator.index(b);
+    size_t left = creator.available();
+
+    vxworks::shared_object_pool<block, 8> attached("/test.pool", false);
+    CHECK(attached.available() == left);
+    CHECK(attached.at(i)->value == 42);
+
+    vxworks::shared_object_pool<block, 8> racer("/test.pool");
+    CHECK(racer.available() == left);
+
+    /* the block handed out before is not handed out again */
+    for (block * p; (p = attached.make()) != nullptr; )
+	CHECK(attached.index(p) != i);
+    }
+
+void topics()
+    {
+    vxworks::topic<int> creator("/test.topic", 8);
+    vxworks::topic<int>::subscriber s(creator);
+    int m = 0;
+
+    CHECK(creator.publish(1) == OK);
+    CHECK(creator.publish(2) == OK);
+
+    /* the subscriber and what it has not read survive both opens */
+    vxworks::topic<int> attached("/test.topic", 8, false);
+    CHECK(s.backlog() == 2);
+    vxworks::topic<int> racer("/test.topic", 8);
+    CHECK(racer.capacity() == 8);
+
+    /* and a message published through either reaches it after the others */
+    CHECK(attached.publish(3) == OK);
+    for (int i = 1; i <= 3; i++)
+	CHECK(s.receive(m, NO_WAIT) == OK && m == i);
+    CHECK(s.receive(m, NO_WAIT) == ERROR);
+    }
+
+void rings()
+    {
+    vxworks::broadcast_ring<int> writer("/test.ring", 8);
+    vxworks::broadcast_ring<int>::reader r(writer);
+
+    for (int i = 0; i < 5; i++)
+	writer.write(i);
+
+    vxworks::broadcast_ring<int> attached("/test.ring", 8, false);
+    CHECK(attached.published() == 5);
+    vxworks::broadcast_ring<int> racer("/test.ring", 8);
+    CHECK(racer.published() == 5);
+    CHECK(writer.published() == 5);
+    CHECK(r.backlog() == 5);
+
+    /* a reader of the attached ring sees what the writer publishes next */
+    vxworks::broadcast_ring<int>::reader follower(attached);
+    writer.write(5);
+    vxworks::broadcast_ring<int>::batch b = follower.read(8);
+    CHECK(b.count == 1 && b.first == 5 && b.data[0] == 5);
+    CHECK(follower.release(b));
+    }
+}
+
+int main()
+    {
+    pools();
+    topics();
+    rings();
+    return vxcheck::status("shared_region");
+    }
@@ -0,0 +1,234 @@
+/* stop_wait.cpp - checks of stoppable waits on a shared object */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Pends several tasks in stoppable waits on one semaphore, on one empty
+ * queue and on one full queue, with which only one of them at a time can
+ * register for events, and checks
+ * that each give or send completes one wait, so the registration is handed
+ * on, and that a stop then ends the waits left with ECANCELED. Checks that
+ * a wait still completes while a task that never hands on holds the
+ * registration. Then stops a wait on a condition variable from a task that
+ * does not hold its mutex and from one that does, which must keep it, also
+ * with a scalable mutex, which cannot detect a second take by its owner,
+ * and checks that a wait that fails, as without the mutex, returns at once.
+ * Last stops exclusive and shared locks of a shared_mutex held by another
+ * task, on the semaphore and, when scalable, while a writer waits for its
+ * readers.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "vxworks/condition_variable.hpp"
+#include "vxworks/queue.hpp"
+#include "vxworks/semaphore.hpp"
+#include "vxworks/shared_mutex.hpp"
+#include <semEvLib.h>
+#include "vxworks/stop_token.hpp"
+
+namespace
+{
+const unsigned waiters = 8;
+const unsigned served = 5;
+
+/* run <wait(token)> in <waiters> tasks, call <feed> <served> times, and
+   check that as many waits completed and that a stop ends the others */
+template <typename Wait, typename Feed>
+void shared(Wait wait, Feed feed)
+    {
+    vxworks::stop_source source;
+    std::atomic<unsigned> done(0);
+    std::atomic<unsigned> cancelled(0);
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < waiters; t++)
+	threads.emplace_back([&]
+	    {
+	    if (wait(source.get_token()) == OK)
+		done++;
+	    else if (errno == ECANCELED)
+		cancelled++;
+	    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    for (unsigned i = 0; i < served; i++)
+	{
+	feed();
+	for (int ms = 0; ms < 2000 && done.load() < i + 1; ms++)
+	    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	CHECK(done.load() == i + 1);
+	}
+
+    source.request_stop();
+    for (auto& th : threads)
+	th.join();
+    CHECK(done.load() == served);
+    CHECK(cancelled.load() == waiters - served);
+    }
+
+/* pend in a stoppable take of a semaphore whose events another task has
+   registered for, outside any stoppable wait, and check a give ends it */
+void foreign()
+    {
+    vxworks::counting_semaphore sem(0);
+    vxworks::stop_source source;
+    std::atomic<bool> done(false);
+
+    CHECK(::semEvStart(sem.handle(), VXEV01, 0) == OK);
+    std::thread waiter([&]
+	{
+	CHECK(sem.take(WAIT_FOREVER, source.get_token()) == OK);
+	done = true;
+	});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sem.give();
+    for (int ms = 0; ms < 2000 && !done.load(); ms++)
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(done.load());
+    if (!done.load())
+	source.request_stop();
+    waiter.join();
+    ::semEvStop(sem.handle());
+    }
+
+/* stop a task waiting on a condition variable, holding its mutex <m> if
+   <held> */
+void condvar(vxworks::mutex& m, bool held)
+    {
+    vxworks::condition_variable cv(CONDVAR_Q_PRIORITY);
+    vxworks::stop_source source;
+    std::atomic<bool> waiting(false);
+    std::atomic<bool> finished(false);
+
+    std::thread waiter([&]
+	{
+	m.lock();
+	waiting = true;
+	CHECK(!cv.wait(m, source.get_token(), [] { return false; }));
+	finished = true;
+	m.unlock();
+	});
+    while (!waiting.load())
+	std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    if (held)
+	{
+	m.lock();
+	source.request_stop();
+	/* the waiter is woken, but cannot return without the mutex */
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(!finished.load());
+	CHECK(static_cast<bool>(m.unlock(std::nothrow)));
+	}
+    else
+	source.request_stop();
+    waiter.join();
+    CHECK(finished.load());
+    }
+
+/* run <wait(token)> in another task while <hold> and <release> keep the
+   lock, and check that a stop ends it with ECANCELED */
+template <typename Hold, typename Wait, typename Release>
+void stopped(Hold hold, Wait wait, Release release)
+    {
+    vxworks::stop_source source;
+    std::atomic<bool> cancelled(false);
+
+    hold();
+    std::thread waiter([&]
+	{
+	cancelled = (wait(source.get_token()) == ERROR && errno == ECANCELED);
+	});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    source.request_stop();
+    waiter.join();
+    release();
+    CHECK(cancelled.load());
+    }
+
+void shared_mutexes()
+    {
+    vxworks::shared_mutex rw;
+    stopped([&] { rw.lock(); },
+	    [&](vxworks::stop_token st) { return rw.lock(st); },
+	    [&] { rw.unlock(); });
+    stopped([&] { rw.lock(); },
+	    [&](vxworks::stop_token st) { return rw.lock_shared(st); },
+	    [&] { rw.unlock(); });
+
+    vxworks::shared_timed_mutex quick(SEM_Q_PRIORITY, 20, vxworks::scalable);
+    stopped([&] { quick.lock(); },
+	    [&](vxworks::stop_token st) { return quick.take_shared(WAIT_FOREVER, st); },
+	    [&] { quick.unlock(); });
+    /* the writer takes the semaphore, then waits for the reader */
+    stopped([&] { quick.lock_shared(); },
+	    [&](vxworks::stop_token st) { return quick.take(WAIT_FOREVER, st); },
+	    [&] { quick.unlock_shared(); });
+    CHECK(quick.try_lock());
+    quick.unlock();
+    }
+
+/* wait without owning the mutex: condVarWait() fails, which must end the
+   wait rather than retry it until the timeout */
+void unowned()
+    {
+    vxworks::mutex m;
+    vxworks::condition_variable cv(CONDVAR_Q_PRIORITY);
+    vxworks::stop_source source;
+    auto start = std::chrono::steady_clock::now();
+
+    CHECK(!cv.wait_for(m, std::chrono::seconds(2), source.get_token(),
+		       [] { return false; }));
+    CHECK(errno == S_semLib_INVALID_OPERATION);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    }
+}
+
+int main()
+    {
+    vxworks::counting_semaphore sem(0);
+    shared([&](vxworks::stop_token st) { return sem.take(WAIT_FOREVER, st); },
+	   [&] { sem.give(); });
+
+    vxworks::queue<int> q(4);
+    shared([&](vxworks::stop_token st)
+	{
+	int m = 0;
+	return (q.recieve(m, WAIT_FOREVER, st) == ERROR) ? ERROR : OK;
+	}, [&]
+	{
+	int m = 1;
+	q.send(m, NO_WAIT, MSG_PRI_NORMAL);
+	});
+
+    vxworks::queue<int> full(1);
+    int first = 0;
+    full.send(first, NO_WAIT, MSG_PRI_NORMAL);
+    shared([&](vxworks::stop_token st)
+	{
+	int m = 1;
+	return full.send(m, WAIT_FOREVER, st);
+	}, [&]
+	{
+	int m = 0;
+	full.poll(m);
+	});
+
+    foreign();
+
+    vxworks::mutex m;
+    condvar(m, false);
+    condvar(m, true);
+    vxworks::mutex sm(vxworks::scalable);
+    condvar(sm, false);
+    condvar(sm, true);
+    unowned();
+    shared_mutexes();
+    return vxcheck::status("stop_wait");
+    }
@@ -0,0 +1,70 @@
+/* topic.cpp - checks of an unnamed topic */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Creates an unnamed topic in storage and a ring left dirty, as a reused
+ * heap block would be, and checks that every slot starts empty: a
+ * subscriber receives what was published, in order, and then finds nothing
+ * rather than taking a stale slot for a lapped one.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "check.hpp"
+#include "vxworks/topic.hpp"
+
+/* hand out the topic's ring filled with ones, as a freed block might be */
+void * operator new(size_t size, std::align_val_t align)
+    {
+    size_t a = static_cast<size_t>(align);
+    void * p = std::aligned_alloc(a, (size + a - 1) / a * a);
+
+    if (p == nullptr)
+	throw std::bad_alloc();
+    memset(p, 0xff, size);
+    return p;
+    }
+
+void operator delete(void * p, std::align_val_t) noexcept
+    {
+    std::free(p);
+    }
+
+namespace
+{
+typedef vxworks::topic<int> int_topic;
+
+void dirty()
+    {
+    alignas(int_topic) unsigned char storage[sizeof(int_topic)];
+    memset(storage, 0, sizeof(storage));
+    int_topic * t = new (storage) int_topic(8);
+    int m = 0;
+
+    {
+    int_topic::subscriber s(*t);
+
+    CHECK(s.receive(m, NO_WAIT) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    for (int i = 1; i <= 3; i++)
+	CHECK(t->publish(i) == OK);
+    CHECK(s.backlog() == 3);
+    for (int i = 1; i <= 3; i++)
+	CHECK(s.receive(m, NO_WAIT) == OK && m == i);
+    CHECK(s.receive(m, NO_WAIT) == ERROR && errno == S_objLib_OBJ_UNAVAILABLE);
+    CHECK(s.receive(m, NO_WAIT) == ERROR);
+    CHECK(s.dropped() == 0 && s.backlog() == 0);
+    }
+
+    t->~int_topic();
+    }
+}
+
+int main()
+    {
+    dirty();
+    return vxcheck::status("topic");
+    }
@@ -0,0 +1,63 @@
+/* vxtrace.cpp - convert a saved synchronization trace to Chrome trace JSON */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * usage: vxtrace <trace.bin> [<trace.json>]
+ *
+ * Reads a file written by vxworks::trace::save() and writes it in the
+ * Chrome trace event format, to standard output if no output file is
+ * named, for loading into ui.perfetto.dev or chrome://tracing.
+ */
+
+#include "vxworks/trace.hpp"
+#include <cstring>
+#include <vector>
+
+using vxworks::trace;
+using vxworks::trace_record;
+
+int main(int argc, char ** argv)
+    {
+    if (argc < 2 || argc > 3)
+	{
+	fprintf(stderr, "usage: %s <trace.bin> [<trace.json>]\n", argv[0]);
+	return 2;
+	}
+
+    FILE * in = fopen(argv[1], "rb");
+    if (in == NULL)
+	{
+	perror(argv[1]);
+	return 1;
+	}
+
+    trace::file_header h;
+    if (fread(&h, sizeof(h), 1, in) != 1 ||
+	memcmp(h.magic, "VXTRACE", 8) != 0 || h.version != 1)
+	{
+	fprintf(stderr, "%s: not a trace file\n", argv[1]);
+	fclose(in);
+	return 1;
+	}
+
+    std::vector<trace_record> records(h.count);
+    size_t n = fread(records.data(), sizeof(trace_record), records.size(), in);
+    fclose(in);
+    if (n != records.size())
+	fprintf(stderr, "%s: truncated after %zu of %u records\n", argv[1], n,
+		h.count);
+
+    FILE * out = (argc == 3) ? fopen(argv[2], "w") : stdout;
+    if (out == NULL)
+	{
+	perror(argv[2]);
+	return 1;
+	}
+    trace::write_json(out, records.data(), n, h.ticksPerUs);
+    if (out != stdout)
+	fclose(out);
+    return 0;
+    }
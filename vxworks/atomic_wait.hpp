@@ -0,0 +1,246 @@
+/* atomic_wait.hpp - wait for an atomic word to change */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCatomicwaithpp
+#define __INCatomicwaithpp
+
+#include <eventLib.h>
+#include <objLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "chrono2tic.hpp"
+#include "events.hpp"
+#include "ticks.hpp"
+#include "spin_lock.hpp"
+
+#ifndef VX_ATOMIC_WAIT_BUCKETS
+#define VX_ATOMIC_WAIT_BUCKETS 64	/* wait queues, a power of two */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  The Table of Waiters on Atomic Words
+
+ atomic_wait() and atomic_notify_one()/atomic_notify_all() let a task pend
+ until a word of memory changes, like a futex or C++20 std::atomic::wait(),
+ without a semaphore or an event bit for every word. The waiting task
+ enters a wait queue chosen by hashing the word's address, in a fixed table
+ of VX_ATOMIC_WAIT_BUCKETS queues, and receives the VX_ATOMIC_WAIT_EVENT
+ event when it is notified.
+
+ A waiter enters its queue before it checks the word for the last time, and
+ a notifier looks for waiters only after it has changed the word, so a
+ change cannot be missed between the check and the pend: either the waiter
+ sees the new value, or the notifier sees the waiter and sends it the event,
+ which the task keeps until it receives it. Notifiers only wake waiters on
+ the same address, so words that share a queue do not steal each other's
+ notifications. A notification with no one waiting costs a fence and a
+ load.
+
+ Wake-ups may be spurious; atomic_wait() checks the word again before it
+ returns, so only its callers' own loops need to cope with the ABA case of
+ a word changing and changing back. The event VX_ATOMIC_WAIT_EVENT is
+ reserved for the table in every task that waits, and notifications must
+ be made at task level.
+*/
+class atomic_waiters
+    {
+private:
+    static const size_t buckets = VX_ATOMIC_WAIT_BUCKETS;
+    static_assert((buckets & (buckets - 1)) == 0, "VX_ATOMIC_WAIT_BUCKETS must be a power of two");
+
+    /* a pended task, on its own stack */
+    struct waiter
+	{
+	const void * addr;
+	TASK_ID task;
+	bool woken;
+	waiter * next;
+	};
+
+    struct alignas(64) bucket
+	{
+	spin_lock lock;
+	std::atomic<int> count{0};
+	waiter * head = nullptr;
+	};
+
+    static bucket& of(const void * addr) noexcept
+	{
+	static bucket table[buckets];
+	uintptr_t a = (uintptr_t) addr;
+	return table[((a >> 4) ^ (a >> 12)) & (buckets - 1)];
+	}
+
+    static void enter(bucket& b, waiter& w) noexcept
+	{
+	b.lock.lock();
+	w.woken = false;
+	w.next = b.head;
+	b.head = &w;
+	b.lock.unlock();
+	b.count.fetch_add(1, std::memory_order_seq_cst);
+	}
+
+    static void leave(bucket& b, waiter& w) noexcept
+	{
+	b.lock.lock();
+	for (waiter ** p = &b.head; *p != nullptr; p = &(*p)->next)
+	    if (*p == &w)
+		{
+		*p = w.next;
+		break;
+		}
+	b.lock.unlock();
+	b.count.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+public:
+    /*! Pend on *addr* for up to *timeout* ticks while *unchanged*() is
+        true. Returns OK once it is false, or ERROR with errno set to
+	S_objLib_OBJ_TIMEOUT, or S_objLib_OBJ_UNAVAILABLE for NO_WAIT.
+    */
+    template <typename Pred>
+    static _Vx_STATUS wait(const void * addr, Pred unchanged, _Vx_ticks_t timeout)
+	{
+	if (!unchanged())
+	    return OK;
+	if (timeout == NO_WAIT)
+	    {
+	    errno = S_objLib_OBJ_UNAVAILABLE;
+	    return ERROR;
+	    }
+
+	bucket& b = of(addr);
+	waiter w = { addr, ::taskIdSelf(), false, nullptr };
+	_Vx_ticks64_t start = ::tick64Get();
+
+	for (;;)
+	    {
+	    enter(b, w);
+	    _Vx_ticks_t left = remaining(timeout, start);
+	    _Vx_STATUS status = OK;
+	    if (unchanged() && left != 0)
+		status = ::eventReceiveEx(VX_ATOMIC_WAIT_EVENT,
+					  EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED,
+					  left, NULL);
+	    leave(b, w);
+	    if (!unchanged())
+		return OK;
+	    if (status != OK || remaining(timeout, start) == 0)
+		{
+		errno = S_objLib_OBJ_TIMEOUT;
+		return ERROR;
+		}
+	    }
+	}
+
+    //! Wake one task, or with *all* every task, pended on *addr*
+    static void notify(const void * addr, bool all) noexcept
+	{
+	bucket& b = of(addr);
+
+	/* pairs with the waiter entering before its last check */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (b.count.load(std::memory_order_relaxed) == 0)
+	    return;
+	/* send the events once the lock is released, so that a woken task
+	   does not spin on it; any beyond the first few are sent holding it */
+	TASK_ID wake[8];
+	unsigned n = 0;
+
+	b.lock.lock();
+	for (waiter * w = b.head; w != nullptr; w = w->next)
+	    {
+	    if (w->addr != addr || w->woken)
+		continue;
+	    w->woken = true;
+	    if (n < sizeof(wake) / sizeof(wake[0]))
+		wake[n++] = w->task;
+	    else
+		::eventSend(w->task, VX_ATOMIC_WAIT_EVENT);
+	    if (!all)
+		break;
+	    }
+	b.lock.unlock();
+	for (unsigned i = 0; i < n; i++)
+	    ::eventSend(wake[i], VX_ATOMIC_WAIT_EVENT);
+	}
+    };  // atomic_waiters
+
+/*! Pend for up to *timeout* ticks until the value of *addr* is not *old*.
+    Returns OK when it has changed, or ERROR if the timeout expired first.
+
+    \code
+    std::atomic<int> state {IDLE};
+    ...
+    while (state.load() == IDLE)
+        vxworks::atomic_wait(&state, IDLE);
+    \endcode
+*/
+template <typename T>
+inline _Vx_STATUS atomic_wait(const std::atomic<T> * addr,
+			      typename std::atomic<T>::value_type old,
+			      _Vx_ticks_t timeout = WAIT_FOREVER)
+    {
+    return atomic_waiters::wait(addr, [&]
+	{
+	T v = addr->load(std::memory_order_seq_cst);
+	return memcmp(&v, &old, sizeof(T)) == 0;
+	}, timeout);
+    }
+
+/*! Pend for up to *timeout* ticks until the integer at *addr*, which other
+    tasks change with atomic operations, is not *old*.
+*/
+template <typename T>
+inline _Vx_STATUS atomic_wait(const volatile T * addr,
+			      typename std::enable_if<std::is_integral<T>::value, T>::type old,
+			      _Vx_ticks_t timeout = WAIT_FOREVER)
+    {
+    return atomic_waiters::wait(const_cast<const T *>(addr), [&]
+	{ return __atomic_load_n(addr, __ATOMIC_SEQ_CST) == old; }, timeout);
+    }
+
+//! Pend for up to a std::duration until the value of *addr* is not *old*
+template <typename A, typename T, class Rep, class Period>
+inline _Vx_STATUS atomic_wait(A * addr, T old,
+			      const duration<Rep, Period>& relTime)
+    {
+    return vxworks::atomic_wait(addr, old, chrono2tic(relTime));
+    }
+
+//! Pend until a std::time_point or until the value of *addr* is not *old*
+template <typename A, typename T, class Clock, class Duration>
+inline _Vx_STATUS atomic_wait(A * addr, T old,
+			      const time_point<Clock, Duration>& absTime)
+    {
+    return vxworks::atomic_wait(addr, old, time_point2tic(absTime));
+    }
+
+//! Wake one task pended on *addr*; call it after changing the value
+inline void atomic_notify_one(const volatile void * addr) noexcept
+    {
+    atomic_waiters::notify(const_cast<const void *>(addr), false);
+    }
+
+//! Wake every task pended on *addr*; call it after changing the value
+inline void atomic_notify_all(const volatile void * addr) noexcept
+    {
+    atomic_waiters::notify(const_cast<const void *>(addr), true);
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCatomicwaithpp
@@ -0,0 +1,151 @@
+/* barrier.hpp - reusable meeting point for a group of tasks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCbarrierhpp
+#define __INCbarrierhpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include "atomic_wait.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+//! The completion function of a barrier that has none
+struct barrier_noop
+    {
+    void operator()() noexcept
+	{
+	}
+    };
+
+/*!
+
+\brief  A Barrier Class
+
+ The barrier class mimics the C++20 std::barrier: a group of tasks meet at
+ the barrier once per phase, and none leaves until they have all arrived.
+ The last task to arrive runs the completion function, before any of them
+ leaves, and the barrier is then ready for the next phase:
+
+ \code
+ vxworks::barrier<> frame (workers);
+ ...
+ for (;;)
+     {
+     filter (my_slice);
+     frame.arrive_and_wait ();
+     }
+ \endcode
+
+ The tasks still to arrive are counted by a single atomic word, and the
+ phase by another. Arriving costs one atomic operation; the last task to
+ arrive resets the count, advances the phase, and wakes every task pended on
+ it with one atomic_notify_all(), so a phase costs no system calls when the
+ tasks arrive close together, and one eventSend() for each task that did
+ pend otherwise. A waiting task spins on the phase for a while before it
+ pends with atomic_wait(), and the event VX_ATOMIC_WAIT_EVENT is reserved in
+ every task that waits.
+
+ The completion function runs in the last task to arrive; it must not throw,
+ nor arrive at the barrier itself.
+*/
+template <typename CompletionFunction = barrier_noop> class barrier
+    {
+private:
+    static const int spins = 1000;
+
+    alignas(64) std::atomic<std::ptrdiff_t> remaining;
+    std::atomic<std::ptrdiff_t> group;
+    alignas(64) std::atomic<uint32_t> phase{0};
+    CompletionFunction completion;
+
+public:
+    /*!
+
+    \brief  The Phase a Task Arrived In
+
+     Returned by arrive(), and handed to wait() to wait for the end of that
+     phase.
+    */
+    class arrival_token
+	{
+	private:
+	    friend class barrier;
+	    uint32_t phase;
+
+	    explicit arrival_token(uint32_t p) noexcept : phase(p)
+		{
+		}
+	};
+
+    //! Create a barrier for *expected* tasks, running *f* at each phase's end
+    explicit barrier(std::ptrdiff_t expected,
+		     CompletionFunction f = CompletionFunction())
+	: remaining(expected), group(expected), completion(std::move(f))
+	{
+	}
+
+    barrier(const barrier&) = delete;
+    barrier& operator=(const barrier&) = delete;
+
+    //! the largest number of tasks a barrier may be created for
+    static constexpr std::ptrdiff_t max() noexcept
+	{
+	return std::numeric_limits<std::ptrdiff_t>::max();
+	}
+
+    /*! Arrive *n* times in the current phase without waiting. If these are
+        the last arrivals, run the completion function and start the next
+	phase.
+    */
+    arrival_token arrive(std::ptrdiff_t n = 1)
+	{
+	uint32_t p = phase.load(std::memory_order_acquire);
+
+	if (remaining.fetch_sub(n, std::memory_order_acq_rel) == n)
+	    {
+	    completion();
+	    remaining.store(group.load(std::memory_order_relaxed),
+			    std::memory_order_relaxed);
+	    phase.store(p + 1, std::memory_order_release);
+	    vxworks::atomic_notify_all(&phase);
+	    }
+	return arrival_token(p);
+	}
+
+    //! Wait until the phase *token* was returned in has completed
+    void wait(arrival_token&& token) const
+	{
+	for (int i = 0; i < spins; i++)
+	    if (phase.load(std::memory_order_acquire) != token.phase)
+		return;
+	while (phase.load(std::memory_order_acquire) == token.phase)
+	    vxworks::atomic_wait(&phase, token.phase);
+	}
+
+    //! Arrive once and wait for the other tasks
+    void arrive_and_wait()
+	{
+	wait(arrive());
+	}
+
+    /*! Arrive once and leave the group, so the phases that follow wait for
+        one task fewer
+    */
+    void arrive_and_drop()
+	{
+	group.fetch_sub(1, std::memory_order_relaxed);
+	arrive();
+	}
+    };  // barrier
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCbarrierhpp
@@ -0,0 +1,414 @@
+/* broadcast_ring.hpp - single-producer broadcast ring in shared memory */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCbroadcastringhpp
+#define __INCbroadcastringhpp
+
+#include <vxWorks.h>
+#include <eventLib.h>
+#include <objLib.h>
+#include <sdLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include "chrono2tic.hpp"
+#include "events.hpp"
+#include "object.hpp"
+#include "shared_region.hpp"
+#include "ticks.hpp"
+
+#ifndef VX_RING_READERS
+#define VX_RING_READERS 16	/* readers of one ring that may pend at once */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Single-Producer Broadcast Ring Class
+
+ A broadcast_ring carries a stream of samples from one writer, such as a
+ telemetry producer in the kernel, to any number of readers, which may be
+ in RTPs. The samples are written once into a ring in a named shared data
+ region from
+ [sdLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/sdLib.html),
+ and readers look at them where they lie: a reader is handed a batch of
+ consecutive samples in place, processes them, and then checks with
+ release() that the writer did not overwrite them meanwhile. Reading
+ costs no system call and no copy, however many readers there are.
+
+ The writer never waits for a reader. A reader that falls more than a ring
+ behind has missed samples, which it learns from the sequence numbers:
+ the next batch starts at the oldest sample still in the ring, and
+ lost() counts what was skipped. A batch the writer overwrote while it was
+ being processed is rejected by release(), and its results should be
+ discarded.
+
+ Only one task may write to a ring. Readers that want to pend until the
+ writer has published more use wait(); the writer sends the event
+ VX_RING_EVENT to the pended readers only, and at most VX_RING_READERS may
+ pend at once. Samples must be trivially copyable.
+
+ \code
+ // kernel
+ vxworks::broadcast_ring<sample> ring ("/telemetry", 4096);
+ ring.write (s);
+
+ // each RTP
+ vxworks::broadcast_ring<sample> ring ("/telemetry", 4096);
+ vxworks::broadcast_ring<sample>::reader rd (ring);
+ for (;;)
+     {
+     rd.wait ();
+     auto b = rd.read (64);
+     double sum = 0;
+     for (size_t i = 0; i < b.count; i++)
+         sum += b.data[i].value;
+     if (rd.release (b))
+         record (sum);
+     }
+ \endcode
+*/
+template <typename T> class broadcast_ring
+    {
+    static_assert(std::is_trivially_copyable<T>::value,
+		  "broadcast_ring samples are copied into shared memory");
+private:
+    static const uint32_t ready = 0x7370636d;	/* "spcm" */
+    static const unsigned pendable = VX_RING_READERS;
+    static const int spins = 100;
+
+    /* the region holds no pointers, as RTPs may map it at different addresses */
+    struct region
+	{
+	std::atomic<uint32_t> state;
+	uint32_t size;
+	uint32_t capacity;
+	uint32_t sizeT;
+	alignas(64) std::atomic<uint64_t> head;		/* samples published */
+	std::atomic<uint64_t> claimed;			/* samples being, or been, written */
+	alignas(64) std::atomic<uint32_t> pended;
+	std::atomic<uintptr_t> waiter[pendable];
+	};
+
+    static size_t samples_offset() noexcept
+	{
+	return (sizeof(region) + 63) & ~size_t(63);
+	}
+
+    static size_t region_size(uint32_t capacity) noexcept
+	{
+	return samples_offset() + capacity * sizeof(T);
+	}
+
+    static uint32_t roundup(size_t n)
+	{
+	uint32_t cap = 2;
+	while (cap < n)
+	    cap <<= 1;
+	return cap;
+	}
+
+    SD_ID sd = SD_ID_NULL;
+    region * r = nullptr;
+    T * samples = nullptr;
+    uint64_t mask = 0;
+    uint64_t next = 0;		/* the writer's copy of head */
+
+    void init(uint32_t capacity)
+	{
+	new (&r->state) std::atomic<uint32_t>(0);
+	r->size = static_cast<uint32_t>(region_size(capacity));
+	r->capacity = capacity;
+	r->sizeT = sizeof(T);
+	new (&r->head) std::atomic<uint64_t>(0);
+	new (&r->claimed) std::atomic<uint64_t>(0);
+	new (&r->pended) std::atomic<uint32_t>(0);
+	for (unsigned i = 0; i < pendable; i++)
+	    new (&r->waiter[i]) std::atomic<uintptr_t>(0);
+	r->state.store(ready, std::memory_order_release);
+	}
+
+    void map(void * base)
+	{
+	r = static_cast<region *>(base);
+	samples = reinterpret_cast<T *>(static_cast<unsigned char *>(base) +
+					samples_offset());
+	}
+
+    /* wake the readers pended for samples */
+    void wake() noexcept
+	{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (r->pended.load(std::memory_order_relaxed) == 0)
+	    return;
+	for (unsigned i = 0; i < pendable; i++)
+	    {
+	    uintptr_t t = r->waiter[i].exchange(0, std::memory_order_acq_rel);
+	    if (t != 0)
+		::eventSend(reinterpret_cast<TASK_ID>(t), VX_RING_EVENT);
+	    }
+	}
+
+public:
+    typedef T value_type;
+
+    /*!
+
+    \brief  A Batch of Samples, in Place
+
+     The samples of positions *first* to *first* + *count* - 1, at *data*
+     in the ring. They may be overwritten while they are read, so they are
+     only known to be intact if release() returns true.
+    */
+    struct batch
+	{
+	const T * data;		//!< the first sample
+	size_t count;		//!< the number of samples
+	uint64_t first;		//!< the position of the first sample in the stream
+	};
+
+    /*!
+
+    \brief  A Reader of a Broadcast Ring
+
+     A reader starts at the sample the writer will publish next, and keeps
+     its own position, so any number of readers may follow the same ring.
+    */
+    class reader
+	{
+	private:
+	    broadcast_ring& ring;
+	    uint64_t cursor;
+	    uint64_t missed = 0;
+
+	public:
+	    //! Follow *owner* from its next sample
+	    explicit reader(broadcast_ring& owner)
+		: ring(owner),
+		  cursor(owner.r->head.load(std::memory_order_acquire))
+		{
+		}
+
+	    /*! The next samples, at most *max* of them and never wrapping
+	        around the end of the ring, in place. The batch is empty if
+		the writer has published nothing new. If the reader has
+		fallen more than a ring behind, the batch starts at the oldest
+		sample still there, and the samples skipped are added to
+		lost().
+	    */
+	    batch read(size_t max)
+		{
+		uint64_t head = ring.r->head.load(std::memory_order_acquire);
+		uint64_t cap = ring.mask + 1;
+
+		if (head - cursor > cap)
+		    {
+		    missed += head - cap - cursor;
+		    cursor = head - cap;
+		    }
+		uint64_t n = std::min<uint64_t>({head - cursor, max,
+						 cap - (cursor & ring.mask)});
+		return batch {ring.samples + (cursor & ring.mask),
+			      static_cast<size_t>(n), cursor};
+		}
+
+	    /*! Finish with *b*, moving past it. Returns false if the writer
+	        may have overwritten any of its samples while they were read;
+		those samples are then added to lost().
+	    */
+	    bool release(const batch& b)
+		{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t claimed = ring.r->claimed.load(std::memory_order_relaxed);
+
+		cursor = b.first + b.count;
+		if (b.count == 0 || claimed <= b.first + ring.mask + 1)
+		    return true;
+		missed += std::min<uint64_t>(b.count, claimed - (b.first + ring.mask + 1));
+		return false;
+		}
+
+	    /*! Wait for up to *timeout* ticks until there are samples to read.
+	        Returns ERROR with errno set to S_objLib_OBJ_TIMEOUT, or
+		S_objLib_OBJ_UNAVAILABLE for NO_WAIT, if none came.
+	    */
+	    _Vx_STATUS wait(_Vx_ticks_t timeout = WAIT_FOREVER)
+		{
+		region * r = ring.r;
+
+		for (int i = 0; i < spins; i++)
+		    if (r->head.load(std::memory_order_acquire) != cursor)
+			return OK;
+		if (timeout == NO_WAIT)
+		    {
+		    errno = S_objLib_OBJ_UNAVAILABLE;
+		    return ERROR;
+		    }
+
+		_Vx_ticks64_t start = ::tick64Get();
+		uintptr_t self = reinterpret_cast<uintptr_t>(::taskIdSelf());
+		for (;;)
+		    {
+		    if (r->head.load(std::memory_order_acquire) != cursor)
+			return OK;
+		    _Vx_ticks_t left = remaining(timeout, start);
+		    if (left == 0)
+			{
+			errno = S_objLib_OBJ_TIMEOUT;
+			return ERROR;
+			}
+
+		    /* without a free waiter entry, poll a tick at a time */
+		    unsigned i;
+		    for (i = 0; i < pendable; i++)
+			{
+			uintptr_t none = 0;
+			if (r->waiter[i].compare_exchange_strong(none, self,
+								 std::memory_order_seq_cst))
+			    break;
+			}
+		    if (i == pendable)
+			{
+			::taskDelay(1);
+			continue;
+			}
+		    r->pended.fetch_add(1, std::memory_order_seq_cst);
+		    if (r->head.load(std::memory_order_seq_cst) == cursor)
+			::eventReceive(VX_RING_EVENT, EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED,
+				       left, NULL);
+		    r->pended.fetch_sub(1, std::memory_order_relaxed);
+		    uintptr_t mine = self;
+		    r->waiter[i].compare_exchange_strong(mine, 0);
+		    }
+		}
+
+	    //! wait() with a timeout given as a std::duration
+	    template <class Rep, class Period>
+	    _Vx_STATUS wait(const duration<Rep, Period>& relTime)
+		{
+		return wait(chrono2tic(relTime));
+		}
+
+	    //! the number of samples this reader has missed
+	    uint64_t lost() const noexcept
+		{
+		return missed;
+		}
+
+	    //! the number of samples published but not yet read
+	    uint64_t backlog() const noexcept
+		{
+		return ring.r->head.load(std::memory_order_relaxed) - cursor;
+		}
+	};  // reader
+
+    //! Create an unnamed ring of at least *capacity* samples
+    explicit broadcast_ring(size_t capacity)
+	{
+	uint32_t cap = roundup(capacity);
+	void * base = ::operator new(region_size(cap), std::align_val_t(64),
+				     std::nothrow);
+
+	if (base == nullptr)
+	    throw;
+	map(base);
+	init(cap);
+	mask = cap - 1;
+	}
+
+    /*! Open the ring *name*, creating it with at least *capacity* samples
+        if it does not exist. If *create* is false, it must already exist,
+	with the same capacity and sample size.
+    */
+    broadcast_ring(const string name, size_t capacity, bool create = true)
+	{
+	uint32_t cap = roundup(capacity);
+
+	map(open_shared_region<region>(sd, name, region_size(cap), create, ready,
+	    [&](region * fresh)
+		{
+		map(fresh);
+		init(cap);
+		},
+	    [&](region * old)
+		{
+		return old->capacity == cap && old->sizeT == sizeof(T);
+		}));
+	mask = cap - 1;
+	next = r->head.load(std::memory_order_acquire);
+	}
+
+    //! Delete an unnamed ring, or unmap a named one
+    ~broadcast_ring()
+	{
+	if (sd != SD_ID_NULL)
+	    ::sdClose(sd, 0);
+	else
+	    ::operator delete(r, std::align_val_t(64));
+	}
+
+    broadcast_ring(const broadcast_ring&) = delete;
+    broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+    //! Publish *sample*; only one task may write to a ring
+    void write(const T& sample) noexcept
+	{
+	write(&sample, 1);
+	}
+
+    //! Publish *n* samples at once, waking pended readers once
+    void write(const T * first, size_t n) noexcept
+	{
+	uint64_t cap = mask + 1;
+
+	while (n > 0)
+	    {
+	    size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, cap));
+
+	    /* readers check the claim after reading, so announce the
+	       overwrite before making it */
+	    r->claimed.store(next + chunk, std::memory_order_relaxed);
+	    std::atomic_thread_fence(std::memory_order_release);
+	    for (size_t i = 0; i < chunk; i++)
+		memcpy(&samples[(next + i) & mask], &first[i], sizeof(T));
+	    next += chunk;
+	    first += chunk;
+	    n -= chunk;
+	    r->head.store(next, std::memory_order_release);
+	    }
+	wake();
+	}
+
+    //! the number of samples the ring holds
+    size_t capacity() const noexcept
+	{
+	return static_cast<size_t>(mask + 1);
+	}
+
+    //! the number of samples published so far
+    uint64_t published() const noexcept
+	{
+	return r->head.load(std::memory_order_relaxed);
+	}
+
+    //! The handle of the shared data region, or SD_ID_NULL if unnamed
+    SD_ID handle() const noexcept
+	{
+	return sd;
+	}
+    };  // broadcast_ring
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCbroadcastringhpp
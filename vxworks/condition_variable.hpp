@@ -11,6 +11,12 @@
 #include "object.hpp"
 #include "mutex.hpp"
 #include "chrono2tic.hpp"
+#include "stop_token.hpp"
+#include "ticks.hpp"
+#include <tickLib.h>
+#include <semLib.h>
+#include <atomic>
+#include <cstring>
 
 #ifdef __cplusplus
 
@@ -46,17 +52,51 @@ namespace vxworks
 */
 class condition_variable : public object< CONDVAR_ID >
     {
-     
-	    
-public:
-    /*! Delete a condition variable 
-     */ 
-    ~condition_variable()
+private:
+    /* close or delete the variable, unless it has been moved from */
+    void destroy() noexcept
 	{
-	if(named)
+	if (id == CONDVAR_ID_NULL)
+	    return;
+	delist();
+	if(named())
 	    ::condVarClose(id);
 	else
 	    ::condVarDelete(id);
+	id = CONDVAR_ID_NULL;
+	}
+
+    /* the task that owns mutex <m>, or TASK_ID_NULL */
+    static TASK_ID owner(SEM_ID m) noexcept
+	{
+	SEM_INFO info;
+
+	memset(&info, 0, sizeof(info));
+	if (OK != ::semInfoGet(m, &info))
+	    return TASK_ID_NULL;
+	return info.state.owner;
+	}
+
+public:
+    /*! Delete a condition variable
+     */
+    ~condition_variable()
+	{
+	destroy();
+	}
+
+    //! Take over *other*'s variable, leaving *other* without one
+    condition_variable(condition_variable&& other) noexcept = default;
+
+    //! Delete this variable and take over *other*'s
+    condition_variable& operator=(condition_variable&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    }
+	return *this;
 	}
     
     /*! 
@@ -76,7 +116,7 @@ public:
 	 int options
 	)
 	{
-	id = ::condVarCreate (options);
+	id = enlist(::condVarCreate (options));
 	if (id == CONDVAR_ID_NULL)
 		    throw;
 	}
@@ -101,8 +141,8 @@ public:
     	 void *context
 	 )
 	{
-	named=true;
-	id = ::condVarOpen(name.c_str(), options,  mode, context);
+	set_name(name);
+	id = enlist(::condVarOpen(name.c_str(), options,  mode, context));
 	if (id == CONDVAR_ID_NULL)
 		    throw;
 	}
@@ -126,8 +166,8 @@ public:
 	 int mode 
 	 )
 	{
-	named=true;
-	id = ::condVarOpen(name.c_str(), options,  mode, NULL);
+	set_name(name);
+	id = enlist(::condVarOpen(name.c_str(), options,  mode, NULL));
 	if (id == CONDVAR_ID_NULL)
 		    throw;
 	}
@@ -139,8 +179,8 @@ public:
 	 const string name
 	 )
 	{
-	named=true;
-	id = ::condVarOpen(name.c_str(), 0,  0, NULL);
+	set_name(name);
+	id = enlist(::condVarOpen(name.c_str(), 0,  0, NULL));
 	if (id == CONDVAR_ID_NULL)
 		    throw;
 	}
@@ -165,9 +205,10 @@ public:
 	caller. The mutex will be atomically given until the task is unblocked,
 	whereupon the mutex will again be taken.
     */	
-    inline void wait( mutex& lock )
+    template <int Options>
+    inline void wait( basic_mutex<Options>& lock )
 	{
-	:: condVarWait (canWrite, handle(lock), WAIT_FOREVER);
+	:: condVarWait (id, lock.handle(), WAIT_FOREVER);
 	}
     
     
@@ -181,11 +222,11 @@ public:
     ERROR. When this method returns due to a timeout, it sets the **errno** to 
     S_objLib_OBJ_TIMEOUT (defined in objLib.h).
     */	
-    template<class Rep, class Period>
-    inline void wait_for( timed_mutex& lock,
+    template<int Options, class Rep, class Period>
+    inline void wait_for( basic_timed_mutex<Options>& lock,
                     const duration<Rep, Period>& relTime )
 	{
-	:: condVarWait (canWrite, lock.handle(), chrono2tic(relTime));
+	:: condVarWait (id, lock.handle(), chrono2tic(relTime));
 	}
 
 
@@ -202,9 +243,87 @@ public:
     When this method returns due to a timeout, it sets the **errno** to 
     S_objLib_OBJ_TIMEOUT (defined in objLib.h).
     */	
-    inline void wait_for( timed_mutex& lock,  _Vx_ticks_t timeout )
+    template <int Options>
+    inline void wait_for( basic_timed_mutex<Options>& lock,  _Vx_ticks_t timeout )
+	{
+	:: condVarWait (id, lock.handle(), timeout);
+	}
+
+    /*!
+    Pends on a condition variable until *pred* holds or a stop of *token* is
+    requested, and returns pred(), like the C++20
+    std::condition_variable_any::wait(). The mutex must be owned by the
+    caller, as for wait().
+
+    The stop wakes every task waiting on the variable with a broadcast from
+    the task that requests it, which does not take the mutex, so it may
+    already own it. A waiter owns the mutex between checking the token and
+    pending, where it would miss that broadcast, so while the waiter owns
+    the mutex and has not left the wait the broadcast is repeated each
+    tick. A waiter that does not own the mutex is either pended, and woken,
+    or has yet to check the token.
+    */
+    template <int Options, class Predicate>
+    inline bool wait( basic_mutex<Options>& lock, const stop_token& token,
+		      Predicate pred )
+	{
+	return wait_for(lock, WAIT_FOREVER, token, std::move(pred));
+	}
+
+    /*!
+    Pends on a condition variable until *pred* holds, a stop of *token* is
+    requested, or *timeout* ticks pass, and returns pred(); see wait().
+    If the wait fails other than by timing out, as for a deleted variable
+    or a mutex the caller does not own, it returns false at once with
+    errno set by condVarWait().
+    */
+    template <int Options, class Predicate>
+    inline bool wait_for( basic_mutex<Options>& lock, _Vx_ticks_t timeout,
+			  const stop_token& token, Predicate pred )
+	{
+	TASK_ID self = ::taskIdSelf();
+	CONDVAR_ID cv = id;
+	SEM_ID m = lock.handle();
+	std::atomic<bool> left {false};
+	auto wake = [self, cv, m, &left]() noexcept
+	    {
+	    /* run at once, in the waiter itself, if it was already stopped */
+	    if (::taskIdSelf() == self)
+		return;
+	    for (;;)
+		{
+		bool racing = !left.load() && owner(m) == self;
+		::condVarBroadcast(cv);
+		if (!racing)
+		    return;
+		::taskDelay(1);
+		}
+	    };
+	stop_callback<decltype(wake)> waker(token, wake);
+	_Vx_ticks64_t start = ::tick64Get();
+	bool held;
+
+	while (!(held = pred()))
+	    {
+	    if (token.stop_requested())
+		break;
+	    _Vx_ticks_t rest = remaining(timeout, start);
+	    if (rest == 0)
+		break;
+	    if (OK != ::condVarWait(id, m, rest) && errno != S_objLib_OBJ_TIMEOUT)
+		break;
+	    }
+	left.store(true);
+	return held;
+	}
+
+    //! wait_for() with a timeout given as a std::duration
+    template <int Options, class Rep, class Period, class Predicate>
+    inline bool wait_for( basic_mutex<Options>& lock,
+			  const duration<Rep, Period>& relTime,
+			  const stop_token& token, Predicate pred )
 	{
-	:: condVarWait (canWrite, lock.handle(), timeout);
+	return wait_for(lock, chrono2tic(relTime), token, std::move(pred));
 	}
 
     };  // condition_variable
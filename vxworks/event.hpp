@@ -10,6 +10,10 @@
 #include <eventLib.h>
 #include <thread>
 #include "chrono2tic.hpp"
+#include "expected.hpp"
+#include "stop_token.hpp"
+#include "ticks.hpp"
+#include "trace.hpp"
 
 #ifdef __cplusplus
 
@@ -37,7 +41,8 @@ namespace vxworks
  different events are supported. Of those, eight are reserved for VxWorks
  internal use, and 24 are available for application development: VXEV01 through
  VXEV24. Application developers must have agreement on the assignment of
- individual events to avoid conflicting uses.
+ individual events to avoid conflicting uses. The events this library pends
+ on itself are listed in events.hpp.
 
  The receiving task must explicitly check its event register to determine if it
  has received events, using receive(). A task can wait for multiple events by
@@ -53,7 +58,6 @@ namespace vxworks
  a binary semaphore. It is not possible to track how many times each event
  has been received by a task.
  
-*/
 */
 class event
     {
@@ -64,19 +68,21 @@ public:
 		     TASK_ID taskId,
 		     _Vx_event_t events)
 	    {
-	    return ::eventSend (taskId, events);
+	    return traced(trace_op::event_send, (uintptr_t) taskId, [&]
+		{ return ::eventSend(taskId, events); });
 	    }
 
     /*! send an event to a std::thread()  */
     inline _Vx_STATUS send (
-		     std::thread thread,
+		     std::thread& thread,
 		     _Vx_event_t events)
 	    {
 	    // assert: the first member of the native handle 
 	    // is the task ID
-	    void * t = thread.native_handle();
+	    void * t = reinterpret_cast<void *>(thread.native_handle());
 	    TASK_ID * pTid = static_cast<TASK_ID *>(t);
-	    return ::eventSend ( * pTid , events);
+	    return traced(trace_op::event_send, (uintptr_t) *pTid, [&]
+		{ return ::eventSend(* pTid, events); });
 	    }
 
      /*!  
@@ -169,7 +175,8 @@ public:
 			_Vx_ticks_t timeout,
 			_Vx_event_t& eventsReceived)
 	    {
-	    return ::eventReceiveEx(events, options, timeout, &eventsReceived);
+	    return traced(trace_op::event_receive, events, [&]
+		{ return ::eventReceiveEx(events, options, timeout, &eventsReceived); });
 	    }
 
     /*! Pend and  wait to receive any events sent to the current task for a period of time.
@@ -181,7 +188,8 @@ public:
 			const duration<Rep, Period>& relTime,
 			_Vx_event_t& eventsReceived)
 	    {
-	    return ::eventReceiveEx(events, options, chrono2tic(relTime), &eventsReceived);
+	    return traced(trace_op::event_receive, events, [&]
+		{ return ::eventReceiveEx(events, options, chrono2tic(relTime), &eventsReceived); });
 	    }    
 
     /*! Pend and  wait to receive any events sent to the current task until a specific
@@ -194,7 +202,8 @@ public:
 			const time_point<Clock,Duration>& absTime,
 			_Vx_event_t& eventsReceived)
 	    {
-	    return ::eventReceiveEx(events, options, time_point2tic(absTime), &eventsReceived);
+	    return traced(trace_op::event_receive, events, [&]
+		{ return ::eventReceiveEx(events, options, time_point2tic(absTime), &eventsReceived); });
 	    }    
     
     
@@ -213,24 +222,123 @@ public:
 			_Vx_UINT32 options,
 			_Vx_ticks_t timeout)
 	    {
-	    return ::eventReceiveEx(events, options, timeout, NULL);
+	    return traced(trace_op::event_receive, events, [&]
+		{ return ::eventReceiveEx(events, options, timeout, NULL); });
 	    }
     
 
+    /*! Pend up to *timeout* ticks to receive *events*, as receive(), or
+        until a stop of *token* is requested, when this returns ERROR with
+	errno set to ECANCELED. The stop is sent as VX_STOP_EVENT, which is
+	reserved. A wait for all of *events* that fails puts back those of
+	them it had received, so that they are not lost.
+    */
+    inline _Vx_STATUS receive (
+			_Vx_event_t events,
+			_Vx_UINT32 options,
+			_Vx_ticks_t timeout,
+			_Vx_event_t& eventsReceived,
+			const stop_token& token)
+	    {
+	    return traced(trace_op::event_receive, events, [&]
+		{
+		TASK_ID self = ::taskIdSelf();
+		auto wake = [self]() noexcept { ::eventSend(self, VX_STOP_EVENT); };
+		stop_callback<decltype(wake)> waker(token, wake);
+		bool all = (options & EVENTS_WAIT_ANY) == 0;
+		_Vx_ticks64_t start = ::tick64Get();
+		_Vx_event_t got = 0;
+		_Vx_STATUS status = ERROR;
+
+		for (;;)
+		    {
+		    if (token.stop_requested())
+			{
+			errno = ECANCELED;
+			break;
+			}
+		    _Vx_ticks_t left = (timeout == NO_WAIT) ? NO_WAIT : remaining(timeout, start);
+		    if (timeout != NO_WAIT && left == 0)
+			{
+			errno = S_eventLib_TIMEOUT;
+			break;
+			}
+		    _Vx_event_t r = 0;
+		    _Vx_STATUS s = ::eventReceiveEx((events & ~got) | VX_STOP_EVENT,
+						    options | EVENTS_WAIT_ANY, left, &r);
+		    got |= r & events;
+		    if (all ? got == events : got != 0)
+			{
+			status = OK;
+			break;
+			}
+		    if (s != OK)
+			break;
+		    }
+		if (status != OK && all && got != 0)
+		    {
+		    int e = errno;
+		    ::eventSend(self, got);
+		    errno = e;
+		    }
+		eventsReceived = got;
+		return status;
+		});
+	    }
+
+    /*! Pend until *events* are received, as receive(), or until a stop of
+        *token* is requested */
+    inline _Vx_STATUS receive (
+			_Vx_event_t events,
+			_Vx_UINT32 options,
+			const stop_token& token)
+	    {
+	    _Vx_event_t received;
+
+	    return receive(events, options, WAIT_FOREVER, received, token);
+	    }
+
+    /*! send an event to a VxWorks task ID, returning the error rather
+        than a status */
+    inline expected<void> send (
+		     TASK_ID taskId,
+		     _Vx_event_t events,
+		     std::nothrow_t) noexcept
+	    {
+	    return to_expected(send(taskId, events));
+	    }
+
+    /*! Pend up to *timeout* ticks to receive *events*, as receive(), and
+        return the events received or the error, such as a timeout */
+    inline expected<_Vx_event_t> receive (
+			_Vx_event_t events,
+			_Vx_UINT32 options,
+			_Vx_ticks_t timeout,
+			std::nothrow_t) noexcept
+	    {
+	    _Vx_event_t received = 0;
+
+	    if (OK != receive(events, options, timeout, received))
+		return vx_error::last();
+	    return received;
+	    }
+
     /*!  check for specific events sent the current task without pending  */	
     inline _Vx_STATUS poll(
 		    _Vx_event_t events,
 		    _Vx_UINT32 options,
 		    _Vx_event_t& eventsReceived)
 	    {
-	    return ::eventReceiveEx(events, options, NO_WAIT, &eventsReceived);
+	    return traced(trace_op::event_receive, events, [&]
+		{ return ::eventReceiveEx(events, options, NO_WAIT, &eventsReceived); });
 	    }
     
     /*!  check for any event sent the current task without pending  */
     inline _Vx_STATUS fetch( 
 		     _Vx_event_t& eventsReceived)
 	    {
-	    return ::eventReceiveEx(0, EVENTS_FETCH, NO_WAIT, &eventsReceived);
+	    return traced(trace_op::event_receive, 0, [&]
+		{ return ::eventReceiveEx(0, EVENTS_FETCH, NO_WAIT, &eventsReceived); });
 	    }
 	
     /*!  clear any events for the current task. Since events can be received at
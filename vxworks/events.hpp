@@ -0,0 +1,54 @@
+/* events.hpp - the task events reserved by the library */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+/*
+ * Some classes pend a task on its own event register and wake it with
+ * eventSend(). The event each one uses is reserved in every task that waits
+ * on such an object, and no two of them may share a bit, or a wakeup meant
+ * for one is consumed by the other. They are listed here, from the top of
+ * the application range (VXEV01 through VXEV24) down:
+ *
+ *   VXEV24  VX_INTRUSIVE_QUEUE_EVENT  a receiver of an intrusive_queue (default)
+ *   VXEV23  VX_TOPIC_EVENT            a pended subscriber or publisher of a topic
+ *   VXEV22  VX_RING_EVENT             a pended reader of a broadcast_ring
+ *   VXEV21  VX_STOP_EVENT             a waiter whose stoppable wait is stopped
+ *   VXEV20  VX_STOP_READY_EVENT       a waiter whose object became ready
+ *   VXEV19  VX_ATOMIC_WAIT_EVENT      a task in atomic_wait()
+ *   VXEV18  VX_SHARED_MUTEX_EVENT     a scalable shared_mutex writer
+ *
+ * Each may be redefined before the first include; the application keeps
+ * the remaining events for itself.
+ */
+
+#ifndef __INCeventshpp
+#define __INCeventshpp
+
+#include <vxWorks.h>
+#include <eventLib.h>
+
+#ifndef VX_INTRUSIVE_QUEUE_EVENT
+#define VX_INTRUSIVE_QUEUE_EVENT VXEV24	/* the event a pended receiver receives, by default */
+#endif
+#ifndef VX_TOPIC_EVENT
+#define VX_TOPIC_EVENT VXEV23		/* the event a pended subscriber or publisher receives */
+#endif
+#ifndef VX_RING_EVENT
+#define VX_RING_EVENT VXEV22		/* the event a pended reader receives */
+#endif
+#ifndef VX_STOP_EVENT
+#define VX_STOP_EVENT VXEV21		/* sent to a waiter when its wait is stopped */
+#endif
+#ifndef VX_STOP_READY_EVENT
+#define VX_STOP_READY_EVENT VXEV20	/* sent by the object a stoppable wait is for */
+#endif
+#ifndef VX_ATOMIC_WAIT_EVENT
+#define VX_ATOMIC_WAIT_EVENT VXEV19	/* the event a waiting task receives */
+#endif
+#ifndef VX_SHARED_MUTEX_EVENT
+#define VX_SHARED_MUTEX_EVENT VXEV18	/* sent to a pended writer by the last reader */
+#endif
+
+#endif // __INCeventshpp
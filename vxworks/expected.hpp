@@ -0,0 +1,304 @@
+/* expected.hpp - results that carry a value or the errno of a failure */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCexpectedhpp
+#define __INCexpectedhpp
+
+#include <vxWorks.h>
+#include <objLib.h>
+#include <eventLib.h>
+#include <semLib.h>
+#include <errno.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  The Error of a Failed VxWorks Call
+
+ A vx_error holds the errno a VxWorks call left, and sorts the errors a
+ hot path has to tell apart: a pend that timed out, a NO_WAIT call that
+ found the object unavailable, an object deleted from under the caller,
+ a pend interrupted by a signal, one cancelled with a stop_token, and a
+ message a queue's overflow policy discarded.
+*/
+class vx_error
+    {
+private:
+    int status;
+
+public:
+    constexpr explicit vx_error(int code) noexcept : status(code)
+	{
+	}
+
+    //! the error the calling task's last failed call left in errno
+    static vx_error last() noexcept
+	{
+	return vx_error(errno);
+	}
+
+    //! the errno value
+    constexpr int code() const noexcept
+	{
+	return status;
+	}
+
+    //! true if a pend ran out of time
+    constexpr bool timed_out() const noexcept
+	{
+	return status == S_objLib_OBJ_TIMEOUT || status == S_eventLib_TIMEOUT;
+	}
+
+    //! true if a call that does not pend found the object unavailable
+    constexpr bool unavailable() const noexcept
+	{
+	return status == S_objLib_OBJ_UNAVAILABLE;
+	}
+
+    //! true if the object was deleted before or while the task pended on it
+    constexpr bool deleted() const noexcept
+	{
+	return status == S_objLib_OBJ_DELETED || status == S_objLib_OBJ_ID_ERROR;
+	}
+
+    //! true if a signal interrupted the pend
+    constexpr bool interrupted() const noexcept
+	{
+	return status == EINTR;
+	}
+
+    //! true if a stop was requested of the stop_token the pend was given
+    constexpr bool cancelled() const noexcept
+	{
+	return status == ECANCELED;
+	}
+
+    //! true if a queue's overflow policy discarded the message sent
+    constexpr bool dropped() const noexcept
+	{
+	return status == ENOBUFS;
+	}
+
+    //! true if the owner of a robust mutex died holding it
+    constexpr bool owner_dead() const noexcept
+	{
+	return status == S_semLib_EOWNERDEAD;
+	}
+
+    constexpr bool operator==(const vx_error& other) const noexcept
+	{
+	return status == other.status;
+	}
+
+    constexpr bool operator!=(const vx_error& other) const noexcept
+	{
+	return status != other.status;
+	}
+    };  // vx_error
+
+/*!
+
+\brief  A Value or a vx_error
+
+ The result of the methods that take std::nothrow, in the manner of the
+ C++23 std::expected. Those methods return a kernel error here rather
+ than throwing it, so a real-time task can lock, send and receive with
+ no exception tables or unwinding on its path. They are declared
+ noexcept, save a queue's push() and pop(), which run the code of the
+ message type and of the overflow policy and let its exceptions through:
+
+ \code
+ vxworks::expected<sample> s = q.pop (timeout, std::nothrow);
+ if (s)
+     process (*s);
+ else if (!s.error ().timed_out ())
+     logMsg ("receive failed, errno %#x\n", s.error ().code (), 0, 0, 0, 0, 0);
+ \endcode
+
+ Only a result that holds a value may be dereferenced; value() does not
+ check, as std::expected::value() would, since it cannot throw.
+*/
+template <typename T> class expected
+    {
+private:
+    union
+	{
+	T val;
+	vx_error err;
+	};
+    bool ok;
+
+    void destroy() noexcept
+	{
+	if (ok)
+	    val.~T();
+	}
+
+public:
+    typedef T value_type;
+    typedef vx_error error_type;
+
+    expected(const T& v) noexcept(std::is_nothrow_copy_constructible<T>::value)
+	: val(v), ok(true)
+	{
+	}
+
+    expected(T&& v) noexcept(std::is_nothrow_move_constructible<T>::value)
+	: val(std::move(v)), ok(true)
+	{
+	}
+
+    expected(vx_error e) noexcept : err(e), ok(false)
+	{
+	}
+
+    expected(const expected& other) noexcept(std::is_nothrow_copy_constructible<T>::value)
+	: ok(other.ok)
+	{
+	if (ok)
+	    new (&val) T(other.val);
+	else
+	    new (&err) vx_error(other.err);
+	}
+
+    expected(expected&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+	: ok(other.ok)
+	{
+	if (ok)
+	    new (&val) T(std::move(other.val));
+	else
+	    new (&err) vx_error(other.err);
+	}
+
+    expected& operator=(expected other) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+	destroy();
+	ok = other.ok;
+	if (ok)
+	    new (&val) T(std::move(other.val));
+	else
+	    new (&err) vx_error(other.err);
+	return *this;
+	}
+
+    ~expected()
+	{
+	destroy();
+	}
+
+    //! true if the call succeeded
+    bool has_value() const noexcept
+	{
+	return ok;
+	}
+
+    explicit operator bool() const noexcept
+	{
+	return ok;
+	}
+
+    //! the value of a successful call
+    T& value() & noexcept
+	{
+	return val;
+	}
+
+    const T& value() const & noexcept
+	{
+	return val;
+	}
+
+    T&& value() && noexcept
+	{
+	return std::move(val);
+	}
+
+    T& operator*() noexcept
+	{
+	return val;
+	}
+
+    const T& operator*() const noexcept
+	{
+	return val;
+	}
+
+    T * operator->() noexcept
+	{
+	return &val;
+	}
+
+    const T * operator->() const noexcept
+	{
+	return &val;
+	}
+
+    //! the value, or *other* if the call failed
+    T value_or(T other) const
+	{
+	return ok ? val : other;
+	}
+
+    //! the error of a failed call
+    vx_error error() const noexcept
+	{
+	return err;
+	}
+    };  // expected
+
+/*! The result of a call that returns no value: success or a vx_error */
+template <> class expected<void>
+    {
+private:
+    int status = 0;
+    bool ok = true;
+
+public:
+    typedef void value_type;
+    typedef vx_error error_type;
+
+    constexpr expected() noexcept
+	{
+	}
+
+    constexpr expected(vx_error e) noexcept : status(e.code()), ok(false)
+	{
+	}
+
+    //! true if the call succeeded
+    constexpr bool has_value() const noexcept
+	{
+	return ok;
+	}
+
+    constexpr explicit operator bool() const noexcept
+	{
+	return ok;
+	}
+
+    //! the error of a failed call
+    constexpr vx_error error() const noexcept
+	{
+	return vx_error(status);
+	}
+    };  // expected<void>
+
+/*! The result of a call that returned *status*, OK or ERROR with errno set */
+inline expected<void> to_expected(_Vx_STATUS status) noexcept
+    {
+    if (status == OK)
+	return expected<void>();
+    return vx_error::last();
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCexpectedhpp
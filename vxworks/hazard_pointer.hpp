@@ -0,0 +1,231 @@
+/* hazard_pointer.hpp - safe memory reclamation for lock-free structures */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INChazardpointerhpp
+#define __INChazardpointerhpp
+
+#include <vxWorks.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#ifndef VX_HAZARD_RECORDS
+#define VX_HAZARD_RECORDS 32	/* tasks that may use lock-free structures at once */
+#endif
+#ifndef VX_HAZARD_SLOTS
+#define VX_HAZARD_SLOTS 3	/* hazard pointers per task */
+#endif
+#ifndef VX_HAZARD_BATCH
+#define VX_HAZARD_BATCH 128	/* nodes a task retires before it scans */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  The Hazard Pointers of Every Lock-free Structure
+
+ A lock-free structure cannot delete a node it has unlinked while another
+ task may still be reading it. With hazard pointers, a task publishes the
+ address of each node it is about to read in one of its VX_HAZARD_SLOTS
+ slots with protect(), and a node that has been unlinked is handed to
+ retire() rather than deleted. Retired nodes are kept with the task that
+ retired them until it has VX_HAZARD_BATCH of them; it then scans every
+ slot and deletes the nodes no task has published, keeping the rest for
+ its next scan.
+
+ The domain has a fixed table of VX_HAZARD_RECORDS records, each holding
+ one task's slots and retired nodes. A task claims a record the first time
+ it protects or retires a node, and gives it back when it exits, after a
+ last scan; any nodes still published by others are left in the record for
+ the next task that claims it. So at most VX_HAZARD_RECORDS times
+ VX_HAZARD_BATCH nodes are awaiting deletion at any time, however long a
+ task holds a hazard pointer. A task that needs a record when every one is
+ claimed throws.
+
+ The domain uses only atomics and task-local storage, so it works in the
+ kernel and in an RTP, but not at interrupt level.
+*/
+class hazard_domain
+    {
+private:
+    static const unsigned records = VX_HAZARD_RECORDS;
+    static const unsigned slots = VX_HAZARD_SLOTS;
+    static const unsigned batch = VX_HAZARD_BATCH;
+    static_assert(batch > records * slots,
+		  "VX_HAZARD_BATCH must exceed the number of hazard pointers, "
+		  "or a scan may delete nothing");
+
+    struct retired
+	{
+	void * node;
+	void (*reclaim)(void *);
+	};
+
+    struct alignas(64) record
+	{
+	std::atomic<const void *> hazard[slots];
+	std::atomic<bool> claimed{false};
+	unsigned count = 0;
+	retired pending[batch];
+
+	record()
+	    {
+	    for (unsigned i = 0; i < slots; i++)
+		hazard[i].store(nullptr, std::memory_order_relaxed);
+	    }
+	};
+
+    /* the calling task's record, given back when the task exits */
+    struct owner
+	{
+	record * r = nullptr;
+
+	~owner()
+	    {
+	    if (r == nullptr)
+		return;
+	    for (unsigned i = 0; i < slots; i++)
+		r->hazard[i].store(nullptr, std::memory_order_release);
+	    scan(*r);
+	    r->claimed.store(false, std::memory_order_release);
+	    }
+	};
+
+    static record * table() noexcept
+	{
+	static record t[records];
+	return t;
+	}
+
+    static record& self()
+	{
+	static thread_local owner o;
+
+	if (o.r != nullptr)
+	    return *o.r;
+	record * t = table();
+	for (unsigned i = 0; i < records; i++)
+	    {
+	    bool unclaimed = false;
+	    if (!t[i].claimed.load(std::memory_order_relaxed) &&
+		t[i].claimed.compare_exchange_strong(unclaimed, true,
+						     std::memory_order_acquire))
+		return *(o.r = &t[i]);
+	    }
+	throw;
+	}
+
+    /* delete the nodes retired to <r> that no slot holds */
+    static void scan(record& r) noexcept
+	{
+	const void * held[records * slots];
+	unsigned n = 0;
+	record * t = table();
+
+	/* pairs with the store in protect(): a node unlinked before this
+	   point is either seen here or not found by the protecting task */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (unsigned i = 0; i < records; i++)
+	    for (unsigned j = 0; j < slots; j++)
+		{
+		const void * p = t[i].hazard[j].load(std::memory_order_seq_cst);
+		if (p != nullptr)
+		    held[n++] = p;
+		}
+	std::sort(held, held + n);
+
+	unsigned kept = 0;
+	for (unsigned i = 0; i < r.count; i++)
+	    {
+	    if (std::binary_search(held, held + n, (const void *) r.pending[i].node))
+		r.pending[kept++] = r.pending[i];
+	    else
+		r.pending[i].reclaim(r.pending[i].node);
+	    }
+	r.count = kept;
+	}
+
+    template <typename T> static void destroy(void * node)
+	{
+	delete static_cast<T *>(node);
+	}
+
+public:
+    //! the number of hazard pointers each task has
+    static constexpr unsigned per_task = slots;
+
+    /*! Publish in slot *i* the node *src* points to, and return it. The
+        node cannot be deleted until the slot is cleared or reused, as long
+	as it was reachable from *src* when this returns.
+    */
+    template <typename T>
+    static T * protect(unsigned i, const std::atomic<T *>& src)
+	{
+	std::atomic<const void *>& h = self().hazard[i];
+	T * p = src.load(std::memory_order_relaxed);
+
+	for (;;)
+	    {
+	    h.store(p, std::memory_order_seq_cst);
+	    T * q = src.load(std::memory_order_seq_cst);
+	    if (q == p)
+		return p;
+	    p = q;
+	    }
+	}
+
+    /*! Publish *node* in slot *i* without checking it is still reachable;
+        the caller must check that itself before reading the node
+    */
+    static void set(unsigned i, const void * node)
+	{
+	self().hazard[i].store(node, std::memory_order_seq_cst);
+	}
+
+    //! Clear slot *i*
+    static void clear(unsigned i)
+	{
+	self().hazard[i].store(nullptr, std::memory_order_release);
+	}
+
+    //! Clear every slot of the calling task
+    static void clear()
+	{
+	record& r = self();
+
+	for (unsigned i = 0; i < slots; i++)
+	    r.hazard[i].store(nullptr, std::memory_order_release);
+	}
+
+    /*! Hand over a node that has been unlinked, to be deleted once no task
+        holds it in a slot
+    */
+    template <typename T> static void retire(T * node)
+	{
+	record& r = self();
+
+	r.pending[r.count++] = retired {node, &destroy<T>};
+	if (r.count == batch)
+	    scan(r);
+	}
+
+    /*! Delete the calling task's retired nodes that no task holds now,
+        rather than waiting for a full batch. Returns the number left.
+    */
+    static unsigned reclaim()
+	{
+	record& r = self();
+
+	scan(r);
+	return r.count;
+	}
+    };  // hazard_domain
+}      // vxworks
+#endif // __cplusplus
+#endif // __INChazardpointerhpp
@@ -0,0 +1,384 @@
+/* intrusive_queue.hpp - allocation-free queue of linked objects */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCintrusivequeuehpp
+#define __INCintrusivequeuehpp
+
+#include <eventLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <objLib.h>
+#include <errno.h>
+#include "chrono2tic.hpp"
+#include "events.hpp"
+#include "spin_lock.hpp"
+#include "ticks.hpp"
+#include <mutex>
+#include <new>
+#include <utility>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*! The link node an object embeds to be placed on an intrusive_queue.
+    An object may be on only one queue per hook at a time.
+*/
+template <typename T> struct intrusive_hook
+    {
+    T * next = nullptr;
+    };
+
+/*!
+
+\brief  An Intrusive Queue Class
+
+ A vxworks::queue copies every message into the queue's storage and out
+ again. For large buffers it is cheaper to pass ownership of the buffer
+ itself: an intrusive_queue links objects through an intrusive_hook
+ embedded in the object, so sending and receiving are a few pointer
+ updates and never allocate or copy.
+
+ \code
+ struct frame
+     {
+     vxworks::intrusive_hook<frame> hook;
+     char data [16384];
+     };
+
+ vxworks::intrusive_queue<frame, &frame::hook> ready;
+ \endcode
+
+ The list is protected by a vxworks::spin_lock. A task that finds the
+ queue empty parks itself on a list of waiters and pends with eventLib;
+ a sender hands the object to the first waiter and wakes it with a single
+ eventSend(). The *event* given to the constructor (VX_INTRUSIVE_QUEUE_EVENT
+ by default, see events.hpp) is reserved for this purpose in every task
+ that receives from the queue.
+
+ Objects are typically allocated from a vxworks::fixed_pool so that the
+ whole path from producer to consumer is allocation-free. The queue never
+ owns its objects: they must outlive their time on the queue.
+*/
+template <typename T, intrusive_hook<T> T::* Hook> class intrusive_queue
+    {
+private:
+    struct waiter
+	{
+	TASK_ID tid;
+	waiter * next;
+	T * obj;
+	};
+
+    spin_lock lock;
+    T * head = nullptr;
+    T * tail = nullptr;
+    size_t count = 0;
+    waiter * waitHead = nullptr;
+    waiter * waitTail = nullptr;
+    const _Vx_event_t wakeEvent;
+
+    static T *& link(T * obj)
+	{
+	return (obj->*Hook).next;
+	}
+
+    /* remove the first object, lock held */
+    T * take()
+	{
+	T * obj = head;
+	if (obj != nullptr)
+	    {
+	    head = link(obj);
+	    if (head == nullptr)
+		tail = nullptr;
+	    link(obj) = nullptr;
+	    count--;
+	    }
+	return obj;
+	}
+
+    /* remove <w> from the waiter list if it is still there, lock held */
+    void unwait(waiter * w)
+	{
+	waiter ** pp = &waitHead;
+	waiter * prev = nullptr;
+
+	while (*pp != nullptr && *pp != w)
+	    {
+	    prev = *pp;
+	    pp = &(*pp)->next;
+	    }
+	if (*pp == nullptr)
+	    return;
+	*pp = w->next;
+	if (waitTail == w)
+	    waitTail = prev;
+	}
+
+public:
+    /*! Create an empty queue. Receivers are woken with *event*, which
+        must not be used for anything else by the receiving tasks.
+    */
+    intrusive_queue(_Vx_event_t event = VX_INTRUSIVE_QUEUE_EVENT) : wakeEvent(event)
+	{
+	}
+
+    intrusive_queue(const intrusive_queue&) = delete;
+    intrusive_queue& operator=(const intrusive_queue&) = delete;
+
+    //! The number of objects currently queued.
+    size_t size()
+	{
+	std::lock_guard<spin_lock> g(lock);
+	return count;
+	}
+
+    //! Returns true if the queue is empty.
+    bool empty()
+	{
+	return size() == 0;
+	}
+
+    /*! Put an object at the back of the queue, or hand it directly to a
+        waiting receiver. This never pends, and may not fail.
+    */
+    inline void push(T * obj)
+	{
+	TASK_ID tid = TASK_ID_NULL;
+
+	link(obj) = nullptr;
+	{
+	std::lock_guard<spin_lock> g(lock);
+	waiter * w = waitHead;
+	if (w != nullptr)
+	    {
+	    waitHead = w->next;
+	    if (waitHead == nullptr)
+		waitTail = nullptr;
+	    /* once the lock is released the receiver may return, and its
+	       waiter with it */
+	    tid = w->tid;
+	    w->obj = obj;
+	    }
+	else
+	    {
+	    if (tail != nullptr)
+		link(tail) = obj;
+	    else
+		head = obj;
+	    tail = obj;
+	    count++;
+	    }
+	}
+	if (tid != TASK_ID_NULL)
+	    ::eventSend(tid, wakeEvent);
+	}
+
+    //! Put an object at the back of the queue
+    inline _Vx_STATUS send(T * obj)
+	{
+	push(obj);
+	return OK;
+	}
+
+    //! remove an object from the front of the queue, wait timeout tics for one if the queue is empty
+    inline _Vx_STATUS recieve(
+		    T *& obj,      /* object received */
+		    _Vx_ticks_t timeout       /* ticks to wait */
+		    )
+	{
+	waiter w;
+	_Vx_ticks64_t start = ::tick64Get();
+	_Vx_ticks_t left = timeout;
+
+	{
+	std::lock_guard<spin_lock> g(lock);
+	obj = take();
+	if (obj != nullptr)
+	    return OK;
+	if (timeout == NO_WAIT)
+	    {
+	    errno = S_objLib_OBJ_UNAVAILABLE;
+	    return ERROR;
+	    }
+	w.tid = ::taskIdSelf();
+	w.next = nullptr;
+	w.obj = nullptr;
+	if (waitTail != nullptr)
+	    waitTail->next = &w;
+	else
+	    waitHead = &w;
+	waitTail = &w;
+	}
+
+	for (;;)
+	    {
+	    ::eventReceiveEx(wakeEvent, EVENTS_WAIT_ANY|EVENTS_KEEP_UNWANTED,
+			     left, NULL);
+
+	    std::lock_guard<spin_lock> g(lock);
+	    if (w.obj != nullptr)
+		{
+		obj = w.obj;
+		return OK;
+		}
+	    left = remaining(timeout, start);
+	    if (left == 0)
+		{
+		unwait(&w);
+		errno = S_objLib_OBJ_TIMEOUT;
+		return ERROR;
+		}
+	    }
+	}
+
+    //! remove an object from the front of the queue, wait a std:duration for one if the queue is empty
+    template<class Rep, class Period>
+    inline _Vx_STATUS recieve(
+		    T *& obj,      /* object received */
+		    const duration<Rep, Period>& relTime )
+	{
+	return recieve(obj, chrono2tic(relTime));
+	}
+
+    //! remove an object from the front of the queue, pend indefinitely till one is available
+    inline _Vx_STATUS recieve(T *& obj)
+	{
+	return recieve(obj, WAIT_FOREVER);
+	}
+
+    //! remove an object from the front of the queue, or return NULL immediately if it is empty
+    inline T * poll()
+	{
+	std::lock_guard<spin_lock> g(lock);
+	return take();
+	}
+
+    //! operator to send an object
+    void operator<< ( T * obj)
+ 	{
+	push(obj);
+	}
+
+    //! operator to receive an object
+    void operator>> ( T *& obj)
+ 	{
+	if (OK != recieve(obj, WAIT_FOREVER))
+	    throw;
+	}
+    };  // intrusive_queue
+
+/*!
+
+\brief  A Fixed Size Object Pool Class
+
+ A fixed_pool holds storage for *N* objects of type T inside the pool
+ object itself, so a pool declared statically or created once at start-up
+ never calls malloc(). Free blocks are kept on a list protected by a
+ vxworks::spin_lock; make() and destroy() are constant time.
+
+ It is the natural companion to intrusive_queue for handing buffers
+ between tasks without copying them.
+*/
+template <typename T, size_t N> class fixed_pool
+    {
+private:
+    union block
+	{
+	block * next;
+	alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+    spin_lock lock;
+    block * freeList;
+    size_t freeCount;
+    block blocks[N];
+
+    /* put <b> back on the free list */
+    void release(block * b)
+	{
+	std::lock_guard<spin_lock> g(lock);
+	b->next = freeList;
+	freeList = b;
+	freeCount++;
+	}
+
+public:
+    //! Create a pool with all *N* blocks free
+    fixed_pool() : freeList(nullptr), freeCount(N)
+	{
+	for (size_t i = N; i > 0; i--)
+	    {
+	    blocks[i - 1].next = freeList;
+	    freeList = &blocks[i - 1];
+	    }
+	}
+
+    fixed_pool(const fixed_pool&) = delete;
+    fixed_pool& operator=(const fixed_pool&) = delete;
+
+    //! The number of objects the pool can hold
+    static constexpr size_t capacity()
+	{
+	return N;
+	}
+
+    //! The number of free blocks
+    size_t available()
+	{
+	std::lock_guard<spin_lock> g(lock);
+	return freeCount;
+	}
+
+    /*! Construct an object in a free block, or return NULL if the pool
+        is exhausted. If T's constructor throws, the block is returned to
+        the pool before the exception is passed on.
+    */
+    template <typename... Args>
+    T * make(Args&&... args)
+	{
+	block * b;
+	{
+	std::lock_guard<spin_lock> g(lock);
+	b = freeList;
+	if (b == nullptr)
+	    return nullptr;
+	freeList = b->next;
+	freeCount--;
+	}
+	try
+	    {
+	    return new (b->storage) T(std::forward<Args>(args)...);
+	    }
+	catch (...)
+	    {
+	    /* the constructor threw: the block holds no object */
+	    release(b);
+	    throw;
+	    }
+	}
+
+    //! Destroy an object made by this pool and return its block
+    void destroy(T * obj)
+	{
+	if (obj == nullptr)
+	    return;
+	obj->~T();
+	release(reinterpret_cast<block *>(obj));
+	}
+
+    //! Returns true if *obj* was made by this pool
+    bool owns(const T * obj) const
+	{
+	const void * p = obj;
+	return p >= static_cast<const void *>(&blocks[0]) &&
+	       p < static_cast<const void *>(&blocks[N]);
+	}
+    };  // fixed_pool
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCintrusivequeuehpp
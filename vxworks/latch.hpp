@@ -0,0 +1,95 @@
+/* latch.hpp - single-use countdown for a group of tasks */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INClatchhpp
+#define __INClatchhpp
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include "atomic_wait.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Latch Class
+
+ The latch class mimics the C++20 std::latch: a counter, set when the latch
+ is created, that tasks count down, and on which tasks wait until it
+ reaches zero. It cannot be reset; see vxworks::barrier for a group of
+ tasks that meet repeatedly.
+
+ The counter is a single atomic word, so counting down costs one atomic
+ operation and no system call, and the task that takes it to zero wakes
+ all the tasks pended on it with atomic_notify_all(). A waiting task spins
+ on the counter for a while before it pends with atomic_wait(), so that a
+ task that arrives shortly before the last one does not enter the kernel
+ at all. The event VX_ATOMIC_WAIT_EVENT is therefore reserved in every task
+ that waits.
+*/
+class latch
+    {
+private:
+    static const int spins = 1000;
+
+    std::atomic<std::ptrdiff_t> counter;
+
+public:
+    //! Create a latch that opens after *expected* counts
+    explicit latch(std::ptrdiff_t expected) : counter(expected)
+	{
+	}
+
+    latch(const latch&) = delete;
+    latch& operator=(const latch&) = delete;
+
+    //! the largest count a latch may be created with
+    static constexpr std::ptrdiff_t max() noexcept
+	{
+	return std::numeric_limits<std::ptrdiff_t>::max();
+	}
+
+    //! Count down by *n*, waking the waiting tasks if that opens the latch
+    void count_down(std::ptrdiff_t n = 1) noexcept
+	{
+	if (counter.fetch_sub(n, std::memory_order_acq_rel) == n)
+	    vxworks::atomic_notify_all(&counter);
+	}
+
+    //! Returns true if the latch is open
+    bool try_wait() const noexcept
+	{
+	return counter.load(std::memory_order_acquire) == 0;
+	}
+
+    //! Wait until the latch is open
+    void wait() const
+	{
+	for (int i = 0; i < spins; i++)
+	    if (try_wait())
+		return;
+	for (;;)
+	    {
+	    std::ptrdiff_t c = counter.load(std::memory_order_acquire);
+	    if (c == 0)
+		return;
+	    vxworks::atomic_wait(&counter, c);
+	    }
+	}
+
+    //! Count down by *n* and wait until the latch is open
+    void arrive_and_wait(std::ptrdiff_t n = 1)
+	{
+	count_down(n);
+	wait();
+	}
+    };  // latch
+}      // vxworks
+#endif // __cplusplus
+#endif // __INClatchhpp
@@ -0,0 +1,528 @@
+/* lockdep.hpp - lock order validation for the mutex classes */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INClockdephpp
+#define __INClockdephpp
+
+#include <semLib.h>
+#include <taskLib.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifndef VX_LOCKDEP_EDGES
+#define VX_LOCKDEP_EDGES 1024	/* lock order edges remembered, a power of two */
+#endif
+#ifndef VX_LOCKDEP_DEPTH
+#define VX_LOCKDEP_DEPTH 8	/* locks remembered in each chain */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+ A lock class shared by several mutexes, such as the mutexes of the buckets
+ of a hash table, which are always taken in the same order relative to
+ other locks. Instances are usually static; the address is the key.
+
+ \code
+ static vxworks::lock_class bucketClass ("bucket");
+ for (auto& b : buckets)
+     b.lock.set_lock_class(bucketClass);
+ \endcode
+*/
+struct lock_class
+    {
+    const char * name;		//!< the name used in reports
+
+    explicit constexpr lock_class(const char * n) noexcept : name(n)
+	{
+	}
+    };
+
+//! The locks a task held, outermost first, when it took a lock
+struct lock_chain
+    {
+    TASK_ID task;			//!< the task
+    unsigned depth;			//!< entries of keys[] in use
+    uintptr_t keys[VX_LOCKDEP_DEPTH];	//!< lock class keys; the last was being taken
+    };
+
+//! A possible deadlock: a lock order that closes a cycle
+struct lockdep_report
+    {
+    uintptr_t acquiring;	//!< the class being taken
+    uintptr_t held;		//!< the class held, which already depends on it
+    lock_chain current;		//!< the acquisition that closes the cycle
+    lock_chain previous;	//!< the acquisition that first ordered them the other way
+    unsigned length;		//!< entries of cycle[] in use
+    uintptr_t cycle[VX_LOCKDEP_DEPTH];	//!< acquiring, ..., held, along existing edges
+    };
+
+/* the lock class of one mutex: a shared lock_class or the mutex itself */
+class lock_class_ref
+    {
+    const lock_class * shared = nullptr;
+    const void * self;
+
+public:
+    explicit lock_class_ref(const void * owner) noexcept : self(owner)
+	{
+	}
+
+    //! the class of a mutex moved to *owner*: shared, or else *owner*'s own
+    lock_class_ref(const lock_class_ref& moved, const void * owner) noexcept
+	: shared(moved.shared), self(owner)
+	{
+	}
+
+    void set(const lock_class& c) noexcept
+	{
+	shared = &c;
+	}
+
+    uintptr_t key() const noexcept
+	{
+	return shared ? (uintptr_t) shared : (uintptr_t) self;
+	}
+
+    //! true if the class is private to this mutex
+    bool own() const noexcept
+	{
+	return shared == nullptr;
+	}
+
+    const char * name(const char * fallback) const noexcept
+	{
+	return shared ? shared->name : fallback;
+	}
+    };
+
+/*!
+
+\brief  The Lock Order Validator
+
+ When the program is built with VX_LOCKDEP defined, mutex, recursive_mutex,
+ timed_mutex, recursive_timed_mutex, shared_mutex and shared_timed_mutex
+ tell the validator about every acquisition and release. Each task's held
+ locks are kept in a per-task stack. Taking lock B while holding lock A
+ records the order A before B, an edge in a graph of lock classes.
+
+ Before a task pends on a lock, every new edge is checked against the
+ graph. If the lock being taken can already reach a lock the task holds,
+ the two orders can deadlock under the right interleaving, whether or not
+ they ever have. The report names both locks, the locks the task holds now,
+ and the locks held by the task that first took them in the other order.
+ Trylocks cannot deadlock, so they are recorded but not checked.
+
+ Validated edges are kept in a hash table that is searched without locking,
+ so an acquisition that repeats a known order costs one probe per lock held.
+ Only a new edge takes the validator's lock and searches the graph.
+
+ By default every mutex is a class of its own, so the graph is of mutexes.
+ Mutexes that play the same part, such as per-bucket locks, can share a
+ lock_class with set_lock_class(). Only the first VX_LOCKDEP_EDGES edges
+ are remembered; later new edges are still checked against them but not
+ added. Like VX_OBJECT_REGISTRY, VX_LOCKDEP changes the layout of the
+ mutex classes and must be defined for the whole program.
+*/
+class lockdep
+    {
+public:
+    //! Called with each possible deadlock found
+    typedef void (*handler_t)(const lockdep_report&);
+
+    static const size_t edges = VX_LOCKDEP_EDGES;	//!< edges remembered
+    static const unsigned depth = VX_LOCKDEP_DEPTH;	//!< chain entries kept
+    static_assert((edges & (edges - 1)) == 0, "VX_LOCKDEP_EDGES must be a power of two");
+
+private:
+    static const size_t slots = 2 * edges;
+    static const size_t held_max = 32;
+    static const size_t names = 256;
+
+    enum : uint32_t { empty = 0, valid = 1, removed = 2 };
+
+    struct edge
+	{
+	std::atomic<uint32_t> state{empty};
+	uintptr_t from = 0;
+	uintptr_t to = 0;
+	lock_chain chain;
+	};
+
+    struct class_name
+	{
+	uintptr_t key;
+	char name[40];
+	};
+
+    struct state
+	{
+	edge table[slots];
+	class_name classes[names];
+	std::atomic<unsigned> count{0};
+	std::atomic<unsigned> found{0};
+	std::atomic<handler_t> handler{&print};
+	SEM_ID lock;
+
+	state()
+	    {
+	    lock = ::semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+	    if (lock == SEM_ID_NULL)
+		throw;
+	    }
+	};
+
+    /* the locks held by the calling task */
+    struct held_stack
+	{
+	unsigned n;
+	uintptr_t keys[held_max];
+	const char * names[held_max];
+	};
+
+    static state& global()
+	{
+	static state s;
+	return s;
+	}
+
+    static held_stack& held() noexcept
+	{
+	static thread_local held_stack h;
+	return h;
+	}
+
+    static size_t hash(uintptr_t from, uintptr_t to) noexcept
+	{
+	uint64_t h = (uint64_t(from) * 0x9e3779b97f4a7c15ull) ^ uint64_t(to);
+	h ^= h >> 29;
+	h *= 0xbf58476d1ce4e5b9ull;
+	return size_t(h >> 32) & (slots - 1);
+	}
+
+    /* true if the edge <from> -> <to> has been validated */
+    static bool known(state& s, uintptr_t from, uintptr_t to) noexcept
+	{
+	for (size_t i = hash(from, to), n = 0; n < slots; i = (i + 1) & (slots - 1), n++)
+	    {
+	    const edge& e = s.table[i];
+	    uint32_t st = e.state.load(std::memory_order_acquire);
+	    if (st == empty)
+		return false;
+	    if (st == valid && e.from == from && e.to == to)
+		return true;
+	    }
+	return false;
+	}
+
+    /* the number of entries of h.keys[] that are stored */
+    static unsigned stored(const held_stack& h) noexcept
+	{
+	return (h.n < held_max) ? h.n : held_max;
+	}
+
+    /* the held chain of the calling task, ending with <key> */
+    static void chain_of(const held_stack& h, uintptr_t key, lock_chain& c) noexcept
+	{
+	unsigned top = stored(h);
+	unsigned first = (top + 1 > depth) ? top + 1 - depth : 0;
+
+	c.task = ::taskIdSelf();
+	c.depth = 0;
+	for (unsigned i = first; i < top; i++)
+	    c.keys[c.depth++] = h.keys[i];
+	c.keys[c.depth++] = key;
+	}
+
+    /*
+     * Search the graph, with the lock held, for a path from <from> to <to>.
+     * On success the path is left in <r>.cycle and the chain of its first
+     * edge in <r>.previous.
+     */
+    static bool reaches(state& s, uintptr_t from, uintptr_t to, lockdep_report& r)
+	{
+	/* breadth first, remembering how each class was reached */
+	static uintptr_t queue[slots + 1];
+	static size_t via[slots + 1];
+	size_t head = 0, tail = 0;
+
+	queue[tail] = from;
+	via[tail++] = slots;
+	while (head < tail)
+	    {
+	    size_t at = head++;
+	    uintptr_t k = queue[at];
+
+	    for (size_t i = 0; i < slots; i++)
+		{
+		const edge& e = s.table[i];
+		if (e.state.load(std::memory_order_relaxed) != valid || e.from != k)
+		    continue;
+		bool seen = false;
+		for (size_t j = 0; j < tail && !seen; j++)
+		    seen = queue[j] == e.to;
+		if (seen || tail > slots)
+		    continue;
+		queue[tail] = e.to;
+		via[tail++] = at;
+		if (e.to != to)
+		    continue;
+
+		/* walk back to <from>, then lay the path out forwards */
+		size_t path[depth];
+		unsigned n = 0;
+		for (size_t p = tail - 1; p != slots && n < depth; p = via[p])
+		    path[n++] = p;
+		r.length = 0;
+		while (n > 0)
+		    r.cycle[r.length++] = queue[path[--n]];
+		uintptr_t second = (r.length > 1) ? r.cycle[1] : to;
+		for (size_t m = 0; m < slots; m++)
+		    if (s.table[m].state.load(std::memory_order_relaxed) == valid &&
+			s.table[m].from == from && s.table[m].to == second)
+			r.previous = s.table[m].chain;
+		return true;
+		}
+	    }
+	return false;
+	}
+
+    /* add the validated edge <from> -> <to>, with the lock held. The
+       edge may lie beyond a removed one, so the probe runs on to an empty
+       slot before the first free one is reused */
+    static void add(state& s, uintptr_t from, uintptr_t to, const lock_chain& c)
+	{
+	edge * free = nullptr;
+
+	if (s.count.load(std::memory_order_relaxed) >= edges)
+	    return;
+	for (size_t i = hash(from, to), n = 0; n < slots; i = (i + 1) & (slots - 1), n++)
+	    {
+	    edge& e = s.table[i];
+	    uint32_t st = e.state.load(std::memory_order_relaxed);
+	    if (st == valid && e.from == from && e.to == to)
+		return;
+	    if (st == valid)
+		continue;
+	    if (free == nullptr)
+		free = &e;
+	    if (st == empty)
+		break;
+	    }
+	if (free == nullptr)
+	    return;
+	free->from = from;
+	free->to = to;
+	free->chain = c;
+	free->state.store(valid, std::memory_order_release);
+	s.count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+    /* remember the name of class <key> for reports */
+    static void name_class(state& s, uintptr_t key, const char * name)
+	{
+	class_name * free = nullptr;
+
+	for (class_name& c : s.classes)
+	    {
+	    if (c.key == key)
+		return;
+	    if (c.key == 0 && free == nullptr)
+		free = &c;
+	    }
+	if (free == nullptr || name == nullptr || name[0] == '\0')
+	    return;
+	free->key = key;
+	strncpy(free->name, name, sizeof(free->name) - 1);
+	free->name[sizeof(free->name) - 1] = '\0';
+	}
+
+    static void print_chain(const lock_chain& c)
+	{
+	char buf[40];
+
+	fprintf(stderr, "  task %p holds", (void *) c.task);
+	for (unsigned i = 0; i < c.depth; i++)
+	    fprintf(stderr, "%s%s", (i + 1 == c.depth) ? " and takes " : " ",
+		    name(c.keys[i], buf, sizeof(buf)));
+	fprintf(stderr, "\n");
+	}
+
+public:
+    /*! Copy the name of lock class *key* into *buf* and return it. Unnamed
+        classes are shown as their key.
+    */
+    static const char * name(uintptr_t key, char * buf, size_t size) noexcept
+	{
+	for (const class_name& c : global().classes)
+	    if (c.key == key)
+		{
+		snprintf(buf, size, "%s", c.name);
+		return buf;
+		}
+	snprintf(buf, size, "%#lx", (unsigned long) key);
+	return buf;
+	}
+
+    //! The default handler: describe the deadlock on stderr
+    static void print(const lockdep_report& r)
+	{
+	char a[40], b[40];
+
+	fprintf(stderr, "lockdep: possible deadlock taking %s while holding %s\n",
+		name(r.acquiring, a, sizeof(a)), name(r.held, b, sizeof(b)));
+	print_chain(r.current);
+	fprintf(stderr, " but earlier\n");
+	print_chain(r.previous);
+	fprintf(stderr, " closing the cycle");
+	for (unsigned i = 0; i < r.length; i++)
+	    fprintf(stderr, " %s ->", name(r.cycle[i], a, sizeof(a)));
+	fprintf(stderr, " %s\n", name(r.acquiring, a, sizeof(a)));
+	}
+
+    //! Replace the handler called for each possible deadlock, returning the old one
+    static handler_t set_handler(handler_t h) noexcept
+	{
+	return global().handler.exchange(h ? h : &print);
+	}
+
+    //! The number of possible deadlocks reported so far
+    static unsigned reports() noexcept
+	{
+	return global().found.load(std::memory_order_relaxed);
+	}
+
+    //! The number of lock order edges remembered
+    static unsigned dependencies() noexcept
+	{
+	return global().count.load(std::memory_order_relaxed);
+	}
+
+    /*! Check that the calling task may take lock class *key*, named *name*,
+        given the locks it holds. Called before pending on the lock.
+    */
+    static void check(uintptr_t key, const char * name)
+	{
+	held_stack& h = held();
+	state& s = global();
+	bool locked = false;
+
+	for (unsigned i = 0, top = stored(h); i < top; i++)
+	    {
+	    uintptr_t from = h.keys[i];
+	    if (from == key || known(s, from, key))
+		continue;
+	    if (!locked)
+		{
+		::semMTake(s.lock, WAIT_FOREVER);
+		locked = true;
+		}
+
+	    lockdep_report r = lockdep_report();
+	    name_class(s, key, name);
+	    name_class(s, from, h.names[i]);
+	    chain_of(h, key, r.current);
+	    if (reaches(s, key, from, r))
+		{
+		r.acquiring = key;
+		r.held = from;
+		s.found.fetch_add(1, std::memory_order_relaxed);
+		s.handler.load()(r);
+		}
+	    /* remembered even when it closes a cycle, so it is reported once */
+	    add(s, from, key, r.current);
+	    }
+	if (locked)
+	    ::semMGive(s.lock);
+	}
+
+    //! Record that the calling task now holds lock class *key*, named *name*
+    static void acquired(uintptr_t key, const char * name) noexcept
+	{
+	held_stack& h = held();
+
+	if (h.n < held_max)
+	    {
+	    h.keys[h.n] = key;
+	    h.names[h.n] = name;
+	    }
+	h.n++;
+	}
+
+    //! Record that the calling task released lock class *key*
+    static void released(uintptr_t key) noexcept
+	{
+	held_stack& h = held();
+	unsigned top = stored(h);
+
+	if (h.n > held_max)
+	    {
+	    h.n--;
+	    return;
+	    }
+	/* locks are usually released in reverse order, but need not be */
+	for (unsigned i = top; i-- > 0; )
+	    if (h.keys[i] == key)
+		{
+		memmove(&h.keys[i], &h.keys[i + 1], (top - i - 1) * sizeof(h.keys[0]));
+		memmove(&h.names[i], &h.names[i + 1], (top - i - 1) * sizeof(h.names[0]));
+		h.n--;
+		return;
+		}
+	}
+
+    //! Forget lock class *key*, whose only mutex is being deleted
+    static void forget(uintptr_t key)
+	{
+	state& s = global();
+
+	::semMTake(s.lock, WAIT_FOREVER);
+	for (edge& e : s.table)
+	    if (e.state.load(std::memory_order_relaxed) == valid &&
+		(e.from == key || e.to == key))
+		{
+		e.state.store(removed, std::memory_order_release);
+		s.count.fetch_sub(1, std::memory_order_relaxed);
+		}
+	for (class_name& c : s.classes)
+	    if (c.key == key)
+		c.key = 0;
+	::semMGive(s.lock);
+	}
+    };  // lockdep
+
+/*
+ * Run <call>, taking the lock of class <c>, named <name>, through the
+ * validator. <trylock> acquisitions are not checked.
+ */
+template <typename Call>
+inline _Vx_STATUS lock_checked(const lock_class_ref& c, const char * name,
+			       bool trylock, Call call)
+    {
+    if (!trylock)
+	lockdep::check(c.key(), c.name(name));
+    _Vx_STATUS status = call();
+    if (status == OK)
+	lockdep::acquired(c.key(), c.name(name));
+    return status;
+    }
+
+/* run <call>, releasing the lock of class <c>, through the validator */
+template <typename Call>
+inline _Vx_STATUS unlock_checked(const lock_class_ref& c, Call call)
+    {
+    _Vx_STATUS status = call();
+    if (status == OK)
+	lockdep::released(c.key());
+    return status;
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INClockdephpp
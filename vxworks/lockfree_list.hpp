@@ -0,0 +1,221 @@
+/* lockfree_list.hpp - lock-free ordered set */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INClockfreelisthpp
+#define __INClockfreelisthpp
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "hazard_pointer.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Lock-free Ordered List Class
+
+ The lockfree_list class is a set of keys kept in a sorted singly linked
+ list, which tasks may search, insert into and erase from concurrently
+ without locks (the algorithm is M. Michael's, from "High Performance
+ Dynamic Lock-Free Hash Tables and List-Based Sets", with his hazard
+ pointers).
+
+ A key is erased in two steps: its node is first marked, by setting the
+ low bit of its link, so that no task can insert after it, and is then
+ unlinked, by the eraser or by any task that finds it marked on its way
+ through the list. Unlinked nodes are deleted through the hazard_domain.
+ Each operation uses three of the calling task's hazard pointers: for the
+ node it has reached, for the next node, and for the node whose link it
+ may change.
+
+ The keys are compared with *Compare*, std::less by default, and a list is
+ a building block for a lock-free hash table with one list per bucket. As
+ a set it holds each key at most once.
+*/
+template <typename K, typename Compare = std::less<K>> class lockfree_list
+    {
+    static_assert(hazard_domain::per_task >= 3,
+		  "lockfree_list needs three hazard pointers per task");
+private:
+    struct node
+	{
+	K key;
+	std::atomic<uintptr_t> next;
+	};
+
+    std::atomic<uintptr_t> head{0};
+    Compare less;
+
+    static bool marked(uintptr_t link) noexcept
+	{
+	return (link & 1) != 0;
+	}
+
+    static node * address(uintptr_t link) noexcept
+	{
+	return reinterpret_cast<node *>(link & ~uintptr_t(1));
+	}
+
+    /* where a search for a key ended: the link that points to the first
+       node not less than the key, that node and the one after it */
+    struct position
+	{
+	std::atomic<uintptr_t> * prev;
+	node * cur;
+	uintptr_t next;
+	};
+
+    /*
+     * Find the first node not less than <key>, unlinking the marked nodes on
+     * the way. The nodes in <p> stay protected until the caller clears the
+     * hazard pointers. Returns true if the node holds <key>.
+     */
+    bool find(const K& key, position& p)
+	{
+    retry:
+	unsigned hprev = 2, hcur = 0, hnext = 1;
+
+	p.prev = &head;
+	p.cur = address(p.prev->load(std::memory_order_acquire));
+	for (;;)
+	    {
+	    if (p.cur == nullptr)
+		return false;
+	    hazard_domain::set(hcur, p.cur);
+	    if (p.prev->load(std::memory_order_acquire) != uintptr_t(p.cur))
+		goto retry;
+
+	    p.next = p.cur->next.load(std::memory_order_acquire);
+	    hazard_domain::set(hnext, address(p.next));
+	    if (p.cur->next.load(std::memory_order_acquire) != p.next)
+		goto retry;
+
+	    if (marked(p.next))
+		{
+		/* cur has been erased: unlink it */
+		uintptr_t expected = uintptr_t(p.cur);
+		if (!p.prev->compare_exchange_strong(expected, p.next & ~uintptr_t(1),
+						     std::memory_order_acq_rel,
+						     std::memory_order_relaxed))
+		    goto retry;
+		hazard_domain::retire(p.cur);
+		p.cur = address(p.next);
+		std::swap(hcur, hnext);
+		continue;
+		}
+
+	    if (!less(p.cur->key, key))
+		return !less(key, p.cur->key);
+
+	    /* the node holding prev is now cur, still protected by hcur */
+	    p.prev = &p.cur->next;
+	    p.cur = address(p.next);
+	    unsigned h = hprev;
+	    hprev = hcur;
+	    hcur = hnext;
+	    hnext = h;
+	    }
+	}
+
+public:
+    lockfree_list()
+	{
+	}
+
+    //! Delete the list and its keys; no task may be using it
+    ~lockfree_list()
+	{
+	node * n = address(head.load(std::memory_order_relaxed));
+
+	while (n != nullptr)
+	    {
+	    node * next = address(n->next.load(std::memory_order_relaxed));
+	    delete n;
+	    n = next;
+	    }
+	}
+
+    lockfree_list(const lockfree_list&) = delete;
+    lockfree_list& operator=(const lockfree_list&) = delete;
+
+    //! Returns true if *key* is in the list
+    bool contains(const K& key)
+	{
+	position p;
+	bool found = find(key, p);
+
+	hazard_domain::clear();
+	return found;
+	}
+
+    //! Insert *key*. Returns false if it was already in the list.
+    bool insert(const K& key)
+	{
+	node * n = new node {key, {0}};
+	position p;
+
+	for (;;)
+	    {
+	    if (find(key, p))
+		{
+		hazard_domain::clear();
+		delete n;
+		return false;
+		}
+	    n->next.store(uintptr_t(p.cur), std::memory_order_relaxed);
+	    uintptr_t expected = uintptr_t(p.cur);
+	    if (p.prev->compare_exchange_strong(expected, uintptr_t(n),
+						std::memory_order_release,
+						std::memory_order_relaxed))
+		{
+		hazard_domain::clear();
+		return true;
+		}
+	    }
+	}
+
+    //! Erase *key*. Returns false if it was not in the list.
+    bool erase(const K& key)
+	{
+	position p;
+
+	for (;;)
+	    {
+	    if (!find(key, p))
+		{
+		hazard_domain::clear();
+		return false;
+		}
+	    /* mark cur, so nothing is inserted after it */
+	    uintptr_t next = p.next;
+	    if (!p.cur->next.compare_exchange_strong(next, next | 1,
+						     std::memory_order_acq_rel,
+						     std::memory_order_relaxed))
+		continue;
+	    uintptr_t expected = uintptr_t(p.cur);
+	    if (p.prev->compare_exchange_strong(expected, next,
+						std::memory_order_acq_rel,
+						std::memory_order_relaxed))
+		hazard_domain::retire(p.cur);
+	    else
+		find(key, p);	/* another task is in the way; let find unlink it */
+	    hazard_domain::clear();
+	    return true;
+	    }
+	}
+
+    //! Returns true if the list was empty when it was looked at
+    bool empty() const noexcept
+	{
+	return head.load(std::memory_order_relaxed) == 0;
+	}
+    };  // lockfree_list
+}      // vxworks
+#endif // __cplusplus
+#endif // __INClockfreelisthpp
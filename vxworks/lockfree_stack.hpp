@@ -0,0 +1,121 @@
+/* lockfree_stack.hpp - lock-free unbounded stack */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INClockfreestackhpp
+#define __INClockfreestackhpp
+
+#include <atomic>
+#include <utility>
+#include "hazard_pointer.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Lock-free Stack Class
+
+ The lockfree_stack class is a Treiber stack: push() and pop() each change
+ the top of the stack with a single compare-and-swap, so tasks on different
+ CPUs never wait for one another, and a task preempted in the middle of an
+ operation does not hold the others up.
+
+ A popped node is deleted through the hazard_domain rather than at once,
+ since another task may have loaded the same top and be about to read its
+ link. This also rules out the ABA problem of a node being deleted and its
+ memory reused as a new top between another task's load and its
+ compare-and-swap.
+
+ Each push() allocates a node, so a stack is best suited to tasks rather
+ than to code that must not allocate. The stack is unbounded, and pop()
+ never pends; pair it with a semaphore to wait for an element.
+*/
+template <typename T> class lockfree_stack
+    {
+private:
+    struct node
+	{
+	T value;
+	node * next;
+	};
+
+    std::atomic<node *> top{nullptr};
+
+public:
+    lockfree_stack()
+	{
+	}
+
+    //! Delete the stack and its elements; no task may be using it
+    ~lockfree_stack()
+	{
+	node * n = top.load(std::memory_order_relaxed);
+
+	while (n != nullptr)
+	    {
+	    node * next = n->next;
+	    delete n;
+	    n = next;
+	    }
+	}
+
+    lockfree_stack(const lockfree_stack&) = delete;
+    lockfree_stack& operator=(const lockfree_stack&) = delete;
+
+    //! Push a copy of *value*
+    void push(const T& value)
+	{
+	node * n = new node {value, top.load(std::memory_order_relaxed)};
+
+	while (!top.compare_exchange_weak(n->next, n, std::memory_order_release,
+					  std::memory_order_relaxed))
+	    ;
+	}
+
+    //! Push *value*, moving it
+    void push(T&& value)
+	{
+	node * n = new node {std::move(value), top.load(std::memory_order_relaxed)};
+
+	while (!top.compare_exchange_weak(n->next, n, std::memory_order_release,
+					  std::memory_order_relaxed))
+	    ;
+	}
+
+    /*! Pop the top element into *value*. Returns false, leaving *value*
+        alone, if the stack is empty.
+    */
+    bool pop(T& value)
+	{
+	for (;;)
+	    {
+	    node * t = hazard_domain::protect(0, top);
+	    if (t == nullptr)
+		{
+		hazard_domain::clear(0);
+		return false;
+		}
+	    if (top.compare_exchange_weak(t, t->next, std::memory_order_acquire,
+					  std::memory_order_relaxed))
+		{
+		hazard_domain::clear(0);
+		value = std::move(t->value);
+		hazard_domain::retire(t);
+		return true;
+		}
+	    }
+	}
+
+    //! Returns true if the stack was empty when it was looked at
+    bool empty() const noexcept
+	{
+	return top.load(std::memory_order_relaxed) == nullptr;
+	}
+    };  // lockfree_stack
+}      // vxworks
+#endif // __cplusplus
+#endif // __INClockfreestackhpp
@@ -0,0 +1,283 @@
+/* mpmc_queue.hpp - lock-free bounded multi-producer multi-consumer queue */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCmpmcqueuehpp
+#define __INCmpmcqueuehpp
+
+#include <semLib.h>
+#include <objLib.h>
+#include <tickLib.h>
+#include <errno.h>
+#include "chrono2tic.hpp"
+#include "wait_gate.hpp"
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Lock-free Bounded Queue Class
+
+ The mpmc_queue class offers the same interface as vxworks::queue, but
+ messages are passed through a ring of sequence-numbered slots in the
+ caller's address space rather than through a
+ [msgQLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/msgQLib.html)
+ object. Producers and consumers claim slots with a single compare-and-swap
+ each (the algorithm is D. Vyukov's bounded MPMC queue), so several tasks on
+ different CPUs may send and receive concurrently without serializing on
+ the kernel's queue lock.
+
+ The kernel is entered only on the slow path: a task that finds the queue
+ full (or empty) and is prepared to wait pends on a binary semaphore, and
+ the opposite side gives that semaphore only when it sees a waiter. The
+ semaphore holds at most one wakeup, so a woken task that completes its
+ operation gives it again for any other waiter (see wait_gate.hpp). In the
+ uncontended case a send or receive makes no system call at all.
+
+ Differences from vxworks::queue:
+
+ * The queue lives in the memory of the creating context, so it cannot be
+   named and shared between RTPs or between an RTP and the kernel.
+
+ * The capacity is rounded up to the next power of two.
+
+ * Messages are always delivered in FIFO order; there is no
+   MSG_PRI_URGENT.
+
+ * The message type must be trivially copyable, as it is for a msgQ.
+ .
+*/
+template <typename M> class mpmc_queue
+    {
+    static_assert(std::is_trivially_copyable<M>::value,
+		  "mpmc_queue messages are copied, like msgQ messages");
+private:
+    static const size_t cacheLine = 64;
+    static constexpr size_t sizeM = sizeof(M);
+
+    struct slot
+	{
+	std::atomic<size_t> seq;
+	M message;
+	};
+
+    size_t mask;
+    std::unique_ptr<slot[]> slots;
+
+    alignas(cacheLine) std::atomic<size_t> enqueuePos;
+    alignas(cacheLine) std::atomic<size_t> dequeuePos;
+    alignas(cacheLine) wait_gate notFull;
+    wait_gate notEmpty;
+
+    static size_t roundup(size_t n)
+	{
+	size_t cap = 2;
+	while (cap < n)
+	    cap <<= 1;
+	return cap;
+	}
+
+    bool try_push(const M& message)
+	{
+	size_t pos = enqueuePos.load(std::memory_order_relaxed);
+	slot * s;
+
+	for (;;)
+	    {
+	    s = &slots[pos & mask];
+	    size_t seq = s->seq.load(std::memory_order_acquire);
+	    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+	    if (dif == 0)
+		{
+		if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+						     std::memory_order_relaxed))
+		    break;
+		}
+	    else if (dif < 0)
+		return false;	/* full */
+	    else
+		pos = enqueuePos.load(std::memory_order_relaxed);
+	    }
+	s->message = message;
+	s->seq.store(pos + 1, std::memory_order_release);
+	return true;
+	}
+
+    bool try_pop(M& message)
+	{
+	size_t pos = dequeuePos.load(std::memory_order_relaxed);
+	slot * s;
+
+	for (;;)
+	    {
+	    s = &slots[pos & mask];
+	    size_t seq = s->seq.load(std::memory_order_acquire);
+	    intptr_t dif = static_cast<intptr_t>(seq) -
+			   static_cast<intptr_t>(pos + 1);
+	    if (dif == 0)
+		{
+		if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+						     std::memory_order_relaxed))
+		    break;
+		}
+	    else if (dif < 0)
+		return false;	/* empty */
+	    else
+		pos = dequeuePos.load(std::memory_order_relaxed);
+	    }
+	message = s->message;
+	s->seq.store(pos + mask + 1, std::memory_order_release);
+	return true;
+	}
+
+public:
+
+    /*! Instantiate a queue that holds at least *maxMsgs* in FIFO order.
+    */
+    mpmc_queue(size_t maxMsgs) :
+	mask(roundup(maxMsgs) - 1),
+	slots(new slot[mask + 1]),
+	enqueuePos(0), dequeuePos(0)
+	{
+	for (size_t i = 0; i <= mask; i++)
+	    slots[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    //! Delete a queue; no task may be pended on it
+    ~mpmc_queue() = default;
+
+    //! The number of messages the queue can hold
+    size_t capacity() const
+	{
+	return mask + 1;
+	}
+
+    /*! The number of messages currently in the queue.
+        The value is a snapshot and may be stale when concurrent tasks
+	are sending or receiving.
+    */
+    ssize_t numMsgs() const
+	{
+	size_t enq = enqueuePos.load(std::memory_order_relaxed);
+	size_t deq = dequeuePos.load(std::memory_order_relaxed);
+	return (enq > deq) ? static_cast<ssize_t>(enq - deq) : 0;
+	}
+
+    /*! The number of messages currently queued.
+        ( just like numMsgs )
+    */
+    ssize_t size() const
+	{
+	return numMsgs();
+	}
+
+    //! Returns true if the queue is empty.
+    bool empty() const
+	{
+	return numMsgs() == 0;
+	}
+
+    //! put a message of type M at the back of the queue, pending if the queue is full for *timeout* tics
+    inline _Vx_STATUS send
+    	(
+	const M& message,
+	_Vx_ticks_t timeout       /* ticks to wait */
+    	)
+	{
+	if (!try_push(message) &&
+	    OK != notFull.pend(timeout, [&] { return try_push(message); }))
+	    return ERROR;
+	notEmpty.wake();
+	return OK;
+	}
+
+    //! put a message of type M at the back of the queue, pending if the queue is full for std::duration
+    template<class Rep, class Period>
+    inline _Vx_STATUS send( const M& message, const duration<Rep, Period>& relTime)
+	{
+	return send(message, chrono2tic(relTime));
+	}
+
+    //! put a message of type M at the back of the queue, pending indefinitely if the queue is full
+    inline _Vx_STATUS send
+    	(
+	const M& message
+	)
+	{
+	return send(message, WAIT_FOREVER);
+	}
+
+    //! put a message of type M at the back of the queue, pending indefinitely if the queue is full
+    inline void push(
+	     const M& message
+	     )
+	{
+	if (OK != send(message, WAIT_FOREVER))
+	    throw;
+	}
+
+    //! remove a message from the front of the queue, wait timeout tics for a message if queue is empty
+    inline ssize_t recieve(
+		    M& message,    /* message received */
+		    _Vx_ticks_t timeout       /* ticks to wait */
+		    )
+	{
+	if (!try_pop(message) &&
+	    OK != notEmpty.pend(timeout, [&] { return try_pop(message); }))
+	    return ERROR;
+	notFull.wake();
+	return static_cast<ssize_t>(sizeM);
+	}
+
+    //! remove a message from the front of the queue, wait a std:duration for a message if queue is empty
+    template<class Rep, class Period>
+    inline ssize_t recieve(
+		    M& message,    /* message received */
+		    const duration<Rep, Period>& relTime )
+	{
+	return recieve(message, chrono2tic(relTime));
+	}
+
+    //! remove a message from the front of the queue, pend indefinitely till a message is available
+    inline ssize_t recieve(
+		    M& message
+		    )
+	{
+	return recieve(message, WAIT_FOREVER);
+	}
+
+    //! remove a message from the front of the queue, return error immediately if no message is available
+    inline ssize_t poll(
+		M& message
+		)
+	{
+	return recieve(message, NO_WAIT);
+	}
+
+    //! operator to send a message
+    void operator<< ( const M& message)
+ 	{
+	if (OK != send(message, WAIT_FOREVER))
+	    throw;
+	}
+
+    //! operator to receive a message
+    void operator>> ( M& message)
+ 	{
+	if (ERROR == recieve(message, WAIT_FOREVER))
+	    throw;
+	}
+    };  // mpmc_queue
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCmpmcqueuehpp
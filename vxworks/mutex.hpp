@@ -6,10 +6,14 @@
  */
 
 #include <semLib.h>
+#include <semEvLib.h>
 #include <private/semLibP.h>
 
 #include "object.hpp"
 #include "chrono2tic.hpp"
+#include "expected.hpp"
+#include "lockdep.hpp"
+#include "stop_token.hpp"
 
 #ifndef __INCmutexhpp
 #define __INCmutexhpp
@@ -20,15 +24,192 @@ namespace vxworks
 {
 typedef SEM_ID native_handle_type;
 
+/*! The type of vxworks::scalable */
+struct scalable_t
+    {
+    explicit scalable_t() = default;
+    };
+
+/*! Passed to the constructor of a mutex class to select the scalable
+    lock path: lock(), try_lock() and unlock() then call semMTakeScalable()
+    and semMGiveScalable(), so std::lock_guard and std::unique_lock use it
+    as well.
+
+    \code
+    vxworks::mutex m (vxworks::scalable);
+    std::lock_guard<vxworks::mutex> guard (m);
+    \endcode
+*/
+constexpr scalable_t scalable {};
+
 /*! base mutex class */ 
 class mutexCommon : public object< SEM_ID >
 {
 protected:
 #ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER  ;
+    static constexpr int default_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER  ;
+#else
+    static constexpr int default_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE  ;
+#endif
+    //! checks omitted on the scalable path
+    static constexpr int quick_options = SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER;
+    /* the object flag bits that hold what the options were */
+    static constexpr unsigned quick_flag = 0;
+    static constexpr unsigned no_recurse_flag = 1;
+
+    /* options for semMTakeScalable()/semMGiveScalable() */
+    inline int scalable_options() const noexcept
+	{
+	return quick_options | (flag(no_recurse_flag) ? SEM_NO_RECURSE : 0);
+	}
+
+    /* select the lock path and note the options of a new mutex */
+    inline void configure(int options, bool scalable) noexcept
+	{
+	set_flag(quick_flag, scalable);
+	set_flag(no_recurse_flag, (options & SEM_NO_RECURSE) != 0);
+	}
+
+#ifdef VX_LOCKDEP
+    lock_class_ref depClass {this};
+#endif
+
+    /* run <call>, a take of the mutex, through the lock order validator */
+    template <typename Call>
+    inline _Vx_STATUS locking(bool trylock, Call call)
+	{
+#ifdef VX_LOCKDEP
+	return lock_checked(depClass, name().c_str(), trylock, call);
+#else
+	(void) trylock;
+	return call();
+#endif
+	}
+
+    /* validate a blocking take made as a series of trylocks, as a
+       stoppable one is, before it first pends */
+    inline void ordering() noexcept
+	{
+#ifdef VX_LOCKDEP
+	lockdep::check(depClass.key(), depClass.name(name().c_str()));
+#endif
+	}
+
+    /* run <call>, a give of the mutex, through the lock order validator */
+    template <typename Call>
+    inline _Vx_STATUS unlocking(Call call)
+	{
+#ifdef VX_LOCKDEP
+	return unlock_checked(depClass, call);
 #else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE  ;
+	return call();
+#endif
+	}
+
+    /* delete the mutex, unless it has been moved from, and forget its
+       lock class */
+    void destroy() noexcept
+	{
+#ifdef VX_LOCKDEP
+	if (depClass.own())
+	    lockdep::forget(depClass.key());
 #endif
+	if (id == SEM_ID_NULL)
+	    return;
+	delist();
+	if(named())
+	    ::semClose(id);
+	else
+	    ::semDelete(id);
+	id = SEM_ID_NULL;
+	}
+
+    /* take the mutex on the path selected at construction; <sopts> are
+       the options of the scalable path, a constant in basic_mutex */
+    inline _Vx_STATUS acquire(_Vx_ticks_t timeout, int sopts) noexcept
+	{
+	return locking(timeout == NO_WAIT, [&]
+	    {
+	    return traced(trace_op::lock, [&]
+		{
+		if (flag(quick_flag))
+		    return ::semMTakeScalable(id, timeout, sopts);
+		return ::semMTake(id, timeout);
+		});
+	    });
+	}
+
+    inline _Vx_STATUS acquire(_Vx_ticks_t timeout) noexcept
+	{
+	return acquire(timeout, scalable_options());
+	}
+
+    /* give the mutex on the path selected at construction */
+    inline _Vx_STATUS release(int sopts) noexcept
+	{
+	return unlocking([&]
+	    {
+	    return traced(trace_op::unlock, [&]
+		{
+		if (flag(quick_flag))
+		    return ::semMGiveScalable(id, sopts);
+		return ::semMGive(id);
+		});
+	    });
+	}
+
+    inline _Vx_STATUS release() noexcept
+	{
+	return release(scalable_options());
+	}
+
+    /* take the mutex on the scalable path, whatever the construction */
+    inline _Vx_STATUS take_scalable(_Vx_ticks_t timeout, int sopts) noexcept
+	{
+	return locking(timeout == NO_WAIT, [&]
+	    {
+	    return traced(trace_op::lock, [&]
+		{ return ::semMTakeScalable(id, timeout, sopts); });
+	    });
+	}
+
+    /* give the mutex on the scalable path, whatever the construction */
+    inline _Vx_STATUS give_scalable(int sopts) noexcept
+	{
+	return unlocking([&]
+	    {
+	    return traced(trace_op::unlock, [&]
+		{ return ::semMGiveScalable(id, sopts); });
+	    });
+	}
+
+    /* instantiate an unnamed mutex for a derived class */
+    mutexCommon
+	(
+	int options,
+	bool scalable
+	)
+	{
+	configure(options, scalable);
+	id = enlist(::semMCreate(options));
+	if (id == SEM_ID_NULL)
+	    throw;
+	}
+
+    /* instantiate a named mutex for a derived class */
+    mutexCommon
+	(
+	const string name,
+	int options,
+	bool scalable
+	)
+	{
+	configure(options, scalable);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, options, 0, NULL));
+	if (id == SEM_ID_NULL)
+		throw;
+	}
 
 public:
     /*! instantiate a named mutex 
@@ -38,8 +219,8 @@ public:
 	const string name  
 	)
 	{
-	named=true;
-	id = ::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, default_options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -47,10 +228,38 @@ public:
     /*! delete a mutex */ 
     ~mutexCommon()
 	{
-	if(named)
-	    ::semClose(id);
-	else
-	    ::semDelete(id);
+	destroy();
+	}
+
+    /*! take over *other*'s mutex, leaving *other* without one. A mutex
+        must not be moved while it is held or waited on.
+    */
+    mutexCommon(mutexCommon&& other) noexcept
+	: object(std::move(other))
+#ifdef VX_LOCKDEP
+	, depClass(other.depClass, this)
+#endif
+	{
+#ifdef VX_LOCKDEP
+	if (other.depClass.own())
+	    lockdep::forget(other.depClass.key());
+#endif
+	}
+
+    /*! delete this mutex and take over *other*'s */
+    mutexCommon& operator=(mutexCommon&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+#ifdef VX_LOCKDEP
+	    depClass = lock_class_ref(other.depClass, this);
+	    if (other.depClass.own())
+		lockdep::forget(other.depClass.key());
+#endif
+	    }
+	return *this;
 	}
 
     /*! instantiate a named mutex with specific options 
@@ -79,9 +288,9 @@ public:
 	int options
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, saved_options, 0, NULL);
+	set_name(name);
+	configure(options, false);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -130,9 +339,9 @@ public:
 	void * context
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, saved_options, mode, context);
+	set_name(name);
+	configure(options, false);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_MUTEX, 0, options, mode, context));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -141,7 +350,7 @@ public:
     /*! instantiate an unnamed mutex  */ 
     mutexCommon()
 	{
-	id = ::semMCreate(saved_options);
+	id = enlist(::semMCreate(default_options));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
@@ -152,8 +361,8 @@ public:
 	 int options
 	 )
 	{
-	saved_options = options;	
-	id = ::semMCreate(options);
+	configure(options, false);
+	id = enlist(::semMCreate(options));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
@@ -161,34 +370,105 @@ public:
     /*! release ownership of a mutex (fill) */
     inline _Vx_STATUS give() noexcept 
 	{
-	return ::semMGive(id);
+	return unlocking([&]
+	    { return traced(trace_op::unlock, [&] { return ::semMGive(id); }); });
 	}
 	
     /*! release ownership of a mutex (fill) */	
     inline void unlock()
 	{
-	if ( OK != ::semMGive(id))
+	if ( OK != release())
 	    throw;
 	}
 
     /*! block until the current task can take ownership of a mutex */
     inline void lock()
 	{
-	if (OK != ::semMTake(id, WAIT_FOREVER))
+	if (OK != acquire(WAIT_FOREVER))
 	    throw;
 	}
 
+    /*! release ownership of a mutex, returning the error rather than throwing */
+    inline expected<void> unlock(std::nothrow_t) noexcept
+	{
+	return to_expected(release());
+	}
 
+    /*! block until the current task can take ownership of a mutex,
+        returning the error rather than throwing */
+    inline expected<void> lock(std::nothrow_t) noexcept
+	{
+	return to_expected(acquire(WAIT_FOREVER));
+	}
 
     /*! attempt to take ownership of a mutex without pending*/
     inline bool try_lock()
 	{
-	if (OK == ::semMTake(id, NO_WAIT))
+	if (OK == acquire(NO_WAIT))
 	    return true;
 	else
 	    return false;
 	}
 
+    /*! take ownership of a mutex, pending up to *timeout* tics
+       
+	The behaviour of this method is similar to that of ::lock() on a mutex,
+	differing only in that instrumentation and sanity checks are omitted 
+	to improve performance:
+
+        * Omit semaphore validation with this option. For SMP systems this
+	    enables a lock-free algorithm for acquiring or releasing uncontested
+	    mutex.
+
+        * No error checking is performed. This includes tests for interrupt
+	    context, ownership of the mutex, and validation of tasks unpended
+	    by calls to this method.
+
+        * Only system viewer events associated with unpending a waiting task
+	    will be sent.
+
+        * Recursion is not tracked unless the class is recursive. That is,
+	  successive calls to ::take_quickly( ) on a mutex or timed_mutex
+	  will result in deadlock.
+
+       .
+       This method is intended for those applications where performance is
+       critical. Constructing the mutex with vxworks::scalable makes lock()
+       and unlock() use this path.
+
+     ####CAVEATS
+       This method does not support robust mutex semaphores.
+    */
+    inline _Vx_STATUS take_quickly(_Vx_ticks_t timeout = WAIT_FOREVER) noexcept
+	{
+	return take_scalable(timeout, scalable_options());
+	}
+
+    /*! release ownership of a mutex taken with take_quickly() (fill) */	
+    inline _Vx_STATUS give_quickly() noexcept 
+	{
+	return give_scalable(scalable_options());
+	}
+
+    /*! Make the mutex one of the lock class *c* for lock order validation
+        under VX_LOCKDEP, rather than a class of its own. Call it before
+	the mutex is first taken. Without VX_LOCKDEP it does nothing.
+    */
+    inline void set_lock_class(const lock_class& c) noexcept
+	{
+#ifdef VX_LOCKDEP
+	depClass.set(c);
+#else
+	(void) c;
+#endif
+	}
+
+    /*! Returns true if lock() and unlock() use the scalable path */
+    inline bool is_scalable() const noexcept
+	{
+	return flag(quick_flag);
+	}
+
     /*!  return C API object ID */
     native_handle_type native_handle()
 	{
@@ -198,14 +478,15 @@ public:
     /*!  fill or give a mutex */ 
     inline void operator++()
  	{
-	if ( OK != ::semMGive(id))
+	if ( OK != give())
 	    throw;
 	}
 
     /*! block until the current task can take ownership (or empty) a mutex */
     inline void operator--()
  	{
-	if (OK != ::semMTake(id, WAIT_FOREVER))
+	if (OK != locking(false, [&]
+		{ return traced(trace_op::lock, [&] { return ::semMTake(id, WAIT_FOREVER); }); }))
 		    throw;
  	}
     
@@ -223,324 +504,319 @@ public:
 	
 }; // mutexCommon
 
+/*! The options of vxworks::mutex and vxworks::timed_mutex */
+#ifdef __RTP__
+constexpr int mutex_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE|SEM_USER;
+#else
+constexpr int mutex_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE;
+#endif
+
+/*! The options of vxworks::recursive_mutex and vxworks::recursive_timed_mutex */
+constexpr int recursive_mutex_options = mutex_options & ~SEM_NO_RECURSE;
+
 /*!
 
-\brief  A VxWorks Mutex Class
-  
- This library provides a full featured mutex class for managing 
+\brief  A VxWorks Mutex Class Template
+
+ This library provides a full featured mutex class for managing
  mutually exclusive access to resources.
-  
- The **mutex** class wraps the VxWorks mutex library,
- [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html). 
+
+ The **basic_mutex** class wraps the VxWorks mutex library,
+ [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html).
  The behaviour mimics the C++ std::mutex where possible.
- 
+
+ The semMCreate() *Options* are a template parameter rather than a
+ constructor argument, so combinations semMLib would reject are compile
+ errors, and the options the scalable path passes to semMTakeScalable()
+ and semMGiveScalable() are constants:
+
+ \code
+ vxworks::basic_mutex<SEM_Q_FIFO | SEM_NO_RECURSE> m;
+ std::lock_guard<decltype(m)> guard (m);
+ \endcode
+
+ vxworks::mutex and vxworks::recursive_mutex are basic_mutex with
+ mutex_options and recursive_mutex_options; the only difference between
+ them is the SEM_NO_RECURSE bit. mutexCommon still takes the options at
+ run time.
+
  The advantage of the VxWorks over the standard class is that a named mutex
  may be shared between processes and with the kernel (similar to a POSIX
- semaphore). 
- 
- All member functions are inherited, the only difference between a mutex and
- a recursive_mutex is the SEM_NO_RECURSE bit in the constructor options. 
- 
+ semaphore).
+
 */
-class mutex : public mutexCommon
+template <int Options> class basic_mutex : public mutexCommon
     {
-    
-private:
-#ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE|SEM_USER   ;
-#else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE   ;
-#endif
-public:
-    /*! block until the current task can take ownership of a mutex 
-       
-	The behaviour of this method is similar to that of ::lock() on a mutex,
-	differing only in that instrumentation and sanity checks are omitted 
-	to improve performance:
-
-        * Omit semaphore validation with this option. For SMP systems this
-	    enables a lock-free algorithm for acquiring or releasing uncontested
-	    mutex.
+    static_assert((Options & ~(SEM_Q_PRIORITY|SEM_DELETE_SAFE|SEM_INVERSION_SAFE|
+			       SEM_EVENTSEND_ERR_NOTIFY|SEM_INTERRUPTIBLE|
+			       SEM_NO_RECURSE|SEM_USER|SEM_TASK_DELETION_WAKEUP|
+			       SEM_ROBUST)) == 0,
+		  "not a semMCreate() option");
+    static_assert(!(Options & SEM_INVERSION_SAFE) || (Options & SEM_Q_PRIORITY),
+		  "SEM_INVERSION_SAFE must be accompanied by SEM_Q_PRIORITY");
 
-        * No error checking is performed. This includes tests for interrupt
-	    context, ownership of the mutex, and validation of tasks unpended
-	    by calls to this method.
+protected:
+    //! the options of semMTakeScalable() and semMGiveScalable()
+    static constexpr int scalable_flags = quick_options | (Options & SEM_NO_RECURSE);
 
-        * Only system viewer events associated with unpending a waiting task
-	    will be sent.
+    /* the scalable path does not support robust mutexes */
+    static constexpr bool robust = (Options & SEM_ROBUST) != 0;
 
-        * Recursion will not be tracked. That is, successive calls to 
-	  ::lock_quickly( ) with this option specified will result in deadlock.
+    /* take the mutex, pending up to <timeout> tics or until <token> is
+       stopped; scalable_flags leave out SEM_NO_EVENT_SEND, so a give on
+       either path sends the event the waiter registers for. Each take is
+       a trylock, so the lock order is checked here first */
+    inline _Vx_STATUS acquire_stoppable(_Vx_ticks_t timeout, const stop_token& token) noexcept
+	{
+	if (timeout != NO_WAIT)
+	    ordering();
+	return stoppable_wait(token, timeout, id,
+	    [&](_Vx_ticks_t t) { return acquire(t, scalable_flags); },
+	    [&] { return ::semEvStart(id, VX_STOP_READY_EVENT,
+				      EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE); },
+	    [&] { ::semEvStop(id); });
+	}
 
-       .
-       This method is intended for those applications where performance is
-       critical. 
+public:
+    //! the semMCreate() options of the mutex
+    static constexpr int options = Options;
 
-     ####CAVEATS
-       This method does not support robust mutex semaphores.
-    */
-    inline _Vx_STATUS take_quickly()
+    //! instantiate an unnamed mutex
+    basic_mutex() : mutexCommon(Options, false)
 	{
-	return ::semMTakeScalable(id, WAIT_FOREVER, saved_options|
-	    SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER|SEM_NO_RECURSE );
 	}
 
+    //! instantiate an unnamed mutex that locks with the scalable path
+    basic_mutex(scalable_t) : mutexCommon(Options, true)
+	{
+	static_assert(!robust, "a SEM_ROBUST mutex cannot use the scalable path");
+	}
 
-    /*! release ownership of a mutex (fill) */	
-    inline _Vx_STATUS give_quickly() noexcept 
+    //! instantiate a named mutex
+    basic_mutex(const string name) : mutexCommon(name, Options, false)
 	{
-	return ::semMGiveScalable(id, WAIT_FOREVER, saved_options|
-	    SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER|SEM_NO_RECURSE );
 	}
-	return ::semMGive(id);
+
+    //! instantiate a named mutex that locks with the scalable path
+    basic_mutex(const string name, scalable_t) : mutexCommon(name, Options, true)
+	{
+	static_assert(!robust, "a SEM_ROBUST mutex cannot use the scalable path");
 	}
 
+    /*! release ownership of a mutex (fill) */
+    inline void unlock()
+	{
+	if (OK != release(scalable_flags))
+	    throw;
+	}
 
+    /*! block until the current task can take ownership of a mutex */
+    inline void lock()
+	{
+	if (OK != acquire(WAIT_FOREVER, scalable_flags))
+	    throw;
+	}
 
+    /*! release ownership of a mutex, returning the error rather than throwing */
+    inline expected<void> unlock(std::nothrow_t) noexcept
+	{
+	return to_expected(release(scalable_flags));
+	}
 
+    /*! block until the current task can take ownership of a mutex,
+        returning the error rather than throwing */
+    inline expected<void> lock(std::nothrow_t) noexcept
+	{
+	return to_expected(acquire(WAIT_FOREVER, scalable_flags));
+	}
 
-    };  // mutex
+    /*! block until the current task can take ownership of a mutex, or
+        until a stop of *token* is requested, when this returns ERROR with
+	errno set to ECANCELED. The task pends on its event register rather
+	than in the mutex's queue, so even with SEM_INVERSION_SAFE the owner
+	is not raised to the priority of a stoppable waiter. */
+    inline _Vx_STATUS lock(const stop_token& token) noexcept
+	{
+	return acquire_stoppable(WAIT_FOREVER, token);
+	}
 
-/*!
+    /*! attempt to take ownership of a mutex without pending*/
+    inline bool try_lock()
+	{
+	return OK == acquire(NO_WAIT, scalable_flags);
+	}
 
-\brief  A VxWorks Recursive Mutex Class
-  
- This library provides a full featured mutex class for managing 
- mutually exclusive access to resources.
-  
- The **mutex** class wraps the VxWorks mutex library,
- [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html). 
- The behaviour mimics the C++ std::mutex where possible.
- 
- The advantage of the VxWorks over the standard class is that a named mutex
- may be shared between processes and with the kernel (similar to a POSIX
- semaphore). 
- 
- All member functions are inherited, the only difference between a mutex and
- a recursive_mutex is the SEM_NO_RECURSE bit in the constructor options. 
- 
-*/
-class recursive_mutex : public mutexCommon
-    {
-    
-private:
-#ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER   ;
-#else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE   ;
-#endif
-    /*! block until the current task can take ownership of a mutex 
-       
-	The behaviour of this method is similar to that of ::lock() on a mutex,
-	differing only in that instrumentation and sanity checks are omitted 
-	to improve performance:
+    /*! take ownership of a mutex, pending up to *timeout* tics, on the
+        scalable path; see mutexCommon::take_quickly() */
+    inline _Vx_STATUS take_quickly(_Vx_ticks_t timeout = WAIT_FOREVER) noexcept
+	{
+	static_assert(!robust, "a SEM_ROBUST mutex cannot use the scalable path");
+	return take_scalable(timeout, scalable_flags);
+	}
 
-        * Omit semaphore validation with this option. For SMP systems this
-	    enables a lock-free algorithm for acquiring or releasing uncontested
-	    mutex.
+    /*! release ownership of a mutex taken with take_quickly() (fill) */
+    inline _Vx_STATUS give_quickly() noexcept
+	{
+	return give_scalable(scalable_flags);
+	}
+    };  // basic_mutex
 
-        * No error checking is performed. This includes tests for interrupt
-	    context, ownership of the mutex, and validation of tasks unpended
-	    by calls to this method.
+/*!
 
-        * Only system viewer events associated with unpending a waiting task
-	    will be sent.
+\brief  A VxWorks Mutex Class
 
-       .
-       This method is intended for those applications where performance is
-       critical. 
+ A basic_mutex with priority queuing, inversion safety and SEM_NO_RECURSE,
+ which mimics the C++ std::mutex.
+*/
+typedef basic_mutex<mutex_options> mutex;
 
-     ####CAVEATS
-       This method does not support robust mutex semaphores.
-    */
-    inline _Vx_STATUS take_quickly()
-	{
-	return ::semMTakeScalable(id, WAIT_FOREVER, saved_options|
-	    SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER );
-	}
+/*!
 
-    };  // recursive_mutex
+\brief  A VxWorks Recursive Mutex Class
 
+ A basic_mutex with priority queuing and inversion safety that the owner
+ may take again, which mimics the C++ std::recursive_mutex.
+*/
+typedef basic_mutex<recursive_mutex_options> recursive_mutex;
 
 /*!
 
-\brief  A VxWorks Timed Mutex Class
-  
- This library provides a full featured mutex class for managing 
+\brief  A VxWorks Timed Mutex Class Template
+
+ This library provides a full featured mutex class for managing
  mutually exclusive access to resources.
-  
- The **recursive_mutex** class wraps the VxWorks mutex library,
- [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html). 
+
+ The **basic_timed_mutex** class wraps the VxWorks mutex library,
+ [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html).
  The behaviour mimics the C++ std::timed_mutex where possible.
- 
- VxWorks mutexes are recursive by default, and the only difference in this 
- class is that the SEM_NO_RECURSE bit is not set in the constructor 
- *option* parameter 
+
+ VxWorks does not distinguish between timed and un-timed mutexes, the
+ differentiation is in the wrapper classes to follow the C++ convention.
+ The *Options* are checked as for basic_mutex.
+
+ All std::duration parameters are converted to system tics, and
+ are rounded accordingly.
 
  The advantage of the VxWorks over the standard class is that a named mutex
  may be shared between processes and with the kernel (similar to a POSIX
- semaphore). 
- 
+ semaphore).
+
 */
-class timed_mutex : public mutexCommon
+template <int Options> class basic_timed_mutex : public basic_mutex<Options>
     {
-    
-protected:
-#ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE|SEM_USER   ;
-#else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_NO_RECURSE   ;
-#endif
-    static const quick_options =  SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER|SEM_NO_RECURSE ;   
-public:
-   /*! block until the current task can take ownership of a mutex 
-       
-	The behaviour of this method is similar to that of ::lock() on a mutex,
-	differing only in that instrumentation and sanity checks are omitted 
-	to improve performance:
+    typedef basic_mutex<Options> base;
 
-        * Omit semaphore validation with this option. For SMP systems this
-	    enables a lock-free algorithm for acquiring or releasing uncontested
-	    mutex.
-
-        * No error checking is performed. This includes tests for interrupt
-	    context, ownership of the mutex, and validation of tasks unpended
-	    by calls to this method.
-
-        * Only system viewer events associated with unpending a waiting task
-	    will be sent.
-
-        * Recursion will not be tracked. That is, successive calls to 
-	  ::lock_quickly( ) with this option specified will result in deadlock.
-
-       .
-       This method is intended for those applications where performance is
-       critical. 
-
-     ####CAVEATS
-       This method does not support robust mutex semaphores.
-    */
-    inline _Vx_STATUS take_quickly_for(_Vx_ticks_t  timeout)
+public:
+    //! instantiate an unnamed timed mutex
+    basic_timed_mutex()
 	{
-	return ::semMTakeScalable(id, timeout, saved_option|quick_options);
 	}
 
-    /*! optimized give (or fill) of a mutex  
-       
-	The behaviour of this method is similar to that of ::lock() on a mutex,
-	differing only in that instrumentation and sanity checks are omitted 
-	to improve performance:
-
-        * Omit semaphore validation with this option. For SMP systems this
-	    enables a lock-free algorithm for acquiring or releasing uncontested
-	    mutex.
-
-        * No error checking is performed. This includes tests for interrupt
-	    context, ownership of the mutex, and validation of tasks unpended
-	    by calls to this method.
+    //! instantiate an unnamed timed mutex that locks with the scalable path
+    basic_timed_mutex(scalable_t s) : base(s)
+	{
+	}
 
-        * Only system viewer events associated with unpending a waiting task
-	    will be sent.
+    //! instantiate a named timed mutex
+    basic_timed_mutex(const string name) : base(name)
+	{
+	}
 
-        * Recursion will not be tracked. That is, successive calls to 
-	  ::lock_quickly( ) with this option specified will result in deadlock.
+    //! instantiate a named timed mutex that locks with the scalable path
+    basic_timed_mutex(const string name, scalable_t s) : base(name, s)
+	{
+	}
 
-       .
-       This method is intended for those applications where performance is
-       critical. 
+    /*! take ownership of a mutex on the scalable path, pending up to
+        *timeout* tics; see take_quickly() */
+    inline _Vx_STATUS take_quickly_for(_Vx_ticks_t  timeout) noexcept
+	{
+	return this->take_quickly(timeout);
+	}
 
-     ####CAVEATS
-       This method does not support robust mutex semaphores.
-    */
- 
-    inline _Vx_STATUS give_quickly_for(_Vx_ticks_t  timeout) 
+    /*! release ownership of a mutex on the scalable path; see
+        give_quickly(). A give never pends, so *timeout* is ignored. */
+    inline _Vx_STATUS give_quickly_for(_Vx_ticks_t  timeout) noexcept
 	{
-	return ::semMTakeScalable(id, timeout, saved_option|quick_options);
+	(void) timeout;
+	return this->give_quickly();
 	}
 
-    /*! wait to take ownership of mutex for period of time specified in system ticks */ 
+    /*! wait to take ownership of mutex for period of time specified in system ticks */
     inline _Vx_STATUS take
 	(
 	_Vx_ticks_t   timeout
 	) noexcept
 	{
-	return ::semMTake(id, timeout);
+	return this->acquire(timeout, base::scalable_flags);
+	}
+
+    /*! wait to take ownership of mutex for period of time specified in
+        system ticks, or until a stop of *token* is requested, when this
+	returns ERROR with errno set to ECANCELED. As for
+	lock(const stop_token&), the owner's priority is not raised. */
+    inline _Vx_STATUS take
+	(
+	_Vx_ticks_t   timeout,
+	const stop_token& token
+	) noexcept
+	{
+	return this->acquire_stoppable(timeout, token);
 	}
 
-    /*! wait to take ownership of mutex for period of time specified as standard duration */ 
+    /*! wait to take ownership of mutex for period of time specified as standard duration */
      template<class Rep, class Period>
-     inline bool try_lock_for(const duration<Rep, Period>& relTime) 
+     inline bool try_lock_for(const duration<Rep, Period>& relTime)
 	{
-        if ( OK == ::semMTake(id, chrono2tic(relTime)))
-		{
-		return true;
-		}
-	    else 
-		{
-		return false;
-		}		     
+	return OK == this->acquire(chrono2tic(relTime), base::scalable_flags);
 	}
-    /*! wait to take ownership of mutex until a certain time */ 
+
+    /*! wait to take ownership of mutex until a certain time */
      template< class Clock, class Duration >
      inline bool try_lock_until (const time_point<Clock,Duration>& abs_time)
 	{
-	bool again = true;
 	_Vx_ticks_t tics = time_point2tic(abs_time);
-	STATUS status;
-	
-	if (tics == 0)
-	    status = ::semMTake(id, NO_WAIT); 
-	else
-	    status = ::semMTake(id, tics);
-	
-	if (status == OK)
-	    {
-	    return true;
-	    }
-	else 
-	    {
-	    return false;
-	    }
+
+	return OK == this->acquire((tics == 0) ? NO_WAIT : tics,
+				   base::scalable_flags);
 	}
-    };  // timed_mutex
-    
-/*!
 
-\brief  A VxWorks Recursive Timed Mutex Class
-  
- This library provides a full featured mutex class for managing 
- mutually exclusive access to resources.
-  
- The **recursive_timed_mutex** class wraps the VxWorks mutex library,
- [semMLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semMLib.html). 
- The behaviour mimics the C++ std::recursive_timed_mutex where possible.
- 
- VxWorks does not distinguish between timed and un-timed mutexes, the  
- differentiation is in the wrapper classes to follow the C++ convention.
+    /*! wait to take ownership of mutex for a standard duration, returning
+        the error, such as a timeout, rather than false */
+     template<class Rep, class Period>
+     inline expected<void> try_lock_for(const duration<Rep, Period>& relTime,
+					std::nothrow_t) noexcept
+	{
+	return to_expected(this->acquire(chrono2tic(relTime), base::scalable_flags));
+	}
 
- VxWorks mutexes are recursive by default, and the only difference in this 
- class is that the SEM_NO_RECURSE bit is not set in the constructor 
- *option* parameter 
+    /*! wait to take ownership of mutex until a certain time, returning
+        the error, such as a timeout, rather than false */
+     template< class Clock, class Duration >
+     inline expected<void> try_lock_until(const time_point<Clock,Duration>& abs_time,
+					  std::nothrow_t) noexcept
+	{
+	return to_expected(this->acquire(time_point2tic(abs_time), base::scalable_flags));
+	}
+    };  // basic_timed_mutex
 
- All std::duration parameters are converted to system tics, and 
- are rounded accordingly.  
- 
- The advantage of the VxWorks over the standard class is that a named mutex
- may be shared between processes and with the kernel (similar to a POSIX
- semaphore). 
- 
+/*!
+
+\brief  A VxWorks Timed Mutex Class
+
+ A basic_timed_mutex with the options of vxworks::mutex, which mimics the
+ C++ std::timed_mutex.
 */
-class recursive_timed_mutex : public timed_mutex
-    {
-private:
-#ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER   ;
-#else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE   ;
-#endif
-    static const quick_options =  SEM_NO_ID_VALIDATE|SEM_NO_ERROR_CHECK|SEM_NO_SYSTEM_VIEWER ;   
+typedef basic_timed_mutex<mutex_options> timed_mutex;
 
-    }; // recursive_timed_mutex
+/*!
+
+\brief  A VxWorks Recursive Timed Mutex Class
+
+ A basic_timed_mutex with the options of vxworks::recursive_mutex, which
+ mimics the C++ std::recursive_timed_mutex.
+*/
+typedef basic_timed_mutex<recursive_mutex_options> recursive_timed_mutex;
 } // vxworks
 #endif  // __cplusplus 
 #endif  // __INCmutexhpp
@@ -8,17 +8,79 @@
 #define __INCobjecthpp
 
 #include <objLib.h>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "trace.hpp"
+#ifdef VX_OBJECT_REGISTRY
+#include "registry.hpp"
+#endif
 
 #ifdef __cplusplus
 
 namespace vxworks
 {
+using std::string;
+
 #ifdef __RTP__
 #define __OBJ(_id)  static_cast<OBJ_HANDLE>(_id)
 #else
 #define __OBJ(_id)  static_cast<OBJ_ID>(_id)
 #endif
 
+/*!
+ * A read-only view of an object's name, returned by object::name() without
+ * copying or allocating. The view remains valid for the life of the object.
+ * It is always NUL terminated, so c_str() may be passed straight to printf().
+ */
+class name_view
+    {
+private:
+    const char * str;
+    size_t len;
+
+public:
+    //! an empty name, as returned for an unnamed object
+    constexpr name_view() noexcept : str(""), len(0)
+	{
+	}
+
+    constexpr name_view(const char * s, size_t n) noexcept : str(s), len(n)
+	{
+	}
+
+    //! the NUL terminated name
+    constexpr const char * c_str() const noexcept
+	{
+	return str;
+	}
+
+    //! the name, as for c_str()
+    constexpr const char * data() const noexcept
+	{
+	return str;
+	}
+
+    //! the length of the name, not counting the NUL
+    constexpr size_t size() const noexcept
+	{
+	return len;
+	}
+
+    //! Returns true for an unnamed object
+    constexpr bool empty() const noexcept
+	{
+	return len == 0;
+	}
+
+    //! a copy of the name
+    operator string() const
+	{
+	return string(str, len);
+	}
+    };
+
 /*! 
  * The parent object class of all VxWorks classes 
  *   
@@ -31,10 +93,156 @@ namespace vxworks
 
 template<typename T> class object
     {
+private:
+    /* the low bits of <word> left free by the alignment of a name block */
+    static constexpr uintptr_t flag_mask = 0x3;
+
+    /* the cached name: its length, then the NUL terminated characters */
+    size_t * block() const noexcept
+	{
+	return reinterpret_cast<size_t *>(word & ~flag_mask);
+	}
+
+    void free_name() noexcept
+	{
+	delete [] block();
+	word &= flag_mask;
+	}
+
 protected:
-    bool named = false;
-    T id;
+    T id = T();
+    /* the cached name block, and the flag bits of a derived class */
+    uintptr_t word = 0;
+#ifdef VX_OBJECT_REGISTRY
+    registry_entry entry;
+#endif
+
+    object() = default;
+
+    /* take over <other>'s kernel object, leaving it with a null handle */
+    object(object&& other) noexcept : id(other.id), word(other.word)
+	{
+	other.id = T();
+	other.word = 0;
+	relist(other);
+	}
+
+    /* take over <other>'s kernel object; the derived class has already
+       released this object's own */
+    object& operator=(object&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    delist();
+	    free_name();
+	    id = other.id;
+	    word = other.word;
+	    other.id = T();
+	    other.word = 0;
+	    relist(other);
+	    }
+	return *this;
+	}
+
+    object(const object&) = delete;
+    object& operator=(const object&) = delete;
+
+    /* a flag bit, 0 or 1, kept for a derived class */
+    bool flag(unsigned bit) const noexcept
+	{
+	return (word & (uintptr_t(1) << bit)) != 0;
+	}
+
+    void set_flag(unsigned bit, bool on) noexcept
+	{
+	if (on)
+	    word |= uintptr_t(1) << bit;
+	else
+	    word &= ~(uintptr_t(1) << bit);
+	}
+
+    /* true if the object was opened by name */
+    bool named() const noexcept
+	{
+	return block() != nullptr;
+	}
+
+    /* mark the object as named <n>, keeping a copy for name() */
+    void set_name(const char * n)
+	{
+	size_t len = strlen(n);
+	size_t * b = new size_t[1 + (len + sizeof(size_t)) / sizeof(size_t)];
+
+	b[0] = len;
+	memcpy(b + 1, n, len + 1);
+	free_name();
+	word |= reinterpret_cast<uintptr_t>(b);
+	}
+
+    void set_name(const string& n)
+	{
+	set_name(n.c_str());
+	}
+
+    /* register a newly created kernel object, returning its <handle> */
+    T enlist(T handle) noexcept
+	{
+#ifdef VX_OBJECT_REGISTRY
+	if (handle != T())
+	    {
+	    entry.handle = (uintptr_t) handle;
+	    entry.name = name().c_str();
+	    entry.kind = registry::kind_of<T>();
+	    registry::enlist(entry);
+	    }
+#endif
+	return handle;
+	}
+
+    /* unregister the object; called before its kernel object is deleted */
+    void delist() noexcept
+	{
+#ifdef VX_OBJECT_REGISTRY
+	registry::delist(entry);
+#endif
+	}
+
+    /* move <other>'s registration, if any, to this object */
+    void relist(object& other) noexcept
+	{
+#ifdef VX_OBJECT_REGISTRY
+	if (other.entry.listed)
+	    {
+	    other.delist();
+	    enlist(id);
+	    }
+#else
+	(void) other;
+#endif
+	}
+
+    /* run <call>, <op> on this object, recording it under VX_OBJECT_TRACE */
+    template <typename Call>
+    auto traced(trace_op op, Call call) -> decltype(call())
+	{
+	return vxworks::traced(op, (uintptr_t) id, call);
+	}
+
 public:
+    ~object()
+	{
+	delist();
+	free_name();
+	}
+
+    /*! Returns false once the object has been moved from, when it no
+        longer has a kernel object.
+    */
+    bool valid() const noexcept
+	{
+	return id != T();
+	}
+
 
 
 #ifndef __RTP__
@@ -86,9 +294,16 @@ public:
     */
     string name(size_t capacity  ) 
 	{
-        char * nameBuf = malloc (capacity);
+	if (named())
+	    {
+	    name_view n = name();
+	    if (capacity < n.size() + 1)
+		throw ;
+	    return string(n);
+	    }
+        char * nameBuf = static_cast<char *>(malloc (capacity));
 	string ret;
-	if nameBuf == NULL
+	if (nameBuf == NULL)
 		throw ;
 	if ( ERROR == ::objNameGet(__OBJ(id), nameBuf, capacity ))
 		throw ;
@@ -100,6 +315,41 @@ public:
 
 
 #endif
+    /*!
+    Return the name the object was opened with, without allocating.
+    Unnamed objects return an empty view.
+    */
+    name_view name() const noexcept
+	{
+	const size_t * b = block();
+
+	if (b == nullptr)
+	    return name_view();
+	return name_view(reinterpret_cast<const char *>(b + 1), b[0]);
+	}
+
+    /*!
+    Copy the NUL terminated name into *buffer*, which holds *capacity*
+    characters, and return its length. If the object is not named, or the
+    buffer is too small, ERROR is returned.
+    */
+    ssize_t name(char * buffer, size_t capacity) const noexcept
+	{
+	name_view n = name();
+
+	if (n.empty() || capacity < n.size() + 1)
+	    return ERROR;
+	memcpy(buffer, n.c_str(), n.size() + 1);
+	return static_cast<ssize_t>(n.size());
+	}
+
+    /*! Copy the name into the array *buffer*; see name(char *, size_t) */
+    template <size_t Capacity>
+    ssize_t name(char (&buffer)[Capacity]) const noexcept
+	{
+	return name(buffer, Capacity);
+	}
+
     /*! Return the underlying VxWorks object ID.     
      */
     T handle()
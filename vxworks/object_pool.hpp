@@ -0,0 +1,407 @@
+/* object_pool.hpp - lock-free fixed-block object pools */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCobjectpoolhpp
+#define __INCobjectpoolhpp
+
+#include <taskLib.h>
+#ifndef __RTP__
+#include <vxCpuLib.h>
+#endif
+#include <sdLib.h>
+#include <objLib.h>
+#include "object.hpp"
+#include "shared_region.hpp"
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Lock-free Fixed-block Object Pool Class
+
+ An object_pool holds storage for *N* objects of type T inside the pool
+ object itself, like vxworks::fixed_pool, but is built for many tasks on
+ many CPUs allocating and freeing at once:
+
+ * Each CPU has a small cache of free blocks. A task allocates from, and
+   frees to, the cache of the CPU it is running on, so a task that churns
+   through objects touches no memory shared with other CPUs.
+
+ * Behind the caches is a global free list, a lock-free stack updated with
+   a single compare-and-swap. Caches refill from it when empty and spill
+   half their blocks to it when full. When both the list and the local
+   cache are empty the other CPUs' caches are searched before make()
+   reports that the pool is exhausted.
+
+ A cache is claimed with a test-and-set rather than a lock: a task that
+ finds its cache busy, because an interrupt or another task on the same
+ CPU is using it, goes straight to the global list. Nothing ever spins or
+ pends, so, as the pool is filled when it is constructed, allocate(),
+ deallocate(), make() and destroy() may be called from an interrupt
+ service routine (T's constructor and destructor permitting).
+
+ In the kernel a cache is chosen with vxCpuIndexGet(). In an RTP the CPU
+ cannot be read cheaply, so caches are chosen by task instead; a busy
+ cache costs only a trip to the global list.
+
+ Blocks are linked by index rather than by address, so the pool is position
+ independent; see vxworks::shared_object_pool for a pool in a shared data
+ region.
+
+ The top of the global list is a 64-bit word, so the pool needs a target
+ with a lock-free 64-bit compare-and-swap; elsewhere it does not compile.
+*/
+template <typename T, size_t N> class object_pool
+    {
+    static_assert(N > 0 && N < UINT32_MAX, "object_pool holds 1 to 2^32-2 blocks");
+    /* a lock would make the pool unsafe in an ISR and across RTPs */
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+		  "object_pool needs a lock-free 64-bit compare-and-swap");
+public:
+    static const unsigned caches = 8;	//!< caches per pool
+    static const unsigned depth = 16;	//!< free blocks held by each cache
+
+private:
+    static const size_t cacheLine = 64;
+    static const uint32_t none = UINT32_MAX;
+
+    struct block
+	{
+	std::atomic<uint32_t> next;
+	alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+    struct alignas(cacheLine) cache
+	{
+	std::atomic_flag busy = ATOMIC_FLAG_INIT;
+	std::atomic<uint32_t> count{0};
+	uint32_t item[depth];
+	};
+
+    /* top of the free list: a change count above the index of the top block */
+    alignas(cacheLine) std::atomic<uint64_t> top;
+    std::atomic<uint32_t> globalCount;
+    cache cpu[caches];
+    block blocks[N];
+
+    static uint32_t first(uint64_t t)
+	{
+	return static_cast<uint32_t>(t);
+	}
+
+    static uint64_t link(uint64_t t, uint32_t i)
+	{
+	return (((t >> 32) + 1) << 32) | i;
+	}
+
+    static unsigned here()
+	{
+#ifdef __RTP__
+	uintptr_t tid = (uintptr_t) ::taskIdSelf();
+	return static_cast<unsigned>((tid ^ (tid >> 12)) % caches);
+#else
+	return ::vxCpuIndexGet() % caches;
+#endif
+	}
+
+    uint32_t pop()
+	{
+	uint64_t t = top.load(std::memory_order_acquire);
+
+	while (first(t) != none)
+	    {
+	    uint32_t next = blocks[first(t)].next.load(std::memory_order_relaxed);
+	    if (top.compare_exchange_weak(t, link(t, next),
+					  std::memory_order_acquire,
+					  std::memory_order_acquire))
+		{
+		globalCount.fetch_sub(1, std::memory_order_relaxed);
+		return first(t);
+		}
+	    }
+	return none;
+	}
+
+    void push(uint32_t i)
+	{
+	uint64_t t = top.load(std::memory_order_relaxed);
+
+	globalCount.fetch_add(1, std::memory_order_relaxed);
+	do
+	    blocks[i].next.store(first(t), std::memory_order_relaxed);
+	while (!top.compare_exchange_weak(t, link(t, i),
+					  std::memory_order_release,
+					  std::memory_order_relaxed));
+	}
+
+    /* take a free block from another CPU's cache */
+    uint32_t steal(unsigned mine)
+	{
+	for (unsigned k = 1; k < caches; k++)
+	    {
+	    cache& c = cpu[(mine + k) % caches];
+	    uint32_t i = none;
+
+	    if (c.count.load(std::memory_order_relaxed) == 0 ||
+		c.busy.test_and_set(std::memory_order_acquire))
+		continue;
+	    uint32_t n = c.count.load(std::memory_order_relaxed);
+	    if (n > 0)
+		{
+		i = c.item[n - 1];
+		c.count.store(n - 1, std::memory_order_relaxed);
+		}
+	    c.busy.clear(std::memory_order_release);
+	    if (i != none)
+		return i;
+	    }
+	return none;
+	}
+
+    uint32_t claim()
+	{
+	unsigned mine = here();
+	cache& c = cpu[mine];
+	uint32_t i = none;
+
+	if (!c.busy.test_and_set(std::memory_order_acquire))
+	    {
+	    uint32_t n = c.count.load(std::memory_order_relaxed);
+	    if (n > 0)
+		{
+		i = c.item[n - 1];
+		c.count.store(n - 1, std::memory_order_relaxed);
+		}
+	    c.busy.clear(std::memory_order_release);
+	    }
+	if (i == none)
+	    i = pop();
+	if (i == none)
+	    i = steal(mine);
+	return i;
+	}
+
+    void release(uint32_t i)
+	{
+	cache& c = cpu[here()];
+
+	if (c.busy.test_and_set(std::memory_order_acquire))
+	    {
+	    push(i);
+	    return;
+	    }
+	uint32_t n = c.count.load(std::memory_order_relaxed);
+	if (n == depth)
+	    {
+	    /* spill half, so that alternating frees and allocations stay local */
+	    while (n > depth / 2)
+		push(c.item[--n]);
+	    }
+	c.item[n] = i;
+	c.count.store(n + 1, std::memory_order_relaxed);
+	c.busy.clear(std::memory_order_release);
+	}
+
+public:
+    //! Create a pool with all *N* blocks on the global free list
+    object_pool() : top(0), globalCount(N)
+	{
+	for (size_t i = 0; i < N; i++)
+	    blocks[i].next.store((i + 1 < N) ? uint32_t(i + 1) : none,
+				 std::memory_order_relaxed);
+	}
+
+    object_pool(const object_pool&) = delete;
+    object_pool& operator=(const object_pool&) = delete;
+
+    //! The number of objects the pool can hold
+    static constexpr size_t capacity()
+	{
+	return N;
+	}
+
+    /*! The number of free blocks. The count is exact only while no other
+        task is using the pool.
+    */
+    size_t available() const
+	{
+	size_t n = globalCount.load(std::memory_order_relaxed);
+	for (const cache& c : cpu)
+	    n += c.count.load(std::memory_order_relaxed);
+	return n;
+	}
+
+    //! Returns true if *p* points into this pool's storage
+    bool owns(const void * p) const
+	{
+	const unsigned char * b = reinterpret_cast<const unsigned char *>(blocks);
+	const unsigned char * q = static_cast<const unsigned char *>(p);
+	return q >= b && q < b + sizeof(blocks);
+	}
+
+    /*! Take an uninitialized block large enough for a T, or return NULL if
+        the pool is exhausted.
+    */
+    void * allocate() noexcept
+	{
+	uint32_t i = claim();
+	return (i == none) ? nullptr : blocks[i].storage;
+	}
+
+    //! Return a block taken with allocate()
+    void deallocate(void * p) noexcept
+	{
+	release(static_cast<uint32_t>(index(static_cast<T *>(p))));
+	}
+
+    /*! Construct an object in a free block, or return NULL if the pool
+        is exhausted.
+    */
+    template <typename... Args>
+    T * make(Args&&... args)
+	{
+	void * p = allocate();
+	if (p == nullptr)
+	    return nullptr;
+	return new (p) T(std::forward<Args>(args)...);
+	}
+
+    //! Destroy an object made by this pool and return its block
+    void destroy(T * obj)
+	{
+	obj->~T();
+	deallocate(obj);
+	}
+
+    /*! The position of *obj* in the pool. Unlike its address, the position
+        is the same in every context that maps a shared pool.
+    */
+    size_t index(const T * obj) const
+	{
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(obj);
+	const unsigned char * b = reinterpret_cast<const unsigned char *>(blocks);
+	return static_cast<size_t>(p - b) / sizeof(block);
+	}
+
+    //! The object at position *i*, as returned by index()
+    T * at(size_t i)
+	{
+	return reinterpret_cast<T *>(blocks[i].storage);
+	}
+    };  // object_pool
+
+/*!
+
+\brief  A Shared Object Pool Class
+
+ A shared_object_pool places a vxworks::object_pool in a named shared data
+ region from
+ [sdLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/sdLib.html),
+ so that RTPs and the kernel can pass objects to each other without
+ copying them. The first context to open the name creates and fills the
+ pool; later ones map it and wait, if need be, until it is ready.
+
+ The region may be mapped at a different address in each RTP, so objects
+ in it must not hold pointers, and an object is passed between contexts by
+ its position, object_pool::index(), rather than by its address. On a
+ uniprocessor or in a kernel-only system the per-CPU caches behave as for
+ an object_pool; between RTPs the caches are chosen by task.
+
+ The region is deleted when the last context closes it.
+*/
+template <typename T, size_t N> class shared_object_pool
+    {
+private:
+    static const uint32_t ready = 0x706f6f6c;	/* "pool" */
+
+    struct region
+	{
+	std::atomic<uint32_t> state;
+	uint32_t size;
+	object_pool<T, N> pool;
+	};
+
+    SD_ID sd = SD_ID_NULL;
+    region * r = nullptr;
+
+public:
+    /*! Open the shared pool *name*, creating it if it does not exist.
+        If *create* is false, the pool must already exist.
+    */
+    shared_object_pool(const string name, bool create = true)
+	{
+	r = open_shared_region<region>(sd, name, sizeof(region), create, ready,
+	    [](region * fresh)
+		{
+		new (&fresh->state) std::atomic<uint32_t>(0);
+		fresh->size = sizeof(region);
+		new (&fresh->pool) object_pool<T, N>();
+		fresh->state.store(ready, std::memory_order_release);
+		},
+	    [](region * old) { return old->size == sizeof(region); });
+	}
+
+    shared_object_pool(const shared_object_pool&) = delete;
+    shared_object_pool& operator=(const shared_object_pool&) = delete;
+
+    //! Unmap the pool; it is deleted when the last context closes it
+    ~shared_object_pool()
+	{
+	::sdClose(sd, 0);
+	}
+
+    //! The pool in the shared region
+    object_pool<T, N>& pool() noexcept
+	{
+	return r->pool;
+	}
+
+    //! The handle of the shared data region
+    SD_ID handle() const noexcept
+	{
+	return sd;
+	}
+
+    //! Construct an object in the shared pool, or return NULL if it is full
+    template <typename... Args>
+    T * make(Args&&... args)
+	{
+	return r->pool.make(std::forward<Args>(args)...);
+	}
+
+    //! Destroy an object made by any context sharing the pool
+    void destroy(T * obj)
+	{
+	r->pool.destroy(obj);
+	}
+
+    //! The number of free blocks
+    size_t available() const
+	{
+	return r->pool.available();
+	}
+
+    //! The position of *obj*, valid in every context sharing the pool
+    size_t index(const T * obj) const
+	{
+	return r->pool.index(obj);
+	}
+
+    //! This context's address of the object at position *i*
+    T * at(size_t i)
+	{
+	return r->pool.at(i);
+	}
+    };  // shared_object_pool
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCobjectpoolhpp
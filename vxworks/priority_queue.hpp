@@ -0,0 +1,325 @@
+/* priority_queue.hpp - bounded multi-priority message queue */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCpriorityqueuehpp
+#define __INCpriorityqueuehpp
+
+#include <semLib.h>
+#include <objLib.h>
+#include <tickLib.h>
+#include <errno.h>
+#include "chrono2tic.hpp"
+#include "wait_gate.hpp"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*! Message ordering for a priority_queue where messages of the same band
+    are delivered strictly in the order they were sent.
+*/
+template <typename M> struct fifo_order
+    {
+    bool operator()(const M&, const M&) const
+	{
+	return false;
+	}
+    };
+
+/*!
+
+\brief  A Bounded Priority Queue Class
+
+ A vxworks::queue only distinguishes MSG_PRI_NORMAL and MSG_PRI_URGENT.
+ The priority_queue class accepts messages in any of 32 priority *bands*
+ and always delivers a message from the most urgent band that is not
+ empty. Following the VxWorks task priority convention band 0 is the most
+ urgent and band 31 (**lowest_band**) the least.
+
+ Within a band messages are ordered by *Compare*, with the same meaning as
+ for std::priority_queue: the greatest message according to *Compare* is
+ received first. Messages that compare equal, and all messages when the
+ default fifo_order is used, are received in the order they were sent.
+
+ The queue is a binary heap in pre-allocated storage, so send and receive
+ are O(log n) in the number of queued messages and never allocate. A
+ bitmap of non-empty bands is maintained alongside the heap, so the most
+ urgent pending band can be read in O(1) with highest_band() without
+ taking the queue's lock.
+
+ The storage lives in the memory of the creating context, so unlike a
+ vxworks::queue a priority_queue cannot be named and shared between RTPs.
+*/
+template <typename M, typename Compare = fifo_order<M> > class priority_queue
+    {
+public:
+    //! The number of priority bands
+    static const unsigned bands = 32;
+
+    //! The least urgent band, used when no band is given
+    static const unsigned lowest_band = bands - 1;
+
+private:
+    static constexpr size_t sizeM = sizeof(M);
+
+    struct entry
+	{
+	M message;
+	unsigned band;
+	unsigned long long seq;
+	};
+
+    /* holds <sem> for its scope, so that a copy of M that throws does not
+       leave it taken */
+    struct locked
+	{
+	SEM_ID sem;
+
+	explicit locked(SEM_ID s) : sem(s) { ::semMTake(sem, WAIT_FOREVER); }
+	~locked() { ::semMGive(sem); }
+	locked(const locked&) = delete;
+	locked& operator=(const locked&) = delete;
+	};
+
+    /* heap order: true if <a> is to be received after <b> */
+    struct later
+	{
+	Compare comp;
+
+	bool operator()(const entry& a, const entry& b) const
+	    {
+	    if (a.band != b.band)
+		return a.band > b.band;
+	    if (comp(a.message, b.message))
+		return true;
+	    if (comp(b.message, a.message))
+		return false;
+	    return a.seq > b.seq;
+	    }
+	};
+
+    size_t maxMsgs;
+    std::vector<entry> heap;
+    later order;
+    unsigned long long seq = 0;
+    unsigned counts[bands] = {};
+    std::atomic<_Vx_UINT32> bitmap;
+    SEM_ID lock;
+    wait_gate notEmpty;
+    wait_gate notFull;
+
+    bool try_push(const M& message, unsigned band)
+	{
+	locked l(lock);
+
+	if (heap.size() == maxMsgs)
+	    return false;
+	heap.push_back(entry{message, band, seq++});
+	std::push_heap(heap.begin(), heap.end(), order);
+	if (counts[band]++ == 0)
+	    bitmap.fetch_or(1u << band, std::memory_order_relaxed);
+	return true;
+	}
+
+    bool try_pop(M& message, unsigned& band)
+	{
+	locked l(lock);
+
+	if (heap.empty())
+	    return false;
+	/* copied before the heap is touched, so a throw leaves it whole */
+	message = heap.front().message;
+	band = heap.front().band;
+	std::pop_heap(heap.begin(), heap.end(), order);
+	heap.pop_back();
+	if (--counts[band] == 0)
+	    bitmap.fetch_and(~(1u << band), std::memory_order_relaxed);
+	return true;
+	}
+
+public:
+
+    /*! Instantiate a queue that holds up to *maxMsgs* messages.
+    */
+    priority_queue(size_t maxMsgs, const Compare& comp = Compare()) :
+	maxMsgs(maxMsgs), order{comp}, bitmap(0)
+	{
+	heap.reserve(maxMsgs);
+	lock = ::semMCreate(SEM_Q_PRIORITY|SEM_INVERSION_SAFE);
+	if (lock == SEM_ID_NULL)
+	    throw;
+	}
+
+    priority_queue(const priority_queue&) = delete;
+    priority_queue& operator=(const priority_queue&) = delete;
+
+    //! Delete a queue; no task may be pended on it
+    ~priority_queue()
+	{
+	::semDelete(lock);
+	}
+
+    //! The number of messages the queue can hold
+    size_t capacity() const
+	{
+	return maxMsgs;
+	}
+
+    /*! The number of messages currently in the queue.
+     */
+    ssize_t numMsgs()
+	{
+	::semMTake(lock, WAIT_FOREVER);
+	ssize_t n = static_cast<ssize_t>(heap.size());
+	::semMGive(lock);
+	return n;
+	}
+
+    /*! The number of messages currently queued.
+        ( just like numMsgs )
+    */
+    ssize_t size()
+	{
+	return numMsgs();
+	}
+
+    //! The number of messages currently queued in *band*
+    ssize_t size(unsigned band)
+	{
+	::semMTake(lock, WAIT_FOREVER);
+	ssize_t n = (band < bands) ? counts[band] : 0;
+	::semMGive(lock);
+	return n;
+	}
+
+    //! Returns true if the queue is empty.
+    bool empty() const
+	{
+	return bitmap.load(std::memory_order_relaxed) == 0;
+	}
+
+    /*! The most urgent band holding a message, or -1 if the queue is empty.
+        This is a lock-free O(1) read, and so only a hint when other tasks
+	are sending or receiving concurrently.
+    */
+    int highest_band() const
+	{
+	_Vx_UINT32 map = bitmap.load(std::memory_order_relaxed);
+	if (map == 0)
+	    return -1;
+	return __builtin_ctz(map);
+	}
+
+    //! put a message in priority *band*, pending if the queue is full for *timeout* tics
+    inline _Vx_STATUS send
+    	(
+	const M& message,
+	unsigned band,            /* 0 (most urgent) to lowest_band */
+	_Vx_ticks_t timeout       /* ticks to wait */
+    	)
+	{
+	if (band >= bands)
+	    {
+	    errno = EINVAL;
+	    return ERROR;
+	    }
+	if (!try_push(message, band) &&
+	    OK != notFull.pend(timeout, [&] { return try_push(message, band); }))
+	    return ERROR;
+	notEmpty.wake();
+	return OK;
+	}
+
+    //! put a message in priority *band*, pending if the queue is full for std::duration
+    template<class Rep, class Period>
+    inline _Vx_STATUS send( const M& message, unsigned band,
+			    const duration<Rep, Period>& relTime)
+	{
+	return send(message, band, chrono2tic(relTime));
+	}
+
+    //! put a message in priority *band*, pending indefinitely if the queue is full
+    inline _Vx_STATUS send( const M& message, unsigned band )
+	{
+	return send(message, band, WAIT_FOREVER);
+	}
+
+    //! put a message in the lowest band, pending indefinitely if the queue is full
+    inline void push( const M& message, unsigned band = lowest_band )
+	{
+	if (OK != send(message, band, WAIT_FOREVER))
+	    throw;
+	}
+
+    //! remove the most urgent message, returning its band, wait timeout tics for a message if queue is empty
+    inline ssize_t recieve(
+		    M& message,    /* message received */
+		    unsigned& band,           /* band of the message */
+		    _Vx_ticks_t timeout       /* ticks to wait */
+		    )
+	{
+	if (!try_pop(message, band) &&
+	    OK != notEmpty.pend(timeout, [&] { return try_pop(message, band); }))
+	    return ERROR;
+	notFull.wake();
+	return static_cast<ssize_t>(sizeM);
+	}
+
+    //! remove the most urgent message, wait timeout tics for a message if queue is empty
+    inline ssize_t recieve(
+		    M& message,    /* message received */
+		    _Vx_ticks_t timeout       /* ticks to wait */
+		    )
+	{
+	unsigned band;
+	return recieve(message, band, timeout);
+	}
+
+    //! remove the most urgent message, wait a std:duration for a message if queue is empty
+    template<class Rep, class Period>
+    inline ssize_t recieve(
+		    M& message,    /* message received */
+		    const duration<Rep, Period>& relTime )
+	{
+	return recieve(message, chrono2tic(relTime));
+	}
+
+    //! remove the most urgent message, pend indefinitely till a message is available
+    inline ssize_t recieve(
+		    M& message
+		    )
+	{
+	return recieve(message, WAIT_FOREVER);
+	}
+
+    //! remove the most urgent message, return error immediately if no message is available
+    inline ssize_t poll(
+		M& message
+		)
+	{
+	return recieve(message, NO_WAIT);
+	}
+
+    //! operator to send a message in the lowest band
+    void operator<< ( const M& message)
+ 	{
+	if (OK != send(message, lowest_band, WAIT_FOREVER))
+	    throw;
+	}
+
+    //! operator to receive the most urgent message
+    void operator>> ( M& message)
+ 	{
+	if (ERROR == recieve(message, WAIT_FOREVER))
+	    throw;
+	}
+    };  // priority_queue
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCpriorityqueuehpp
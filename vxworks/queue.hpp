@@ -9,31 +9,78 @@
 
 #include <msgQLib.h>
 #include <msgQEvLib.h>
+#include <semLib.h>
 #include "object.hpp"
 #include "chrono2tic.hpp"
+#include "expected.hpp"
+#include "queue_telemetry.hpp"
+#include "stop_token.hpp"
+#include "wait_gate.hpp"
+#include <errno.h>
+#include <atomic>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 #ifdef __cplusplus
 
 namespace vxworks 
 {
+/*! What a vxworks::queue does when a message is sent while it is full */
+enum class overflow_policy
+    {
+    block,	    //!< pend for the send timeout (the default)
+    drop_newest,    //!< discard the message being sent
+    drop_oldest,    //!< discard the oldest queued message to make room
+    coalesce	    //!< replace a queued message with the same key, else pend
+    };
+
 //! unlink a named message queue	
-void unlink( string name )
+inline void unlink( string name )
 	{
-	::msgQUnlink( name.c_str().c_str());
+	::msgQUnlink( name.c_str());
 	}
 
 
 // (VxWorks message queue )
 class msgQcommon : public object< MSG_Q_ID >
     {
-public:
-    ~msgQcommon()
+private:
+    /* close or delete the queue, unless it has been moved from */
+    void destroy() noexcept
 	{
-	if(named)
+	if (id == MSG_Q_ID_NULL)
+	    return;
+	delist();
+	if(named())
 	    ::msgQClose(id);
 	else
 	    ::msgQDelete(id);
+	id = MSG_Q_ID_NULL;
+	}
+
+public:
+    msgQcommon() = default;
+
+    //! Take over *other*'s queue, leaving *other* without one
+    msgQcommon(msgQcommon&& other) noexcept = default;
+
+    //! Delete this queue and take over *other*'s
+    msgQcommon& operator=(msgQcommon&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    }
+	return *this;
+	}
+
+    ~msgQcommon()
+	{
+	destroy();
 	}
   
    
@@ -96,16 +143,16 @@ use vxworks::queue.
 class msgQ: public msgQcommon
     {
 private:
-     const int default_mode = OM_DESTROY_ON_LAST_CALL | OM_CREATE ; 	    
-     const int default_options = MSG_Q_FIFO ; 	    
+     static constexpr int default_mode = OM_DESTROY_ON_LAST_CALL | OM_CREATE ;
+     static constexpr int default_options = MSG_Q_FIFO ;
 public:
     //! Create a VxWorks named message queue specifying all parameters 
     msgQ( const string name, size_t maxMsgs, 
 			     size_t maxMsgLength, int options, int mode,
 			     void * context)
 	{
-	named = true;
-	id = ::msgQOpen( name.c_str(), maxMsgs, maxMsgLength,  options, mode, context);
+	set_name(name);
+	id = enlist(::msgQOpen( name.c_str(), maxMsgs, maxMsgLength,  options, mode, context));
 	if (id == MSG_Q_ID_NULL)
 	    throw;
 	}
@@ -114,8 +161,8 @@ public:
     msgQ( const string name, size_t maxMsgs, 
 			     size_t maxMsgLength)
 	{
-	named = true;
-	id = ::msgQOpen(  name.c_str(), maxMsgs, maxMsgLength,  default_options, default_mode, NULL);
+	set_name(name);
+	id = enlist(::msgQOpen(  name.c_str(), maxMsgs, maxMsgLength,  default_options, default_mode, NULL));
 	if (id == MSG_Q_ID_NULL)
 		    throw;
 	}
@@ -124,7 +171,7 @@ public:
     msgQ(size_t maxMsgs, 
 	     size_t maxMsgLength, int options)
 	{
-	id = ::msgQCreate (maxMsgs, maxMsgLength, options);
+	id = enlist(::msgQCreate (maxMsgs, maxMsgLength, options));
 	if (id == MSG_Q_ID_NULL)
 		    throw;
 	}
@@ -132,8 +179,8 @@ public:
     //! open an existing named queue, created in another context 
     msgQ(const char& name)
 	{
-	named = true;
-	id = ::msgQOpen( &name, 0, 0, 0, 0, NULL);
+	set_name(&name);
+	id = enlist(::msgQOpen( &name, 0, 0, 0, 0, NULL));
 	if (id == MSG_Q_ID_NULL)
 	    throw;
 	}
@@ -147,7 +194,8 @@ public:
 	 int       priority        /* MSG_PRI_NORMAL or MSG_PRI_URGENT */
     	)
 	{
-	return ::msgQSend(id, &buffer, nBytes, timeout, priority);
+	return traced(trace_op::send, [&]
+	    { return ::msgQSend(id, &buffer, nBytes, timeout, priority); });
 	}
 
     //! put a message on the front of the queue, pend if the queue is full
@@ -157,7 +205,8 @@ public:
 	 size_t    nBytes         /* length of message */
     	)
 	{
-	return ::msgQSend(id, &buffer, nBytes, WAIT_FOREVER, MSG_PRI_NORMAL);
+	return traced(trace_op::send, [&]
+	    { return ::msgQSend(id, &buffer, nBytes, WAIT_FOREVER, MSG_PRI_NORMAL); });
 	}
     
     //! remove a message from the end of the queue, wait timeout tics for a message if queue is empty
@@ -166,7 +215,8 @@ public:
 		    _Vx_ticks_t timeout       /* ticks to wait */
 		    )
 	{
-	 return ::msgQReceive( id, &buffer, maxNBytes, timeout);
+	return traced(trace_op::receive, [&]
+	    { return ::msgQReceive(id, &buffer, maxNBytes, timeout); });
 	}
  
     //! remove a message from the end of the queue, wait a std:duration for a message if queue is empty
@@ -176,7 +226,8 @@ public:
 		    size_t      maxNBytes,    /* length of buffer */
 		    const duration<Rep, Period>& relTime   )
 	{
-	 return ::msgQReceive( id, &buffer, maxNBytes, chrono2tic(relTime));
+	return traced(trace_op::receive, [&]
+	    { return ::msgQReceive(id, &buffer, maxNBytes, chrono2tic(relTime)); });
 	}
 
  
@@ -185,7 +236,8 @@ public:
 		    size_t      maxNBytes    /* length of buffer */
 		    )
 	{
-	 return ::msgQReceive( id, &buffer, maxNBytes, WAIT_FOREVER);
+	return traced(trace_op::receive, [&]
+	    { return ::msgQReceive(id, &buffer, maxNBytes, WAIT_FOREVER); });
 	}
     
     //! remove a message from the end of the queue, return error immediately if no message is available
@@ -193,7 +245,8 @@ public:
 		 size_t      maxNBytes    /* length of buffer */
 		 )
 	{
-	 return ::msgQReceive( id, &buffer, maxNBytes, NO_WAIT);
+	return traced(trace_op::receive, [&]
+	    { return ::msgQReceive(id, &buffer, maxNBytes, NO_WAIT); });
 	}
     }; // msgQ 
 
@@ -207,13 +260,547 @@ this way it is similar to std::queue, however a vxworks::queue is **not**
 a wrapper to an underlying container class. And thus manipulation of the underlying
 queue contents is quite limited compared to std::queue.
 
+The optional *Telemetry* parameter selects whether the queue gathers depth
+and latency statistics, see vxworks::queue_telemetry. With the default,
+vxworks::no_telemetry, no statistics code is generated.
+
+By default a send to a full queue pends, for ever in the case of push()
+and operator<<. overflow() selects another vxworks::overflow_policy, and
+watermarks() installs callbacks that tell producers to throttle before the
+queue fills. Both are properties of this queue object, not of the
+underlying msgQ: other contexts using the same named queue are not
+affected. A queue that never configures them pays only a null pointer
+test per operation. They may be changed while other tasks send and
+receive: each change publishes a new copy of the configuration, and the
+copy it replaces is deleted once no task that could be reading it is
+still sending or receiving.
+
 */
-template <typename M> class queue : public msgQcommon
+template <typename M, typename Telemetry = no_telemetry> class queue : public msgQcommon, private Telemetry
     {
 private:
-    const size_t sizeM = sizeof(M);
-    const int default_mode = OM_DESTROY_ON_LAST_CALL | OM_CREATE ; 	    
-    const int default_options = MSG_Q_FIFO ; 	    
+    /* a message as carried by the msgQ when telemetry is enabled */
+    struct stamped
+	{
+	M message;
+	unsigned long long stamp;
+	};
+    typedef typename std::conditional<Telemetry::enabled, stamped, M>::type wire;
+
+    static constexpr size_t sizeM = sizeof(wire);
+    static constexpr int default_mode = OM_DESTROY_ON_LAST_CALL | OM_CREATE ;
+    static constexpr int default_options = MSG_Q_FIFO ;
+
+    /* overflow policy and watermark settings, allocated only when
+       configured. A published copy is never changed: configuring
+       publishes a changed copy in its place, see control */
+    struct backpressure
+	{
+	overflow_policy policy = overflow_policy::block;
+	std::function<unsigned long long(const M&)> key;
+	size_t high = 0;
+	size_t low = 0;
+	std::function<void(size_t)> onHigh;
+	std::function<void(size_t)> onLow;
+	backpressure * next = nullptr;	/* in the list of replaced copies */
+	};
+
+    /* hold a mutex semaphore for a scope */
+    struct locked
+	{
+	SEM_ID sem;
+
+	explicit locked(SEM_ID s) : sem(s) { ::semMTake(sem, WAIT_FOREVER); }
+	~locked() { ::semMGive(sem); }
+	locked(const locked&) = delete;
+	locked& operator=(const locked&) = delete;
+	};
+
+    /* The keys of the messages on the msgQ of a coalescing queue, so that a
+       sender can replace a message without taking it off the msgQ. While
+       the index exists every send is made without pending and counted
+       here, under <lock>; a sender that finds no room pends on <space>,
+       which receivers give. A message that replaces a queued one is kept
+       here, and handed to whoever receives the last message queued with
+       its key, in that message's place */
+    class keyed
+	{
+	private:
+	    struct entry
+		{
+		bool used = false;
+		bool replaced = false;
+		unsigned long long key = 0;
+		size_t queued = 0;
+		wire latest;
+		};
+
+	    /* open addressing, at least twice the capacity of the msgQ, and
+	       an entry only for a key that has a message queued */
+	    std::vector<entry> table;
+	    size_t mask;
+
+	    size_t home(unsigned long long key) const noexcept
+		{
+		return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+		}
+
+	    size_t slot(unsigned long long key) const noexcept
+		{
+		size_t i = home(key);
+
+		while (table[i].used && table[i].key != key)
+		    i = (i + 1) & mask;
+		return i;
+		}
+
+	    /* free the entry at <i>, moving back the entries after it that
+	       would otherwise no longer be found */
+	    void erase(size_t i) noexcept
+		{
+		for (size_t j = (i + 1) & mask; table[j].used; j = (j + 1) & mask)
+		    {
+		    if (((j - home(table[j].key)) & mask) >= ((j - i) & mask))
+			{
+			table[i] = table[j];
+			i = j;
+			}
+		    }
+		table[i].used = false;
+		table[i].replaced = false;
+		table[i].queued = 0;
+		}
+
+	public:
+	    SEM_ID lock;
+	    wait_gate space;
+
+	    explicit keyed(size_t capacity)
+		{
+		size_t n = 2;
+
+		while (n < 2 * capacity)
+		    n *= 2;
+		table.resize(n);
+		mask = n - 1;
+		lock = ::semMCreate(SEM_Q_PRIORITY|SEM_INVERSION_SAFE);
+		if (lock == SEM_ID_NULL)
+		    throw;
+		}
+
+	    ~keyed()
+		{
+		::semDelete(lock);
+		}
+
+	    keyed(const keyed&) = delete;
+	    keyed& operator=(const keyed&) = delete;
+
+	    /* count a message just put on the msgQ */
+	    void queued(unsigned long long key) noexcept
+		{
+		entry& e = table[slot(key)];
+
+		e.used = true;
+		e.key = key;
+		e.queued++;
+		}
+
+	    /* replace the last message queued with <key> by <w>; false if
+	       none is queued */
+	    bool replace(unsigned long long key, const wire& w) noexcept
+		{
+		entry& e = table[slot(key)];
+
+		if (!e.used)
+		    return false;
+		e.latest = w;
+		e.replaced = true;
+		return true;
+		}
+
+	    /* count the message <w> with <key> taken off the msgQ, putting in
+	       its place the message that replaced it if it is the last one
+	       queued with that key. The index is only made on an empty msgQ,
+	       so every message received was counted when it was queued */
+	    void received(unsigned long long key, wire& w) noexcept
+		{
+		size_t i = slot(key);
+
+		if (!table[i].used || --table[i].queued != 0)
+		    return;
+		if (table[i].replaced)
+		    w = table[i].latest;
+		erase(i);
+		}
+	};
+
+    /* The back pressure state of a queue, allocated when it is first
+       configured and kept until the queue is destroyed. The tasks using
+       the current settings are counted in <users>. The copies that
+       configuring replaces are deleted once that count is seen to be 0
+       after they were replaced, as no task can then still be reading
+       them; the last user to leave, or the next to configure, does so.
+       Receivers wake <room> for senders that wait for a stop as well as
+       for space */
+    struct control
+	{
+	std::atomic<backpressure *> current {nullptr};
+	std::atomic<backpressure *> replaced {nullptr};
+	std::atomic<unsigned> users {0};
+	std::atomic<bool> above {false};
+	std::atomic<unsigned long long> dropped {0};
+	std::atomic<keyed *> index {nullptr};
+	wait_gate room;
+
+	control() = default;
+	control(const control&) = delete;
+	control& operator=(const control&) = delete;
+
+	~control()
+	    {
+	    delete current.load(std::memory_order_relaxed);
+	    release(replaced.load(std::memory_order_relaxed));
+	    delete index.load(std::memory_order_relaxed);
+	    }
+
+	static void release(backpressure * b) noexcept
+	    {
+	    while (b != nullptr)
+		{
+		backpressure * next = b->next;
+		delete b;
+		b = next;
+		}
+	    }
+
+	/* count the caller as a user and return the current settings */
+	backpressure * enter() noexcept
+	    {
+	    users.fetch_add(1, std::memory_order_seq_cst);
+	    return current.load(std::memory_order_seq_cst);
+	    }
+
+	/* stop counting the caller, deleting the replaced copies if it was
+	   the last user */
+	void leave() noexcept
+	    {
+	    if (users.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+		replaced.load(std::memory_order_relaxed) != nullptr)
+		reclaim();
+	    }
+
+	/* add the list of copies starting at <b> to the replaced ones */
+	void retire(backpressure * b) noexcept
+	    {
+	    backpressure * tail = b;
+	    backpressure * head = replaced.load(std::memory_order_relaxed);
+
+	    while (tail->next != nullptr)
+		tail = tail->next;
+	    do
+		tail->next = head;
+	    while (!replaced.compare_exchange_weak(head, b, std::memory_order_seq_cst,
+						   std::memory_order_relaxed));
+	    }
+
+	/* delete the replaced copies if no task is using the settings */
+	void reclaim() noexcept
+	    {
+	    backpressure * list = replaced.exchange(nullptr, std::memory_order_seq_cst);
+
+	    if (list == nullptr)
+		return;
+	    if (users.load(std::memory_order_seq_cst) == 0)
+		release(list);
+	    else
+		retire(list);
+	    }
+	};
+    std::atomic<control *> bp {nullptr};
+
+    /* the settings of a queue, kept from deletion while this is held */
+    struct hold
+	{
+	control * c;
+	backpressure * b;
+
+	explicit hold(control * state) noexcept
+	    : c(state), b(state ? state->enter() : nullptr)
+	    {
+	    }
+
+	~hold()
+	    {
+	    if (c != nullptr)
+		c->leave();
+	    }
+
+	hold(const hold&) = delete;
+	hold& operator=(const hold&) = delete;
+	};
+
+    static const M& payload(const wire& w)
+	{
+	if constexpr (Telemetry::enabled)
+	    return w.message;
+	else
+	    return w;
+	}
+
+    /* the back pressure state, made on first use */
+    control * controlled()
+	{
+	control * c = bp.load(std::memory_order_acquire);
+
+	if (c == nullptr)
+	    {
+	    std::unique_ptr<control> fresh(new control);
+	    if (bp.compare_exchange_strong(c, fresh.get(), std::memory_order_acq_rel,
+					   std::memory_order_acquire))
+		c = fresh.release();
+	    }
+	return c;
+	}
+
+    /* publish a copy of the current settings changed by <change> */
+    template <typename Change>
+    void configure(Change change)
+	{
+	control * c = controlled();
+	hold h(c);
+	backpressure * old = h.b;
+
+	for (;;)
+	    {
+	    std::unique_ptr<backpressure> fresh(old ? new backpressure(*old)
+						    : new backpressure);
+	    fresh->next = nullptr;
+	    change(*fresh);
+	    if (c->current.compare_exchange_strong(old, fresh.get(),
+						   std::memory_order_seq_cst))
+		{
+		fresh.release();
+		if (old != nullptr)
+		    {
+		    old->next = nullptr;
+		    c->retire(old);
+		    }
+		return;
+		}
+	    /* another task configured the queue meanwhile: start again from its settings */
+	    }
+	}
+
+    /* count a message discarded by the overflow policy and report it */
+    static _Vx_STATUS discard(control& c) noexcept
+	{
+	c.dropped.fetch_add(1, std::memory_order_relaxed);
+	errno = ENOBUFS;
+	return ERROR;
+	}
+
+    /* try once, with the index locked, to put <w> on the msgQ of a queue
+       with a key index, applying the overflow policy. Returns false if the
+       sender must wait for room, else true with the result in <status> */
+    bool offer(control& c, const backpressure& b, keyed& k, unsigned long long key,
+	       const wire& w, int priority, _Vx_STATUS& status)
+	{
+	char * buffer = reinterpret_cast<char *>(const_cast<wire *>(&w));
+
+	for (;;)
+	    {
+	    if (OK == ::msgQSend(id, buffer, sizeM, NO_WAIT, priority))
+		{
+		k.queued(key);
+		status = OK;
+		return true;
+		}
+	    if (errno != S_objLib_OBJ_UNAVAILABLE)
+		{
+		status = ERROR;
+		return true;
+		}
+	    switch (b.policy)
+		{
+		case overflow_policy::drop_newest:
+		    status = discard(c);
+		    return true;
+		case overflow_policy::drop_oldest:
+		    {
+		    wire old;
+		    if (ERROR != ::msgQReceive(id, reinterpret_cast<char *>(&old), sizeM, NO_WAIT))
+			{
+			k.received(b.key(payload(old)), old);
+			c.dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		    break;
+		    }
+		case overflow_policy::coalesce:
+		    if (!k.replace(key, w))
+			return false;
+		    c.dropped.fetch_add(1, std::memory_order_relaxed);
+		    status = OK;
+		    return true;
+		default:
+		    return false;
+		}
+	    }
+	}
+
+    /* put a message on the msgQ, applying the overflow policy */
+    _Vx_STATUS post(const hold& h, const wire& w, _Vx_ticks_t timeout, int priority)
+	{
+	return traced(trace_op::send, [&]() -> _Vx_STATUS
+	    {
+	    char * buffer = reinterpret_cast<char *>(const_cast<wire *>(&w));
+	    backpressure * b = h.b;
+	    keyed * k = b ? h.c->index.load(std::memory_order_acquire) : nullptr;
+
+	    if (k != nullptr && b->key)
+		{
+		unsigned long long key = b->key(payload(w));
+		_Vx_STATUS status = ERROR;
+		auto attempt = [&]
+		    {
+		    locked g(k->lock);
+		    return offer(*h.c, *b, *k, key, w, priority, status);
+		    };
+
+		if (attempt())
+		    return status;
+		if (timeout == NO_WAIT)
+		    {
+		    errno = S_objLib_OBJ_UNAVAILABLE;
+		    return ERROR;
+		    }
+		return (OK == k->space.pend(timeout, attempt)) ? status : ERROR;
+		}
+
+	    if (b == nullptr || b->policy == overflow_policy::block ||
+		b->policy == overflow_policy::coalesce)
+		return ::msgQSend(id, buffer, sizeM, timeout, priority);
+
+	    for (;;)
+		{
+		if (OK == ::msgQSend(id, buffer, sizeM, NO_WAIT, priority))
+		    return OK;
+		if (errno != S_objLib_OBJ_UNAVAILABLE)
+		    return ERROR;
+		if (b->policy == overflow_policy::drop_newest)
+		    return discard(*h.c);
+		wire old;
+		if (ERROR != ::msgQReceive(id, reinterpret_cast<char *>(&old), sizeM, NO_WAIT))
+		    h.c->dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	    });
+	}
+
+    /* note the queue crossing the high watermark, calling onHigh; the
+       crossing is tracked if either callback is set, as onLow needs it */
+    void rising(control& c, backpressure& b)
+	{
+	if ((b.onHigh || b.onLow) && !c.above.load(std::memory_order_relaxed))
+	    {
+	    ssize_t depth = ::msgQNumMsgs(id);
+	    bool was = false;
+	    if (depth >= static_cast<ssize_t>(b.high) &&
+		c.above.compare_exchange_strong(was, true) && b.onHigh)
+		b.onHigh(static_cast<size_t>(depth));
+	    }
+	}
+
+    /* note the queue draining to the low watermark, calling onLow */
+    void falling(control& c, backpressure& b)
+	{
+	if ((b.onHigh || b.onLow) && c.above.load(std::memory_order_relaxed))
+	    {
+	    ssize_t depth = ::msgQNumMsgs(id);
+	    bool was = true;
+	    if (depth <= static_cast<ssize_t>(b.low) &&
+		c.above.compare_exchange_strong(was, false) && b.onLow)
+		b.onLow(static_cast<size_t>(depth));
+	    }
+	}
+
+    /* account for the message <w> just received: count it off the key
+       index, which may put the message that replaced it in its place, and
+       note the queue draining */
+    void settle(wire& w)
+	{
+	hold h(bp.load(std::memory_order_acquire));
+
+	if (h.c == nullptr)
+	    return;
+	h.c->room.wake();
+	if (h.b == nullptr)
+	    return;
+	if (keyed * k = h.c->index.load(std::memory_order_acquire))
+	    {
+	    if (h.b->key)
+		{
+		unsigned long long key = h.b->key(payload(w));
+		locked g(k->lock);
+		k->received(key, w);
+		}
+	    k->space.wake();
+	    }
+	falling(*h.c, *h.b);
+	}
+
+    /* send one message, recording it if telemetry is enabled */
+    inline _Vx_STATUS transmit(const M& message, _Vx_ticks_t timeout, int priority)
+	{
+	_Vx_STATUS status;
+	hold h(bp.load(std::memory_order_acquire));
+
+	if constexpr (Telemetry::enabled)
+	    {
+	    stamped s;
+	    s.message = message;
+	    s.stamp = Telemetry::now();
+	    status = post(h, s, timeout, priority);
+	    if (status == OK)
+		Telemetry::sent(::msgQNumMsgs(id));
+	    else if (errno == S_objLib_OBJ_TIMEOUT)
+		Telemetry::send_timeout();
+	    }
+	else
+	    status = post(h, message, timeout, priority);
+
+	if (status == OK && h.b != nullptr)
+	    rising(*h.c, *h.b);
+	return status;
+	}
+
+    /* receive one message, recording it if telemetry is enabled */
+    inline ssize_t fetch(M& message, _Vx_ticks_t timeout)
+	{
+	if constexpr (Telemetry::enabled)
+	    {
+	    stamped s;
+	    ssize_t n = traced(trace_op::receive, [&]
+		{ return ::msgQReceive(id, reinterpret_cast<char *>(&s), sizeM, timeout); });
+	    if (n == ERROR)
+		{
+		if (errno == S_objLib_OBJ_TIMEOUT)
+		    Telemetry::receive_timeout();
+		return ERROR;
+		}
+	    settle(s);
+	    message = s.message;
+	    Telemetry::received(s.stamp);
+	    return static_cast<ssize_t>(sizeof(M));
+	    }
+	else
+	    {
+	    ssize_t n = traced(trace_op::receive, [&]
+		{ return ::msgQReceive(id, reinterpret_cast<char *>(&message), sizeM, timeout); });
+	    if (n != ERROR)
+		settle(message);
+	    return n;
+	    }
+	}
 
 public:    
     
@@ -223,8 +810,8 @@ public:
     			     int options, int mode,
     			     void * context)
     	{
-	named = true;
-    	id = ::msgQOpen( name.c_str(), maxMsgs, sizeM,  options, mode, context);
+	set_name(name);
+    	id = enlist(::msgQOpen( name.c_str(), maxMsgs, sizeM,  options, mode, context));
     	if (id == MSG_Q_ID_NULL)
     	    throw;
     	}
@@ -233,8 +820,8 @@ public:
     */
     queue(const string name, size_t maxMsgs )
 	{
-	named = true;
-	id = ::msgQOpen( name.c_str(), maxMsgs, sizeM,  default_options, default_mode, NULL);
+	set_name(name);
+	id = enlist(::msgQOpen( name.c_str(), maxMsgs, sizeM,  default_options, default_mode, NULL));
 	if (id == MSG_Q_ID_NULL)
 		    throw;
 	}
@@ -243,7 +830,7 @@ public:
     */
     queue(size_t maxMsgs )
 	{
-	id = ::msgQCreate (maxMsgs, sizeM, default_options);
+	id = enlist(::msgQCreate (maxMsgs, sizeM, default_options));
 	if (id == MSG_Q_ID_NULL)
 		    throw;
 	}
@@ -252,11 +839,32 @@ public:
          */
     queue(const string name)
 	{
-	named = true;
-	id = ::msgQOpen( name.c_str(), 0, 0, 0, 0, NULL);
+	set_name(name);
+	id = enlist(::msgQOpen( name.c_str(), 0, 0, 0, 0, NULL));
 	if (id == MSG_Q_ID_NULL)
 	    throw;
 	}
+
+    //! Take over the queue and configuration of *other*, leaving it invalid
+    queue(queue&& other) noexcept
+	: msgQcommon(std::move(other)), Telemetry(std::move(other)),
+	  bp(other.bp.exchange(nullptr, std::memory_order_relaxed))
+	{
+	}
+
+    queue& operator=(queue&& other) noexcept
+	{
+	msgQcommon::operator=(std::move(other));
+	Telemetry::operator=(std::move(other));
+	delete bp.exchange(other.bp.exchange(nullptr, std::memory_order_relaxed),
+			   std::memory_order_relaxed);
+	return *this;
+	}
+
+    ~queue()
+	{
+	delete bp.load(std::memory_order_relaxed);
+	}
     
     //! put a message of type M at the front of the queue, pending if the queue is full for *timeout* tics 
     inline _Vx_STATUS send 
@@ -266,14 +874,14 @@ public:
 	 int       priority        /* MSG_PRI_NORMAL or MSG_PRI_URGENT */
     	)
 	{
-	return ::msgQSend(id, reinterpret_cast<char *>(&message), sizeM, timeout, priority);
+	return transmit(message, timeout, priority);
 	}
 	
     //! put a message of type M at the front of the queue, pending if the queue is full for std::duration
      template<class Rep, class Period>
      inline _Vx_STATUS send( M& message, const duration<Rep, Period>& relTime) 
 	{
-	return ::msgQSend(id, reinterpret_cast<char *>(&message), sizeM, chrono2tic(relTime), MSG_PRI_NORMAL);
+	return transmit(message, chrono2tic(relTime), MSG_PRI_NORMAL);
 	}
 
     //! put a message of type M at the front of the queue, pending indefinitely if the queue is full 
@@ -282,15 +890,18 @@ public:
 	M& message
 	)
 	{
-	return ::msgQSend(id, reinterpret_cast<char *>(&message), sizeM, WAIT_FOREVER, MSG_PRI_NORMAL);
+	return transmit(message, WAIT_FOREVER, MSG_PRI_NORMAL);
 	}
     
-    //! put a message of type M at the front of the queue, pending indefinitely if the queue is full
+    /*! put a message of type M at the front of the queue, pending
+        indefinitely if the queue is full. A message discarded by
+	overflow_policy::drop_newest is not an error here.
+    */
     inline void push( 
 	     const M& message 
 	     )
 	{
-	if ( OK != ::msgQSend(id, reinterpret_cast<char *>(&message), sizeM, WAIT_FOREVER, MSG_PRI_NORMAL))
+	if ( OK != transmit(message, WAIT_FOREVER, MSG_PRI_NORMAL) && errno != ENOBUFS)
 	    throw;
 	}
     
@@ -300,7 +911,7 @@ public:
 		    _Vx_ticks_t timeout       /* ticks to wait */
 		    )
 	{
-	 return ::msgQReceive( id, reinterpret_cast<char *>(&message), sizeM, timeout);
+	 return fetch(message, timeout);
 	}
     
     //! remove a message from the end of the queue, wait a std:duration for a message if queue is empty
@@ -309,7 +920,7 @@ public:
 		    M& message,    /* pointer to message */
 		    const duration<Rep, Period>& relTime     		    )
 	{
-	 return ::msgQReceive( id, reinterpret_cast<char *>(&message), sizeM, chrono2tic(relTime));
+	 return fetch(message, chrono2tic(relTime));
 	}
 
    //! remove a message from the end of the queue, pend indefinitely till a message is available
@@ -317,7 +928,82 @@ public:
 		    M& message
 		    )
 	{
-	 return ::msgQReceive( id, reinterpret_cast<char *>(&message), sizeM, WAIT_FOREVER);
+	 return fetch(message, WAIT_FOREVER);
+	}
+
+    /*! remove a message from the end of the queue, wait *timeout* tics for
+        a message if queue is empty, or until a stop of *token* is
+	requested, when this returns ERROR with errno set to ECANCELED
+    */
+    inline ssize_t recieve(
+		    M& message,    /* pointer to message */
+		    _Vx_ticks_t timeout,       /* ticks to wait */
+		    const stop_token& token
+		    )
+	{
+	ssize_t n = ERROR;
+
+	if (OK != stoppable_wait(token, timeout, id,
+		[&](_Vx_ticks_t t) { return (n = fetch(message, t)) == ERROR ? ERROR : OK; },
+		[&] { return ::msgQEvStart(id, VX_STOP_READY_EVENT,
+					   EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE); },
+		[&] { ::msgQEvStop(id); }))
+	    return ERROR;
+	return n;
+	}
+
+   //! remove a message from the end of the queue, pend till a message is available or a stop of *token* is requested
+   inline ssize_t recieve(
+		    M& message,
+		    const stop_token& token
+		    )
+	{
+	 return recieve(message, WAIT_FOREVER, token);
+	}
+
+    /*! put a message of type M at the front of the queue, pending up to
+        *timeout* tics if the queue is full, or until a stop of *token* is
+	requested, when this returns ERROR with errno set to ECANCELED.
+	A msgQ sends no event when it has space, so the receivers of this
+	object wake the sender through a gate of its own. A named queue may
+	be received from in other contexts, which do not, so a stop of a
+	send to a full named queue is seen within 1/VX_STOP_POLL_HZ seconds.
+    */
+    inline _Vx_STATUS send
+    	(
+	M& message,
+	 _Vx_ticks_t timeout,      /* ticks to wait */
+	 const stop_token& token
+    	)
+	{
+	control * c = named() ? nullptr : controlled();
+	wait_gate * room = c ? &c->room : nullptr;
+
+	return stoppable_wait(token, timeout, room ? room->object() : id,
+	    [&](_Vx_ticks_t t) { return transmit(message, t, MSG_PRI_NORMAL); },
+	    [&]
+		{
+		MSG_Q_INFO info;
+
+		/* pend on the queue in periods */
+		if (room == nullptr)
+		    return ERROR;
+		if (OK != room->arm(VX_STOP_READY_EVENT))
+		    return ERROR;
+		/* a receive before arming did not wake the gate */
+		memset(&info, 0, sizeof(info));
+		if (OK == ::msgQInfoGet(id, &info) &&
+		    info.numMsgs < info.maxMsgs)
+		    room->wake();
+		return OK;
+		},
+	    [&] { room->disarm(); });
+	}
+
+    //! put a message of type M at the front of the queue, pending if it is full until a stop of *token* is requested
+    inline _Vx_STATUS send(M& message, const stop_token& token)
+	{
+	return send(message, WAIT_FOREVER, token);
 	}
 
     //! remove a message from the end of the queue, return error immediately if no message is available
@@ -325,22 +1011,199 @@ public:
 		M& message 
 		)
 	{
-	 return ::msgQReceive( id, reinterpret_cast<char *>(&message), sizeM, NO_WAIT);
+	 return fetch(message, NO_WAIT);
 	}
 
-    //! operator to send a message 
+    //! operator to send a message; as with push(), a dropped message is not an error
     void operator<< ( M& message)
  	{
-	if (OK != ::msgQSend(id, reinterpret_cast<char *>(&message), sizeM, WAIT_FOREVER, MSG_PRI_NORMAL))
+	if (OK != transmit(message, WAIT_FOREVER, MSG_PRI_NORMAL) && errno != ENOBUFS)
 	    throw;
 	}
 	 
     //! operator to receive a message 
     void operator>> (  M& message)
  	{
-	if (OK != ::msgQReceive( id, reinterpret_cast<char *>(&message), sizeM, WAIT_FOREVER) )
+	if (ERROR == fetch(message, WAIT_FOREVER) )
 	    throw;
 	}
+
+    /*! put a message of type M at the front of the queue, pending up to
+        *timeout* tics if it is full, and return the error rather than
+	throwing. Unlike the other nothrow overloads this one is not
+	noexcept: an exception from M or from a coalesce_by() key or a
+	watermark callback still propagates.
+    */
+    inline expected<void> push(const M& message, _Vx_ticks_t timeout,
+			       std::nothrow_t)
+	{
+	return to_expected(transmit(message, timeout, MSG_PRI_NORMAL));
+	}
+
+    //! put a message of type M at the front of the queue, pending if it is full
+    inline expected<void> push(const M& message, std::nothrow_t)
+	{
+	return to_expected(transmit(message, WAIT_FOREVER, MSG_PRI_NORMAL));
+	}
+
+    /*! remove a message from the end of the queue, pending up to *timeout*
+        tics if it is empty, and return it or the error. Not noexcept, as
+	constructing and copying M and the watermark callbacks may throw.
+    */
+    inline expected<M> pop(_Vx_ticks_t timeout, std::nothrow_t)
+	{
+	M message;
+
+	if (ERROR == fetch(message, timeout))
+	    return vx_error::last();
+	return message;
+	}
+
+    //! remove a message from the end of the queue, pending if it is empty
+    inline expected<M> pop(std::nothrow_t)
+	{
+	return pop(WAIT_FOREVER, std::nothrow);
+	}
+
+    //! remove a message from the end of the queue, pending up to a std::duration
+    template<class Rep, class Period>
+    inline expected<M> pop(const duration<Rep, Period>& relTime,
+			   std::nothrow_t)
+	{
+	return pop(chrono2tic(relTime), std::nothrow);
+	}
+
+    /*! Select what happens when a message is sent to a full queue.
+        The policy applies to every send method, including push() and
+	operator<<. With overflow_policy::drop_newest and
+	overflow_policy::drop_oldest a send never pends for want of space;
+	a send whose message overflow_policy::drop_newest discards returns
+	ERROR with errno set to ENOBUFS. overflow_policy::coalesce needs a
+	key, see coalesce_by(), and pends as overflow_policy::block does
+	when no queued message has the key of the one sent.
+    */
+    void overflow(overflow_policy policy)
+	{
+	configure([policy](backpressure& c) { c.policy = policy; });
+	}
+
+    //! The current overflow policy
+    overflow_policy overflow() const
+	{
+	hold h(bp.load(std::memory_order_acquire));
+	return h.b ? h.b->policy : overflow_policy::block;
+	}
+
+    /*! Coalesce messages by key when the queue is full.
+
+	When a send finds the queue full, the newest queued message whose
+	*key* equals that of the new message is replaced by it; if there is
+	none the send pends, up to its timeout, as with
+	overflow_policy::block. *key* is any callable taking a const M& and
+	returning an integral key.
+
+	The msgQ is never drained: this queue keeps an index of the keys of
+	the messages it has queued, made here for the capacity of the queue
+	so that sending does not allocate, and the message that replaces
+	another is kept in the index and received in its place. Messages
+	with other keys are never lost or reordered. The last message with
+	the key to be received is the one replaced, which differs from the
+	newest sent only if MSG_PRI_URGENT was used. From then on every
+	send to the queue is made without pending on the msgQ, under a
+	lock shared with receivers, and a sender that must wait for room
+	pends until a receiver takes a message. The index must start from
+	an empty queue: the first call returns ERROR, with errno set to
+	EBUSY and the policy unchanged, if a message is queued, and must not
+	be made while other tasks send. Later calls only change the key.
+
+	The index only sees the messages sent and received through this
+	object. A named queue may be used from other contexts, so on a named
+	queue overflow_policy::coalesce behaves as overflow_policy::block.
+    */
+    template <typename Key>
+    _Vx_STATUS coalesce_by(Key key)
+	{
+	if (!named())
+	    {
+	    control * c = controlled();
+	    if (c->index.load(std::memory_order_acquire) == nullptr)
+		{
+		MSG_Q_INFO info;
+		keyed * none = nullptr;
+
+		memset(&info, 0, sizeof(info));
+		if (OK != ::msgQInfoGet(id, &info))
+		    throw;
+		/* a message already queued would not be counted, and
+		   receiving it would hand out the replacement of a later one
+		   with its key too early */
+		if (info.numMsgs != 0)
+		    {
+		    errno = EBUSY;
+		    return ERROR;
+		    }
+		std::unique_ptr<keyed> index(new keyed(static_cast<size_t>(info.maxMsgs)));
+		if (c->index.compare_exchange_strong(none, index.get(),
+						     std::memory_order_acq_rel))
+		    index.release();
+		}
+	    }
+	configure([&](backpressure& c)
+	    {
+	    c.key = [key](const M& m) { return static_cast<unsigned long long>(key(m)); };
+	    c.policy = overflow_policy::coalesce;
+	    });
+	return OK;
+	}
+
+    /*! Install queue depth watermarks.
+
+	*onHigh* is called by the sender whose message brings the queue to
+	*high* messages or more, and *onLow* by the receiver that brings it
+	back down to *low* messages or fewer; each is called once per
+	crossing. Either may be empty: *onLow* alone still fires only after
+	the queue has reached *high*. They run in the context of the task
+	that caused the crossing and must not block on this queue.
+    */
+    void watermarks(size_t high, size_t low,
+		    std::function<void(size_t)> onHigh,
+		    std::function<void(size_t)> onLow)
+	{
+	controlled()->above.store(false, std::memory_order_relaxed);
+	configure([&](backpressure& c)
+	    {
+	    c.high = high;
+	    c.low = low;
+	    c.onHigh = onHigh;
+	    c.onLow = onLow;
+	    });
+	}
+
+    /*! The number of messages discarded or coalesced by the overflow
+        policy since the queue was created.
+    */
+    unsigned long long dropped() const
+	{
+	control * c = bp.load(std::memory_order_acquire);
+	return c ? c->dropped.load(std::memory_order_relaxed) : 0;
+	}
+
+    /*! Return the statistics gathered by a queue with telemetry.
+        Only available when *Telemetry* is vxworks::queue_telemetry.
+    */
+    queue_stats snapshot() const
+	{
+	static_assert(Telemetry::enabled, "queue was built without telemetry");
+	return Telemetry::snapshot();
+	}
+
+    /*! Clear the statistics gathered by a queue with telemetry.
+    */
+    void reset_telemetry()
+	{
+	static_assert(Telemetry::enabled, "queue was built without telemetry");
+	Telemetry::reset();
+	}
     };  // queue
 }      // vxworks
 #endif // __cplusplus 
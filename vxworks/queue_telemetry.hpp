@@ -0,0 +1,206 @@
+/* queue_telemetry.hpp - message queue depth and latency statistics */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCqueuetelemetryhpp
+#define __INCqueuetelemetryhpp
+
+#include <time.h>
+#include <sys/types.h>
+#include <atomic>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*! A snapshot of the statistics gathered by queue_telemetry. */
+struct queue_stats
+    {
+    //! number of buckets in the latency histogram
+    static const unsigned buckets = 48;
+
+    unsigned long long sends = 0;		//!< messages sent
+    unsigned long long receives = 0;		//!< messages received
+    unsigned long long send_timeouts = 0;	//!< sends that timed out
+    unsigned long long receive_timeouts = 0;	//!< receives that timed out
+    size_t high_water = 0;			//!< deepest queue seen after a send
+
+    /*! Time-in-queue histogram. Bucket *i* counts messages that spent
+        between 2^i and 2^(i+1) nanoseconds in the queue (bucket 0 also
+	counts shorter times, the last bucket also counts longer ones).
+    */
+    unsigned long long latency[buckets] = {};
+
+    /*! An upper bound, in nanoseconds, on the time-in-queue of the given
+        fraction *p* (0.0 to 1.0) of received messages, or 0 if no message
+	has been received.
+    */
+    unsigned long long percentile(double p) const
+	{
+	unsigned long long total = 0;
+	unsigned long long seen = 0;
+
+	for (unsigned i = 0; i < buckets; i++)
+	    total += latency[i];
+	if (total == 0)
+	    return 0;
+	for (unsigned i = 0; i < buckets; i++)
+	    {
+	    seen += latency[i];
+	    if (seen >= p * total)
+		return 2ull << i;
+	    }
+	return 2ull << (buckets - 1);
+	}
+    };
+
+/*!
+
+\brief  Queue Telemetry Policy
+
+ Passing queue_telemetry as the second template parameter of
+ vxworks::queue makes the queue carry a CLOCK_MONOTONIC timestamp with
+ every message and keep the counters of a queue_stats, which can be read
+ at any time with queue::snapshot():
+
+ \code
+ vxworks::queue<sample, vxworks::queue_telemetry> q ("/samples", 64);
+ ...
+ vxworks::queue_stats s = q.snapshot ();
+ printf ("p99 %llu ns, deepest %zu\n", s.percentile (0.99), s.high_water);
+ \endcode
+
+ The counters are updated with relaxed atomic operations, so a snapshot
+ taken while the queue is in use is consistent per counter but not
+ across counters. All the tasks using a named queue must agree on the
+ policy, since it changes the size of the messages on the queue.
+
+ The default policy, no_telemetry, compiles to nothing: a queue without
+ telemetry is exactly as large and as fast as one built before telemetry
+ existed.
+
+ This header depends only on the C++ and POSIX run-time, so the
+ statistics can be built and checked on a development host.
+*/
+class queue_telemetry
+    {
+private:
+    std::atomic<unsigned long long> sends;
+    std::atomic<unsigned long long> receives;
+    std::atomic<unsigned long long> sendTimeouts;
+    std::atomic<unsigned long long> receiveTimeouts;
+    std::atomic<size_t> highWater;
+    std::atomic<unsigned long long> latency[queue_stats::buckets];
+
+public:
+    static const bool enabled = true;
+
+    queue_telemetry()
+	{
+	reset();
+	}
+
+    //! carry the counters of a queue that is moved
+    queue_telemetry(queue_telemetry&& other) noexcept
+	{
+	*this = std::move(other);
+	}
+
+    queue_telemetry& operator=(queue_telemetry&& other) noexcept
+	{
+	queue_stats s = other.snapshot();
+
+	sends.store(s.sends, std::memory_order_relaxed);
+	receives.store(s.receives, std::memory_order_relaxed);
+	sendTimeouts.store(s.send_timeouts, std::memory_order_relaxed);
+	receiveTimeouts.store(s.receive_timeouts, std::memory_order_relaxed);
+	highWater.store(s.high_water, std::memory_order_relaxed);
+	for (unsigned i = 0; i < queue_stats::buckets; i++)
+	    latency[i].store(s.latency[i], std::memory_order_relaxed);
+	other.reset();
+	return *this;
+	}
+
+    //! the timestamp carried with each message, in nanoseconds
+    static inline unsigned long long now() noexcept
+	{
+	struct timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull +
+	       static_cast<unsigned long long>(ts.tv_nsec);
+	}
+
+    //! record a message sent, leaving *depth* messages on the queue
+    inline void sent(ssize_t depth) noexcept
+	{
+	sends.fetch_add(1, std::memory_order_relaxed);
+	size_t d = (depth > 0) ? static_cast<size_t>(depth) : 0;
+	size_t hw = highWater.load(std::memory_order_relaxed);
+	while (d > hw &&
+	       !highWater.compare_exchange_weak(hw, d, std::memory_order_relaxed))
+	    ;
+	}
+
+    //! record a message received that was sent at time *stamp*
+    inline void received(unsigned long long stamp) noexcept
+	{
+	unsigned long long t = now();
+	unsigned long long ns = (t > stamp) ? t - stamp : 0;
+	unsigned bucket = (ns < 2) ? 0 : 63 - __builtin_clzll(ns);
+
+	if (bucket >= queue_stats::buckets)
+	    bucket = queue_stats::buckets - 1;
+	receives.fetch_add(1, std::memory_order_relaxed);
+	latency[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+    //! record a send that timed out
+    inline void send_timeout() noexcept
+	{
+	sendTimeouts.fetch_add(1, std::memory_order_relaxed);
+	}
+
+    //! record a receive that timed out
+    inline void receive_timeout() noexcept
+	{
+	receiveTimeouts.fetch_add(1, std::memory_order_relaxed);
+	}
+
+    //! copy all the counters
+    queue_stats snapshot() const noexcept
+	{
+	queue_stats s;
+
+	s.sends = sends.load(std::memory_order_relaxed);
+	s.receives = receives.load(std::memory_order_relaxed);
+	s.send_timeouts = sendTimeouts.load(std::memory_order_relaxed);
+	s.receive_timeouts = receiveTimeouts.load(std::memory_order_relaxed);
+	s.high_water = highWater.load(std::memory_order_relaxed);
+	for (unsigned i = 0; i < queue_stats::buckets; i++)
+	    s.latency[i] = latency[i].load(std::memory_order_relaxed);
+	return s;
+	}
+
+    //! clear all the counters
+    void reset() noexcept
+	{
+	sends.store(0, std::memory_order_relaxed);
+	receives.store(0, std::memory_order_relaxed);
+	sendTimeouts.store(0, std::memory_order_relaxed);
+	receiveTimeouts.store(0, std::memory_order_relaxed);
+	highWater.store(0, std::memory_order_relaxed);
+	for (unsigned i = 0; i < queue_stats::buckets; i++)
+	    latency[i].store(0, std::memory_order_relaxed);
+	}
+    };  // queue_telemetry
+
+/*! The default queue policy: no timestamps and no counters. */
+struct no_telemetry
+    {
+    static const bool enabled = false;
+    };
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCqueuetelemetryhpp
@@ -0,0 +1,248 @@
+/* rate_limiter.hpp - token-bucket rate limiter */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCratelimiterhpp
+#define __INCratelimiterhpp
+
+#include <vxWorks.h>
+#include <objLib.h>
+#include <sysLib.h>
+#include <taskLib.h>
+#include <errno.h>
+#include <time.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "chrono2tic.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Token-Bucket Rate Limiter Class
+
+ A rate_limiter hands out permits at a steady rate, letting up to a burst of
+ them be taken at once after a quiet period, to throttle outbound traffic
+ and the like:
+
+ \code
+ vxworks::rate_limiter limit (10000.0, 64);	// 10k packets/s, bursts of 64
+ ...
+ limit.acquire ();
+ send (packet);
+ \endcode
+
+ No timer refills the bucket. The limiter keeps one atomic word, the time at
+ which the bucket would be full again, and each acquire works out from the
+ CLOCK_MONOTONIC time how many permits have accrued, then claims its own
+ with a compare-and-swap. Acquiring costs a clock read and one atomic
+ operation, and the rate is exact to the resolution of the clock rather
+ than of the system tick.
+
+ A task that must wait reserves its permits at once, so waiters are served
+ in the order they arrived, and then sleeps until the moment they accrue
+ with clock_nanosleep() to that absolute time, which ends on the first tick
+ after it. The rate and burst may be changed at any time; the change
+ applies to the permits acquired after it, not to those already reserved.
+
+ Times are kept in 1/256 ns from the limiter's creation, so that rates that
+ do not divide a second evenly are kept exactly; a limiter lasts two years.
+*/
+class rate_limiter
+    {
+private:
+    static const unsigned fraction = 8;		/* bits below a nanosecond */
+
+    alignas(64) std::atomic<uint64_t> full{0};	/* when the bucket is full again */
+    std::atomic<uint64_t> interval;		/* between permits */
+    std::atomic<uint64_t> size;			/* the burst */
+    uint64_t origin;
+
+    static uint64_t monotonic() noexcept
+	{
+	struct timespec ts;
+
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+
+    /* the interval of *permits_per_second*, or 0 for a rate that is not
+       positive or whose interval does not fit */
+    static uint64_t per_permit(double permits_per_second) noexcept
+	{
+	double step = 1e9 * (1u << fraction) / permits_per_second + 0.5;
+
+	/* written so that a NaN fails too */
+	if (!(permits_per_second > 0) || !(step >= 1 && step < 0x1p63))
+	    return 0;
+	return static_cast<uint64_t>(step);
+	}
+
+    static uint64_t tick_length() noexcept
+	{
+	return (1000000000ull << fraction) / ::sysClkRateGet();
+	}
+
+    uint64_t now() const noexcept
+	{
+	return (monotonic() - origin) << fraction;
+	}
+
+    /* reserve *n* permits at *t*, if they accrue within *limit*, and
+       return how long after *t* they do */
+    bool reserve(std::ptrdiff_t n, uint64_t t, uint64_t limit, uint64_t& wait) noexcept
+	{
+	uint64_t step = interval.load(std::memory_order_relaxed);
+	uint64_t tolerance = size.load(std::memory_order_relaxed) * step;
+	uint64_t f = full.load(std::memory_order_relaxed);
+
+	for (;;)
+	    {
+	    uint64_t next = (f > t ? f : t) + n * step;
+
+	    wait = (next - t > tolerance) ? next - t - tolerance : 0;
+	    if (wait > limit)
+		return false;
+	    if (full.compare_exchange_weak(f, next, std::memory_order_relaxed))
+		return true;
+	    }
+	}
+
+    /* sleep until *deadline* */
+    void park(uint64_t deadline) const
+	{
+	uint64_t ns = origin + ((deadline + (1u << fraction) - 1) >> fraction);
+	struct timespec ts;
+	int error;
+
+	ts.tv_sec = static_cast<time_t>(ns / 1000000000ull);
+	ts.tv_nsec = static_cast<long>(ns % 1000000000ull);
+	while ((error = ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR)
+	    ;
+	if (error == 0)
+	    return;
+
+	/* no absolute sleep on this clock: delay whole ticks, rounded up */
+	uint64_t tick = tick_length();
+	for (uint64_t t = now(); t < deadline; t = now())
+	    ::taskDelay(static_cast<_Vx_ticks_t>((deadline - t + tick - 1) / tick));
+	}
+
+public:
+    //! Create a limiter of *permits_per_second*, which must be positive, allowing bursts of *burst*
+    rate_limiter(double permits_per_second, std::ptrdiff_t burst = 1)
+	: interval(per_permit(permits_per_second)), size(burst),
+	  origin(monotonic())
+	{
+	if (interval.load(std::memory_order_relaxed) == 0)
+	    throw;
+	}
+
+    rate_limiter(const rate_limiter&) = delete;
+    rate_limiter& operator=(const rate_limiter&) = delete;
+
+    //! Take *n* permits, waiting until they have accrued
+    void acquire(std::ptrdiff_t n = 1)
+	{
+	uint64_t t = now();
+	uint64_t wait;
+
+	reserve(n, t, UINT64_MAX, wait);
+	if (wait != 0)
+	    park(t + wait);
+	}
+
+    //! Take *n* permits if they are available now, without waiting
+    bool try_acquire(std::ptrdiff_t n = 1) noexcept
+	{
+	uint64_t wait;
+
+	return reserve(n, now(), 0, wait);
+	}
+
+    /*! Take *n* permits, waiting up to *timeout* ticks for them to accrue.
+        If they would not accrue in time, returns ERROR at once, with errno
+	set to S_objLib_OBJ_TIMEOUT, or S_objLib_OBJ_UNAVAILABLE for NO_WAIT,
+	and takes nothing.
+    */
+    _Vx_STATUS take(std::ptrdiff_t n, _Vx_ticks_t timeout)
+	{
+	uint64_t t = now();
+	uint64_t limit = (timeout == WAIT_FOREVER) ? UINT64_MAX :
+			 static_cast<uint64_t>(timeout) * tick_length();
+	uint64_t wait;
+
+	if (!reserve(n, t, limit, wait))
+	    {
+	    errno = (timeout == NO_WAIT) ? S_objLib_OBJ_UNAVAILABLE :
+					   S_objLib_OBJ_TIMEOUT;
+	    return ERROR;
+	    }
+	if (wait != 0)
+	    park(t + wait);
+	return OK;
+	}
+
+    //! take() with a timeout given as a std::duration
+    template <class Rep, class Period>
+    _Vx_STATUS take(std::ptrdiff_t n, const duration<Rep, Period>& relTime)
+	{
+	return take(n, chrono2tic(relTime));
+	}
+
+    //! the number of permits that could be taken now without waiting
+    std::ptrdiff_t available() const noexcept
+	{
+	uint64_t t = now();
+	uint64_t step = interval.load(std::memory_order_relaxed);
+	uint64_t tolerance = size.load(std::memory_order_relaxed) * step;
+	uint64_t f = full.load(std::memory_order_relaxed);
+	uint64_t debt = f > t ? f - t : 0;
+
+	return debt >= tolerance ? 0 :
+	       static_cast<std::ptrdiff_t>((tolerance - debt) / step);
+	}
+
+    /*! Change the rate to *permits_per_second*. A rate that is not
+        positive, or too small or large to keep, returns ERROR with errno
+	set to EINVAL and leaves the rate as it was.
+    */
+    _Vx_STATUS set_rate(double permits_per_second) noexcept
+	{
+	uint64_t step = per_permit(permits_per_second);
+
+	if (step == 0)
+	    {
+	    errno = EINVAL;
+	    return ERROR;
+	    }
+	interval.store(step, std::memory_order_relaxed);
+	return OK;
+	}
+
+    //! the rate, in permits per second
+    double rate() const noexcept
+	{
+	return 1e9 * (1u << fraction) / interval.load(std::memory_order_relaxed);
+	}
+
+    //! Change the largest burst to *burst* permits
+    void set_burst(std::ptrdiff_t burst) noexcept
+	{
+	size.store(burst, std::memory_order_relaxed);
+	}
+
+    //! the largest burst, in permits
+    std::ptrdiff_t burst() const noexcept
+	{
+	return static_cast<std::ptrdiff_t>(size.load(std::memory_order_relaxed));
+	}
+    };  // rate_limiter
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCratelimiterhpp
@@ -0,0 +1,402 @@
+/* rcu_ptr.hpp - read-copy-update pointer for read-mostly data */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCrcuptrhpp
+#define __INCrcuptrhpp
+
+#include <vxWorks.h>
+#include <taskLib.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "spin_lock.hpp"
+#ifndef __RTP__
+#include "wd.hpp"
+#endif
+
+#ifndef VX_RCU_READERS
+#define VX_RCU_READERS 64	/* tasks that may read at once */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  The Reader Epochs of Every rcu_ptr
+
+ The domain counts epochs, and has a slot for each task that reads an
+ rcu_ptr, in a fixed table of VX_RCU_READERS slots. A task claims a slot
+ the first time it reads, and gives it back when it exits. While it is
+ reading, its slot holds the epoch in which it started; otherwise it holds
+ 0.
+
+ An update retires the version it replaces with the current epoch and
+ then advances the epoch. A version may be deleted once every slot is 0
+ or holds a later epoch than the version's, since no reader can then be
+ looking at it. detect() finds that oldest epoch by reading every slot. It
+ only loads atomics, so it may run at interrupt level: in the kernel,
+ start_detector() runs it from a watchdog, which takes the scan off the
+ path of update(). The versions themselves are deleted at task level, by
+ the next update() or reclaim() of their rcu_ptr.
+
+ A task that reads when every slot is claimed throws.
+*/
+class rcu_domain
+    {
+private:
+    static const unsigned slots = VX_RCU_READERS;
+
+    struct alignas(64) slot
+	{
+	std::atomic<uint64_t> epoch{0};
+	std::atomic<bool> claimed{false};
+	};
+
+    struct state
+	{
+	alignas(64) std::atomic<uint64_t> epoch{1};
+	alignas(64) std::atomic<uint64_t> safe{0};
+	std::atomic<_Vx_ticks_t> period{0};
+	slot table[slots];
+	};
+
+    /* the calling task's slot and how deeply it is reading */
+    struct reader
+	{
+	slot * s = nullptr;
+	unsigned depth = 0;
+
+	~reader()
+	    {
+	    if (s == nullptr)
+		return;
+	    s->epoch.store(0, std::memory_order_release);
+	    s->claimed.store(false, std::memory_order_release);
+	    }
+	};
+
+    static state& global() noexcept
+	{
+	static state s;
+	return s;
+	}
+
+    static reader& self() noexcept
+	{
+	static thread_local reader r;
+	return r;
+	}
+
+    static slot * claim()
+	{
+	state& g = global();
+
+	for (unsigned i = 0; i < slots; i++)
+	    {
+	    bool unclaimed = false;
+	    if (!g.table[i].claimed.load(std::memory_order_relaxed) &&
+		g.table[i].claimed.compare_exchange_strong(unclaimed, true,
+							   std::memory_order_acquire))
+		return &g.table[i];
+	    }
+	throw;
+	}
+
+#ifndef __RTP__
+    static wd& detector()
+	{
+	static wd w;
+	return w;
+	}
+
+    static void tick(_Vx_usr_arg_t) noexcept
+	{
+	detect();
+	_Vx_ticks_t p = global().period.load(std::memory_order_relaxed);
+	if (p != 0)
+	    detector().start(p, reinterpret_cast<FUNCPTR>(tick), 0);
+	}
+#endif
+
+public:
+    /*! Mark the calling task as reading, from the current epoch. Reads
+        nest; only the outermost enter() and leave() touch the slot.
+    */
+    static void enter()
+	{
+	reader& r = self();
+
+	if (r.depth++ != 0)
+	    return;
+	if (r.s == nullptr)
+	    r.s = claim();
+	/* the epoch is loaded with acquire, pairing with advance(), so that
+	   the reader sees every version published before that epoch began,
+	   and is published before the reader loads any version */
+	r.s->epoch.store(global().epoch.load(std::memory_order_acquire),
+			 std::memory_order_seq_cst);
+	}
+
+    //! Mark the calling task as no longer reading
+    static void leave() noexcept
+	{
+	reader& r = self();
+
+	if (--r.depth == 0)
+	    r.s->epoch.store(0, std::memory_order_release);
+	}
+
+    //! Advance the epoch, returning the one that has ended
+    static uint64_t advance() noexcept
+	{
+	return global().epoch.fetch_add(1, std::memory_order_seq_cst);
+	}
+
+    /*! Find the oldest epoch a task is reading in, publish it and return
+        it. Versions retired in an earlier epoch may be deleted.
+    */
+    static uint64_t detect() noexcept
+	{
+	state& g = global();
+	uint64_t oldest = g.epoch.load(std::memory_order_seq_cst);
+
+	for (unsigned i = 0; i < slots; i++)
+	    {
+	    uint64_t e = g.table[i].epoch.load(std::memory_order_seq_cst);
+	    if (e != 0 && e < oldest)
+		oldest = e;
+	    }
+	g.safe.store(oldest, std::memory_order_release);
+	return oldest;
+	}
+
+    /*! The oldest epoch published by the detector, or found by detect()
+        if the detector is not running
+    */
+    static uint64_t oldest() noexcept
+	{
+	state& g = global();
+
+	if (g.period.load(std::memory_order_relaxed) == 0)
+	    return detect();
+	return g.safe.load(std::memory_order_acquire);
+	}
+
+#ifndef __RTP__
+    /*! Run detect() from a watchdog every *period* ticks, so that update()
+        and reclaim() only compare epochs. A *period* of 0 stops it.
+    */
+    static _Vx_STATUS start_detector(_Vx_ticks_t period)
+	{
+	state& g = global();
+
+	if (period == 0)
+	    {
+	    g.period.store(0, std::memory_order_relaxed);
+	    return detector().cancel();
+	    }
+	detect();
+	g.period.store(period, std::memory_order_relaxed);
+	return detector().start(period, reinterpret_cast<FUNCPTR>(tick), 0);
+	}
+#endif
+    };  // rcu_domain
+
+/*!
+
+\brief  A Read-Copy-Update Pointer
+
+ An rcu_ptr holds the current version of an object that is read far more
+ often than it is changed, such as a routing table. Readers take a guard
+ with read(), which costs two stores and two loads, never pends and
+ never writes to memory shared with other readers, so it scales with the
+ number of CPUs where shared_mutex::lock_shared() does not:
+
+ \code
+ vxworks::rcu_ptr<routes> table (new routes);
+ ...
+ {
+ auto r = table.read ();
+ port = r->lookup (addr);
+ }
+ ...
+ routes * next = new routes (*table.read ());
+ next->add (addr, port);
+ table.update (next);
+ \endcode
+
+ update() publishes a new version and retires the old one, which is
+ deleted once every reader that could have seen it has finished; see
+ rcu_domain. A guard must not be held across a pend, since that delays
+ the deletion of every version retired meanwhile, from every rcu_ptr.
+ Updates may be made by several tasks at once.
+*/
+template <typename T> class rcu_ptr
+    {
+private:
+    struct retired
+	{
+	T * version;
+	uint64_t epoch;
+	retired * next;
+	};
+
+    std::atomic<T *> current;
+    spin_lock lock;
+    retired * pending = nullptr;
+    std::atomic<size_t> backlog{0};
+
+public:
+    /*!
+
+    \brief  A Read Guard
+
+     Keeps the version current when it was taken alive until it is
+     destroyed.
+    */
+    class guard
+	{
+	private:
+	    T * p;
+
+	public:
+	    explicit guard(const rcu_ptr& owner)
+		{
+		rcu_domain::enter();
+		p = owner.current.load(std::memory_order_seq_cst);
+		}
+
+	    ~guard()
+		{
+		rcu_domain::leave();
+		}
+
+	    guard(const guard&) = delete;
+	    guard& operator=(const guard&) = delete;
+
+	    const T& operator*() const noexcept
+		{
+		return *p;
+		}
+
+	    const T * operator->() const noexcept
+		{
+		return p;
+		}
+
+	    //! the version read, which may be null
+	    const T * get() const noexcept
+		{
+		return p;
+		}
+	};  // guard
+
+    //! Create a pointer holding *initial*, which it will delete
+    explicit rcu_ptr(T * initial = nullptr) : current(initial)
+	{
+	}
+
+    /*! Delete the current version and every retired one. No task may be
+        reading.
+    */
+    ~rcu_ptr()
+	{
+	delete current.load(std::memory_order_relaxed);
+	while (pending != nullptr)
+	    {
+	    retired * r = pending;
+	    pending = r->next;
+	    delete r->version;
+	    delete r;
+	    }
+	}
+
+    rcu_ptr(const rcu_ptr&) = delete;
+    rcu_ptr& operator=(const rcu_ptr&) = delete;
+
+    //! Take a guard on the current version
+    guard read() const
+	{
+	return guard(*this);
+	}
+
+    /*! Publish *fresh* as the current version, retire the one it replaces
+        and delete any retired versions no task can still be reading
+    */
+    void update(T * fresh)
+	{
+	retired * r = new retired {nullptr, 0, nullptr};
+
+	r->version = current.exchange(fresh, std::memory_order_seq_cst);
+	r->epoch = rcu_domain::advance();
+	{
+	std::lock_guard<spin_lock> g(lock);
+	r->next = pending;
+	pending = r;
+	}
+	backlog.fetch_add(1, std::memory_order_relaxed);
+	reclaim();
+	}
+
+    /*! Delete the retired versions no task can still be reading. Returns
+        the number still waiting.
+    */
+    size_t reclaim()
+	{
+	if (backlog.load(std::memory_order_relaxed) == 0)
+	    return 0;
+
+	uint64_t oldest = rcu_domain::oldest();
+	retired * done = nullptr;
+	size_t n = 0;
+
+	{
+	std::lock_guard<spin_lock> g(lock);
+	for (retired ** p = &pending; *p != nullptr; )
+	    {
+	    retired * r = *p;
+	    if (r->epoch < oldest)
+		{
+		*p = r->next;
+		r->next = done;
+		done = r;
+		n++;
+		}
+	    else
+		p = &r->next;
+	    }
+	}
+	/* delete outside the lock, as the destructors may take locks */
+	while (done != nullptr)
+	    {
+	    retired * r = done;
+	    done = r->next;
+	    delete r->version;
+	    delete r;
+	    }
+	return backlog.fetch_sub(n, std::memory_order_relaxed) - n;
+	}
+
+    /*! Wait, a tick at a time, until every retired version is deleted. It
+        must not be called by a task holding a guard.
+    */
+    void synchronize()
+	{
+	while (reclaim() != 0)
+	    ::taskDelay(1);
+	}
+
+    //! The number of retired versions not yet deleted
+    size_t retired_count() const noexcept
+	{
+	return backlog.load(std::memory_order_relaxed);
+	}
+    };  // rcu_ptr
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCrcuptrhpp
@@ -0,0 +1,274 @@
+/* registry.hpp - registry and snapshot of vxworks:: objects */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCregistryhpp
+#define __INCregistryhpp
+
+#include <semLib.h>
+#include <msgQLib.h>
+#include <wdLib.h>
+#include <condVarLib.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+//! The kernel object class behind a registered object
+enum class object_kind
+    {
+    object,			//!< not identified
+    semaphore,			//!< mutexes, semaphores and shared mutexes
+    queue,			//!< message queues
+    watchdog,			//!< watchdog timers
+    condition_variable		//!< condition variables
+    };
+
+/*!
+ A registered object as it was when a snapshot was taken. Counts that the
+ kernel does not report for the kind of object are -1.
+*/
+struct object_info
+    {
+    object_kind kind;		//!< the class of kernel object
+    int semType;		//!< SEM_TYPE_xxx for a semaphore, else -1
+    uintptr_t handle;		//!< the object ID
+    char name[64];		//!< the name, truncated, or "" if unnamed
+    long count;			//!< semaphore count, 1 for a free mutex, or messages queued
+    long capacity;		//!< the messages a queue can hold
+    long waiters;		//!< tasks pended on the object
+
+    //! The name of the vxworks:: class that best describes the object
+    const char * type() const noexcept
+	{
+	switch (kind)
+	    {
+	    case object_kind::semaphore:
+		switch (semType)
+		    {
+		    case SEM_TYPE_MUTEX:
+			return "mutex";
+		    case SEM_TYPE_BINARY:
+			return "binary_semaphore";
+		    case SEM_TYPE_COUNTING:
+			return "counting_semaphore";
+		    case SEM_TYPE_RW:
+			return "shared_mutex";
+		    default:
+			return "semaphore";
+		    }
+	    case object_kind::queue:
+		return "queue";
+	    case object_kind::watchdog:
+		return "wd";
+	    case object_kind::condition_variable:
+		return "condition_variable";
+	    default:
+		return "object";
+	    }
+	}
+    };
+
+/* the link in the registry held by every object<T> */
+struct registry_entry
+    {
+    registry_entry * next = nullptr;
+    uintptr_t handle = 0;
+    const char * name = nullptr;
+    object_kind kind = object_kind::object;
+    bool listed = false;
+    };
+
+/*!
+
+\brief  The Registry of vxworks:: Objects
+
+ When the program is built with VX_OBJECT_REGISTRY defined, every object
+ of the namespace registers itself here once its kernel object has been
+ created, and removes itself before the kernel object is deleted.
+ snapshot() then describes them all in one call: the class, name and ID of
+ each object, with the depth of queues, the count of semaphores, the state
+ of mutexes and the number of tasks pended on each, from semInfoGet() and
+ msgQInfoGet().
+
+ Registration pushes onto an intrusive list with one compare-and-swap and
+ allocates nothing. Removal and snapshots are serialized by a mutex. A
+ snapshot into a caller's array allocates nothing either; it costs one
+ information call per object, which is cheap enough to take several times
+ a second.
+
+ VX_OBJECT_REGISTRY changes the layout of every class, so it must be
+ defined for the whole program, for example on the compiler command line.
+ The registry is per RTP, or per kernel image. In an RTP all object IDs
+ share one type, so watchdogs and condition variables are reported as
+ object_kind::object there.
+*/
+class registry
+    {
+private:
+    struct state
+	{
+	std::atomic<registry_entry *> head{nullptr};
+	SEM_ID lock;
+
+	state()
+	    {
+	    lock = ::semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+	    if (lock == SEM_ID_NULL)
+		throw;
+	    }
+	};
+
+    static state& global()
+	{
+	static state s;
+	return s;
+	}
+
+    /* fill in the counts of one object */
+    static void probe(object_info& info)
+	{
+	switch (info.kind)
+	    {
+	    case object_kind::semaphore:
+		{
+		SEM_INFO si;
+
+		memset(&si, 0, sizeof(si));
+		if (OK == ::semInfoGet((SEM_ID) info.handle, &si))
+		    {
+		    info.semType = si.semType;
+		    info.waiters = si.numTasks;
+		    if (si.semType == SEM_TYPE_MUTEX || si.semType == SEM_TYPE_RW)
+			info.count = (si.state.owner == TASK_ID_NULL) ? 1 : 0;
+		    else if (si.semType == SEM_TYPE_BINARY)
+			info.count = si.state.full ? 1 : 0;
+		    else
+			info.count = si.state.count;
+		    return;
+		    }
+		}
+		/* an RTP cannot tell a queue ID from a semaphore ID */
+		[[fallthrough]];
+	    case object_kind::queue:
+		{
+		MSG_Q_INFO mi;
+
+		memset(&mi, 0, sizeof(mi));
+		if (OK == ::msgQInfoGet((MSG_Q_ID) info.handle, &mi))
+		    {
+		    info.kind = object_kind::queue;
+		    info.count = mi.numMsgs;
+		    info.capacity = mi.maxMsgs;
+		    info.waiters = mi.numTasks;
+		    return;
+		    }
+		}
+		info.kind = object_kind::object;
+		break;
+	    default:
+		break;
+	    }
+	}
+
+public:
+    //! The kind of object behind a handle of type T
+    template <typename T> static constexpr object_kind kind_of() noexcept
+	{
+	return std::is_same<T, SEM_ID>::value ? object_kind::semaphore :
+	       std::is_same<T, MSG_Q_ID>::value ? object_kind::queue :
+	       std::is_same<T, WDOG_ID>::value ? object_kind::watchdog :
+	       std::is_same<T, CONDVAR_ID>::value ?
+		    object_kind::condition_variable : object_kind::object;
+	}
+
+    //! Add an object to the registry; called once its ID is known
+    static void enlist(registry_entry& e) noexcept
+	{
+	state& s = global();
+	registry_entry * h = s.head.load(std::memory_order_relaxed);
+
+	e.listed = true;
+	do
+	    e.next = h;
+	while (!s.head.compare_exchange_weak(h, &e, std::memory_order_release,
+					     std::memory_order_relaxed));
+	}
+
+    //! Remove an object; called before its kernel object is deleted
+    static void delist(registry_entry& e) noexcept
+	{
+	state& s = global();
+
+	if (!e.listed)
+	    return;
+	::semMTake(s.lock, WAIT_FOREVER);
+	registry_entry * h = &e;
+	if (!s.head.compare_exchange_strong(h, e.next, std::memory_order_acq_rel))
+	    {
+	    /* registrations only push on the head, so e has a predecessor */
+	    registry_entry * p = h;
+	    while (p->next != &e)
+		p = p->next;
+	    p->next = e.next;
+	    }
+	e.listed = false;
+	::semMGive(s.lock);
+	}
+
+    /*! Describe up to *max* registered objects in *info*, most recently
+        created first, and return the number registered, which may be more
+        than *max*.
+    */
+    static size_t snapshot(object_info * info, size_t max)
+	{
+	state& s = global();
+	size_t n = 0;
+
+	::semMTake(s.lock, WAIT_FOREVER);
+	for (registry_entry * e = s.head.load(std::memory_order_acquire);
+	     e != nullptr; e = e->next, n++)
+	    {
+	    if (n >= max)
+		continue;
+	    object_info& i = info[n];
+	    i.kind = e->kind;
+	    i.semType = -1;
+	    i.handle = e->handle;
+	    i.count = -1;
+	    i.capacity = -1;
+	    i.waiters = -1;
+	    i.name[0] = '\0';
+	    if (e->name != nullptr)
+		{
+		strncpy(i.name, e->name, sizeof(i.name) - 1);
+		i.name[sizeof(i.name) - 1] = '\0';
+		}
+	    probe(i);
+	    }
+	::semMGive(s.lock);
+	return n;
+	}
+
+    //! Describe every registered object
+    static std::vector<object_info> snapshot()
+	{
+	std::vector<object_info> all(64);
+	size_t n;
+
+	while ((n = snapshot(all.data(), all.size())) > all.size())
+	    all.resize(n + n / 4);
+	all.resize(n);
+	return all;
+	}
+    };  // registry
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCregistryhpp
@@ -6,10 +6,14 @@
  */
 
 #include <semLib.h>
+#include <semEvLib.h>
 #include <private/semLibP.h>
 #include "object.hpp"
 #include "chrono2tic.hpp"
+#include "expected.hpp"
+#include "stop_token.hpp"
 #include <cstring>
+#include <climits>
 
 #ifndef __INCsemaphorehpp
 #define __INCsemaphorehpp
@@ -20,62 +24,87 @@ namespace vxworks
 {
 /*!
 
-\brief  A VxWorks Counting Semaphore Class
+\brief  A VxWorks Counting Semaphore Class Template
   
  This library provides a counting semaphore class for managing 
  mutually exclusive access to resources and signalling between
  threads.
   
- The counting_semaphore class wraps the counting semaphore library,
+ The basic_counting_semaphore class wraps the counting semaphore library,
  [semCLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/semCLib.html). 
  The behaviour mimics the C++ std::counting_semaphore where possible.
+
+ The semCCreate() *Options* are a template parameter, so options that only
+ apply to mutexes are rejected at compile time. The constructors that take
+ *options* are kept for existing code, and use them instead of *Options*.
+ vxworks::counting_semaphore is a basic_counting_semaphore with
+ SEM_Q_PRIORITY.
  
  The advantage of the VxWorks over the standard class is that a named semaphore
  may be shared between processes and with the kernel (similar to a POSIX
  semaphore). 
  
 */
-	
-	
-class counting_semaphore  : public object< SEM_ID >
+template <int Options> class basic_counting_semaphore  : public object< SEM_ID >
     {
+    static_assert((Options & (SEM_DELETE_SAFE|SEM_INVERSION_SAFE|SEM_NO_RECURSE|SEM_ROBUST)) == 0,
+		  "SEM_DELETE_SAFE, SEM_INVERSION_SAFE, SEM_NO_RECURSE and SEM_ROBUST apply only to mutexes");
+    static_assert((Options & ~(SEM_Q_PRIORITY|SEM_EVENTSEND_ERR_NOTIFY|SEM_INTERRUPTIBLE|
+			       SEM_USER|SEM_TASK_DELETION_WAKEUP|SEM_DELETE_SAFE|
+			       SEM_INVERSION_SAFE|SEM_NO_RECURSE|SEM_ROBUST)) == 0,
+		  "not a semCCreate() option");
     
 private:
 
-    int saved_options = SEM_Q_PRIORITY;
+    static constexpr int default_options = Options;
+
+    /* close or delete the semaphore, unless it has been moved from */
+    void destroy() noexcept
+	{
+	if (id == SEM_ID_NULL)
+	    return;
+	delist();
+	if(named())
+	    ::semClose(id);
+	else
+	    ::semDelete(id);
+	id = SEM_ID_NULL;
+	}
 
 public:
-    const int max = INT_MAX;
+    static constexpr int max = INT_MAX;
+
+    //! the semCCreate() options of the semaphore, unless given at construction
+    static constexpr int options = Options;
     
     //! Create a named counting semaphore
-    counting_semaphore 
+    basic_counting_semaphore 
 	(
 	const string name  
 	)
 	{
-	named=true;
-	id = ::semOpen( name.c_str().c_str(), SEM_TYPE_COUNTING, 0, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_COUNTING, 0, default_options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
     
     //! Create a named counting semaphore specifying options and initial count. 
-    counting_semaphore 
+    basic_counting_semaphore 
 	(
 	const string name,
 	int options,
 	int initialCount 
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str().c_str(), SEM_TYPE_COUNTING, initialCount, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_COUNTING, initialCount, options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
     
     //! Create a named counting semaphore specifying options, initial count, mode and context. 
-    counting_semaphore 
+    basic_counting_semaphore 
 	(
 	const string name,
 	int options, 
@@ -84,53 +113,70 @@ public:
 	void * context
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str().c_str(), SEM_TYPE_COUNTING, initialCount, saved_options, mode, context);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_COUNTING, initialCount, options, mode, context));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
     
     //! Create an unnamed counting semaphore
-    counting_semaphore ()
+    basic_counting_semaphore ()
 	{
-	id = ::semCCreate(saved_options,0);
+	id = enlist(::semCCreate(default_options,0));
+	if (id == SEM_ID_NULL)
+	    throw;
+	}
+    
+    //! Create an unnamed counting semaphore holding *desired* counts
+    explicit basic_counting_semaphore (std::ptrdiff_t desired)
+	{
+	id = enlist(::semCCreate(default_options, static_cast<int>(desired)));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
     
     //! Create an unnamed counting semaphore specifying options and initial count. 
-    counting_semaphore 
+    basic_counting_semaphore 
 	(
 	 int options,
 	 int initialCount
 	 )
 	{
-	saved_options = options;	
-	id = ::semCCreate(options,initialCount);
+	id = enlist(::semCCreate(options,initialCount));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
  
     //! Delete a counting semaphore   
-    ~counting_semaphore ()
+    ~basic_counting_semaphore ()
 	{
-	if(named)
-	    ::semClose(id);
-	else
-	    ::semDelete(id);
+	destroy();
+	}
+
+    //! Take over *other*'s semaphore, leaving *other* without one
+    basic_counting_semaphore(basic_counting_semaphore&& other) noexcept = default;
+
+    //! Delete this semaphore and take over *other*'s
+    basic_counting_semaphore& operator=(basic_counting_semaphore&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    }
+	return *this;
 	}
     
     //! give a semaphore (fill)
     inline _Vx_STATUS give() noexcept 
 	{
-	return ::semCGive(id);
+	return traced(trace_op::give, [&] { return ::semCGive(id); });
 	}
 	
     //! give a semaphore (fill)
     inline void release()
 	{
-	if ( OK != ::semCGive(id))
+	if ( OK != traced(trace_op::give, [&] { return ::semCGive(id); }))
 	    throw;
 	}
     
@@ -139,7 +185,7 @@ public:
 	{
 	while(n)
 	    {
-	    if ( OK != ::semCGive(id))
+	    if ( OK != traced(trace_op::give, [&] { return ::semCGive(id); }))
 	    	    throw;
 	    --n;
 	    }
@@ -148,7 +194,7 @@ public:
     //! pend and wait to acquire a semaphore 
     inline void acquire()
 	{
-	if (OK != ::semCTake(id, WAIT_FOREVER))
+	if (OK != traced(trace_op::take, [&] { return ::semCTake(id, WAIT_FOREVER); }))
 	    throw;
 	}
 	
@@ -156,10 +202,10 @@ public:
     template<class Rep, class Period>
     inline _Vx_STATUS take
 	(
-	const duration<Rep, Period>& relTime,
+	const duration<Rep, Period>& relTime
 	) noexcept
 	{
-	return ::semCTake(id, chrono2tic(relTime));
+	return traced(trace_op::take, [&] { return ::semCTake(id, chrono2tic(relTime)); });
 	}
 
    
@@ -169,31 +215,83 @@ public:
 	_Vx_ticks_t   timeout
 	) noexcept
 	{
-	return ::semCTake(id, timeout);
+	return traced(trace_op::take, [&] { return ::semCTake(id, timeout); });
+	}
+
+    /*! pend up to *timeout* tics to acquire a semaphore, or until a stop of
+        *token* is requested, when this returns ERROR with errno set to
+	ECANCELED */
+    inline _Vx_STATUS take
+	(
+	_Vx_ticks_t   timeout,
+	const stop_token& token
+	) noexcept
+	{
+	return stoppable_wait(token, timeout, id,
+	    [&](_Vx_ticks_t t) { return take(t); },
+	    [&] { return ::semEvStart(id, VX_STOP_READY_EVENT,
+				      EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE); },
+	    [&] { ::semEvStop(id); });
+	}
+
+    //! pend to acquire a semaphore until a stop of *token* is requested
+    inline _Vx_STATUS take(const stop_token& token) noexcept
+	{
+	return take(WAIT_FOREVER, token);
 	}
 
     //! try to acquire a semaphore without pending  
     inline void try_aquire()
 	{
-	if (OK != ::semCTake(id, NO_WAIT))
+	if (OK != traced(trace_op::take, [&] { return ::semCTake(id, NO_WAIT); }))
 	    throw;
 	}
     
+    //! give a semaphore (fill), returning the error rather than throwing
+    inline expected<void> release(std::nothrow_t) noexcept
+	{
+	return to_expected(give());
+	}
+
+    //! pend and wait to acquire a semaphore, returning the error rather than throwing
+    inline expected<void> acquire(std::nothrow_t) noexcept
+	{
+	return to_expected(take(WAIT_FOREVER));
+	}
+
+    //! try to acquire a semaphore without pending, returning the error rather than throwing
+    inline expected<void> try_acquire(std::nothrow_t) noexcept
+	{
+	return to_expected(take(NO_WAIT));
+	}
+
+    //! pend up to a std::duration to acquire a semaphore, returning the error rather than false
+    template<class Rep, class Period>
+    inline expected<void> try_acquire_for(const duration<Rep, Period>& relTime,
+					  std::nothrow_t) noexcept
+	{
+	return to_expected(take(relTime));
+	}
+    
     //! fill operation 
     inline void operator++()
  	{
-	if ( OK != ::semCGive(id))
+	if ( OK != traced(trace_op::give, [&] { return ::semCGive(id); }))
 	    throw;
 	}
 
     //! empty operation
     inline void operator--()
  	{
-	if (OK != ::semCTake(id, WAIT_FOREVER))
+	if (OK != traced(trace_op::take, [&] { return ::semCTake(id, WAIT_FOREVER); }))
 		    throw;
  	}
     
-    };  // counting_semaphore 
+    };  // basic_counting_semaphore
+
+/*! A counting semaphore that queues pended tasks by priority */
+typedef basic_counting_semaphore<SEM_Q_PRIORITY> counting_semaphore;
+
 /*!
 
 \brief  A VxWorks Binary Semaphore Class
@@ -216,10 +314,23 @@ class binary_semaphore  : public object< SEM_ID >
     
 private:
 
-    int saved_options = SEM_Q_PRIORITY;
+    static constexpr int default_options = SEM_Q_PRIORITY;
+
+    /* close or delete the semaphore, unless it has been moved from */
+    void destroy() noexcept
+	{
+	if (id == SEM_ID_NULL)
+	    return;
+	delist();
+	if(named())
+	    ::semClose(id);
+	else
+	    ::semDelete(id);
+	id = SEM_ID_NULL;
+	}
 
 public:
-    const int max = 1;
+    static constexpr int max = 1;
     
     //! create a named binary semaphore 
     binary_semaphore 
@@ -227,8 +338,8 @@ public:
 	const string name  
 	)
 	{
-	named=true;
-	id = ::semOpen( name.c_str(), SEM_TYPE_BINARY, SEM_EMPTY, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_BINARY, SEM_EMPTY, default_options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -241,9 +352,8 @@ public:
 	SEM_B_STATE initialState 
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_BINARY, initialState, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_BINARY, initialState, options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -258,9 +368,8 @@ public:
 	void * context
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_BINARY, initialState, saved_options, mode, context);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_BINARY, initialState, options, mode, context));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -268,7 +377,7 @@ public:
     //! create a unnamed binary semaphore 
     binary_semaphore ()
 	{
-	id = ::semBCreate(saved_options,SEM_EMPTY);
+	id = enlist(::semBCreate(default_options,SEM_EMPTY));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
@@ -280,8 +389,7 @@ public:
 	 SEM_B_STATE initialState
 	 )
 	{
-	saved_options = options;	
-	id = ::semBCreate(options,initialState);
+	id = enlist(::semBCreate(options,initialState));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
@@ -289,20 +397,31 @@ public:
     //! delete a binary semaphore 
     ~binary_semaphore ()
 	{
-	if(named)
-	    ::semClose(id);
-	else
-	    ::semDelete(id);
+	destroy();
+	}
+
+    //! Take over *other*'s semaphore, leaving *other* without one
+    binary_semaphore(binary_semaphore&& other) noexcept = default;
+
+    //! Delete this semaphore and take over *other*'s
+    binary_semaphore& operator=(binary_semaphore&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    }
+	return *this;
 	}
     
     inline _Vx_STATUS give() noexcept 
 	{
-	return ::semBGive(id);
+	return traced(trace_op::give, [&] { return ::semBGive(id); });
 	}
 	
     inline void release()
 	{
-	if ( OK != ::semBGive(id))
+	if ( OK != traced(trace_op::give, [&] { return ::semBGive(id); }))
 	    throw;
 	}
     
@@ -310,7 +429,7 @@ public:
 	{
 	while(n)
 	    {
-	    if ( OK != ::semBGive(id))
+	    if ( OK != traced(trace_op::give, [&] { return ::semBGive(id); }))
 	    	    throw;
 	    --n;
 	    }
@@ -319,7 +438,7 @@ public:
     //! pend and wait to acquire a semaphore for std::duration
     inline void aquire()
 	{
-	if (OK != ::semBTake(id, WAIT_FOREVER))
+	if (OK != traced(trace_op::take, [&] { return ::semBTake(id, WAIT_FOREVER); }))
 	    throw;
 	}
 
@@ -329,37 +448,85 @@ public:
 	_Vx_ticks_t   timeout
 	) noexcept
 	{
-	return ::semBTake(id, timeout);
+	return traced(trace_op::take, [&] { return ::semBTake(id, timeout); });
 	}
 
     //! pend and wait to acquire a semaphore for std::duration
     template<class Rep, class Period>
     inline _Vx_STATUS take
 	(
-	const duration<Rep, Period>& relTime,
+	const duration<Rep, Period>& relTime
 	) noexcept
 	{
-	return ::semBTake(id, chrono2tic(relTime));
+	return traced(trace_op::take, [&] { return ::semBTake(id, chrono2tic(relTime)); });
+	}
+
+    /*! pend up to *timeout* tics to acquire a semaphore, or until a stop of
+        *token* is requested, when this returns ERROR with errno set to
+	ECANCELED */
+    inline _Vx_STATUS take
+	(
+	_Vx_ticks_t   timeout,
+	const stop_token& token
+	) noexcept
+	{
+	return stoppable_wait(token, timeout, id,
+	    [&](_Vx_ticks_t t) { return take(t); },
+	    [&] { return ::semEvStart(id, VX_STOP_READY_EVENT,
+				      EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE); },
+	    [&] { ::semEvStop(id); });
+	}
+
+    //! pend to acquire a semaphore until a stop of *token* is requested
+    inline _Vx_STATUS take(const stop_token& token) noexcept
+	{
+	return take(WAIT_FOREVER, token);
 	}
 
      //! try to acquire a semaphore without pending  
      inline void try_aquire()
 	{
-	if (OK != ::semBTake(id, NO_WAIT))
+	if (OK != traced(trace_op::take, [&] { return ::semBTake(id, NO_WAIT); }))
 	    throw;
 	}
     
+    //! give a semaphore (fill), returning the error rather than throwing
+    inline expected<void> release(std::nothrow_t) noexcept
+	{
+	return to_expected(give());
+	}
+
+    //! pend and wait to acquire a semaphore, returning the error rather than throwing
+    inline expected<void> acquire(std::nothrow_t) noexcept
+	{
+	return to_expected(take(WAIT_FOREVER));
+	}
+
+    //! try to acquire a semaphore without pending, returning the error rather than throwing
+    inline expected<void> try_acquire(std::nothrow_t) noexcept
+	{
+	return to_expected(take(NO_WAIT));
+	}
+
+    //! pend up to a std::duration to acquire a semaphore, returning the error rather than false
+    template<class Rep, class Period>
+    inline expected<void> try_acquire_for(const duration<Rep, Period>& relTime,
+					  std::nothrow_t) noexcept
+	{
+	return to_expected(take(relTime));
+	}
+    
     //!  fill operation 
     inline void operator++()
  	{
-	if ( OK != ::semBGive(id))
+	if ( OK != traced(trace_op::give, [&] { return ::semBGive(id); }))
 	    throw;
 	}
 
     //! empty operation
     inline void operator--()
  	{
-	if (OK != ::semBTake(id, WAIT_FOREVER))
+	if (OK != traced(trace_op::take, [&] { return ::semBTake(id, WAIT_FOREVER); }))
 		    throw;
  	}
     
@@ -6,10 +6,19 @@
  */
 
 #include <semLib.h>
+#include <eventLib.h>
 #include <private/semLibP.h>
+#include <taskLib.h>
+#include <tickLib.h>
 #include "object.hpp"
 #include "chrono2tic.hpp"
+#include "ticks.hpp"
+#include "expected.hpp"
+#include "events.hpp"
+#include "mutex.hpp"
+#include <atomic>
 #include <cstring>
+#include <memory>
 
 #ifndef __INCsharedmutexhpp
 #define __INCsharedmutexhpp
@@ -47,17 +56,220 @@ typedef SEM_ID native_handle_type;
  
  This class is initialized with a maximum of 20 readers unless specified
  otherwise.
+
+ An unnamed shared_mutex constructed with vxworks::scalable takes and
+ releases shared ownership without entering the kernel: readers announce
+ themselves in a counter in the object, and only pend on the read-write
+ semaphore while a writer holds or is acquiring the lock. A writer takes
+ the semaphore exclusively and then pends on VX_SHARED_MUTEX_EVENT until
+ the last of the readers already inside leaves and sends it. This suits
+ read-mostly data with short read sections. Readers are not limited by the
+ maximum, and a task that holds the exclusive lock of a scalable
+ shared_mutex must not also take it shared. The readers inside hold no
+ kernel object, so a high priority writer waiting for them does not lend
+ them its priority: a low priority reader preempted inside its section
+ delays the writer like an unbounded priority inversion.
  
 */
 class shared_mutex : public object< SEM_ID >
     {
 protected:
 #ifdef __RTP__
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER  ;
+    static constexpr int default_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE|SEM_USER  ;
+#else
+    static constexpr int default_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE  ;
+#endif
+    static constexpr int defaultMaxReaders = 20;
+
+    /* the state of the scalable reader path, allocated only when selected */
+    struct scalable_state
+	{
+	int writeDepth = 0;			/* recursion of the exclusive owner */
+	std::atomic<int> readers {0};		/* readers inside */
+	std::atomic<bool> writing {false};	/* a writer holds or wants the lock */
+	std::atomic<TASK_ID> writer {TASK_ID_NULL};	/* the writer to wake */
+	};
+    std::unique_ptr<scalable_state> quick;
+#ifdef VX_LOCKDEP
+    lock_class_ref depClass {this};
+#endif
+
+    /* run <call>, a take of the lock, through the lock order validator */
+    template <typename Call>
+    inline _Vx_STATUS locking(bool trylock, Call call)
+	{
+#ifdef VX_LOCKDEP
+	return lock_checked(depClass, name().c_str(), trylock, call);
 #else
-    int saved_options = SEM_Q_PRIORITY|SEM_INVERSION_SAFE  ;
+	(void) trylock;
+	return call();
+#endif
+	}
+
+    /* run <call>, a give of the lock, through the lock order validator */
+    template <typename Call>
+    inline _Vx_STATUS unlocking(Call call)
+	{
+#ifdef VX_LOCKDEP
+	return unlock_checked(depClass, call);
+#else
+	return call();
+#endif
+	}
+
+    /* delete the semaphore, unless it has been moved from, and forget its
+       lock class */
+    void destroy() noexcept
+	{
+#ifdef VX_LOCKDEP
+	if (depClass.own())
+	    lockdep::forget(depClass.key());
 #endif
-    const int defaultMaxReaders = 20;
+	if (id == SEM_ID_NULL)
+	    return;
+	delist();
+	if(named())
+	    ::semClose(id);
+	else
+	    ::semDelete(id);
+	id = SEM_ID_NULL;
+	}
+
+    /* take the semaphore with <take(ticks)>, pending up to <timeout>
+       ticks, or until a stop of <token> if there is one */
+    template <typename Take>
+    _Vx_STATUS pend(_Vx_ticks_t timeout, const stop_token * token, Take take) noexcept
+	{
+	if (token == nullptr)
+	    return take(timeout);
+	return stoppable_wait(*token, timeout, id, take,
+	    [&] { return ::semEvStart(id, VX_STOP_READY_EVENT,
+				      EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE); },
+	    [&] { ::semEvStop(id); });
+	}
+
+    /* wait, holding the semaphore, for the scalable readers to leave */
+    _Vx_STATUS drain(_Vx_ticks_t timeout, _Vx_ticks64_t start,
+		     const stop_token * token) noexcept
+	{
+	TASK_ID self = ::taskIdSelf();
+	auto wake = [self]() noexcept { ::eventSend(self, VX_STOP_EVENT); };
+	stop_callback<decltype(wake)> waker(token ? *token : stop_token(), wake);
+
+	quick->writer.store(self, std::memory_order_relaxed);
+	quick->writing.store(true, std::memory_order_seq_cst);
+	while (quick->readers.load(std::memory_order_seq_cst) != 0)
+	    {
+	    /* the timeout covers the wait for the readers too */
+	    _Vx_ticks_t left = remaining(timeout, start);
+	    bool stopped = token && token->stop_requested();
+	    if (timeout == NO_WAIT || left == 0 || stopped)
+		{
+		quick->writeDepth = 0;
+		quick->writing.store(false, std::memory_order_release);
+		::semRWGive(id);
+		errno = stopped ? ECANCELED :
+			(timeout == NO_WAIT) ? S_objLib_OBJ_UNAVAILABLE :
+					       S_objLib_OBJ_TIMEOUT;
+		return ERROR;
+		}
+	    /* the last reader out sends the event; it stays pending if
+	       that happens first, and one left from an earlier writer
+	       only costs another look at the count */
+	    ::eventReceive(VX_SHARED_MUTEX_EVENT | VX_STOP_EVENT,
+			   EVENTS_WAIT_ANY, left, NULL);
+	    }
+	return OK;
+	}
+
+    /* take the lock exclusively, waiting for scalable readers to leave,
+       or until a stop of <token> if there is one */
+    _Vx_STATUS write_lock(_Vx_ticks_t timeout, const stop_token * token = nullptr) noexcept
+	{
+	return locking(timeout == NO_WAIT, [&]
+	    {
+	    return traced(trace_op::lock, [&]() -> _Vx_STATUS
+		{
+		_Vx_ticks64_t start = ::tick64Get();
+
+		if (OK != pend(timeout, token,
+			       [&](_Vx_ticks_t t) { return ::semWTake(id, t); }))
+		    return ERROR;
+		if (quick && quick->writeDepth++ == 0)
+		    return drain(timeout, start, token);
+		return OK;
+		});
+	    });
+	}
+
+    /* release the exclusive lock */
+    _Vx_STATUS write_unlock() noexcept
+	{
+	return unlocking([&]
+	    {
+	    return traced(trace_op::unlock, [&]() -> _Vx_STATUS
+		{
+		if (quick && quick->writeDepth > 0 && --quick->writeDepth == 0)
+		    quick->writing.store(false, std::memory_order_release);
+		return ::semRWGive(id);
+		});
+	    });
+	}
+
+    /* leave the scalable readers, waking a waiting writer if the last */
+    void leave() noexcept
+	{
+	if (quick->readers.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+	    quick->writing.load(std::memory_order_seq_cst))
+	    ::eventSend(quick->writer.load(std::memory_order_relaxed), VX_SHARED_MUTEX_EVENT);
+	}
+
+    /* take the lock shared, in user space unless a writer is about, or
+       until a stop of <token> if there is one */
+    _Vx_STATUS read_lock(_Vx_ticks_t timeout, const stop_token * token = nullptr) noexcept
+	{
+	auto take = [&](_Vx_ticks_t t) { return ::semRTake(id, t); };
+
+	return locking(timeout == NO_WAIT, [&]
+	    {
+	    return traced(trace_op::lock_shared, [&]() -> _Vx_STATUS
+		{
+		if (!quick)
+		    return pend(timeout, token, take);
+
+		_Vx_ticks64_t start = ::tick64Get();
+		for (;;)
+		    {
+		    quick->readers.fetch_add(1, std::memory_order_seq_cst);
+		    if (!quick->writing.load(std::memory_order_seq_cst))
+			return OK;
+		    leave();
+
+		    /* pend until the writer gives the semaphore back, then retry */
+		    _Vx_ticks_t left = remaining(timeout, start);
+		    if (OK != pend(left, token, take))
+			return ERROR;
+		    ::semRWGive(id);
+		    }
+		});
+	    });
+	}
+
+    /* release shared ownership */
+    _Vx_STATUS read_unlock() noexcept
+	{
+	return unlocking([&]
+	    {
+	    return traced(trace_op::unlock_shared, [&]() -> _Vx_STATUS
+		{
+		if (!quick)
+		    return ::semRWGive(id);
+		leave();
+		return OK;
+		});
+	    });
+	}
+
 public:
     /*! Create a named shared mutex */
     shared_mutex
@@ -65,8 +277,8 @@ public:
 	const string name  
 	)
 	{
-	named=true;
-	id = ::semOpen( name.c_str(), SEM_TYPE_RW, defaultMaxReaders, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_RW, defaultMaxReaders, default_options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -74,10 +286,39 @@ public:
     /*! Delete a shared mutex */
     ~shared_mutex()
 	{
-	if(named)
-	    ::semClose(id);
-	else
-	    ::semDelete(id);
+	destroy();
+	}
+
+    /*! Take over *other*'s shared mutex, leaving *other* without one. A
+        shared mutex must not be moved while it is held or waited on.
+    */
+    shared_mutex(shared_mutex&& other) noexcept
+	: object(std::move(other)), quick(std::move(other.quick))
+#ifdef VX_LOCKDEP
+	, depClass(other.depClass, this)
+#endif
+	{
+#ifdef VX_LOCKDEP
+	if (other.depClass.own())
+	    lockdep::forget(other.depClass.key());
+#endif
+	}
+
+    /*! Delete this shared mutex and take over *other*'s */
+    shared_mutex& operator=(shared_mutex&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    quick = std::move(other.quick);
+#ifdef VX_LOCKDEP
+	    depClass = lock_class_ref(other.depClass, this);
+	    if (other.depClass.own())
+		lockdep::forget(other.depClass.key());
+#endif
+	    }
+	return *this;
 	}
 
     /*! Create a named shared mutex specifying options and maximum readers */
@@ -88,9 +329,8 @@ public:
 	int options
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_RW, maxReaders, saved_options, 0, NULL);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_RW, maxReaders, options, 0, NULL));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -105,9 +345,8 @@ public:
 	void * context
 	)
 	{
-	named=true;
-	saved_options = options;
-	id = ::semOpen( name.c_str(), SEM_TYPE_RW, maxReaders, saved_options, mode, context);
+	set_name(name);
+	id = enlist(::semOpen( name.c_str(), SEM_TYPE_RW, maxReaders, options, mode, context));
 	if (id == SEM_ID_NULL)
 		throw;
 	}
@@ -115,7 +354,7 @@ public:
     /*! Create a unnamed shared mutex */
     shared_mutex()
 	{
-	id = ::semRWCreate(saved_options, defaultMaxReaders);
+	id = enlist(::semRWCreate(default_options, defaultMaxReaders));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
@@ -127,37 +366,106 @@ public:
 	 int maxReaders
 	 )
 	{
-	saved_options = options;	
-	id = ::semRWCreate(options,  maxReaders);
+	id = enlist(::semRWCreate(options,  maxReaders));
+	if (id == SEM_ID_NULL)
+	    throw;
+	}
+
+    /*! Create a unnamed shared mutex with the scalable reader path */
+    shared_mutex
+	(
+	scalable_t
+	) : quick(new scalable_state)
+	{
+	id = enlist(::semRWCreate(default_options, defaultMaxReaders));
+	if (id == SEM_ID_NULL)
+	    throw;
+	}
+
+    /*! Create a unnamed shared mutex with the scalable reader path,
+        specifying the options */
+    shared_mutex
+	(
+	 int options,
+	 int maxReaders,
+	 scalable_t
+	 ) : quick(new scalable_state)
+	{
+	id = enlist(::semRWCreate(options,  maxReaders));
 	if (id == SEM_ID_NULL)
 	    throw;
 	}
+
+    /*! Make the shared mutex one of the lock class *c* for lock order
+        validation under VX_LOCKDEP, rather than a class of its own. Call it
+	before the shared mutex is first taken. Without VX_LOCKDEP it does
+	nothing.
+    */
+    inline void set_lock_class(const lock_class& c) noexcept
+	{
+#ifdef VX_LOCKDEP
+	depClass.set(c);
+#else
+	(void) c;
+#endif
+	}
+
+    /*! Returns true if shared ownership is taken on the scalable path */
+    inline bool is_scalable() const noexcept
+	{
+	return quick != nullptr;
+	}
  
-    /*!  give (empty) a shared mutex */
+    /*!  give (empty) a shared mutex. On a scalable shared_mutex only the
+         exclusive owner may call give(); readers use unlock_shared(). */
     inline _Vx_STATUS give() noexcept 
 	{
-	return ::semRWGive(id);
+	if (quick)
+	    return write_unlock();
+	return unlocking([&]
+	    { return traced(trace_op::unlock, [&] { return ::semRWGive(id); }); });
 	}
 	
     /*!  unlock (fill) a shared mutex */
     inline void unlock()
 	{
-	if ( OK != ::semRWGive(id))
+	if ( OK != write_unlock())
 	    throw;
 	}
 
     /*!  exclusive lock (empty) a shared mutex */
     inline void lock()
 	{
-	if (OK != ::semWTake(id, WAIT_FOREVER))
+	if (OK != write_lock(WAIT_FOREVER))
 	    throw;
 	}
 
+    /*!  release exclusive ownership, returning the error rather than throwing */
+    inline expected<void> unlock(std::nothrow_t) noexcept
+	{
+	return to_expected(write_unlock());
+	}
+
+    /*!  exclusive lock, returning the error rather than throwing */
+    inline expected<void> lock(std::nothrow_t) noexcept
+	{
+	return to_expected(write_lock(WAIT_FOREVER));
+	}
+
+    /*!  exclusive lock, or until a stop of *token* is requested, when this
+         returns ERROR with errno set to ECANCELED. As for
+	 basic_mutex::lock(const stop_token&), the task pends on its event
+	 register, so it does not raise the priority of the owner. */
+    inline _Vx_STATUS lock(const stop_token& token) noexcept
+	{
+	return write_lock(WAIT_FOREVER, &token);
+	}
+
 
     /*!  exclusively  try to lock (empty) a shared mutex */
     inline bool try_lock()
 	{
-	if (OK == ::semWTake(id, NO_WAIT))
+	if (OK == write_lock(NO_WAIT))
 	    return true;
 	else
 	    return false;
@@ -172,28 +480,28 @@ public:
     //! fill operation (unlock)
     inline void operator++()
  	{
-	if ( OK != ::semRWGive(id))
+	if ( OK != write_unlock())
 	    throw;
 	}
 
     //! exclusive empty operation (lock)
     inline void operator--()
  	{
-	if (OK != ::semWTake(id, WAIT_FOREVER))
+	if (OK != write_lock(WAIT_FOREVER))
 		    throw;
  	}
 
     //! shared lock (empty)
     inline void lock_shared()
 	{
-	if (OK != ::semRTake(id, WAIT_FOREVER))
+	if (OK != read_lock(WAIT_FOREVER))
 	    throw;
 	}
     
     //! attempt to acquire shared lock
     inline bool try_lock_shared()
 	{
-	if (OK==::semRTake(id, NO_WAIT))
+	if (OK==read_lock(NO_WAIT))
 	    return true;
 	else
 	    return false;
@@ -202,9 +510,27 @@ public:
     //! shared unlock (fill)
     inline void unlock_shared()
 	{
-	if ( OK != ::semRWGive(id))
+	if ( OK != read_unlock())
 	    throw;
 	}
+
+    //! shared lock, returning the error rather than throwing
+    inline expected<void> lock_shared(std::nothrow_t) noexcept
+	{
+	return to_expected(read_lock(WAIT_FOREVER));
+	}
+
+    //! shared lock, or until a stop of *token* is requested, when this returns ERROR with errno set to ECANCELED
+    inline _Vx_STATUS lock_shared(const stop_token& token) noexcept
+	{
+	return read_lock(WAIT_FOREVER, &token);
+	}
+
+    //! shared unlock, returning the error rather than throwing
+    inline expected<void> unlock_shared(std::nothrow_t) noexcept
+	{
+	return to_expected(read_unlock());
+	}
     }; // shared_mutex
 
 
@@ -244,6 +570,7 @@ public:
 class shared_timed_mutex : public shared_mutex
     {
 public:
+    using shared_mutex::shared_mutex;
     
     //! pend and wait to exclusively acquire a lock for a specified period 
     inline _Vx_STATUS take
@@ -251,7 +578,7 @@ public:
 	_Vx_ticks_t   timeout
 	) noexcept
 	{
-	return ::semWTake(id, timeout);
+	return write_lock(timeout);
 	}
     
     //! pend and wait to acquire a shared lock for a specified period 
@@ -260,7 +587,27 @@ public:
 	_Vx_ticks_t   timeout
 	) noexcept
 	{
-	return ::semRTake(id, timeout);
+	return read_lock(timeout);
+	}
+
+    //! pend and wait to exclusively acquire a lock for a specified period, or until a stop of *token* is requested
+    inline _Vx_STATUS take
+	(
+	_Vx_ticks_t   timeout,
+	const stop_token& token
+	) noexcept
+	{
+	return write_lock(timeout, &token);
+	}
+
+    //! pend and wait to acquire a shared lock for a specified period, or until a stop of *token* is requested
+    inline _Vx_STATUS take_shared
+	(
+	_Vx_ticks_t   timeout,
+	const stop_token& token
+	) noexcept
+	{
+	return read_lock(timeout, &token);
 	}
     
     
@@ -268,7 +615,7 @@ public:
     template<class Rep, class Period>
     inline bool try_lock_for(const duration<Rep, Period>& relTime) 
 	{
-       if ( OK == ::semWTake(id, chrono2tic(relTime)))
+       if ( OK == write_lock(chrono2tic(relTime)))
 		{
 		return true;
 		}
@@ -287,9 +634,9 @@ public:
 	STATUS status;
 	
 	if (tics == 0)
-	    status = ::semWTake(id, NO_WAIT); 
+	    status = write_lock(NO_WAIT); 
 	else
-	    status = ::semWTake(id, tics);
+	    status = write_lock(tics);
 	
 	if (status == OK)
 	    {
@@ -305,7 +652,7 @@ public:
     template<class Rep, class Period>
     inline bool try_lock_shared_for(const duration<Rep, Period>& relTime) 
 	{
-       if ( OK == ::semRTake(id, chrono2tic(relTime)))
+       if ( OK == read_lock(chrono2tic(relTime)))
 		{
 		return true;
 		}
@@ -324,9 +671,9 @@ public:
 	STATUS status;
 	
 	if (tics == 0)
-	    status = ::semRTake(id, NO_WAIT); 
+	    status = read_lock(NO_WAIT); 
 	else
-	    status = ::semRTake(id, tics);
+	    status = read_lock(tics);
 	
 	if (status == OK)
 	    {
@@ -0,0 +1,75 @@
+/* shared_region.hpp - creating or attaching to a named shared data region */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCsharedregionhpp
+#define __INCsharedregionhpp
+
+#include <vxWorks.h>
+#include <sdLib.h>
+#include <objLib.h>
+#include <taskLib.h>
+#include <errno.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*
+ * Open the shared data region *name* of *size* bytes, which holds a
+ * *Region* whose first member is a std::atomic<uint32_t> named state, and
+ * return its address in this context, leaving the handle in *sd*.
+ *
+ * Only the context that creates the region, with OM_CREATE | OM_EXCL,
+ * initialises it: *init(region)* must construct the state with 0 first,
+ * then the rest of the region, and last store *ready* in the state with
+ * std::memory_order_release. Constructing the state with *ready* is not a
+ * release store, so an attacher could see it before the rest. Every other context attaches to it as it is, whether it
+ * asked to create it and lost the race or did not ask to: it waits until
+ * the state is *ready*, then calls *check(region)*, and if that returns
+ * false closes the region again and throws. If *create* is false, the
+ * region must already exist.
+ */
+template <typename Region, typename Init, typename Check>
+Region * open_shared_region(SD_ID& sd, const std::string& name, size_t size,
+			    bool create, uint32_t ready, Init init, Check check)
+    {
+    void * base = nullptr;
+
+    if (create)
+	{
+	sd = ::sdOpen(name.c_str(), 0, OM_CREATE | OM_EXCL, size, 0,
+		      SD_ATTR_RW | SD_CACHE_COPYBACK, &base);
+	if (sd != SD_ID_NULL)
+	    {
+	    Region * r = static_cast<Region *>(base);
+	    init(r);
+	    return r;
+	    }
+	if (errno != S_objLib_OBJ_NAME_CLASH)
+	    throw;
+	}
+
+    sd = ::sdOpen(name.c_str(), 0, 0, size, 0, SD_ATTR_RW | SD_CACHE_COPYBACK,
+		  &base);
+    if (sd == SD_ID_NULL)
+	throw;
+    Region * r = static_cast<Region *>(base);
+    while (r->state.load(std::memory_order_acquire) != ready)
+	::taskDelay(1);
+    if (!check(r))
+	{
+	::sdClose(sd, 0);
+	sd = SD_ID_NULL;
+	throw;
+	}
+    return r;
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCsharedregionhpp
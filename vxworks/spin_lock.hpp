@@ -0,0 +1,90 @@
+/* spin_lock.hpp - lightweight lock for very short critical sections */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCspinlockhpp
+#define __INCspinlockhpp
+
+#include <taskLib.h>
+#ifndef __RTP__
+#include <spinLockLib.h>
+#endif
+#include <atomic>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*!
+
+\brief  A Lightweight Spin Lock Class
+
+ The spin_lock class protects critical sections of a few instructions, such
+ as relinking a list, where the cost of a mutex system call would dominate.
+ It satisfies the C++ *BasicLockable* requirements, so it may be used with
+ std::lock_guard.
+
+ In the kernel it wraps a task-level spinlock from
+ [spinLockLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/spinLockLib.html),
+ which also disables task preemption while it is held. In an RTP it is a
+ test-and-set lock that yields the CPU when it has spun for a while, and
+ eventually delays for a tick, so that a preempted owner of lower priority
+ can run and release it.
+
+ A spin_lock must never be held across a call that may pend, and it may not
+ be taken from interrupt level.
+*/
+class spin_lock
+    {
+private:
+#ifdef __RTP__
+    static const int spins = 100;
+    static const int yields = 10;
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+#else
+    spinlockTask_t spin;
+#endif
+
+public:
+    //! Create an unlocked spin lock
+    spin_lock()
+	{
+#ifndef __RTP__
+	::spinLockTaskInit(&spin, 0);
+#endif
+	}
+
+    spin_lock(const spin_lock&) = delete;
+    spin_lock& operator=(const spin_lock&) = delete;
+
+    //! Spin until the lock is acquired
+    inline void lock() noexcept
+	{
+#ifdef __RTP__
+	int n = 0;
+	while (flag.test_and_set(std::memory_order_acquire))
+	    {
+	    if (++n < spins)
+		continue;
+	    ::taskDelay((n < spins + yields) ? 0 : 1);
+	    }
+#else
+	::spinLockTaskTake(&spin);
+#endif
+	}
+
+    //! Release the lock
+    inline void unlock() noexcept
+	{
+#ifdef __RTP__
+	flag.clear(std::memory_order_release);
+#else
+	::spinLockTaskGive(&spin);
+#endif
+	}
+    };  // spin_lock
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCspinlockhpp
@@ -0,0 +1,542 @@
+/* stop_token.hpp - cancellation of blocking waits */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCstoptokenhpp
+#define __INCstoptokenhpp
+
+#include <vxWorks.h>
+#include <eventLib.h>
+#include <objLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <sysLib.h>
+#include <errno.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "events.hpp"
+#include "spin_lock.hpp"
+#include "ticks.hpp"
+#if __cplusplus > 201703L && __has_include(<stop_token>)
+#include <stop_token>
+#endif
+
+#ifndef VX_STOP_POLL_HZ
+#define VX_STOP_POLL_HZ 100		/* how often a wait on an object sending no events checks for a stop */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+class stop_token;
+class stop_source;
+
+/* the part of a stop_callback that the stop state links and runs */
+class stop_callback_base
+    {
+private:
+    friend class stop_state;
+
+    stop_callback_base * next = nullptr;
+    stop_callback_base * prev = nullptr;
+    void (* invoke)(stop_callback_base *) noexcept;
+    std::atomic<bool> done {false};
+
+protected:
+    explicit stop_callback_base(void (* f)(stop_callback_base *) noexcept) noexcept
+	: invoke(f)
+	{
+	}
+    };
+
+/* the state shared by a stop_source and its tokens and callbacks */
+class stop_state
+    {
+private:
+    std::atomic<bool> requested {false};
+    std::atomic<unsigned> sources {0};
+    spin_lock lock;
+    stop_callback_base * head = nullptr;
+    stop_callback_base * running = nullptr;
+    TASK_ID requester = TASK_ID_NULL;
+
+    void unlink(stop_callback_base * cb) noexcept
+	{
+	if (cb->prev != nullptr)
+	    cb->prev->next = cb->next;
+	else
+	    head = cb->next;
+	if (cb->next != nullptr)
+	    cb->next->prev = cb->prev;
+	cb->next = cb->prev = nullptr;
+	}
+
+public:
+    bool stop_requested() const noexcept
+	{
+	return requested.load(std::memory_order_acquire);
+	}
+
+    bool stop_possible() const noexcept
+	{
+	return stop_requested() || sources.load(std::memory_order_relaxed) != 0;
+	}
+
+    void attach() noexcept
+	{
+	sources.fetch_add(1, std::memory_order_relaxed);
+	}
+
+    void detach() noexcept
+	{
+	sources.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+    /* run every callback registered, once, in the calling task */
+    bool request_stop() noexcept
+	{
+	if (requested.exchange(true, std::memory_order_acq_rel))
+	    return false;
+
+	std::unique_lock<spin_lock> g(lock);
+	requester = ::taskIdSelf();
+	while (head != nullptr)
+	    {
+	    stop_callback_base * cb = head;
+	    unlink(cb);
+	    running = cb;
+	    g.unlock();
+	    cb->invoke(cb);
+	    cb->done.store(true, std::memory_order_release);
+	    g.lock();
+	    running = nullptr;
+	    }
+	return true;
+	}
+
+    /* link *cb*, or run it at once if a stop has been requested */
+    void add(stop_callback_base * cb) noexcept
+	{
+	{
+	std::lock_guard<spin_lock> g(lock);
+	if (!stop_requested())
+	    {
+	    cb->next = head;
+	    if (head != nullptr)
+		head->prev = cb;
+	    head = cb;
+	    return;
+	    }
+	}
+	cb->invoke(cb);
+	}
+
+    /* unlink *cb*, or wait for it to finish if another task is running it */
+    void remove(stop_callback_base * cb) noexcept
+	{
+	bool inflight;
+
+	{
+	std::lock_guard<spin_lock> g(lock);
+	if (cb->prev != nullptr || head == cb)
+	    {
+	    unlink(cb);
+	    return;
+	    }
+	inflight = (running == cb && requester != ::taskIdSelf());
+	}
+	while (inflight && !cb->done.load(std::memory_order_acquire))
+	    ::taskDelay(0);
+	}
+    };
+
+/*!
+
+\brief  A Stop Token Class
+
+ A stop_token mimics the C++20 std::stop_token: it tells whether a stop has
+ been requested of the stop_source it came from, and the blocking methods of
+ the mutexes, semaphores, queues, condition variables and events that take
+ one return as soon as that happens, with errno set to ECANCELED.
+
+ When the tree is built as C++20, a std::stop_token, such as the one a
+ std::jthread hands its function, converts to a vxworks::stop_token.
+*/
+class stop_token
+    {
+private:
+    friend class stop_source;
+    template <typename Callback> friend class stop_callback;
+
+    std::shared_ptr<stop_state> state;
+
+    explicit stop_token(std::shared_ptr<stop_state> s) noexcept : state(std::move(s))
+	{
+	}
+
+#ifdef __cpp_lib_jthread
+    /* a state that follows a std::stop_token */
+    struct bridged : stop_state
+	{
+	std::stop_callback<std::function<void()>> follow;
+
+	explicit bridged(const std::stop_token& st)
+	    : follow(st, [this] { request_stop(); })
+	    {
+	    }
+	};
+#endif
+
+public:
+    //! a token with no stop source, whose stop is never requested
+    stop_token() noexcept = default;
+
+#ifdef __cpp_lib_jthread
+    //! a token whose stop is requested when *st*'s is
+    stop_token(const std::stop_token& st)
+	{
+	if (st.stop_possible())
+	    state = std::make_shared<bridged>(st);
+	}
+#endif
+
+    //! true if a stop has been requested
+    bool stop_requested() const noexcept
+	{
+	return state && state->stop_requested();
+	}
+
+    //! true if a stop has been, or still could be, requested
+    bool stop_possible() const noexcept
+	{
+	return state && state->stop_possible();
+	}
+
+    //! true if both tokens have the same stop source, or neither has one
+    friend bool operator==(const stop_token& a, const stop_token& b) noexcept
+	{
+	return a.state == b.state;
+	}
+
+    friend bool operator!=(const stop_token& a, const stop_token& b) noexcept
+	{
+	return a.state != b.state;
+	}
+    };
+
+/*!
+
+\brief  A Stop Source Class
+
+ A stop_source mimics the C++20 std::stop_source: request_stop() marks every
+ token obtained from it, and its copies, as stopped, runs the callbacks
+ registered on them, and wakes every task in a blocking wait with one of
+ them:
+
+ \code
+ vxworks::stop_source teardown;
+ ...
+ // the connection's receive task
+ while (rx.recieve (msg, teardown.get_token ()) != ERROR)
+     handle (msg);
+
+ // closing the connection
+ teardown.request_stop ();
+ \endcode
+*/
+class stop_source
+    {
+private:
+    std::shared_ptr<stop_state> state;
+
+public:
+    //! Create a source with a new stop state
+    stop_source() : state(std::make_shared<stop_state>())
+	{
+	state->attach();
+	}
+
+    stop_source(const stop_source& other) noexcept : state(other.state)
+	{
+	if (state)
+	    state->attach();
+	}
+
+    stop_source(stop_source&& other) noexcept = default;
+
+    stop_source& operator=(stop_source other) noexcept
+	{
+	std::swap(state, other.state);
+	return *this;
+	}
+
+    ~stop_source()
+	{
+	if (state)
+	    state->detach();
+	}
+
+    //! A token of this source
+    stop_token get_token() const noexcept
+	{
+	return stop_token(state);
+	}
+
+    /*! Request a stop, running the callbacks registered on this source's
+        tokens in the calling task. Returns false if a stop had already
+	been requested.
+    */
+    bool request_stop() noexcept
+	{
+	return state && state->request_stop();
+	}
+
+    //! true if a stop has been requested
+    bool stop_requested() const noexcept
+	{
+	return state && state->stop_requested();
+	}
+
+    //! true if this source has a stop state
+    bool stop_possible() const noexcept
+	{
+	return state != nullptr;
+	}
+    };
+
+/*!
+
+\brief  A Stop Callback Class
+
+ A stop_callback mimics the C++20 std::stop_callback: it runs *callback* in
+ the task that requests a stop of *token*, or at once if one has already
+ been requested. Destroying it deregisters the callback, waiting for it to
+ finish if another task is running it. The callback must not throw, nor
+ pend for long, as it holds up request_stop().
+*/
+template <typename Callback> class stop_callback : private stop_callback_base
+    {
+private:
+    std::shared_ptr<stop_state> state;
+    Callback callback;
+
+    static void run(stop_callback_base * base) noexcept
+	{
+	static_cast<stop_callback *>(base)->callback();
+	}
+
+public:
+    typedef Callback callback_type;
+
+    //! Run *f* when a stop of *token* is requested
+    template <typename F>
+    explicit stop_callback(const stop_token& token, F&& f)
+	: stop_callback_base(run), state(token.state),
+	  callback(std::forward<F>(f))
+	{
+	if (state)
+	    state->add(this);
+	}
+
+    ~stop_callback()
+	{
+	if (state)
+	    state->remove(this);
+	}
+
+    stop_callback(const stop_callback&) = delete;
+    stop_callback& operator=(const stop_callback&) = delete;
+    };
+
+template <typename Callback>
+stop_callback(stop_token, Callback) -> stop_callback<Callback>;
+
+/*
+ * A task in stoppable_wait() for an object. Only one task at a time can be
+ * registered for the events of an object, so the others join a list kept
+ * per object and wait on their event registers, and the registered task
+ * sends VX_STOP_READY_EVENT to the first of them when it leaves, which
+ * retries the object and registers in its place. Objects are hashed to a
+ * fixed table of lists, since the classes hold nothing but their ID.
+ */
+class stop_waiter
+    {
+private:
+    static const unsigned buckets = 64;
+
+    struct bucket
+	{
+	spin_lock lock;
+	stop_waiter * head = nullptr;
+	};
+
+    const void * object;
+    TASK_ID task;
+    stop_waiter * next = nullptr;
+    stop_waiter * prev = nullptr;
+    bool joined = false;
+    bool registered = false;
+
+    static bucket& of(const void * object) noexcept
+	{
+	static bucket table[buckets];
+	uintptr_t key = reinterpret_cast<uintptr_t>(object);
+	return table[((key >> 4) ^ (key >> 12)) % buckets];
+	}
+
+public:
+    stop_waiter(const void * obj, TASK_ID self) noexcept
+	: object(obj), task(self)
+	{
+	}
+
+    //! true once the task has joined the list for its object
+    bool waiting() const noexcept
+	{
+	return joined;
+	}
+
+    //! Join the list of tasks waiting for the object's registration
+    void join() noexcept
+	{
+	bucket& b = of(object);
+	std::lock_guard<spin_lock> g(b.lock);
+
+	next = b.head;
+	if (next != nullptr)
+	    next->prev = this;
+	b.head = this;
+	joined = true;
+	}
+
+    //! Note that the task has been registered, so must hand on when leaving
+    void hold() noexcept
+	{
+	registered = true;
+	}
+
+    //! Leave the list, waking the next task in it if registered
+    ~stop_waiter()
+	{
+	if (!joined && !registered)
+	    return;
+
+	bucket& b = of(object);
+	TASK_ID other = TASK_ID_NULL;
+
+	{
+	std::lock_guard<spin_lock> g(b.lock);
+	if (joined)
+	    {
+	    if (prev != nullptr)
+		prev->next = next;
+	    else
+		b.head = next;
+	    if (next != nullptr)
+		next->prev = prev;
+	    }
+	if (registered)
+	    for (stop_waiter * w = b.head; w != nullptr; w = w->next)
+		if (w->object == object)
+		    {
+		    other = w->task;
+		    break;
+		    }
+	}
+	if (other != TASK_ID_NULL)
+	    ::eventSend(other, VX_STOP_READY_EVENT);
+	}
+
+    stop_waiter(const stop_waiter&) = delete;
+    stop_waiter& operator=(const stop_waiter&) = delete;
+    };
+
+/*
+ * Wait until *attempt* takes *object*, *token* is stopped, or *timeout*
+ * ticks pass. *attempt(ticks)* takes it, pending up to the ticks given;
+ * *arm()* registers the calling task to be sent VX_STOP_READY_EVENT when the
+ * object becomes free, with semEvStart() or msgQEvStart(), and *disarm()*
+ * deregisters it. The task pends on its event register, so that the stop
+ * callback can wake it with VX_STOP_EVENT. While another task is registered
+ * with the object, the task joins its stop_waiter list to be woken when
+ * that task leaves; as a task registered by other means than this never
+ * hands on, it also looks at the object again after each period. Those
+ * periods double from a tick to 1/VX_STOP_POLL_HZ seconds. If *arm()* fails
+ * for other reasons, as for an object that sends no events, the task pends
+ * on the object itself for such periods, so a stop is seen within that
+ * time.
+ */
+template <typename Attempt, typename Arm, typename Disarm>
+_Vx_STATUS stoppable_wait(const stop_token& token, _Vx_ticks_t timeout,
+			  const void * object, Attempt attempt, Arm arm,
+			  Disarm disarm)
+    {
+    TASK_ID self = ::taskIdSelf();
+    auto wake = [self]() noexcept { ::eventSend(self, VX_STOP_EVENT); };
+    stop_callback<decltype(wake)> waker(token, wake);
+    stop_waiter queued(object, self);
+    _Vx_ticks64_t start = ::tick64Get();
+    _Vx_ticks_t period = 1;
+    _Vx_ticks_t longest = ::sysClkRateGet() / VX_STOP_POLL_HZ;
+
+    for (;;)
+	{
+	if (token.stop_requested())
+	    {
+	    errno = ECANCELED;
+	    return ERROR;
+	    }
+	if (attempt(NO_WAIT) == OK)
+	    return OK;
+	if (errno != S_objLib_OBJ_UNAVAILABLE || timeout == NO_WAIT)
+	    return ERROR;
+
+	_Vx_ticks_t left = remaining(timeout, start);
+	if (left == 0)
+	    {
+	    errno = S_objLib_OBJ_TIMEOUT;
+	    return ERROR;
+	    }
+
+	if (arm() == OK)
+	    {
+	    queued.hold();
+	    ::eventReceive(VX_STOP_READY_EVENT | VX_STOP_EVENT,
+			   EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED, left, NULL);
+	    disarm();
+	    }
+	else if (errno == S_eventLib_ALREADY_REGISTERED)
+	    {
+	    /* retry once joined, in case the registered task left before */
+	    if (!queued.waiting())
+		queued.join();
+	    else
+		{
+		::eventReceive(VX_STOP_READY_EVENT | VX_STOP_EVENT,
+			       EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED,
+			       (left != WAIT_FOREVER && left < period) ? left : period,
+			       NULL);
+		if (period < longest)
+		    period *= 2;
+		}
+	    }
+	else
+	    {
+	    if (attempt((left != WAIT_FOREVER && left < period) ? left : period) == OK)
+		return OK;
+	    if (errno != S_objLib_OBJ_TIMEOUT)
+		return ERROR;
+	    if (period < longest)
+		period *= 2;
+	    }
+	}
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCstoptokenhpp
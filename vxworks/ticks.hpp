@@ -0,0 +1,33 @@
+/* ticks.hpp - tick arithmetic shared by the blocking classes */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCtickshpp
+#define __INCtickshpp
+
+#include <vxWorks.h>
+#include <tickLib.h>
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*
+ * The ticks left of *timeout* since *start*, a tick64Get() value: 0 once it
+ * has expired, and WAIT_FOREVER if it never does. A method that pends more
+ * than once, retrying after a wakeup, passes this to each pend so that the
+ * caller's timeout covers them all.
+ */
+inline _Vx_ticks_t remaining(_Vx_ticks_t timeout, _Vx_ticks64_t start) noexcept
+    {
+    if (timeout == WAIT_FOREVER)
+	return WAIT_FOREVER;
+    _Vx_ticks64_t elapsed = ::tick64Get() - start;
+    return (elapsed >= static_cast<_Vx_ticks64_t>(timeout)) ? 0 :
+	   static_cast<_Vx_ticks_t>(timeout - elapsed);
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCtickshpp
@@ -0,0 +1,498 @@
+/* topic.hpp - publish/subscribe through a shared ring */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCtopichpp
+#define __INCtopichpp
+
+#include <vxWorks.h>
+#include <eventLib.h>
+#include <objLib.h>
+#include <sdLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <errno.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include "chrono2tic.hpp"
+#include "events.hpp"
+#include "ticks.hpp"
+#include "shared_region.hpp"
+#include "object.hpp"
+
+#ifndef VX_TOPIC_SUBSCRIBERS
+#define VX_TOPIC_SUBSCRIBERS 32	/* subscribers of one topic */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*! What a topic does when a subscriber falls a whole ring behind */
+enum class subscriber_policy
+    {
+    drop,	//!< the subscriber skips what was overwritten, and counts it
+    block	//!< publishers pend until the subscriber has caught up
+    };
+
+/*!
+
+\brief  A Publish/Subscribe Topic Class
+
+ A topic delivers every message published to it to every subscriber, as
+ sending it to one vxworks::queue per subscriber would, but a message is
+ written once, into a ring of *capacity* slots, and each subscriber keeps
+ its own read cursor into the ring. Publishing costs the same however many
+ subscribers there are, apart from an eventSend() to each subscriber that
+ was pended waiting for it, and no subscriber delays another.
+
+ A subscriber that falls a whole ring behind is dealt with according to
+ its subscriber_policy. A *drop* subscriber skips to the oldest message
+ still in the ring and counts the ones it missed, so a slow consumer of
+ telemetry never holds up the producer. A *block* subscriber holds back
+ every publisher, which pends for its timeout until the subscriber has
+ read the slot it needs; a block subscriber that stops reading therefore
+ stops the topic.
+
+ A topic may be named, in which case the ring is in a shared data region
+ from [sdLib](https://docs.windriver.com/bundle/vxworks_kernel_coreos_21_07/page/CORE/sdLib.html),
+ and tasks in RTPs and the kernel that open the same name publish to and
+ subscribe to the same topic. A topic has at most VX_TOPIC_SUBSCRIBERS
+ subscribers. Pended subscribers and publishers are woken with the event
+ VX_TOPIC_EVENT, which is reserved in every task that waits on a topic.
+
+ Messages are copied in and out like msgQ messages, so M must be trivially
+ copyable. A subscriber reads a message by copying it and then checking
+ that it was not overwritten meanwhile.
+
+ \code
+ vxworks::topic<sample> imu ("/imu", 256);
+ vxworks::topic<sample>::subscriber s (imu);
+ sample x;
+ while (s.receive (x) == OK)
+     filter (x);
+ \endcode
+*/
+template <typename M> class topic
+    {
+    static_assert(std::is_trivially_copyable<M>::value,
+		  "topic messages are copied, like msgQ messages");
+private:
+    static const uint32_t ready = 0x746f7063;	/* "topc" */
+    static const unsigned subscribers = VX_TOPIC_SUBSCRIBERS;
+    static const unsigned publishers = 8;	/* publishers pended at once */
+    static const int spins = 100;
+
+    enum : uint32_t { unused, claimed, dropping, blocking };
+
+    struct alignas(64) reader
+	{
+	std::atomic<uint32_t> state;
+	std::atomic<uint32_t> waiting;
+	std::atomic<uintptr_t> task;
+	std::atomic<uint64_t> cursor;
+	std::atomic<uint64_t> dropped;
+	};
+
+    struct slot
+	{
+	std::atomic<uint64_t> seq;	/* 2p + 1 while position p is written, 2p + 2 after */
+	M message;
+	};
+
+    /* the region holds no pointers, as RTPs may map it at different addresses */
+    struct region
+	{
+	std::atomic<uint32_t> state;
+	uint32_t size;
+	uint32_t capacity;
+	uint32_t sizeM;
+	alignas(64) std::atomic<uint64_t> head;
+	std::atomic<uint32_t> blockers;
+	std::atomic<uint32_t> pended;
+	std::atomic<uintptr_t> publisher[publishers];
+	reader readers[subscribers];
+	};
+
+    static size_t slots_offset() noexcept
+	{
+	return (sizeof(region) + 63) & ~size_t(63);
+	}
+
+    static size_t region_size(uint32_t capacity) noexcept
+	{
+	return slots_offset() + capacity * sizeof(slot);
+	}
+
+    static uint32_t roundup(size_t n)
+	{
+	uint32_t cap = 2;
+	while (cap < n)
+	    cap <<= 1;
+	return cap;
+	}
+
+    SD_ID sd = SD_ID_NULL;
+    region * r = nullptr;
+    uint64_t mask = 0;
+
+    slot& at(uint64_t pos) const noexcept
+	{
+	unsigned char * base = reinterpret_cast<unsigned char *>(r) + slots_offset();
+	return reinterpret_cast<slot *>(base)[pos & mask];
+	}
+
+    void init(uint32_t capacity)
+	{
+	new (&r->state) std::atomic<uint32_t>(0);
+	r->size = static_cast<uint32_t>(region_size(capacity));
+	r->capacity = capacity;
+	r->sizeM = sizeof(M);
+	new (&r->head) std::atomic<uint64_t>(0);
+	new (&r->blockers) std::atomic<uint32_t>(0);
+	new (&r->pended) std::atomic<uint32_t>(0);
+	for (unsigned i = 0; i < publishers; i++)
+	    new (&r->publisher[i]) std::atomic<uintptr_t>(0);
+	for (unsigned i = 0; i < subscribers; i++)
+	    new (&r->readers[i]) reader{{unused}, {0}, {0}, {0}, {0}};
+	mask = capacity - 1;
+	for (uint64_t i = 0; i < capacity; i++)
+	    new (&at(i).seq) std::atomic<uint64_t>(0);
+	r->state.store(ready, std::memory_order_release);
+	}
+
+    /* true if publishing at <pos> would overwrite what a block subscriber
+       has not read */
+    bool held_back(uint64_t pos) const noexcept
+	{
+	if (r->blockers.load(std::memory_order_acquire) == 0)
+	    return false;
+	for (unsigned i = 0; i < subscribers; i++)
+	    {
+	    const reader& s = r->readers[i];
+	    if (s.state.load(std::memory_order_acquire) == blocking &&
+		pos >= s.cursor.load(std::memory_order_acquire) + mask + 1)
+		return true;
+	    }
+	return false;
+	}
+
+    /* wake the subscribers pended for a message */
+    void wake_subscribers() noexcept
+	{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (unsigned i = 0; i < subscribers; i++)
+	    {
+	    reader& s = r->readers[i];
+	    if (s.waiting.load(std::memory_order_relaxed) != 0 &&
+		s.waiting.exchange(0, std::memory_order_acq_rel) != 0)
+		::eventSend(reinterpret_cast<TASK_ID>(s.task.load(std::memory_order_relaxed)),
+			    VX_TOPIC_EVENT);
+	    }
+	}
+
+    /* wake the publishers pended for a block subscriber */
+    void wake_publishers() noexcept
+	{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (r->pended.load(std::memory_order_relaxed) == 0)
+	    return;
+	for (unsigned i = 0; i < publishers; i++)
+	    {
+	    uintptr_t t = r->publisher[i].exchange(0, std::memory_order_acq_rel);
+	    if (t != 0)
+		::eventSend(reinterpret_cast<TASK_ID>(t), VX_TOPIC_EVENT);
+	    }
+	}
+
+    /* pend a publisher until a subscriber moves on, or for a tick if
+       too many publishers are pended already */
+    void pend_publisher(uint64_t pos, _Vx_ticks_t left)
+	{
+	uintptr_t self = reinterpret_cast<uintptr_t>(::taskIdSelf());
+
+	r->pended.fetch_add(1, std::memory_order_seq_cst);
+	for (unsigned i = 0; i < publishers; i++)
+	    {
+	    uintptr_t none = 0;
+	    if (r->publisher[i].compare_exchange_strong(none, self,
+							std::memory_order_seq_cst))
+		{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (held_back(pos))
+		    ::eventReceive(VX_TOPIC_EVENT, EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED,
+				   left, NULL);
+		r->publisher[i].compare_exchange_strong(self, 0);
+		r->pended.fetch_sub(1, std::memory_order_relaxed);
+		return;
+		}
+	    }
+	r->pended.fetch_sub(1, std::memory_order_relaxed);
+	::taskDelay(1);
+	}
+
+public:
+    typedef M value_type;
+
+    /*!
+
+    \brief  A Subscription to a Topic
+
+     A subscriber receives the messages published after it subscribed, in
+     the order they were published. It belongs to the task that created
+     it, which is the task woken when a message arrives.
+    */
+    class subscriber
+	{
+	private:
+	    topic& t;
+	    reader * s = nullptr;
+
+	public:
+	    //! Subscribe to *owner* with the given *policy*
+	    explicit subscriber(topic& owner,
+				subscriber_policy policy = subscriber_policy::drop)
+		: t(owner)
+		{
+		uint32_t state = (policy == subscriber_policy::block) ? blocking : dropping;
+
+		for (unsigned i = 0; i < subscribers && s == nullptr; i++)
+		    {
+		    reader& c = t.r->readers[i];
+		    uint32_t none = unused;
+		    if (c.state.load(std::memory_order_relaxed) == unused &&
+			c.state.compare_exchange_strong(none, claimed,
+							std::memory_order_acquire))
+			s = &c;
+		    }
+		if (s == nullptr)
+		    throw;
+		s->task.store(reinterpret_cast<uintptr_t>(::taskIdSelf()),
+			      std::memory_order_relaxed);
+		s->waiting.store(0, std::memory_order_relaxed);
+		s->dropped.store(0, std::memory_order_relaxed);
+		if (state == blocking)
+		    t.r->blockers.fetch_add(1, std::memory_order_seq_cst);
+		s->cursor.store(t.r->head.load(std::memory_order_seq_cst),
+				std::memory_order_seq_cst);
+		s->state.store(state, std::memory_order_seq_cst);
+		}
+
+	    //! Unsubscribe, releasing any publisher held back
+	    ~subscriber()
+		{
+		uint32_t state = s->state.load(std::memory_order_relaxed);
+
+		s->state.store(unused, std::memory_order_release);
+		if (state == blocking)
+		    {
+		    t.r->blockers.fetch_sub(1, std::memory_order_relaxed);
+		    t.wake_publishers();
+		    }
+		}
+
+	    subscriber(const subscriber&) = delete;
+	    subscriber& operator=(const subscriber&) = delete;
+
+	    /*! Copy the next message into *message*, pending for up to
+	        *timeout* ticks if there is none. Returns ERROR with errno
+		set to S_objLib_OBJ_TIMEOUT, or S_objLib_OBJ_UNAVAILABLE for
+		NO_WAIT, if no message came.
+	    */
+	    _Vx_STATUS receive(M& message, _Vx_ticks_t timeout = WAIT_FOREVER)
+		{
+		_Vx_ticks64_t start = ::tick64Get();
+		int spun = 0;
+
+		for (;;)
+		    {
+		    uint64_t c = s->cursor.load(std::memory_order_relaxed);
+		    slot& sl = t.at(c);
+		    uint64_t seq = sl.seq.load(std::memory_order_acquire);
+
+		    if (seq == 2 * c + 2)
+			{
+			memcpy(&message, &sl.message, sizeof(M));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sl.seq.load(std::memory_order_relaxed) == seq)
+			    {
+			    s->cursor.store(c + 1, std::memory_order_release);
+			    if (s->state.load(std::memory_order_relaxed) == blocking)
+				t.wake_publishers();
+			    return OK;
+			    }
+			seq = sl.seq.load(std::memory_order_relaxed);
+			}
+		    if (seq > 2 * c + 2)
+			{
+			/* lapped: resume at the oldest message still there */
+			uint64_t oldest = t.r->head.load(std::memory_order_acquire) - t.mask;
+			s->dropped.fetch_add(oldest - c, std::memory_order_relaxed);
+			s->cursor.store(oldest, std::memory_order_release);
+			continue;
+			}
+
+		    /* nothing yet: spin briefly, then pend */
+		    if (timeout == NO_WAIT)
+			{
+			errno = S_objLib_OBJ_UNAVAILABLE;
+			return ERROR;
+			}
+		    if (spun++ < spins)
+			continue;
+		    _Vx_ticks_t left = remaining(timeout, start);
+		    if (left == 0)
+			{
+			errno = S_objLib_OBJ_TIMEOUT;
+			return ERROR;
+			}
+		    s->waiting.store(1, std::memory_order_seq_cst);
+		    if (sl.seq.load(std::memory_order_seq_cst) < 2 * c + 2)
+			::eventReceive(VX_TOPIC_EVENT, EVENTS_WAIT_ANY | EVENTS_KEEP_UNWANTED,
+				       left, NULL);
+		    s->waiting.store(0, std::memory_order_relaxed);
+		    }
+		}
+
+	    //! receive() with a timeout given as a std::duration
+	    template <class Rep, class Period>
+	    _Vx_STATUS receive(M& message, const duration<Rep, Period>& relTime)
+		{
+		return receive(message, chrono2tic(relTime));
+		}
+
+	    //! the number of messages a drop subscriber has missed
+	    uint64_t dropped() const noexcept
+		{
+		return s->dropped.load(std::memory_order_relaxed);
+		}
+
+	    //! the number of messages published but not yet received
+	    uint64_t backlog() const noexcept
+		{
+		return t.r->head.load(std::memory_order_relaxed) -
+		       s->cursor.load(std::memory_order_relaxed);
+		}
+	};  // subscriber
+
+    //! Create an unnamed topic with a ring of at least *capacity* messages
+    explicit topic(size_t capacity)
+	{
+	uint32_t cap = roundup(capacity);
+
+	r = static_cast<region *>(::operator new(region_size(cap), std::align_val_t(64),
+						  std::nothrow));
+	if (r == nullptr)
+	    throw;
+	init(cap);
+	}
+
+    /*! Open the topic *name*, creating it with a ring of at least
+        *capacity* messages if it does not exist. If *create* is false, it
+	must already exist, with the same capacity and message size.
+    */
+    topic(const string name, size_t capacity, bool create = true)
+	{
+	uint32_t cap = roundup(capacity);
+
+	r = open_shared_region<region>(sd, name, region_size(cap), create, ready,
+	    [&](region * fresh)
+		{
+		r = fresh;
+		init(cap);
+		},
+	    [&](region * old)
+		{
+		return old->capacity == cap && old->sizeM == sizeof(M);
+		});
+	mask = cap - 1;
+	}
+
+    //! Delete an unnamed topic, or unmap a named one; no task may be subscribed
+    ~topic()
+	{
+	if (sd != SD_ID_NULL)
+	    ::sdClose(sd, 0);
+	else
+	    ::operator delete(r, std::align_val_t(64));
+	}
+
+    topic(const topic&) = delete;
+    topic& operator=(const topic&) = delete;
+
+    /*! Publish a copy of *message* to every subscriber. If a block
+        subscriber has not read the slot the message needs, pend for up to
+	*timeout* ticks; return ERROR with errno set to S_objLib_OBJ_TIMEOUT,
+	or S_objLib_OBJ_UNAVAILABLE for NO_WAIT, if it does not catch up.
+    */
+    _Vx_STATUS publish(const M& message, _Vx_ticks_t timeout = WAIT_FOREVER)
+	{
+	_Vx_ticks64_t start = ::tick64Get();
+	uint64_t pos = r->head.load(std::memory_order_relaxed);
+
+	/* claim a position only once every block subscriber has room */
+	for (;;)
+	    {
+	    if (held_back(pos))
+		{
+		if (timeout == NO_WAIT)
+		    {
+		    errno = S_objLib_OBJ_UNAVAILABLE;
+		    return ERROR;
+		    }
+		_Vx_ticks_t left = remaining(timeout, start);
+		if (left == 0)
+		    {
+		    errno = S_objLib_OBJ_TIMEOUT;
+		    return ERROR;
+		    }
+		pend_publisher(pos, left);
+		pos = r->head.load(std::memory_order_relaxed);
+		continue;
+		}
+	    if (r->head.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst,
+					      std::memory_order_relaxed))
+		break;
+	    }
+
+	/* wait for a publisher still writing the previous lap to finish */
+	slot& sl = at(pos);
+	uint64_t previous = (pos > mask) ? 2 * (pos - mask - 1) + 2 : 0;
+	while (sl.seq.load(std::memory_order_acquire) < previous)
+	    ::taskDelay(0);
+
+	sl.seq.store(2 * pos + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&sl.message, &message, sizeof(M));
+	sl.seq.store(2 * pos + 2, std::memory_order_release);
+	wake_subscribers();
+	return OK;
+	}
+
+    //! publish() with a timeout given as a std::duration
+    template <class Rep, class Period>
+    _Vx_STATUS publish(const M& message, const duration<Rep, Period>& relTime)
+	{
+	return publish(message, chrono2tic(relTime));
+	}
+
+    //! the number of messages the ring holds
+    size_t capacity() const noexcept
+	{
+	return static_cast<size_t>(mask + 1);
+	}
+
+    //! The handle of the shared data region, or SD_ID_NULL if unnamed
+    SD_ID handle() const noexcept
+	{
+	return sd;
+	}
+    };  // topic
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCtopichpp
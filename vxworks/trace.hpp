@@ -0,0 +1,367 @@
+/* trace.hpp - binary trace ring of synchronization events */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCtracehpp
+#define __INCtracehpp
+
+#include <taskLib.h>
+#ifndef __RTP__
+#include <vxCpuLib.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#ifndef VX_TRACE_RECORDS
+#define VX_TRACE_RECORDS 1024	/* records kept per CPU, a power of two */
+#endif
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+//! The operations recorded in the trace
+enum class trace_op : uint16_t
+    {
+    lock,		//!< a mutex was taken exclusively
+    unlock,		//!< a mutex is about to be given
+    lock_shared,	//!< a shared_mutex was taken shared
+    unlock_shared,	//!< a shared_mutex is about to be given by a reader
+    take,		//!< a semaphore was taken
+    give,		//!< a semaphore is about to be given
+    send,		//!< a message is about to be sent
+    receive,		//!< a message was received
+    event_send,		//!< events are about to be sent; the object is the task
+    event_receive,	//!< events were received; the object is the wanted set
+    wd_fire		//!< a watchdog routine is about to run
+    };
+
+//! One event, as read back from the trace
+struct trace_record
+    {
+    uint64_t time;	//!< trace::now() when the operation happened
+    uint64_t object;	//!< the object ID
+    uint64_t task;	//!< the task that performed the operation
+    uint16_t op;	//!< a trace_op
+    int16_t status;	//!< OK or ERROR
+    uint16_t cpu;	//!< the ring the record was written to
+    uint16_t reserved;
+    };
+
+/*!
+
+\brief  The Synchronization Event Trace
+
+ When the program is built with VX_OBJECT_TRACE defined, the mutexes,
+ semaphores, queues, events and watchdogs of the namespace record each
+ operation in the trace: the time, the object, the calling task, the
+ operation and its result, in a 32 byte record. Without the macro the
+ hooks compile to nothing.
+
+ Every CPU has its own ring of VX_TRACE_RECORDS records. A writer claims a
+ slot with one atomic increment and stamps it with a sequence number once
+ it is written, so recording never locks or pends and may be done at
+ interrupt level; when a ring is full the oldest records are overwritten.
+ Operations that release an object (unlock, give, send) are stamped before
+ the release so that, in the trace, a release always precedes the
+ acquisition it allows.
+
+ collect() copies the complete records out of all the rings in time order.
+ write_json() turns records into the Chrome trace event format, which
+ Perfetto (ui.perfetto.dev) and chrome://tracing load directly: each task
+ becomes a thread, each operation an instant event, and each time a mutex
+ is held a span on the mutex's own track. save() writes the raw records to
+ a file for the vxtrace tool to convert on a host.
+
+ Times come from the CPU's cycle counter where the compiler offers one, and
+ from std::chrono::steady_clock otherwise; they are converted to
+ microseconds with a rate measured against steady_clock.
+*/
+class trace
+    {
+public:
+    static const unsigned cpus = 8;			//!< rings
+    static const size_t records = VX_TRACE_RECORDS;	//!< records per ring
+    static_assert((records & (records - 1)) == 0, "VX_TRACE_RECORDS must be a power of two");
+
+    //! The header of a file written by save()
+    struct file_header
+	{
+	char magic[8];		//!< "VXTRACE"
+	uint32_t version;	//!< 1
+	uint32_t count;		//!< records that follow
+	double ticksPerUs;	//!< rate of trace_record::time
+	};
+
+private:
+    /* a slot in a ring: a record guarded by its sequence number */
+    struct slot
+	{
+	uint64_t time;
+	uint64_t object;
+	uint64_t task;
+	uint16_t op;
+	int16_t status;
+	std::atomic<uint32_t> seq;
+	};
+
+    struct alignas(64) ring
+	{
+	std::atomic<uint64_t> head{0};
+	slot slots[records];
+	};
+
+    struct state
+	{
+	ring rings[cpus];
+	uint64_t origin;
+	std::chrono::steady_clock::time_point start;
+
+	state() : origin(now()), start(std::chrono::steady_clock::now())
+	    {
+	    }
+	};
+
+    static state& global()
+	{
+	static state s;
+	return s;
+	}
+
+    static unsigned here()
+	{
+#ifdef __RTP__
+	uintptr_t tid = (uintptr_t) ::taskIdSelf();
+	return static_cast<unsigned>((tid ^ (tid >> 12)) % cpus);
+#else
+	return ::vxCpuIndexGet() % cpus;
+#endif
+	}
+
+    static void escape(FILE * f, uint64_t v)
+	{
+	fprintf(f, "\"0x%llx\"", static_cast<unsigned long long>(v));
+	}
+
+public:
+    //! The current trace time
+    static uint64_t now() noexcept
+	{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+    //! The rate of now(), in ticks per microsecond
+    static double ticks_per_us()
+	{
+	state& s = global();
+	double us = std::chrono::duration<double, std::micro>(
+	    std::chrono::steady_clock::now() - s.start).count();
+	uint64_t ticks = now() - s.origin;
+
+	if (us < 1000.0)
+	    return 1000.0;	/* too soon to tell; assume a 1 GHz counter */
+	return double(ticks) / us;
+	}
+
+    //! Record *op* on *object*, which happened at *time*, with *status*
+    static void record(trace_op op, uintptr_t object, int status,
+		       uint64_t time) noexcept
+	{
+	ring& r = global().rings[here()];
+	uint64_t n = r.head.fetch_add(1, std::memory_order_relaxed);
+	slot& s = r.slots[n & (records - 1)];
+
+	/* a zero sequence marks the slot as being rewritten */
+	s.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s.time = time;
+	s.object = object;
+	s.task = (uintptr_t) ::taskIdSelf();
+	s.op = static_cast<uint16_t>(op);
+	s.status = static_cast<int16_t>(status);
+	s.seq.store(static_cast<uint32_t>(n + 1), std::memory_order_release);
+	}
+
+    //! Record *op* on *object* now
+    static void record(trace_op op, uintptr_t object, int status) noexcept
+	{
+	record(op, object, status, now());
+	}
+
+    /*! Copy up to *max* of the most recent complete records into *out* in
+        time order, and return how many were copied. Records being written
+	while they are copied are skipped.
+    */
+    static size_t collect(trace_record * out, size_t max)
+	{
+	state& s = global();
+	std::vector<trace_record> all;
+
+	for (unsigned c = 0; c < cpus; c++)
+	    {
+	    ring& r = s.rings[c];
+	    uint64_t head = r.head.load(std::memory_order_acquire);
+	    uint64_t first = (head > records) ? head - records : 0;
+
+	    for (uint64_t n = first; n < head; n++)
+		{
+		const slot& sl = r.slots[n & (records - 1)];
+		uint32_t seq = sl.seq.load(std::memory_order_acquire);
+		trace_record t = { sl.time, sl.object, sl.task, sl.op, sl.status,
+				   static_cast<uint16_t>(c), 0 };
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq != static_cast<uint32_t>(n + 1) ||
+		    sl.seq.load(std::memory_order_relaxed) != seq)
+		    continue;
+		all.push_back(t);
+		}
+	    }
+	std::sort(all.begin(), all.end(),
+		  [](const trace_record& a, const trace_record& b)
+		      { return a.time < b.time; });
+	if (all.size() > max)
+	    all.erase(all.begin(), all.end() - max);
+	std::copy(all.begin(), all.end(), out);
+	return all.size();
+	}
+
+    //! Copy every complete record, in time order
+    static std::vector<trace_record> collect()
+	{
+	std::vector<trace_record> all(size_t(cpus) * records);
+	all.resize(collect(all.data(), all.size()));
+	return all;
+	}
+
+    //! Discard everything recorded so far
+    static void clear() noexcept
+	{
+	for (ring& r : global().rings)
+	    for (slot& sl : r.slots)
+		sl.seq.store(0, std::memory_order_relaxed);
+	}
+
+    //! The name of an operation
+    static const char * name(uint16_t op) noexcept
+	{
+	static const char * const names[] =
+	    {
+	    "lock", "unlock", "lock_shared", "unlock_shared", "take", "give",
+	    "send", "receive", "event_send", "event_receive", "wd_fire"
+	    };
+	return (op < sizeof(names) / sizeof(names[0])) ? names[op] : "unknown";
+	}
+
+    /*! Write *n* records as a Chrome trace event JSON document, with times
+        in microseconds from the first record.
+    */
+    static void write_json(FILE * f, const trace_record * rec, size_t n,
+			   double ticksPerUs)
+	{
+	std::map<uint64_t, unsigned> tasks;
+	uint64_t origin = (n > 0) ? rec[0].time : 0;
+	const char * sep = "\n";
+
+	fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (size_t i = 0; i < n; i++)
+	    {
+	    const trace_record& r = rec[i];
+	    double ts = double(r.time - origin) / ticksPerUs;
+	    auto t = tasks.emplace(r.task, unsigned(tasks.size() + 1));
+
+	    if (t.second)
+		{
+		fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+			"\"tid\":%u,\"args\":{\"name\":\"task 0x%llx\"}}", sep,
+			t.first->second, static_cast<unsigned long long>(r.task));
+		sep = ",\n";
+		}
+	    fprintf(f, "%s{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"vxworks\","
+		    "\"name\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+		    "\"args\":{\"object\":", sep, name(r.op), ts, t.first->second);
+	    escape(f, r.object);
+	    fprintf(f, ",\"status\":%d,\"cpu\":%u}}", r.status, r.cpu);
+	    sep = ",\n";
+
+	    /* the time a mutex is held, on a track of its own */
+	    bool opens = r.op == uint16_t(trace_op::lock);
+	    bool closes = r.op == uint16_t(trace_op::unlock);
+	    if (r.status == 0 && (opens || closes))
+		{
+		fprintf(f, ",\n{\"ph\":\"%s\",\"cat\":\"held\",\"name\":\"0x%llx\","
+			"\"id\":", opens ? "b" : "e",
+			static_cast<unsigned long long>(r.object));
+		escape(f, r.object);
+		fprintf(f, ",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", ts,
+			t.first->second);
+		}
+	    }
+	fprintf(f, "\n]}\n");
+	}
+
+    //! Write everything recorded so far as Chrome trace event JSON
+    static void dump_json(FILE * f)
+	{
+	std::vector<trace_record> all = collect();
+	write_json(f, all.data(), all.size(), ticks_per_us());
+	}
+
+    /*! Write everything recorded so far, in binary, for vxtrace to convert.
+        Returns ERROR if the file cannot be written.
+    */
+    static _Vx_STATUS save(FILE * f)
+	{
+	std::vector<trace_record> all = collect();
+	file_header h;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "VXTRACE", 8);
+	h.version = 1;
+	h.count = static_cast<uint32_t>(all.size());
+	h.ticksPerUs = ticks_per_us();
+	if (fwrite(&h, sizeof(h), 1, f) != 1 ||
+	    fwrite(all.data(), sizeof(trace_record), all.size(), f) != all.size())
+	    return ERROR;
+	return OK;
+	}
+    };  // trace
+
+/*
+ * Run <call>, an operation on <object>, and record it in the trace with its
+ * result when VX_OBJECT_TRACE is defined. Releases are stamped before the
+ * call, everything else when it returns.
+ */
+template <typename Call>
+inline auto traced(trace_op op, uintptr_t object, Call call) -> decltype(call())
+    {
+#ifdef VX_OBJECT_TRACE
+    bool before = op == trace_op::unlock || op == trace_op::unlock_shared ||
+		  op == trace_op::give || op == trace_op::send ||
+		  op == trace_op::event_send || op == trace_op::wd_fire;
+    uint64_t t = before ? trace::now() : 0;
+    auto result = call();
+    trace::record(op, object, (result == decltype(result)(ERROR)) ? ERROR : OK,
+		  before ? t : trace::now());
+    return result;
+#else
+    (void) op;
+    (void) object;
+    return call();
+#endif
+    }
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCtracehpp
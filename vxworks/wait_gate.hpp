@@ -0,0 +1,134 @@
+/* wait_gate.hpp - pending for the slow path of non-blocking classes */
+
+/*
+ * Copyright (c) 2022 Wind River Systems, Inc.
+ */
+
+#ifndef __INCwaitgatehpp
+#define __INCwaitgatehpp
+
+#include <semLib.h>
+#include <semEvLib.h>
+#include <objLib.h>
+#include <tickLib.h>
+#include <errno.h>
+#include <atomic>
+#include "ticks.hpp"
+
+#ifdef __cplusplus
+
+namespace vxworks
+{
+/*
+ * A binary semaphore and a count of the tasks pended on it, for classes
+ * such as mpmc_queue whose operations normally complete without entering
+ * the kernel. A task that cannot complete its operation pends in pend(),
+ * and the task that makes it possible calls wake(), which gives the
+ * semaphore only if some task may be pended, so that the fast path makes
+ * no system call. The semaphore holds at most one wakeup, so gives that no
+ * task took leave at most one spurious wakeup behind; a woken task that
+ * completes its operation passes the wakeup on in case it was meant for
+ * more than one. A task that must also wait for something else, such as a
+ * stop, pends on its event register instead, registered with arm() to be
+ * sent an event when the semaphore is given.
+ */
+class wait_gate
+    {
+private:
+    std::atomic<int> waiters {0};
+    SEM_ID sem;
+
+public:
+    wait_gate()
+	{
+	sem = ::semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+	if (sem == SEM_ID_NULL)
+	    throw;
+	}
+
+    wait_gate(const wait_gate&) = delete;
+    wait_gate& operator=(const wait_gate&) = delete;
+
+    ~wait_gate()
+	{
+	::semDelete(sem);
+	}
+
+    /* give the semaphore if a task may be pended on it */
+    void wake() noexcept
+	{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiters.load(std::memory_order_relaxed) > 0)
+	    ::semBGive(sem);
+	}
+
+    /* count the calling task as a waiter and register it to be sent
+       <events> when the semaphore is given, dropping a wakeup left by an
+       earlier give. The caller must look again at what it waits for
+       after this, as a wake() before it went unseen */
+    _Vx_STATUS arm(_Vx_event_t events) noexcept
+	{
+	::semTake(sem, NO_WAIT);
+	waiters.fetch_add(1, std::memory_order_seq_cst);
+	if (OK == ::semEvStart(sem, events, EVENTS_SEND_ONCE | EVENTS_SEND_IF_FREE))
+	    return OK;
+	waiters.fetch_sub(1, std::memory_order_relaxed);
+	return ERROR;
+	}
+
+    /* undo arm() */
+    void disarm() noexcept
+	{
+	::semEvStop(sem);
+	waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+    /* the semaphore, by which tasks that arm() are told apart */
+    const void * object() const noexcept
+	{
+	return sem;
+	}
+
+    /* pend until <attempt> succeeds or <timeout> expires; the count is
+       raised before each attempt, so a wake() after a failed attempt is
+       never missed */
+    template <typename Attempt>
+    _Vx_STATUS pend(_Vx_ticks_t timeout, Attempt attempt)
+	{
+	_Vx_ticks64_t start = ::tick64Get();
+
+	if (timeout == NO_WAIT)
+	    {
+	    errno = S_objLib_OBJ_UNAVAILABLE;
+	    return ERROR;
+	    }
+
+	for (;;)
+	    {
+	    waiters.fetch_add(1, std::memory_order_seq_cst);
+	    if (attempt())
+		{
+		waiters.fetch_sub(1, std::memory_order_relaxed);
+		return OK;
+		}
+	    _Vx_ticks_t left = remaining(timeout, start);
+	    _Vx_STATUS status = (left == 0) ? ERROR : ::semBTake(sem, left);
+	    waiters.fetch_sub(1, std::memory_order_relaxed);
+	    if (attempt())
+		{
+		if (status == OK)
+		    wake();
+		return OK;
+		}
+	    if (status != OK)
+		{
+		if (left == 0)
+		    errno = S_objLib_OBJ_TIMEOUT;
+		return ERROR;
+		}
+	    }
+	}
+    };
+}      // vxworks
+#endif // __cplusplus
+#endif // __INCwaitgatehpp
@@ -9,6 +9,9 @@
 #ifndef __RTP__ 
 #include <wdLib.h>
 #include <functional>
+#include <memory>
+#include <new>
+#include "expected.hpp"
 #include "object.hpp"
 
 #ifdef __cplusplus
@@ -40,16 +43,31 @@ class wd : public object< WDOG_ID >
 
 private:
     
-    std::function<void() noexcept> func;
+    /* the std::function callback, which stays put when the wd is moved */
+    struct callback
+	{
+	WDOG_ID id;
+	std::function<void()> func;
+	};
+    std::unique_ptr<callback> fn;
     
-    void callback() noexcept
+    static void _callback( callback * r ) noexcept
 	{
-	func();
+#ifdef VX_OBJECT_TRACE
+	trace::record(trace_op::wd_fire, (uintptr_t) r->id, OK);
+#endif
+	r->func();
 	}
-    
-    static void _callback( wd * me ) noexcept
+
+    /* delete the watchdog, unless it has been moved from */
+    void destroy() noexcept
 	{
-	    me->callback();
+	if (id == WDOG_ID_NULL)
+	    return;
+	delist();
+	::wdDelete(id);
+	id = WDOG_ID_NULL;
+	fn.reset();
 	}
     
 public:
@@ -60,7 +78,7 @@ public:
     */
     wd()
 	{
-	id = ::wdCreate();
+	id = enlist(::wdCreate());
 	if (id == NULL)
 	    throw;
 	}
@@ -68,7 +86,22 @@ public:
     /*! Delete a watchdog */
     ~wd()
 	{
-	::wdDelete(id);
+	destroy();
+	}
+
+    //! Take over *other*'s watchdog, leaving *other* without one
+    wd(wd&& other) noexcept = default;
+
+    //! Delete this watchdog and take over *other*'s
+    wd& operator=(wd&& other) noexcept
+	{
+	if (this != &other)
+	    {
+	    destroy();
+	    object::operator=(std::move(other));
+	    fn = std::move(other.fn);
+	    }
+	return *this;
 	}
 	
 	
@@ -94,13 +127,38 @@ public:
     * itself must call wdStart( ) to restart the timer on each invocation.
     *
     */
-    _Vx_STATUS start( _Vx_ticks_t  delay, std::function<void() noexcept> routine)
+    _Vx_STATUS start( _Vx_ticks_t  delay, std::function<void()> routine)
 	{
-	func = routine;  
+	if (!fn)
+	    fn.reset(new callback {id, nullptr});
+	else
+	    ::wdCancel(id);
+	fn->func = routine;
 	return ::wdStart(id, delay, reinterpret_cast<FUNCPTR>( wd::_callback), 
-			 reinterpret_cast<_Vx_usr_arg_t>(this));
+			 reinterpret_cast<_Vx_usr_arg_t>(fn.get()));
 	}
     /*!
+    * Start a watchdog with std:function as a callback, as start(), but
+    * return the error rather than throwing if the callback cannot be
+    * allocated. Only the first start() of a watchdog allocates.
+    */
+    expected<void> start( _Vx_ticks_t  delay, std::function<void()> routine,
+			  std::nothrow_t) noexcept
+	{
+	if (!fn)
+	    {
+	    fn.reset(new (std::nothrow) callback {id, nullptr});
+	    if (!fn)
+		return vx_error(ENOMEM);
+	    }
+	else
+	    ::wdCancel(id);
+	fn->func = std::move(routine);
+	return to_expected(::wdStart(id, delay, reinterpret_cast<FUNCPTR>( wd::_callback),
+				     reinterpret_cast<_Vx_usr_arg_t>(fn.get())));
+	}
+
+    /*!
     * Start a watchdog with VxWorks FUNCPTR type as a callback. 
     * This form mimics the C function wdStart().
     *
@@ -136,6 +194,15 @@ public:
 	{
 	return ::wdCancel(id);
 	}
+
+    /*!
+    * Cancel a watchdog timer before it fires, returning the error rather
+    * than a status.
+    */
+    expected<void> cancel(std::nothrow_t) noexcept
+	{
+	return to_expected(::wdCancel(id));
+	}
     }; // wd 
 }      // vxworks
 #endif // __cplusplus 